@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <numbers>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "src/engine/cpu_cull.h"
+#include "src/job_system.h"
+#include "src/math/geometry.h"
+#include "src/math/mat.h"
+
+namespace {
+
+namespace engine = el::engine;
+namespace math = el::math;
+
+constexpr size_t kDefaultObjects = size_t{1} << 20;
+constexpr size_t kRuns = 25;
+// Objects are scattered through a cube this far from the camera on each
+// axis, so about a tenth of them fall inside the frustum.
+constexpr float kWorldExtent = 100.0F;
+constexpr float kFov = std::numbers::pi_v<float> / 3.0F;
+constexpr float kAspect = 16.0F / 9.0F;
+constexpr float kNear = 0.1F;
+constexpr float kFar = 200.0F;
+
+// Looking down -z from the origin.
+auto frustum() -> math::Frustum {
+  return math::Frustum::from_matrix(
+      math::perspective(kFov, kAspect, kNear, kFar));
+}
+
+struct Scene {
+  engine::CullSpheres spheres;
+  engine::CullBoxes boxes;
+};
+
+auto make_scene(size_t count) -> Scene {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> position(-kWorldExtent, kWorldExtent);
+  std::uniform_real_distribution<float> size(0.5F, 2.0F);
+
+  Scene scene;
+  scene.spheres.reserve(count);
+  scene.boxes.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    std::array<float, 3> center = {position(rng), position(rng), position(rng)};
+    auto radius = size(rng);
+    scene.spheres.push_back({center[0], center[1], center[2], radius});
+    scene.boxes.push_back(
+        {center[0] - radius, center[1] - radius, center[2] - radius},
+        {center[0] + radius, center[1] + radius, center[2] + radius});
+  }
+  return scene;
+}
+
+struct Result {
+  double ms = 0;
+  size_t visible = 0;
+};
+
+// Median time of a cull over |volumes|, after one warm up run.
+template <typename Volumes>
+auto measure(engine::CpuCuller* culler,
+             const math::Frustum& f,
+             const Volumes& volumes) -> Result {
+  std::vector<uint32_t> visible;
+  culler->cull(f, volumes, &visible);
+
+  std::vector<double> times;
+  for (size_t i = 0; i < kRuns; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    culler->cull(f, volumes, &visible);
+    times.push_back(std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count());
+  }
+  std::nth_element(std::begin(times), std::begin(times) + kRuns / 2,
+                   std::end(times));
+  return {times.at(kRuns / 2), visible.size()};
+}
+
+auto report(const std::string& label,
+            size_t objects,
+            uint32_t cores,
+            const Result& result) -> void {
+  auto per_ms = double(objects) / result.ms;
+  std::cout << std::left << std::setw(20) << label << std::right
+            << std::setw(6) << cores << std::fixed << std::setprecision(3)
+            << std::setw(12) << result.ms << std::setprecision(0)
+            << std::setw(14) << per_ms << std::setw(14) << per_ms / cores
+            << std::setw(10) << result.visible << "\n";
+}
+
+template <typename Volumes>
+auto run(const std::string& shape,
+         const Volumes& volumes,
+         el::JobSystem* jobs,
+         const math::Frustum& f) -> void {
+  auto cores = jobs->thread_count() + 1;
+  for (auto kernel : engine::available_cull_kernels()) {
+    auto name = shape + " " + std::string(engine::to_string(kernel));
+
+    engine::CpuCuller single(engine::CpuCullerConfig().set_kernel(kernel));
+    report(name, volumes.size(), 1, measure(&single, f, volumes));
+
+    engine::CpuCuller parallel(
+        engine::CpuCullerConfig(jobs).set_kernel(kernel));
+    report(name, volumes.size(), cores, measure(&parallel, f, volumes));
+  }
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+  try {
+    std::span args(argv, size_t(argc));
+    auto objects = args.size() > 1 ? std::stoul(args[1]) : kDefaultObjects;
+
+    el::JobSystem jobs;
+    auto scene = make_scene(objects);
+    auto f = frustum();
+
+    std::cout << objects << " objects, " << kRuns << " runs, median\n\n"
+              << std::left << std::setw(20) << "kernel" << std::right
+              << std::setw(6) << "cores" << std::setw(12) << "ms"
+              << std::setw(14) << "objects/ms" << std::setw(14)
+              << "per core" << std::setw(10) << "visible" << "\n";
+    run("sphere", scene.spheres, &jobs, f);
+    run("box", scene.boxes, &jobs, f);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
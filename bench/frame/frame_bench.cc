@@ -0,0 +1,492 @@
+#include "bench/frame/frame_bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace el::bench {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Sizes cycled through by Scene::kResizeStorm, relative to the configured
+// dimensions.
+constexpr std::array<float, 6> kResizeScales = {1.0F,   0.75F, 0.5F,
+                                                0.625F, 0.875F, 0.25F};
+constexpr float kFillAlpha = 0.05F;
+
+auto ms_since(Clock::time_point start) -> double {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+using engine::check;
+
+auto read_spirv(const std::string& path) -> std::vector<uint32_t> {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    throw std::runtime_error(std::string("Failed to open shader: ")
+                                 .append(path));
+  }
+  auto size = size_t(file.tellg());
+  if (size == 0 || size % sizeof(uint32_t) != 0) {
+    throw std::runtime_error(std::string("Invalid SPIR-V size: ")
+                                 .append(path));
+  }
+  std::vector<uint32_t> code(size / sizeof(uint32_t));
+  file.seekg(0);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.read(reinterpret_cast<char*>(code.data()), std::streamsize(size));
+  if (!file) {
+    throw std::runtime_error(std::string("Failed to read shader: ")
+                                 .append(path));
+  }
+  return code;
+}
+
+// Tiles normalized device coordinates with |count| small rects, each with
+// its own color.
+auto make_grid(uint32_t count) -> std::vector<DrawConstants> {
+  auto side = std::max(1U, uint32_t(std::ceil(std::sqrt(double(count)))));
+  auto size = 2.0F / float(side);
+
+  std::vector<DrawConstants> grid(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    auto x = i % side;
+    auto y = i / side;
+    grid[i] = {
+        .rect = {-1.0F + float(x) * size, -1.0F + float(y) * size, size * 0.5F,
+                 size * 0.5F},
+        .color = {float(x) / float(side), float(y) / float(side), 0.5F, 1.0F},
+    };
+  }
+  return grid;
+}
+
+}  // namespace
+
+auto to_string(Scene scene) -> std::string_view {
+  switch (scene) {
+    case Scene::kEmpty:
+      return "empty";
+    case Scene::kManyDraws:
+      return "many_draws";
+    case Scene::kHeavyFill:
+      return "heavy_fill";
+    case Scene::kUploadHeavy:
+      return "upload_heavy";
+    case Scene::kResizeStorm:
+      return "resize_storm";
+  }
+  return "unknown";
+}
+
+FrameBench::FrameBench(const FrameBenchConfig& config)
+    : device_(config.device()),
+      readback_(config.readback()),
+      resolution_(config.dynamic_resolution()),
+      dimensions_(config.dimensions()),
+      fill_layers_(config.fill_layers()),
+      warmup_frames_(config.warmup_frames()),
+      shader_dir_(config.shader_dir()),
+      grid_(make_grid(config.draws())),
+      pipelines_(
+          engine::PipelineRegistryConfig(config.device(), config.jobs())),
+      gpu_timer_(config.device()),
+      uploader_(engine::StagingUploaderConfig(config.device())),
+      upload_dst_(engine::BufferConfig(config.device())
+                      .set_size(config.upload_size())
+                      .set_usage(VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)),
+      upload_data_(config.upload_size()) {
+  create_render_pass();
+  create_pipelines();
+  create_frames();
+  target_ = create_target(dimensions_);
+}
+
+FrameBench::~FrameBench() {
+  vkDeviceWaitIdle(device_->device());
+  release_target(target_);
+
+  auto device = device_->device();
+  std::for_each(std::begin(frames_), std::end(frames_),
+                [this, device](const Frame& frame) {
+                  vkDestroyFence(device, frame.fence, nullptr);
+                  vkFreeCommandBuffers(device, device_->graphics_cmd_pool(), 1,
+                                       &frame.cmd);
+                });
+  vkDestroyPipelineLayout(device, layout_, nullptr);
+  vkDestroyRenderPass(device, render_pass_, nullptr);
+}
+
+auto FrameBench::run(Scene scene, uint32_t frames) -> SceneResult {
+  SceneResult result{.scene = scene};
+  result.cpu_ms.reserve(frames);
+  result.frame_ms.reserve(frames);
+  result.gpu_ms.reserve(frames);
+  if (resolution_ != nullptr) {
+    result.render_scale.reserve(frames);
+  }
+
+  auto last_start = Clock::now();
+  for (uint32_t i = 0; i < warmup_frames_ + frames; ++i) {
+    auto start = Clock::now();
+    if (i > warmup_frames_) {
+      result.frame_ms.push_back(
+          std::chrono::duration<double, std::milli>(start - last_start)
+              .count());
+    }
+    last_start = start;
+
+    auto slot = i % engine::kMaxFramesInFlight;
+    wait_frame(slot, &result);
+
+    auto cpu_start = Clock::now();
+    auto frame = device_->begin_frame();
+    if (readback_ != nullptr) {
+      readback_->poll();
+    }
+    prepare(scene, frame);
+    record(scene, slot);
+    auto measured = i >= warmup_frames_;
+    submit(slot, measured);
+    if (measured) {
+      result.cpu_ms.push_back(ms_since(cpu_start));
+      if (resolution_ != nullptr) {
+        result.render_scale.push_back(resolution_->scale());
+      }
+    }
+  }
+
+  for (uint32_t slot = 0; slot < engine::kMaxFramesInFlight; ++slot) {
+    wait_frame(slot, &result);
+  }
+  if (readback_ != nullptr) {
+    readback_->flush();
+  }
+
+  if (target_.extent.width != dimensions_.width ||
+      target_.extent.height != dimensions_.height) {
+    release_target(target_);
+    target_ = create_target(dimensions_);
+  }
+  return result;
+}
+
+auto FrameBench::wait_frame(uint32_t slot, SceneResult* result) -> void {
+  auto& frame = frames_.at(slot);
+  check(vkWaitForFences(device_->device(), 1, &frame.fence, VK_TRUE,
+                        UINT64_MAX),
+        "wait for frame");
+  auto measured = frame.measured;
+  frame.measured = false;
+
+  // Warmup frames still steer the resolution, they just aren't reported.
+  auto gpu_ms = gpu_timer_.read(slot);
+  if (!gpu_ms.has_value()) {
+    return;
+  }
+  if (resolution_ != nullptr) {
+    resolution_->update(gpu_ms.value());
+  }
+  if (measured) {
+    result->gpu_ms.push_back(gpu_ms.value());
+  }
+}
+
+auto FrameBench::prepare(Scene scene, uint64_t frame) -> void {
+  if (scene == Scene::kUploadHeavy) {
+    // Touch the data so every frame uploads freshly written memory.
+    upload_data_[frame % upload_data_.size()] = std::byte(frame);
+    uploader_.upload(upload_dst_, 0, upload_data_);
+    uploader_.flush();
+  } else if (scene == Scene::kResizeStorm) {
+    auto scale = kResizeScales.at(frame % kResizeScales.size());
+    release_target(target_);
+    target_ = create_target({
+        .width = std::max(1U, uint32_t(float(dimensions_.width) * scale)),
+        .height = std::max(1U, uint32_t(float(dimensions_.height) * scale)),
+    });
+  }
+}
+
+auto FrameBench::record(Scene scene, uint32_t slot) -> void {
+  auto cmd = frames_.at(slot).cmd;
+  check(vkResetCommandBuffer(cmd, 0), "reset frame command buffer");
+
+  VkCommandBufferBeginInfo begin_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+  };
+  check(vkBeginCommandBuffer(cmd, &begin_info), "begin frame commands");
+
+  gpu_timer_.begin(cmd, slot);
+
+  // Dynamic resolution renders into the corner of the full size target,
+  // which an upscale would stretch over the output.
+  auto extent = resolution_ != nullptr
+                    ? resolution_->render_extent(target_.extent)
+                    : target_.extent;
+
+  VkClearValue clear = {.color = {.float32 = {0.0F, 0.0F, 0.0F, 1.0F}}};
+  VkRenderPassBeginInfo pass_info = {
+      .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+      .renderPass = render_pass_,
+      .framebuffer = target_.framebuffer,
+      .renderArea = {.offset = {0, 0}, .extent = extent},
+      .clearValueCount = 1,
+      .pClearValues = &clear,
+  };
+  vkCmdBeginRenderPass(cmd, &pass_info, VK_SUBPASS_CONTENTS_INLINE);
+
+  VkViewport viewport = {
+      .x = 0,
+      .y = 0,
+      .width = float(extent.width),
+      .height = float(extent.height),
+      .minDepth = 0,
+      .maxDepth = 1,
+  };
+  VkRect2D scissor = {.offset = {0, 0}, .extent = extent};
+  vkCmdSetViewport(cmd, 0, 1, &viewport);
+  vkCmdSetScissor(cmd, 0, 1, &scissor);
+
+  auto draw = [cmd, layout = layout_](const DrawConstants& constants) {
+    vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                       sizeof(DrawConstants), &constants);
+    vkCmdDraw(cmd, 3, 1, 0, 0);
+  };
+
+  if (scene == Scene::kManyDraws) {
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, opaque_);
+    std::for_each(std::begin(grid_), std::end(grid_), draw);
+  } else if (scene == Scene::kHeavyFill) {
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, blended_);
+    for (uint32_t i = 0; i < fill_layers_; ++i) {
+      auto shade = float(i) / float(std::max(1U, fill_layers_));
+      draw({.rect = {-1.0F, -1.0F, 2.0F, 2.0F},
+            .color = {shade, 1.0F - shade, 0.5F, kFillAlpha}});
+    }
+  }
+
+  vkCmdEndRenderPass(cmd);
+
+  // Only the rendered corner, not the stale texels around it.
+  if (readback_ != nullptr) {
+    readback_->record(cmd, target_.image,
+                      VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, kTargetFormat,
+                      extent);
+  }
+
+  gpu_timer_.end(cmd, slot);
+  check(vkEndCommandBuffer(cmd), "end frame commands");
+}
+
+auto FrameBench::submit(uint32_t slot, bool measured) -> void {
+  auto& frame = frames_.at(slot);
+  check(vkResetFences(device_->device(), 1, &frame.fence), "reset fence");
+
+  VkSubmitInfo submit_info = {
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &frame.cmd,
+  };
+  check(vkQueueSubmit(device_->graphics_queue(), 1, &submit_info, frame.fence),
+        "submit frame");
+  frame.measured = measured;
+}
+
+auto FrameBench::create_render_pass() -> void {
+  VkAttachmentDescription color = {
+      .format = kTargetFormat,
+      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+      .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+      .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+      .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+  };
+  VkAttachmentReference color_ref = {
+      .attachment = 0,
+      .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+  };
+  VkSubpassDescription subpass = {
+      .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+      .colorAttachmentCount = 1,
+      .pColorAttachments = &color_ref,
+  };
+  // Orders the clear after the previous frame's writes to the target.
+  VkSubpassDependency dependency = {
+      .srcSubpass = VK_SUBPASS_EXTERNAL,
+      .dstSubpass = 0,
+      .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+  };
+  VkRenderPassCreateInfo create_info = {
+      .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+      .attachmentCount = 1,
+      .pAttachments = &color,
+      .subpassCount = 1,
+      .pSubpasses = &subpass,
+      .dependencyCount = 1,
+      .pDependencies = &dependency,
+  };
+  check(vkCreateRenderPass(device_->device(), &create_info, nullptr,
+                           &render_pass_),
+        "create bench render pass");
+}
+
+auto FrameBench::load_shader(std::string_view name, engine::shader::Type type)
+    -> std::unique_ptr<engine::Shader> {
+  auto path = std::string(shader_dir_).append("/").append(name);
+  return std::make_unique<engine::Shader>(
+      engine::ShaderConfig(device_).set_type(type).set_data(read_spirv(path)));
+}
+
+auto FrameBench::create_pipelines() -> void {
+  vertex_shader_ = load_shader("quad.vert.spv", engine::shader::Type::kVertex);
+  fragment_shader_ =
+      load_shader("quad.frag.spv", engine::shader::Type::kFragment);
+
+  VkPushConstantRange push_range = {
+      .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+      .offset = 0,
+      .size = sizeof(DrawConstants),
+  };
+  VkPipelineLayoutCreateInfo layout_info = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .pushConstantRangeCount = 1,
+      .pPushConstantRanges = &push_range,
+  };
+  check(vkCreatePipelineLayout(device_->device(), &layout_info, nullptr,
+                               &layout_),
+        "create bench pipeline layout");
+
+  engine::PipelineState state;
+  state.shaders = {vertex_shader_.get(), fragment_shader_.get()};
+  state.color_formats = {kTargetFormat};
+  state.layout = layout_;
+  state.render_pass = render_pass_;
+  state.raster.cull_mode = VK_CULL_MODE_NONE;
+  state.depth.test_enable = VK_FALSE;
+  state.depth.write_enable = VK_FALSE;
+  opaque_ = pipelines_.get_blocking(state);
+
+  state.blend_attachments = {{
+      .blendEnable = VK_TRUE,
+      .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+      .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+      .colorBlendOp = VK_BLEND_OP_ADD,
+      .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+      .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+      .alphaBlendOp = VK_BLEND_OP_ADD,
+      .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                        VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+  }};
+  blended_ = pipelines_.get_blocking(state);
+}
+
+auto FrameBench::create_frames() -> void {
+  for (auto& frame : frames_) {
+    VkCommandBufferAllocateInfo alloc_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = device_->graphics_cmd_pool(),
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+    check(vkAllocateCommandBuffers(device_->device(), &alloc_info, &frame.cmd),
+          "allocate frame command buffer");
+
+    // Signaled, so waiting on a slot which never ran returns at once.
+    VkFenceCreateInfo fence_info = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+    };
+    check(vkCreateFence(device_->device(), &fence_info, nullptr, &frame.fence),
+          "create frame fence");
+  }
+}
+
+auto FrameBench::create_target(Dimensions dimensions) -> Target {
+  Target target;
+  target.extent = {dimensions.width, dimensions.height};
+
+  VkImageCreateInfo image_info = {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+      .imageType = VK_IMAGE_TYPE_2D,
+      .format = kTargetFormat,
+      .extent = {dimensions.width, dimensions.height, 1},
+      .mipLevels = 1,
+      .arrayLayers = 1,
+      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .tiling = VK_IMAGE_TILING_OPTIMAL,
+      .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+               VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+      .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+      .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+  };
+  check(vkCreateImage(device_->device(), &image_info, nullptr, &target.image),
+        "create bench target");
+
+  VkMemoryRequirements reqs = {};
+  vkGetImageMemoryRequirements(device_->device(), target.image, &reqs);
+  auto type = device_->find_memory_type(reqs.memoryTypeBits,
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  if (!type.has_value()) {
+    vkDestroyImage(device_->device(), target.image, nullptr);
+    throw std::runtime_error("No device local memory for the bench target");
+  }
+  VkMemoryAllocateInfo alloc_info = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+      .allocationSize = reqs.size,
+      .memoryTypeIndex = type.value(),
+  };
+  check(device_->allocate_memory(alloc_info, &target.memory),
+        "allocate bench target memory");
+  check(vkBindImageMemory(device_->device(), target.image, target.memory, 0),
+        "bind bench target memory");
+
+  VkImageViewCreateInfo view_info = {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+      .image = target.image,
+      .viewType = VK_IMAGE_VIEW_TYPE_2D,
+      .format = kTargetFormat,
+      .subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                           .baseMipLevel = 0,
+                           .levelCount = 1,
+                           .baseArrayLayer = 0,
+                           .layerCount = 1},
+  };
+  check(vkCreateImageView(device_->device(), &view_info, nullptr,
+                          &target.view),
+        "create bench target view");
+
+  VkFramebufferCreateInfo framebuffer_info = {
+      .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+      .renderPass = render_pass_,
+      .attachmentCount = 1,
+      .pAttachments = &target.view,
+      .width = dimensions.width,
+      .height = dimensions.height,
+      .layers = 1,
+  };
+  check(vkCreateFramebuffer(device_->device(), &framebuffer_info, nullptr,
+                            &target.framebuffer),
+        "create bench framebuffer");
+  return target;
+}
+
+auto FrameBench::release_target(const Target& target) -> void {
+  device_->destroy_deferred(target.framebuffer);
+  device_->destroy_deferred(target.view);
+  device_->destroy_deferred(target.image);
+  device_->destroy_deferred(target.memory);
+}
+
+}  // namespace el::bench
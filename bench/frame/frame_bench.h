@@ -0,0 +1,245 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/dimensions.h"
+#include "src/engine/buffer.h"
+#include "src/engine/device.h"
+#include "src/engine/dynamic_resolution.h"
+#include "src/engine/gpu_timer.h"
+#include "src/engine/pipeline_registry.h"
+#include "src/engine/readback.h"
+#include "src/engine/shader.h"
+#include "src/engine/uploader.h"
+#include "src/engine/vk.h"
+#include "src/job_system.h"
+#include "src/pad.h"
+
+namespace el::bench {
+
+constexpr VkFormat kTargetFormat = VK_FORMAT_R8G8B8A8_UNORM;
+constexpr uint32_t kDefaultDraws = 10000;
+constexpr uint32_t kDefaultFillLayers = 32;
+constexpr VkDeviceSize kDefaultUploadSize = VkDeviceSize{32} * 1024 * 1024;
+constexpr uint32_t kDefaultWarmupFrames = 10;
+
+enum class Scene : uint8_t {
+  // Clears the target and nothing else, the fixed cost of a frame.
+  kEmpty,
+  // Many tiny draws, each with its own push constants. CPU and driver bound.
+  kManyDraws,
+  // Blended fullscreen layers. Fill rate bound.
+  kHeavyFill,
+  // Streams a large buffer through the staging uploader every frame.
+  kUploadHeavy,
+  // Recreates the render target at a different size every frame, as a
+  // window being dragged recreates its swapchain.
+  kResizeStorm,
+};
+
+constexpr std::array<Scene, 5> kScenes = {
+    Scene::kEmpty, Scene::kManyDraws, Scene::kHeavyFill, Scene::kUploadHeavy,
+    Scene::kResizeStorm};
+
+auto to_string(Scene scene) -> std::string_view;
+
+// Push constants of bench/frame/shaders/quad.vert.
+struct DrawConstants {
+  // Normalized device coordinates, xy offset and zw size.
+  std::array<float, 4> rect = {};
+  std::array<float, 4> color = {};
+};
+
+// Per frame timings of one scene, in milliseconds.
+struct SceneResult {
+  Scene scene = Scene::kEmpty;
+  EL_PAD(7);
+  // Recording and submitting, without waiting on the GPU.
+  std::vector<double> cpu_ms;
+  // Wall time between consecutive frame starts, including throttling on
+  // the GPU.
+  std::vector<double> frame_ms;
+  // From timestamp queries. Empty when the graphics queue has none.
+  std::vector<double> gpu_ms;
+  // Dynamic resolution scale each frame was rendered at. Empty without
+  // dynamic resolution.
+  std::vector<double> render_scale;
+};
+
+class FrameBenchConfig {
+ public:
+  FrameBenchConfig(engine::Device* device, JobSystem* jobs)
+      : device_(device), jobs_(jobs) {}
+
+  auto set_dimensions(Dimensions dimensions) -> FrameBenchConfig& {
+    dimensions_ = dimensions;
+    return *this;
+  }
+
+  // Directory holding quad.vert.spv and quad.frag.spv.
+  auto set_shader_dir(std::string_view dir) -> FrameBenchConfig& {
+    shader_dir_ = dir;
+    return *this;
+  }
+
+  auto set_draws(uint32_t draws) -> FrameBenchConfig& {
+    draws_ = draws;
+    return *this;
+  }
+
+  auto set_fill_layers(uint32_t layers) -> FrameBenchConfig& {
+    fill_layers_ = layers;
+    return *this;
+  }
+
+  // Bytes uploaded per frame by Scene::kUploadHeavy.
+  auto set_upload_size(VkDeviceSize size) -> FrameBenchConfig& {
+    upload_size_ = size;
+    return *this;
+  }
+
+  // Frames run before measuring, letting drivers settle and caches warm.
+  auto set_warmup_frames(uint32_t frames) -> FrameBenchConfig& {
+    warmup_frames_ = frames;
+    return *this;
+  }
+
+  // Reads every frame's target back through |readback|, which is polled as
+  // frames complete. Null, the default, reads nothing back.
+  auto set_readback(engine::ReadbackService* readback) -> FrameBenchConfig& {
+    readback_ = readback;
+    return *this;
+  }
+
+  // Renders into the part of the target |resolution| sizes from the GPU
+  // frame times. Null, the default, always renders the whole target.
+  auto set_dynamic_resolution(engine::DynamicResolution* resolution)
+      -> FrameBenchConfig& {
+    resolution_ = resolution;
+    return *this;
+  }
+
+  [[nodiscard]] auto device() const -> engine::Device* { return device_; }
+  [[nodiscard]] auto jobs() const -> JobSystem* { return jobs_; }
+  [[nodiscard]] auto readback() const -> engine::ReadbackService* {
+    return readback_;
+  }
+  [[nodiscard]] auto dynamic_resolution() const
+      -> engine::DynamicResolution* {
+    return resolution_;
+  }
+  [[nodiscard]] auto dimensions() const -> Dimensions { return dimensions_; }
+  [[nodiscard]] auto shader_dir() const -> std::string_view {
+    return shader_dir_;
+  }
+  [[nodiscard]] auto draws() const -> uint32_t { return draws_; }
+  [[nodiscard]] auto fill_layers() const -> uint32_t { return fill_layers_; }
+  [[nodiscard]] auto upload_size() const -> VkDeviceSize {
+    return upload_size_;
+  }
+  [[nodiscard]] auto warmup_frames() const -> uint32_t {
+    return warmup_frames_;
+  }
+
+ private:
+  engine::Device* device_ = nullptr;
+  JobSystem* jobs_ = nullptr;
+  engine::ReadbackService* readback_ = nullptr;
+  engine::DynamicResolution* resolution_ = nullptr;
+  std::string shader_dir_ = "bench/frame/shaders";
+  VkDeviceSize upload_size_ = kDefaultUploadSize;
+  Dimensions dimensions_ = {.width = 1920, .height = 1080};
+  uint32_t draws_ = kDefaultDraws;
+  uint32_t fill_layers_ = kDefaultFillLayers;
+  uint32_t warmup_frames_ = kDefaultWarmupFrames;
+  EL_PAD(4);
+};
+
+// Renders scripted scenes into an offscreen target, so frames can be timed
+// on headless devices such as lavapipe in CI. Frames are pipelined
+// engine::kMaxFramesInFlight deep, as they would be with a swapchain.
+class FrameBench {
+ public:
+  explicit FrameBench(const FrameBenchConfig& config);
+  FrameBench(const FrameBench&) = delete;
+  FrameBench(FrameBench&&) = delete;
+  ~FrameBench();
+
+  auto operator=(const FrameBench&) -> FrameBench& = delete;
+  auto operator=(FrameBench&&) -> FrameBench& = delete;
+
+  // Runs the warmup frames and then |frames| measured ones.
+  auto run(Scene scene, uint32_t frames) -> SceneResult;
+
+  // Whether SceneResult::gpu_ms gets filled in.
+  [[nodiscard]] auto gpu_timing() const -> bool {
+    return gpu_timer_.available();
+  }
+
+ private:
+  struct Target {
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VkExtent2D extent = {};
+  };
+
+  struct Frame {
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    // Whether the last submission was measured and its timestamps are still
+    // to be read.
+    bool measured = false;
+    EL_PAD(7);
+  };
+
+  auto create_render_pass() -> void;
+  auto create_pipelines() -> void;
+  auto create_frames() -> void;
+  auto create_target(Dimensions dimensions) -> Target;
+  // Destroys |target| once the frames using it are done.
+  auto release_target(const Target& target) -> void;
+  auto load_shader(std::string_view name, engine::shader::Type type)
+      -> std::unique_ptr<engine::Shader>;
+
+  // Waits for |slot|'s previous submission and collects its GPU time,
+  // feeding it to the dynamic resolution.
+  auto wait_frame(uint32_t slot, SceneResult* result) -> void;
+  auto prepare(Scene scene, uint64_t frame) -> void;
+  auto submit(uint32_t slot, bool measured) -> void;
+  auto record(Scene scene, uint32_t slot) -> void;
+
+  engine::Device* device_ = nullptr;
+  engine::ReadbackService* readback_ = nullptr;
+  engine::DynamicResolution* resolution_ = nullptr;
+  Dimensions dimensions_ = {};
+  uint32_t fill_layers_ = 0;
+  uint32_t warmup_frames_ = 0;
+  std::string shader_dir_;
+  // One entry per draw of Scene::kManyDraws, tiling the target.
+  std::vector<DrawConstants> grid_;
+
+  engine::PipelineRegistry pipelines_;
+  std::unique_ptr<engine::Shader> vertex_shader_;
+  std::unique_ptr<engine::Shader> fragment_shader_;
+  VkRenderPass render_pass_ = VK_NULL_HANDLE;
+  VkPipelineLayout layout_ = VK_NULL_HANDLE;
+  VkPipeline opaque_ = VK_NULL_HANDLE;
+  VkPipeline blended_ = VK_NULL_HANDLE;
+  Target target_;
+
+  std::array<Frame, engine::kMaxFramesInFlight> frames_ = {};
+  engine::GpuTimer gpu_timer_;
+
+  engine::StagingUploader uploader_;
+  engine::Buffer upload_dst_;
+  std::vector<std::byte> upload_data_;
+};
+
+}  // namespace el::bench
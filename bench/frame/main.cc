@@ -0,0 +1,285 @@
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench/frame/frame_bench.h"
+#include "bench/stats.h"
+#include "src/dimensions.h"
+#include "src/engine/device.h"
+#include "src/engine/dynamic_resolution.h"
+#include "src/engine/frame_sink.h"
+#include "src/engine/readback.h"
+#include "src/event_service.h"
+#include "src/job_system.h"
+#include "src/pad.h"
+
+namespace {
+
+namespace bench = el::bench;
+namespace engine = el::engine;
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t kDefaultFrames = 300;
+
+struct Options {
+  std::string device_name;
+  std::string shader_dir = "bench/frame/shaders";
+  std::string out;
+  std::string capture_dir;
+  std::string capture_command;
+  std::vector<bench::Scene> scenes = {std::begin(bench::kScenes),
+                                      std::end(bench::kScenes)};
+  // Enables dynamic resolution with this GPU frame budget when set.
+  double gpu_budget_ms = 0;
+  el::Dimensions dimensions = {.width = 1920, .height = 1080};
+  uint32_t frames = kDefaultFrames;
+  uint32_t warmup = bench::kDefaultWarmupFrames;
+  engine::FrameFormat capture_format = engine::FrameFormat::kPpm;
+  bool validation = false;
+  EL_PAD(6);
+};
+
+auto usage(std::string_view name) -> void {
+  std::cerr
+      << "Usage: " << name << " [options]\n"
+      << "  --device <name>    only use devices whose name contains <name>,\n"
+      << "                     e.g. llvmpipe for lavapipe\n"
+      << "  --scene <name>     run only this scene, may be repeated:\n"
+      << "                     empty many_draws heavy_fill upload_heavy\n"
+      << "                     resize_storm\n"
+      << "  --frames <n>       measured frames per scene, default "
+      << kDefaultFrames << "\n"
+      << "  --warmup <n>       unmeasured frames per scene, default "
+      << bench::kDefaultWarmupFrames << "\n"
+      << "  --size <w>x<h>     render target size, default 1920x1080\n"
+      << "  --shaders <dir>    compiled quad shaders, default "
+         "bench/frame/shaders\n"
+      << "  --out <file>       write the JSON report there, not to stdout\n"
+      << "  --capture <dir>    read every frame back and write it to <dir>\n"
+      << "  --capture-cmd <c>  read every frame back and pipe it into the\n"
+      << "                     shell command <c>, such as an encoder\n"
+      << "  --capture-format <f>\n"
+      << "                     ppm, the default, or raw RGBA\n"
+      << "  --gpu-budget <ms>  scale the render resolution to keep GPU frame\n"
+      << "                     times under <ms>\n"
+      << "  --validation       enable the validation layers\n";
+}
+
+auto parse_scene(std::string_view name) -> bench::Scene {
+  for (auto scene : bench::kScenes) {
+    if (bench::to_string(scene) == name) {
+      return scene;
+    }
+  }
+  throw std::runtime_error(std::string("Unknown scene: ").append(name));
+}
+
+auto parse_capture_format(std::string_view name) -> engine::FrameFormat {
+  if (name == "ppm") {
+    return engine::FrameFormat::kPpm;
+  }
+  if (name == "raw") {
+    return engine::FrameFormat::kRaw;
+  }
+  throw std::runtime_error(
+      std::string("Unknown capture format: ").append(name));
+}
+
+auto parse_size(const std::string& size) -> el::Dimensions {
+  auto x = size.find('x');
+  if (x == std::string::npos) {
+    throw std::runtime_error(std::string("Invalid size: ").append(size));
+  }
+  return {.width = uint32_t(std::stoul(size.substr(0, x))),
+          .height = uint32_t(std::stoul(size.substr(x + 1)))};
+}
+
+auto parse(std::span<char*> args) -> Options {
+  Options opts;
+  bool explicit_scenes = false;
+  for (size_t i = 1; i < args.size(); ++i) {
+    std::string_view arg(args[i]);
+    if (arg == "--validation") {
+      opts.validation = true;
+      continue;
+    }
+    if (i + 1 == args.size()) {
+      throw std::runtime_error(std::string("Missing value for ").append(arg));
+    }
+    std::string value(args[++i]);
+    if (arg == "--device") {
+      opts.device_name = value;
+    } else if (arg == "--scene") {
+      if (!explicit_scenes) {
+        opts.scenes.clear();
+        explicit_scenes = true;
+      }
+      opts.scenes.push_back(parse_scene(value));
+    } else if (arg == "--frames") {
+      opts.frames = uint32_t(std::stoul(value));
+    } else if (arg == "--warmup") {
+      opts.warmup = uint32_t(std::stoul(value));
+    } else if (arg == "--size") {
+      opts.dimensions = parse_size(value);
+    } else if (arg == "--shaders") {
+      opts.shader_dir = value;
+    } else if (arg == "--out") {
+      opts.out = value;
+    } else if (arg == "--capture") {
+      opts.capture_dir = value;
+    } else if (arg == "--capture-cmd") {
+      opts.capture_command = value;
+    } else if (arg == "--capture-format") {
+      opts.capture_format = parse_capture_format(value);
+    } else if (arg == "--gpu-budget") {
+      opts.gpu_budget_ms = std::stod(value);
+    } else {
+      throw std::runtime_error(std::string("Unknown option: ").append(arg));
+    }
+  }
+  return opts;
+}
+
+auto ms_since(Clock::time_point start) -> double {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+auto write_scene(std::ostream& out,
+                 const bench::SceneResult& result,
+                 bool gpu_timing,
+                 long peak_rss_kib) -> void {
+  out << "    {\"name\": \"" << bench::to_string(result.scene)
+      << "\",\n     \"cpu_ms\": ";
+  bench::write_json(out, bench::summarize(result.cpu_ms));
+  out << ",\n     \"frame_ms\": ";
+  bench::write_json(out, bench::summarize(result.frame_ms));
+  out << ",\n     \"gpu_ms\": ";
+  if (gpu_timing) {
+    bench::write_json(out, bench::summarize(result.gpu_ms));
+  } else {
+    out << "null";
+  }
+  if (!result.render_scale.empty()) {
+    out << ",\n     \"render_scale\": ";
+    bench::write_json(out, bench::summarize(result.render_scale));
+  }
+  out << ",\n     \"peak_rss_kib\": " << peak_rss_kib << "}";
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+  auto process_start = Clock::now();
+
+  std::span args(argv, size_t(argc));
+  Options opts;
+  try {
+    opts = parse(args);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    usage(args[0]);
+    return 1;
+  }
+
+  try {
+    el::EventService event_service;
+    el::JobSystem jobs;
+    engine::ErrorData err_data{
+        .cb = [](const engine::Error& data) { std::cerr << data.message; },
+        .user_data = nullptr,
+    };
+
+    auto config = engine::DeviceConfig()
+                      .set_app_name("Elysian frame bench")
+                      .set_app_version(0, 1, 0)
+                      .set_error_data(&err_data)
+                      .set_device_name(opts.device_name)
+                      .set_event_service(&event_service)
+                      .set_dimensions_cb([&opts]() -> el::Dimensions {
+                        return opts.dimensions;
+                      });
+    if (opts.validation) {
+      config.set_enable_validation();
+    }
+    engine::Device device(config);
+    auto device_ms = ms_since(process_start);
+
+    // Capturing measures the frames with readback and file IO included.
+    std::unique_ptr<engine::FrameSink> sink;
+    std::unique_ptr<engine::ReadbackService> readback;
+    if (!opts.capture_dir.empty() || !opts.capture_command.empty()) {
+      sink = std::make_unique<engine::FrameSink>(
+          engine::FrameSinkConfig()
+              .set_directory(opts.capture_dir)
+              .set_command(opts.capture_command)
+              .set_format(opts.capture_format));
+      readback = std::make_unique<engine::ReadbackService>(
+          engine::ReadbackServiceConfig(&device).set_callback(
+              sink->callback()));
+    }
+
+    std::unique_ptr<engine::DynamicResolution> resolution;
+    if (opts.gpu_budget_ms > 0) {
+      resolution = std::make_unique<engine::DynamicResolution>(
+          engine::DynamicResolutionConfig().set_budget_ms(opts.gpu_budget_ms));
+    }
+
+    bench::FrameBench frame_bench(
+        bench::FrameBenchConfig(&device, &jobs)
+            .set_dimensions(opts.dimensions)
+            .set_shader_dir(opts.shader_dir)
+            .set_warmup_frames(opts.warmup)
+            .set_readback(readback.get())
+            .set_dynamic_resolution(resolution.get()));
+    auto startup_ms = ms_since(process_start);
+
+    std::ofstream file;
+    if (!opts.out.empty()) {
+      file.open(opts.out);
+      if (!file) {
+        throw std::runtime_error(
+            std::string("Failed to open output: ").append(opts.out));
+      }
+    }
+    std::ostream& out = opts.out.empty() ? std::cout : file;
+
+    const auto& props = device.physical_device_info().properties;
+    out << "{\n  \"device\": \""
+        << static_cast<const char*>(props.deviceName) << "\",\n"
+        << "  \"width\": " << opts.dimensions.width << ",\n"
+        << "  \"height\": " << opts.dimensions.height << ",\n"
+        << "  \"frames\": " << opts.frames << ",\n"
+        << "  \"warmup_frames\": " << opts.warmup << ",\n"
+        << "  \"device_startup_ms\": " << device_ms << ",\n"
+        << "  \"startup_ms\": " << startup_ms << ",\n"
+        << "  \"scenes\": [\n";
+    for (size_t i = 0; i < opts.scenes.size(); ++i) {
+      auto result = frame_bench.run(opts.scenes[i], opts.frames);
+      write_scene(out, result, frame_bench.gpu_timing(),
+                  bench::peak_rss_kib());
+      out << (i + 1 < opts.scenes.size() ? ",\n" : "\n");
+    }
+    out << "  ],\n";
+    if (readback) {
+      out << "  \"readbacks_dropped\": " << readback->dropped() << ",\n";
+    }
+    out << "  \"peak_rss_kib\": " << bench::peak_rss_kib() << "\n}\n";
+    // Every readback was flushed at the end of its scene.
+    if (sink) {
+      sink->close();
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Exception: " << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
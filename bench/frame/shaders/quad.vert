@@ -0,0 +1,19 @@
+#version 460
+
+// A right triangle covering the rect given in normalized device coordinates
+// with the square half of its bounds, drawn from three vertices without
+// vertex buffers. The push constants match el::bench::DrawConstants.
+
+layout(push_constant) uniform Constants {
+  // xy offset and zw size.
+  vec4 rect;
+  vec4 color;
+} constants;
+
+layout(location = 0) out vec4 color;
+
+void main() {
+  vec2 corner = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+  gl_Position = vec4(constants.rect.xy + corner * constants.rect.zw, 0, 1);
+  color = constants.color;
+}
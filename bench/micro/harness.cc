@@ -0,0 +1,165 @@
+#include "bench/micro/harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace el::bench {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Calibration stops growing the iteration count past this.
+constexpr uint64_t kMaxIterations = uint64_t{1} << 32;
+
+struct Sample {
+  double ns = 0;
+  uint64_t cycles = 0;
+};
+
+auto measure(const Micro& micro, uint64_t iterations) -> Sample {
+  auto start = Clock::now();
+  auto start_cycles = cycle_count();
+  micro.fn(iterations);
+  auto cycles = cycle_count() - start_cycles;
+  return {std::chrono::duration<double, std::nano>(Clock::now() - start)
+              .count(),
+          cycles};
+}
+
+// Grows the iteration count until a run takes |min_ns|, then scales it to
+// land just past it.
+auto calibrate(const Micro& micro, double min_ns) -> uint64_t {
+  uint64_t iterations = 1;
+  while (iterations < kMaxIterations) {
+    auto ns = measure(micro, iterations).ns;
+    if (ns >= min_ns) {
+      break;
+    }
+    auto scale = ns > 0 ? std::clamp(min_ns * 1.2 / ns, 2.0, 10.0) : 10.0;
+    iterations = uint64_t(std::ceil(double(iterations) * scale));
+  }
+  return std::min(iterations, kMaxIterations);
+}
+
+}  // namespace
+
+auto run_micro(const MicroConfig& config, const Micro& micro) -> MicroResult {
+  MicroResult result{.name = micro.name};
+  result.iterations = calibrate(micro, config.min_time_ms() * 1e6);
+
+  for (uint32_t i = 0; i < config.warmup_repetitions(); ++i) {
+    measure(micro, result.iterations);
+  }
+
+  auto iterations = double(result.iterations);
+  for (uint32_t i = 0; i < config.repetitions(); ++i) {
+    auto sample = measure(micro, result.iterations);
+    result.ns_per_op.push_back(sample.ns / iterations);
+    result.cycles_per_op.push_back(double(sample.cycles) / iterations);
+  }
+  return result;
+}
+
+auto baseline_entry(const MicroResult& result) -> BaselineEntry {
+  const auto& samples = result.ns_per_op;
+  if (samples.empty()) {
+    return {};
+  }
+
+  auto count = double(samples.size());
+  auto mean =
+      std::accumulate(std::begin(samples), std::end(samples), 0.0) / count;
+  auto sq = std::accumulate(
+      std::begin(samples), std::end(samples), 0.0,
+      [mean](double acc, double v) { return acc + (v - mean) * (v - mean); });
+  auto stddev = samples.size() > 1 ? std::sqrt(sq / (count - 1)) : 0.0;
+  return {.mean = mean, .stddev = stddev, .count = samples.size()};
+}
+
+auto read_baseline(const std::string& path) -> Baseline {
+  Baseline baseline;
+  std::ifstream file(path);
+  if (!file) {
+    throw std::runtime_error(
+        std::string("Failed to read baseline: ").append(path));
+  }
+
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line.front() == '#') {
+      continue;
+    }
+    std::istringstream fields(line);
+    std::string name;
+    BaselineEntry entry;
+    if (!(fields >> name >> entry.mean >> entry.stddev >> entry.count)) {
+      throw std::runtime_error(
+          std::string("Invalid baseline line: ").append(line));
+    }
+    baseline[name] = entry;
+  }
+  return baseline;
+}
+
+auto write_baseline(const std::string& path,
+                    std::span<const MicroResult> results) -> void {
+  std::ofstream file(path);
+  if (!file) {
+    throw std::runtime_error(
+        std::string("Failed to write baseline: ").append(path));
+  }
+
+  file << "# name mean_ns stddev_ns repetitions\n";
+  file.precision(9);
+  for (const auto& result : results) {
+    auto entry = baseline_entry(result);
+    file << result.name << " " << entry.mean << " " << entry.stddev << " "
+         << entry.count << "\n";
+  }
+}
+
+auto to_string(Verdict verdict) -> std::string_view {
+  switch (verdict) {
+    case Verdict::kUnchanged:
+      return "unchanged";
+    case Verdict::kFaster:
+      return "faster";
+    case Verdict::kSlower:
+      return "slower";
+  }
+  return "unknown";
+}
+
+auto compare(const BaselineEntry& baseline,
+             const BaselineEntry& current,
+             double noise) -> Comparison {
+  Comparison result;
+  if (baseline.mean <= 0 || baseline.count == 0 || current.count == 0) {
+    return result;
+  }
+  result.change = (current.mean - baseline.mean) / baseline.mean;
+
+  auto variance = baseline.stddev * baseline.stddev / double(baseline.count) +
+                  current.stddev * current.stddev / double(current.count);
+  auto diff = current.mean - baseline.mean;
+  if (variance > 0) {
+    result.t = diff / std::sqrt(variance);
+  } else {
+    // Noiseless samples, any difference at all is significant.
+    constexpr auto kInf = std::numeric_limits<double>::infinity();
+    result.t = diff > 0 ? kInf : diff < 0 ? -kInf : 0;
+  }
+
+  if (std::abs(result.change) > noise && std::abs(result.t) > kSignificantT) {
+    result.verdict = result.change > 0 ? Verdict::kSlower : Verdict::kFaster;
+  }
+  return result;
+}
+
+}  // namespace el::bench
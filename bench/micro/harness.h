@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#include "src/pad.h"
+
+namespace el::bench {
+
+constexpr double kDefaultMinTimeMs = 20.0;
+constexpr uint32_t kDefaultRepetitions = 15;
+constexpr uint32_t kDefaultWarmupRepetitions = 2;
+// Relative change of the mean below which a difference is never reported.
+constexpr double kDefaultNoiseThreshold = 0.05;
+// Welch's t statistic above which a difference is significant, about a 99%
+// two sided confidence for the default repetitions.
+constexpr double kSignificantT = 3.0;
+
+// Keeps the compiler from optimizing away the computation of |value|.
+template <typename T>
+inline auto do_not_optimize(const T& value) -> void {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// The CPU's timestamp counter: TSC reference cycles on x86-64 and the
+// virtual counter on AArch64. Zero elsewhere.
+inline auto cycle_count() -> uint64_t {
+#if defined(__x86_64__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t count = 0;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(count));
+  return count;
+#else
+  return 0;
+#endif
+}
+
+// Runs the measured operation |iterations| times.
+using MicroFn = std::function<void(uint64_t iterations)>;
+
+struct Micro {
+  std::string name;
+  MicroFn fn;
+};
+
+class MicroConfig {
+ public:
+  // Iterations per repetition are calibrated to take at least this long.
+  auto set_min_time_ms(double ms) -> MicroConfig& {
+    min_time_ms_ = ms;
+    return *this;
+  }
+
+  auto set_repetitions(uint32_t repetitions) -> MicroConfig& {
+    repetitions_ = repetitions;
+    return *this;
+  }
+
+  // Repetitions run and discarded before measuring.
+  auto set_warmup_repetitions(uint32_t repetitions) -> MicroConfig& {
+    warmup_repetitions_ = repetitions;
+    return *this;
+  }
+
+  [[nodiscard]] auto min_time_ms() const -> double { return min_time_ms_; }
+  [[nodiscard]] auto repetitions() const -> uint32_t { return repetitions_; }
+  [[nodiscard]] auto warmup_repetitions() const -> uint32_t {
+    return warmup_repetitions_;
+  }
+
+ private:
+  double min_time_ms_ = kDefaultMinTimeMs;
+  uint32_t repetitions_ = kDefaultRepetitions;
+  uint32_t warmup_repetitions_ = kDefaultWarmupRepetitions;
+};
+
+// Per repetition costs of one operation.
+struct MicroResult {
+  std::string name;
+  uint64_t iterations = 0;
+  std::vector<double> ns_per_op;
+  std::vector<double> cycles_per_op;
+};
+
+auto run_micro(const MicroConfig& config, const Micro& micro) -> MicroResult;
+
+// Mean and spread of a benchmark's ns per op from an earlier run.
+struct BaselineEntry {
+  double mean = 0;
+  double stddev = 0;
+  uint64_t count = 0;
+};
+
+using Baseline = std::map<std::string, BaselineEntry, std::less<>>;
+
+// Baselines are text, one "name mean stddev count" line per benchmark.
+// Throws if the file can't be read, so a missing baseline never passes as
+// one without any regressions.
+auto read_baseline(const std::string& path) -> Baseline;
+auto write_baseline(const std::string& path,
+                    std::span<const MicroResult> results) -> void;
+
+auto baseline_entry(const MicroResult& result) -> BaselineEntry;
+
+enum class Verdict : uint8_t {
+  kUnchanged,
+  kFaster,
+  kSlower,
+};
+
+auto to_string(Verdict verdict) -> std::string_view;
+
+struct Comparison {
+  // Relative change of the mean, positive when slower.
+  double change = 0;
+  // Welch's t statistic of the two means.
+  double t = 0;
+  Verdict verdict = Verdict::kUnchanged;
+  EL_PAD(7);
+};
+
+// A change is only reported when it is both larger than |noise| and
+// statistically significant.
+auto compare(const BaselineEntry& baseline,
+             const BaselineEntry& current,
+             double noise = kDefaultNoiseThreshold) -> Comparison;
+
+}  // namespace el::bench
@@ -0,0 +1,484 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "bench/micro/harness.h"
+#include "bench/stats.h"
+#include "src/ecs/world.h"
+#include "src/engine/deletion_queue.h"
+#include "src/engine/device.h"
+#include "src/engine/draw_list.h"
+#include "src/engine/error.h"
+#include "src/engine/swapchain.h"
+#include "src/event_service.h"
+#include "src/job_system.h"
+#include "src/pad.h"
+
+namespace {
+
+namespace bench = el::bench;
+namespace engine = el::engine;
+
+constexpr uint64_t kListenersPerService = 64;
+constexpr size_t kEmitListeners = 8;
+constexpr size_t kDeletersPerFrame = 64;
+constexpr size_t kDrawListSize = 4096;
+constexpr size_t kEntities = 65536;
+constexpr size_t kParallelItems = 1024;
+constexpr size_t kParallelGrain = 64;
+constexpr size_t kAllocSize = 64;
+
+struct Position {
+  float x = 0;
+  float y = 0;
+  float z = 0;
+};
+
+struct Velocity {
+  float x = 0;
+  float y = 0;
+  float z = 0;
+};
+
+struct Options {
+  std::string filter;
+  std::string baseline;
+  std::string save_baseline;
+  std::string device_name;
+  bench::MicroConfig config;
+  bool vulkan = false;
+  EL_PAD(7);
+};
+
+auto usage(std::string_view name) -> void {
+  std::cerr
+      << "Usage: " << name << " [options]\n"
+      << "  --filter <text>          only run benchmarks containing <text>\n"
+      << "  --repetitions <n>        measured repetitions, default "
+      << bench::kDefaultRepetitions << "\n"
+      << "  --warmup <n>             discarded repetitions, default "
+      << bench::kDefaultWarmupRepetitions << "\n"
+      << "  --min-time-ms <ms>       minimum time per repetition, default "
+      << bench::kDefaultMinTimeMs << "\n"
+      << "  --baseline <file>        compare against a saved baseline and\n"
+      << "                           exit with 2 on significant slowdowns\n"
+      << "  --save-baseline <file>   save this run as a baseline\n"
+      << "  --vulkan                 also run benchmarks needing a device\n"
+      << "  --device <name>          only use devices whose name contains\n"
+      << "                           <name>, e.g. llvmpipe\n";
+}
+
+auto parse(std::span<char*> args) -> Options {
+  Options opts;
+  for (size_t i = 1; i < args.size(); ++i) {
+    std::string_view arg(args[i]);
+    if (arg == "--vulkan") {
+      opts.vulkan = true;
+      continue;
+    }
+    if (i + 1 == args.size()) {
+      throw std::runtime_error(std::string("Missing value for ").append(arg));
+    }
+    std::string value(args[++i]);
+    if (arg == "--filter") {
+      opts.filter = value;
+    } else if (arg == "--repetitions") {
+      opts.config.set_repetitions(uint32_t(std::stoul(value)));
+    } else if (arg == "--warmup") {
+      opts.config.set_warmup_repetitions(uint32_t(std::stoul(value)));
+    } else if (arg == "--min-time-ms") {
+      opts.config.set_min_time_ms(std::stod(value));
+    } else if (arg == "--baseline") {
+      opts.baseline = value;
+    } else if (arg == "--save-baseline") {
+      opts.save_baseline = value;
+    } else if (arg == "--device") {
+      opts.device_name = value;
+    } else {
+      throw std::runtime_error(std::string("Unknown option: ").append(arg));
+    }
+  }
+  return opts;
+}
+
+// Adds listeners, including the amortized teardown of a service every
+// kListenersPerService adds.
+auto event_add() -> bench::Micro {
+  return {"event_service/add", [](uint64_t iterations) {
+            auto service = std::make_unique<el::EventService>();
+            for (uint64_t i = 0; i < iterations; ++i) {
+              if (i % kListenersPerService == 0) {
+                service = std::make_unique<el::EventService>();
+              }
+              service->add(el::EventType::kKey,
+                           [](const el::Event* evt) {
+                             bench::do_not_optimize(evt);
+                           });
+            }
+          }};
+}
+
+// Emits to kEmitListeners listeners, the iterations split over |threads|
+// threads contending for the service's lock.
+auto event_emit(uint32_t threads) -> bench::Micro {
+  auto service = std::make_shared<el::EventService>();
+  for (size_t i = 0; i < kEmitListeners; ++i) {
+    service->add(el::EventType::kKey, [](const el::Event* evt) {
+      bench::do_not_optimize(evt);
+    });
+  }
+
+  return {"event_service/emit/threads:" + std::to_string(threads),
+          [service, threads = uint64_t{threads}](uint64_t iterations) {
+            auto emit = [&service](uint64_t count) {
+              el::Event evt;
+              for (uint64_t i = 0; i < count; ++i) {
+                service->emit(el::EventType::kKey, &evt);
+              }
+            };
+
+            std::vector<std::thread> workers;
+            for (uint64_t t = 1; t < threads; ++t) {
+              workers.emplace_back(emit, iterations / threads);
+            }
+            emit(iterations - iterations / threads * (threads - 1));
+            std::for_each(std::begin(workers), std::end(workers),
+                          [](std::thread& w) { w.join(); });
+          }};
+}
+
+// A validation message with labels and objects, as the layers send them.
+struct DebugMessage {
+  std::array<VkDebugUtilsLabelEXT, 2> labels = {};
+  std::array<VkDebugUtilsObjectNameInfoEXT, 2> objects = {};
+  VkDebugUtilsMessengerCallbackDataEXT data = {};
+};
+
+auto make_debug_message() -> std::shared_ptr<DebugMessage> {
+  auto msg = std::make_shared<DebugMessage>();
+  msg->labels = {{
+      {.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT,
+       .pLabelName = "graphics"},
+      {.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT,
+       .pLabelName = "shadow pass"},
+  }};
+  msg->objects = {{
+      {.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
+       .objectType = VK_OBJECT_TYPE_COMMAND_BUFFER,
+       .objectHandle = 0x1234,
+       .pObjectName = "frame commands"},
+      {.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
+       .objectType = VK_OBJECT_TYPE_IMAGE,
+       .objectHandle = 0x5678,
+       .pObjectName = nullptr},
+  }};
+  msg->data = {
+      .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CALLBACK_DATA_EXT,
+      .pMessageIdName = "VUID-vkCmdDraw-None-02699",
+      .messageIdNumber = 0x1bd1,
+      .pMessage = "Validation Error: descriptor set 0 binding 1 was never "
+                  "updated before being used by the draw.",
+      .queueLabelCount = 1,
+      .pQueueLabels = &msg->labels[0],
+      .cmdBufLabelCount = 1,
+      .pCmdBufLabels = &msg->labels[1],
+      .objectCount = uint32_t(msg->objects.size()),
+      .pObjects = msg->objects.data(),
+  };
+  return msg;
+}
+
+// The messenger callback, formatting into an Error for a listener or
+// returning early without one.
+auto debug_format(bool listener) -> bench::Micro {
+  auto msg = make_debug_message();
+  auto err_data = std::make_shared<engine::ErrorData>();
+  if (listener) {
+    err_data->cb = [](const engine::Error& e) {
+      bench::do_not_optimize(e.message.size());
+    };
+  }
+
+  return {listener ? "debug_callback/format" : "debug_callback/no_listener",
+          [msg, err_data](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+              engine::debug_callback(
+                  VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT,
+                  VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT, &msg->data,
+                  err_data.get());
+            }
+          }};
+}
+
+// A frame's worth of deferred destruction, queued and collected.
+auto deletion_queue() -> bench::Micro {
+  return {"deletion_queue/push_collect:" + std::to_string(kDeletersPerFrame),
+          [](uint64_t iterations) {
+            engine::DeletionQueue queue;
+            for (uint64_t i = 0; i < iterations; ++i) {
+              for (size_t d = 0; d < kDeletersPerFrame; ++d) {
+                queue.push(i, [&queue]() { bench::do_not_optimize(queue); });
+              }
+              queue.collect(i);
+            }
+          }};
+}
+
+// Collecting and sorting a frame's draws with random keys.
+auto draw_list() -> bench::Micro {
+  std::mt19937 rng(1);
+  auto keys = std::make_shared<std::vector<engine::DrawKey>>(kDrawListSize);
+  std::generate(std::begin(*keys), std::end(*keys), [&rng]() {
+    return engine::DrawKey{.pass = uint16_t(rng() % 4),
+                           .pipeline = uint16_t(rng() % 32),
+                           .material = uint16_t(rng() % 256),
+                           .mesh = uint16_t(rng() % 1024),
+                           .depth = uint16_t(rng())};
+  });
+  auto list = std::make_shared<engine::DrawList>();
+
+  return {"draw_list/add_sort:" + std::to_string(kDrawListSize),
+          [keys, list](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+              list->clear();
+              for (uint32_t k = 0; k < keys->size(); ++k) {
+                list->add((*keys)[k], k);
+              }
+              list->sort();
+              bench::do_not_optimize(list->batches().size());
+            }
+          }};
+}
+
+// Entity churn through the archetype chunk allocator.
+auto ecs_create_destroy() -> bench::Micro {
+  return {"ecs/create_destroy", [](uint64_t iterations) {
+            el::ecs::World world;
+            for (uint64_t i = 0; i < iterations; ++i) {
+              world.destroy(world.create(Position{}, Velocity{}));
+            }
+          }};
+}
+
+// One system update over every entity.
+auto ecs_each() -> bench::Micro {
+  auto world = std::make_shared<el::ecs::World>();
+  for (size_t i = 0; i < kEntities; ++i) {
+    world->create(Position{}, Velocity{.x = 1, .y = 2, .z = 3});
+  }
+
+  return {"ecs/each:" + std::to_string(kEntities),
+          [world](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+              world->each<Position, const Velocity>(
+                  [](Position& p, const Velocity& v) {
+                    p.x += v.x;
+                    p.y += v.y;
+                    p.z += v.z;
+                  });
+            }
+          }};
+}
+
+// Fork and join overhead of the job system, with empty jobs.
+auto parallel_for(el::JobSystem* jobs) -> bench::Micro {
+  return {"job_system/parallel_for:" + std::to_string(kParallelItems),
+          [jobs](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+              jobs->parallel_for(kParallelItems, kParallelGrain,
+                                 [](size_t begin, size_t end) {
+                                   bench::do_not_optimize(begin + end);
+                                 });
+            }
+          }};
+}
+
+// The general purpose allocator, for scale against the engine's own.
+auto new_delete() -> bench::Micro {
+  return {"alloc/new_delete:" + std::to_string(kAllocSize),
+          [](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+              auto p = std::make_unique<std::array<std::byte, kAllocSize>>();
+              bench::do_not_optimize(p.get());
+            }
+          }};
+}
+
+auto has_instance_extension(std::string_view name) -> bool {
+  uint32_t count = 0;
+  vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
+  std::vector<VkExtensionProperties> exts(count);
+  vkEnumerateInstanceExtensionProperties(nullptr, &count, exts.data());
+  return std::any_of(std::begin(exts), std::end(exts),
+                     [name](const VkExtensionProperties& ext) {
+                       return name == static_cast<const char*>(
+                                          ext.extensionName);
+                     });
+}
+
+// Startup probing of a device. With VK_EXT_headless_surface the device gets
+// a surface, so the swapchain support queries can be measured as well.
+auto device_probes(engine::Device* device) -> std::vector<bench::Micro> {
+  std::vector<bench::Micro> micros = {
+      {"device/probe_queue_families", [device](uint64_t iterations) {
+         for (uint64_t i = 0; i < iterations; ++i) {
+           bench::do_not_optimize(engine::Device::probe_queue_families(
+               device->physical_device(), device->surface()));
+         }
+       }}};
+  if (!device->headless()) {
+    micros.push_back(
+        {"swapchain/query_support", [device](uint64_t iterations) {
+           for (uint64_t i = 0; i < iterations; ++i) {
+             bench::do_not_optimize(engine::Swapchain::query_swap_chain_support(
+                 device->physical_device(), device->surface()));
+           }
+         }});
+  }
+  return micros;
+}
+
+auto create_device(const Options& opts, el::EventService* events)
+    -> std::unique_ptr<engine::Device> {
+  auto config = engine::DeviceConfig()
+                    .set_app_name("Elysian micro bench")
+                    .set_device_name(opts.device_name)
+                    .set_event_service(events)
+                    .set_dimensions_cb([]() -> el::Dimensions {
+                      return {.width = 1, .height = 1};
+                    });
+
+  if (has_instance_extension(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME)) {
+    config.set_device_extensions({VK_KHR_SURFACE_EXTENSION_NAME,
+                                  VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME});
+    config.set_surface_cb([](engine::Device& d) {
+      d.create_surface([](VkInstance instance) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        auto create = reinterpret_cast<PFN_vkCreateHeadlessSurfaceEXT>(
+            vkGetInstanceProcAddr(instance, "vkCreateHeadlessSurfaceEXT"));
+        VkHeadlessSurfaceCreateInfoEXT create_info = {
+            .sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT,
+        };
+        VkSurfaceKHR surface = VK_NULL_HANDLE;
+        auto res = create(instance, &create_info, nullptr, &surface);
+        if (res != VK_SUCCESS) {
+          throw std::runtime_error(
+              std::string("Failed to create headless surface: ")
+                  .append(to_string(res)));
+        }
+        return surface;
+      });
+    });
+  }
+  return std::make_unique<engine::Device>(config);
+}
+
+auto report(const bench::MicroResult& result,
+            const bench::Baseline& baseline,
+            bool compare) -> bool {
+  auto ns = bench::summarize(result.ns_per_op);
+  auto cycles = bench::summarize(result.cycles_per_op);
+  auto current = bench::baseline_entry(result);
+
+  std::cout << std::left << std::setw(40) << result.name << std::right
+            << std::setw(12) << result.iterations << std::fixed
+            << std::setprecision(2) << std::setw(12) << ns.mean
+            << std::setw(12) << ns.p50 << std::setw(10)
+            << (ns.mean > 0 ? 100.0 * current.stddev / ns.mean : 0.0)
+            << std::setw(12) << cycles.p50;
+
+  auto slower = false;
+  if (compare) {
+    auto it = baseline.find(result.name);
+    if (it == baseline.end()) {
+      std::cout << "  new";
+    } else {
+      auto cmp = bench::compare(it->second, current);
+      std::cout << std::setw(10) << std::showpos << 100.0 * cmp.change
+                << std::noshowpos << "%  " << bench::to_string(cmp.verdict);
+      slower = cmp.verdict == bench::Verdict::kSlower;
+    }
+  }
+  std::cout << "\n";
+  return slower;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+  std::span args(argv, size_t(argc));
+  Options opts;
+  try {
+    opts = parse(args);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    usage(args[0]);
+    return 1;
+  }
+
+  auto slower = false;
+  try {
+    el::JobSystem jobs;
+    std::vector<bench::Micro> micros = {event_add()};
+    auto max_threads = std::max(2U, std::thread::hardware_concurrency());
+    for (uint32_t threads = 1; threads <= max_threads; threads *= 2) {
+      micros.push_back(event_emit(threads));
+    }
+    micros.push_back(debug_format(true));
+    micros.push_back(debug_format(false));
+    micros.push_back(deletion_queue());
+    micros.push_back(draw_list());
+    micros.push_back(ecs_create_destroy());
+    micros.push_back(ecs_each());
+    micros.push_back(parallel_for(&jobs));
+    micros.push_back(new_delete());
+
+    el::EventService events;
+    std::unique_ptr<engine::Device> device;
+    if (opts.vulkan) {
+      device = create_device(opts, &events);
+      auto probes = device_probes(device.get());
+      micros.insert(std::end(micros), std::begin(probes), std::end(probes));
+    }
+
+    auto compare = !opts.baseline.empty();
+    auto baseline =
+        compare ? bench::read_baseline(opts.baseline) : bench::Baseline{};
+
+    std::cout << opts.config.repetitions() << " repetitions of at least "
+              << opts.config.min_time_ms() << " ms\n\n"
+              << std::left << std::setw(40) << "benchmark" << std::right
+              << std::setw(12) << "iterations" << std::setw(12) << "mean ns"
+              << std::setw(12) << "p50 ns" << std::setw(10) << "cv %"
+              << std::setw(12) << "p50 cycles"
+              << (compare ? "    change" : "") << "\n";
+
+    std::vector<bench::MicroResult> results;
+    for (const auto& micro : micros) {
+      if (micro.name.find(opts.filter) == std::string::npos) {
+        continue;
+      }
+      results.push_back(bench::run_micro(opts.config, micro));
+      slower = report(results.back(), baseline, compare) || slower;
+    }
+
+    if (!opts.save_baseline.empty()) {
+      bench::write_baseline(opts.save_baseline, results);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Exception: " << e.what() << "\n";
+    return 1;
+  }
+  return slower ? 2 : 0;
+}
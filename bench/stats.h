@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <ostream>
+#include <vector>
+
+#include <sys/resource.h>
+
+namespace el::bench {
+
+struct Summary {
+  size_t count = 0;
+  double mean = 0;
+  double min = 0;
+  double max = 0;
+  double p50 = 0;
+  double p95 = 0;
+  double p99 = 0;
+};
+
+// Nearest rank percentile |p|, in [0, 100], of ascending |sorted| samples.
+inline auto percentile(const std::vector<double>& sorted, double p) -> double {
+  if (sorted.empty()) {
+    return 0;
+  }
+  auto rank = size_t(std::ceil(p / 100.0 * double(sorted.size())));
+  return sorted.at(std::clamp(rank, size_t{1}, sorted.size()) - 1);
+}
+
+inline auto summarize(std::vector<double> samples) -> Summary {
+  if (samples.empty()) {
+    return {};
+  }
+  std::sort(std::begin(samples), std::end(samples));
+  return {
+      .count = samples.size(),
+      .mean = std::accumulate(std::begin(samples), std::end(samples), 0.0) /
+              double(samples.size()),
+      .min = samples.front(),
+      .max = samples.back(),
+      .p50 = percentile(samples, 50),
+      .p95 = percentile(samples, 95),
+      .p99 = percentile(samples, 99),
+  };
+}
+
+// Writes |s| as a JSON object.
+inline auto write_json(std::ostream& out, const Summary& s) -> void {
+  out << "{\"count\": " << s.count << ", \"mean\": " << s.mean
+      << ", \"min\": " << s.min << ", \"max\": " << s.max
+      << ", \"p50\": " << s.p50 << ", \"p95\": " << s.p95
+      << ", \"p99\": " << s.p99 << "}";
+}
+
+// Peak resident set size of the process so far, in KiB.
+inline auto peak_rss_kib() -> long {
+  rusage usage = {};
+  getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+  // Reported in bytes on macOS.
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+}  // namespace el::bench
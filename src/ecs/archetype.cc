@@ -0,0 +1,154 @@
+#include "src/ecs/archetype.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+namespace el::ecs {
+namespace {
+
+// Plain arrays so registration needs no static constructors or destructors.
+// Each slot is written once, before its id is published through the
+// function local static in component_id().
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::array<ComponentInfo, kMaxComponents> g_components = {};
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::atomic<uint32_t> g_component_count = 0;
+
+constexpr auto align_up(size_t value, size_t alignment) -> size_t {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+auto register_component(ComponentInfo info) -> ComponentId {
+  auto id = g_component_count.fetch_add(1);
+  if (id >= kMaxComponents) {
+    throw std::runtime_error(std::string("Too many component types, max ")
+                                 .append(std::to_string(kMaxComponents)));
+  }
+  g_components.at(id) = info;
+  return id;
+}
+
+auto component_info(ComponentId id) -> ComponentInfo {
+  return g_components.at(id);
+}
+
+Archetype::Archetype(Signature signature) : signature_(signature) {
+  size_t row_size = sizeof(Entity);
+  for (ComponentId id = 0; id < kMaxComponents; ++id) {
+    if (signature_.test(id)) {
+      auto info = component_info(id);
+      columns_.push_back({.id = id, .offset = 0, .size = info.size});
+      row_size += info.size;
+    }
+  }
+
+  // Start from the unpadded fit and shrink until the aligned columns fit.
+  auto layout = [this](size_t capacity) {
+    auto offset = capacity * sizeof(Entity);
+    for (auto& c : columns_) {
+      offset = align_up(offset, component_info(c.id).alignment);
+      c.offset = uint32_t(offset);
+      offset += capacity * c.size;
+    }
+    return offset;
+  };
+  auto capacity = kChunkSize / row_size;
+  while (capacity > 1 && layout(capacity) > kChunkSize) {
+    --capacity;
+  }
+  if (layout(capacity) > kChunkSize) {
+    throw std::runtime_error("Archetype row does not fit in a chunk");
+  }
+  capacity_ = uint32_t(capacity);
+}
+
+auto Archetype::allocate(Entity entity) -> Location {
+  if (chunks_.empty() || chunks_.back().count == capacity_) {
+    chunks_.push_back({.storage = std::make_unique_for_overwrite<Storage>()});
+  }
+
+  auto location = Location{
+      .chunk = uint32_t(chunks_.size() - 1),
+      .row = chunks_.back().count++,
+  };
+  set_entity(location, entity);
+  return location;
+}
+
+auto Archetype::remove(Location location) -> std::optional<Entity> {
+  auto last = Location{
+      .chunk = uint32_t(chunks_.size() - 1),
+      .row = chunks_.back().count - 1,
+  };
+
+  std::optional<Entity> moved;
+  if (last.chunk != location.chunk || last.row != location.row) {
+    moved = entities(last.chunk)[last.row];
+    set_entity(location, *moved);
+    for (const auto& c : columns_) {
+      auto src = component(last, c.id);
+      std::copy(std::begin(src), std::end(src),
+                std::begin(component(location, c.id)));
+    }
+  }
+
+  if (--chunks_.back().count == 0) {
+    chunks_.pop_back();
+  }
+  return moved;
+}
+
+auto Archetype::copy_to(Location src, Archetype* dst, Location dst_location)
+    const -> void {
+  for (const auto& c : columns_) {
+    if (dst->has(c.id)) {
+      auto from = component(src, c.id);
+      std::copy(std::begin(from), std::end(from),
+                std::begin(dst->component(dst_location, c.id)));
+    }
+  }
+}
+
+auto Archetype::entities(size_t chunk) const -> std::span<const Entity> {
+  const auto& c = chunks_.at(chunk);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return {reinterpret_cast<const Entity*>(c.storage->bytes.data()), c.count};
+}
+
+auto Archetype::column(size_t chunk, ComponentId id) const
+    -> std::span<std::byte> {
+  const auto& c = find(id);
+  return std::span(chunks_.at(chunk).storage->bytes)
+      .subspan(c.offset, size_t{capacity_} * c.size);
+}
+
+auto Archetype::component(Location location, ComponentId id) const
+    -> std::span<std::byte> {
+  const auto& c = find(id);
+  return column(location.chunk, id).subspan(size_t{location.row} * c.size,
+                                            c.size);
+}
+
+auto Archetype::set_entity(Location location, Entity entity) -> void {
+  auto src = std::as_bytes(std::span(&entity, 1));
+  auto dst = std::span(chunks_.at(location.chunk).storage->bytes)
+                 .subspan(size_t{location.row} * sizeof(Entity));
+  std::copy(std::begin(src), std::end(src), std::begin(dst));
+}
+
+auto Archetype::find(ComponentId id) const -> const Column& {
+  auto it = std::lower_bound(
+      std::begin(columns_), std::end(columns_), id,
+      [](const Column& c, ComponentId value) { return c.id < value; });
+  if (it == std::end(columns_) || it->id != id) {
+    throw std::runtime_error(
+        std::string("Archetype has no component ").append(std::to_string(id)));
+  }
+  return *it;
+}
+
+}  // namespace el::ecs
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "src/pad.h"
+
+namespace el::ecs {
+
+// Small enough for a chunk to stay cache resident while a query walks it,
+// large enough to amortize the per chunk work of queries.
+constexpr size_t kChunkSize = size_t{16} * 1024;
+constexpr size_t kChunkAlignment = 64;
+constexpr size_t kMaxComponents = 64;
+
+using ComponentId = uint32_t;
+using Signature = std::bitset<kMaxComponents>;
+
+struct Entity {
+  uint32_t index = 0;
+  uint32_t generation = 0;
+
+  auto operator==(const Entity&) const -> bool = default;
+};
+
+struct ComponentInfo {
+  uint32_t size = 0;
+  uint32_t alignment = 0;
+};
+
+// Hands out process wide component ids. Throws past kMaxComponents types.
+auto register_component(ComponentInfo info) -> ComponentId;
+auto component_info(ComponentId id) -> ComponentInfo;
+
+// Components are plain data, moved between chunks with memcpy and never
+// constructed or destroyed.
+template <typename T>
+auto component_id() -> ComponentId {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Components must be trivially copyable");
+  static_assert(std::is_same_v<T, std::remove_cvref_t<T>>);
+  static_assert(alignof(T) <= kChunkAlignment);
+  static const ComponentId id =
+      register_component({.size = sizeof(T), .alignment = alignof(T)});
+  return id;
+}
+
+template <typename... Ts>
+auto signature_of() -> Signature {
+  Signature signature;
+  (signature.set(component_id<std::remove_const_t<Ts>>()), ...);
+  return signature;
+}
+
+// Where an entity's components live within its archetype.
+struct Location {
+  uint32_t chunk = 0;
+  uint32_t row = 0;
+};
+
+// Every entity with exactly the same set of components. Rows are stored in
+// fixed size chunks, each laid out as one array of Entity followed by one
+// array per component, so queries read each column linearly. Rows are kept
+// dense: removal moves the archetype's last row into the hole.
+class Archetype {
+ public:
+  explicit Archetype(Signature signature);
+  Archetype(const Archetype&) = delete;
+  Archetype(Archetype&&) = delete;
+  ~Archetype() = default;
+
+  auto operator=(const Archetype&) -> Archetype& = delete;
+  auto operator=(Archetype&&) -> Archetype& = delete;
+
+  // Appends an uninitialized row for |entity|.
+  auto allocate(Entity entity) -> Location;
+
+  // Removes the row at |location|. Returns the entity moved into it to keep
+  // the rows dense, if any.
+  auto remove(Location location) -> std::optional<Entity>;
+
+  // Copies the components |dst| also has from |src| to |dst_location|.
+  auto copy_to(Location src, Archetype* dst, Location dst_location) const
+      -> void;
+
+  [[nodiscard]] auto signature() const -> const Signature& {
+    return signature_;
+  }
+  [[nodiscard]] auto has(ComponentId id) const -> bool {
+    return signature_.test(id);
+  }
+  // Rows per chunk.
+  [[nodiscard]] auto capacity() const -> uint32_t { return capacity_; }
+  [[nodiscard]] auto chunk_count() const -> size_t { return chunks_.size(); }
+  [[nodiscard]] auto row_count(size_t chunk) const -> uint32_t {
+    return chunks_.at(chunk).count;
+  }
+
+  [[nodiscard]] auto entities(size_t chunk) const -> std::span<const Entity>;
+
+  // The whole column of |id| in |chunk|, capacity() elements.
+  [[nodiscard]] auto column(size_t chunk, ComponentId id) const
+      -> std::span<std::byte>;
+
+  // The occupied rows of T's column in |chunk|. T may be const.
+  template <typename T>
+  [[nodiscard]] auto column(size_t chunk) const -> std::span<T> {
+    auto bytes = column(chunk, component_id<std::remove_const_t<T>>());
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return {reinterpret_cast<T*>(bytes.data()), row_count(chunk)};
+  }
+
+  [[nodiscard]] auto component(Location location, ComponentId id) const
+      -> std::span<std::byte>;
+
+ private:
+  struct alignas(kChunkAlignment) Storage {
+    std::array<std::byte, kChunkSize> bytes;
+  };
+  struct Chunk {
+    std::unique_ptr<Storage> storage;
+    uint32_t count = 0;
+    EL_PAD(4);
+  };
+  struct Column {
+    ComponentId id = 0;
+    uint32_t offset = 0;
+    uint32_t size = 0;
+  };
+
+  auto set_entity(Location location, Entity entity) -> void;
+  [[nodiscard]] auto find(ComponentId id) const -> const Column&;
+
+  Signature signature_;
+  std::vector<Column> columns_;
+  std::vector<Chunk> chunks_;
+  uint32_t capacity_ = 0;
+  EL_PAD(4);
+};
+
+}  // namespace el::ecs
@@ -0,0 +1,101 @@
+#include "src/ecs/world.h"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace el::ecs {
+
+auto World::destroy(Entity entity) -> void {
+  auto& r = record(entity);
+  relocate(r.archetype->remove({r.chunk, r.row}), {r.chunk, r.row});
+
+  // The stale record is left in place, the bumped generation is what marks
+  // it dead.
+  ++r.generation;
+  r.archetype = nullptr;
+  free_.push_back(entity.index);
+  --size_;
+}
+
+auto World::alive(Entity entity) const -> bool {
+  return entity.index < records_.size() &&
+         records_[entity.index].archetype != nullptr &&
+         records_[entity.index].generation == entity.generation;
+}
+
+auto World::throw_duplicate_component() -> void {
+  throw std::runtime_error("Entity created with a duplicate component");
+}
+
+auto World::archetype(const Signature& signature) -> Archetype* {
+  auto it = by_signature_.find(signature);
+  if (it != std::end(by_signature_)) {
+    return it->second;
+  }
+
+  archetypes_.push_back(std::make_unique<Archetype>(signature));
+  auto* a = archetypes_.back().get();
+  by_signature_.emplace(signature, a);
+  return a;
+}
+
+auto World::allocate(Archetype* archetype) -> Entity {
+  Entity entity;
+  if (free_.empty()) {
+    entity.index = uint32_t(records_.size());
+    records_.emplace_back();
+  } else {
+    entity.index = free_.back();
+    free_.pop_back();
+  }
+
+  auto& r = records_.at(entity.index);
+  entity.generation = r.generation;
+  auto location = archetype->allocate(entity);
+  r.archetype = archetype;
+  r.chunk = location.chunk;
+  r.row = location.row;
+  ++size_;
+  return entity;
+}
+
+auto World::move(Entity entity, const Signature& signature) -> void {
+  auto& r = record(entity);
+  auto* src = r.archetype;
+  auto* dst = archetype(signature);
+  if (src == dst) {
+    return;
+  }
+
+  auto from = Location{r.chunk, r.row};
+  auto to = dst->allocate(entity);
+  src->copy_to(from, dst, to);
+  r.archetype = dst;
+  r.chunk = to.chunk;
+  r.row = to.row;
+  relocate(src->remove(from), from);
+}
+
+auto World::relocate(std::optional<Entity> moved, Location location) -> void {
+  if (moved) {
+    auto& r = records_.at(moved->index);
+    r.chunk = location.chunk;
+    r.row = location.row;
+  }
+}
+
+auto World::record(Entity entity) const -> const Record& {
+  if (!alive(entity)) {
+    throw std::runtime_error(std::string("Entity is not alive: ")
+                                 .append(std::to_string(entity.index)));
+  }
+  return records_[entity.index];
+}
+
+auto World::record(Entity entity) -> Record& {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  return const_cast<Record&>(std::as_const(*this).record(entity));
+}
+
+}  // namespace el::ecs
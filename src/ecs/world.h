@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/ecs/archetype.h"
+#include "src/job_system.h"
+#include "src/pad.h"
+
+namespace el::ecs {
+
+// Entities and their components, grouped into archetypes by component set.
+//
+// Queries walk every archetype holding at least the requested components,
+// chunk by chunk, handing out contiguous spans of each component. Adding or
+// removing components moves an entity between archetypes, so structural
+// changes must not happen while a query runs.
+class World {
+ public:
+  World() = default;
+  World(const World&) = delete;
+  World(World&&) = delete;
+  ~World() = default;
+
+  auto operator=(const World&) -> World& = delete;
+  auto operator=(World&&) -> World& = delete;
+
+  template <typename... Ts>
+  auto create(const Ts&... components) -> Entity {
+    auto signature = signature_of<Ts...>();
+    if (signature.count() != sizeof...(Ts)) {
+      throw_duplicate_component();
+    }
+    auto entity = allocate(archetype(signature));
+    (write(entity, components), ...);
+    return entity;
+  }
+
+  // Throws if |entity| was already destroyed, as do the methods below.
+  auto destroy(Entity entity) -> void;
+
+  [[nodiscard]] auto alive(Entity entity) const -> bool;
+
+  // nullptr when |entity| has no T. Invalidated by structural changes.
+  template <typename T>
+  [[nodiscard]] auto get(Entity entity) -> T* {
+    const auto& r = record(entity);
+    auto id = component_id<T>();
+    if (!r.archetype->has(id)) {
+      return nullptr;
+    }
+    auto bytes = r.archetype->component({r.chunk, r.row}, id);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return reinterpret_cast<T*>(bytes.data());
+  }
+
+  template <typename T>
+  [[nodiscard]] auto has(Entity entity) const -> bool {
+    return record(entity).archetype->has(component_id<T>());
+  }
+
+  // Adds T to |entity|, or overwrites it if already present.
+  template <typename T>
+  auto add(Entity entity, const T& component) -> void {
+    auto signature = record(entity).archetype->signature();
+    move(entity, signature.set(component_id<T>()));
+    write(entity, component);
+  }
+
+  template <typename T>
+  auto remove(Entity entity) -> void {
+    auto signature = record(entity).archetype->signature();
+    move(entity, signature.reset(component_id<T>()));
+  }
+
+  // Calls |fn| with (std::span<const Entity>, std::span<Ts>...) for every
+  // chunk holding all of Ts. Components are read only when Ts is const.
+  template <typename... Ts, typename Fn>
+  auto each_chunk(Fn&& fn) -> void {
+    auto signature = signature_of<Ts...>();
+    for (const auto& a : archetypes_) {
+      if ((a->signature() & signature) == signature) {
+        for (size_t i = 0; i < a->chunk_count(); ++i) {
+          fn(a->entities(i), a->template column<Ts>(i)...);
+        }
+      }
+    }
+  }
+
+  // Like each_chunk() but spreads the chunks over |jobs|. |fn| is called
+  // concurrently and must only write the spans it is handed.
+  template <typename... Ts, typename Fn>
+  auto parallel_each_chunk(JobSystem* jobs, Fn&& fn) -> void {
+    auto signature = signature_of<Ts...>();
+    std::vector<std::pair<const Archetype*, size_t>> chunks;
+    for (const auto& a : archetypes_) {
+      if ((a->signature() & signature) == signature) {
+        for (size_t i = 0; i < a->chunk_count(); ++i) {
+          chunks.emplace_back(a.get(), i);
+        }
+      }
+    }
+    jobs->parallel_for(chunks.size(), 1, [&chunks, &fn](size_t b, size_t e) {
+      for (auto i = b; i < e; ++i) {
+        const auto& [a, chunk] = chunks[i];
+        fn(a->entities(chunk), a->template column<Ts>(chunk)...);
+      }
+    });
+  }
+
+  // Calls |fn| with (Ts&...) for every entity holding all of Ts.
+  template <typename... Ts, typename Fn>
+  auto each(Fn&& fn) -> void {
+    each_chunk<Ts...>(
+        [&fn](std::span<const Entity> entities, std::span<Ts>... columns) {
+          for (size_t i = 0; i < entities.size(); ++i) {
+            fn(columns[i]...);
+          }
+        });
+  }
+
+  // Number of live entities.
+  [[nodiscard]] auto size() const -> size_t { return size_; }
+  [[nodiscard]] auto archetype_count() const -> size_t {
+    return archetypes_.size();
+  }
+
+ private:
+  struct Record {
+    Archetype* archetype = nullptr;
+    uint32_t chunk = 0;
+    uint32_t row = 0;
+    uint32_t generation = 0;
+    EL_PAD(4);
+  };
+
+  [[noreturn]] static auto throw_duplicate_component() -> void;
+
+  // Finds or creates the archetype for |signature|.
+  auto archetype(const Signature& signature) -> Archetype*;
+  auto allocate(Archetype* archetype) -> Entity;
+  // Moves |entity| to the archetype for |signature|, keeping the components
+  // both have.
+  auto move(Entity entity, const Signature& signature) -> void;
+  // Points the record of the entity stored at |location| there, after
+  // Archetype::remove() moved it.
+  auto relocate(std::optional<Entity> moved, Location location) -> void;
+
+  [[nodiscard]] auto record(Entity entity) const -> const Record&;
+  [[nodiscard]] auto record(Entity entity) -> Record&;
+
+  template <typename T>
+  auto write(Entity entity, const T& component) -> void {
+    *get<T>(entity) = component;
+  }
+
+  std::vector<std::unique_ptr<Archetype>> archetypes_;
+  std::unordered_map<Signature, Archetype*> by_signature_;
+  std::vector<Record> records_;
+  // Destroyed entity indices, reused with a bumped generation.
+  std::vector<uint32_t> free_;
+  size_t size_ = 0;
+};
+
+}  // namespace el::ecs
@@ -1,6 +1,29 @@
 #pragma once
 
+#include "src/engine/asset_loader.h"
+#include "src/engine/buffer.h"
+#include "src/engine/clustered_lights.h"
+#include "src/engine/cpu_cull.h"
+#include "src/engine/descriptor_allocator.h"
 #include "src/engine/device.h"
+#include "src/engine/draw_list.h"
+#include "src/engine/dynamic_resolution.h"
 #include "src/engine/error.h"
+#include "src/engine/features.h"
+#include "src/engine/frame_sink.h"
+#include "src/engine/gpu_cull.h"
+#include "src/engine/gpu_timer.h"
+#include "src/engine/ktx2.h"
+#include "src/engine/lod.h"
+#include "src/engine/memory_budget.h"
+#include "src/engine/mesh.h"
+#include "src/engine/pack.h"
+#include "src/engine/particles.h"
+#include "src/engine/pipeline_registry.h"
+#include "src/engine/post_process.h"
+#include "src/engine/readback.h"
+#include "src/engine/residency.h"
 #include "src/engine/swapchain.h"
+#include "src/engine/texture.h"
+#include "src/engine/uploader.h"
 #include "src/engine/version.h"
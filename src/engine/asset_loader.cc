@@ -0,0 +1,376 @@
+#include "src/engine/asset_loader.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <stdexcept>
+
+#include "src/engine/io_ring.h"
+
+namespace el::engine {
+namespace {
+
+// Higher priority first, then first come first served.
+constexpr auto heap_order = [](const auto& a, const auto& b) {
+  if (a->request.priority != b->request.priority) {
+    return a->request.priority < b->request.priority;
+  }
+  return a->id > b->id;
+};
+
+}  // namespace
+
+struct AssetLoader::Load {
+  AssetId id = 0;
+  AssetRequest request;
+  std::vector<std::byte> storage;
+  std::span<std::byte> data;
+  // Bytes handed to reads so far.
+  uint64_t issued = 0;
+  uint32_t in_flight = 0;
+  int fd = -1;
+  std::atomic<bool> cancelled = false;
+  bool failed = false;
+  EL_PAD(6);
+};
+
+AssetLoader::AssetLoader(const AssetLoaderConfig& config)
+    : jobs_(config.jobs()) {
+  std::unique_ptr<IoRing> ring;
+  if (!config.disable_io_uring()) {
+    try {
+      ring = std::make_unique<IoRing>(config.queue_depth());
+    } catch (const std::runtime_error&) {
+      // Kernels without io_uring, or with it blocked by seccomp, fall back to
+      // blocking reads.
+    }
+  }
+
+  use_ring_ = ring != nullptr;
+  if (use_ring_) {
+    threads_.emplace_back(
+        [this, r = std::move(ring)]() { io_uring_loop(r.get()); });
+    return;
+  }
+
+  auto count = std::max(config.io_threads(), 1U);
+  for (uint32_t i = 0; i < count; ++i) {
+    threads_.emplace_back([this]() { pread_loop(); });
+  }
+}
+
+AssetLoader::~AssetLoader() {
+  {
+    const std::lock_guard<std::mutex> lock(lock_);
+    stop_ = true;
+    queue_.clear();
+    std::for_each(std::begin(loads_), std::end(loads_),
+                  [](const auto& entry) { entry.second->cancelled = true; });
+  }
+  work_cv_.notify_all();
+
+  std::for_each(std::begin(threads_), std::end(threads_),
+                [](std::thread& t) { t.join(); });
+
+  std::unique_lock<std::mutex> lock(lock_);
+  idle_cv_.wait(lock, [this]() { return decoding_ == 0; });
+}
+
+auto AssetLoader::load(AssetRequest request) -> AssetId {
+  auto load = std::make_shared<Load>();
+  load->request = std::move(request);
+
+  {
+    const std::lock_guard<std::mutex> lock(lock_);
+    load->id = next_id_++;
+    loads_.emplace(load->id, load);
+    queue_.push_back(load);
+    std::push_heap(std::begin(queue_), std::end(queue_), heap_order);
+  }
+  work_cv_.notify_one();
+  return load->id;
+}
+
+auto AssetLoader::cancel(AssetId id) -> void {
+  const std::lock_guard<std::mutex> lock(lock_);
+  auto it = loads_.find(id);
+  if (it != std::end(loads_)) {
+    it->second->cancelled = true;
+  }
+}
+
+auto AssetLoader::poll() -> void {
+  std::vector<std::shared_ptr<Load>> done;
+  {
+    const std::lock_guard<std::mutex> lock(lock_);
+    done.swap(done_);
+    std::for_each(std::begin(done), std::end(done),
+                  [this](const std::shared_ptr<Load>& load) {
+                    loads_.erase(load->id);
+                  });
+  }
+
+  std::for_each(std::begin(done), std::end(done),
+                [](const std::shared_ptr<Load>& load) {
+                  if (!load->request.ready) {
+                    return;
+                  }
+                  if (load->cancelled) {
+                    load->request.ready(AssetStatus::kCancelled, {});
+                  } else if (load->failed) {
+                    load->request.ready(AssetStatus::kFailed, {});
+                  } else {
+                    load->request.ready(AssetStatus::kLoaded, load->data);
+                  }
+                });
+}
+
+auto AssetLoader::next_load() -> std::shared_ptr<Load> {
+  while (!stop_ && !queue_.empty()) {
+    std::pop_heap(std::begin(queue_), std::end(queue_), heap_order);
+    auto load = std::move(queue_.back());
+    queue_.pop_back();
+
+    if (!load->cancelled) {
+      return load;
+    }
+    done_.push_back(std::move(load));
+  }
+  return nullptr;
+}
+
+auto AssetLoader::open(Load* load) -> bool {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  load->fd = ::open(load->request.path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (load->fd < 0) {
+    load->failed = true;
+    return false;
+  }
+
+  struct stat st = {};
+  if (fstat(load->fd, &st) != 0) {
+    load->failed = true;
+    return false;
+  }
+
+  auto file_size = static_cast<uint64_t>(st.st_size);
+  auto offset = load->request.offset;
+  auto size = load->request.size;
+  if (offset > file_size) {
+    load->failed = true;
+    return false;
+  }
+  if (size == 0) {
+    size = file_size - offset;
+  }
+  if (size > file_size - offset) {
+    load->failed = true;
+    return false;
+  }
+
+  if (load->request.destination.empty()) {
+    load->storage.resize(size);
+    load->data = load->storage;
+  } else if (load->request.destination.size() >= size) {
+    load->data = load->request.destination.first(size);
+  } else {
+    load->failed = true;
+    return false;
+  }
+
+  posix_fadvise(load->fd, static_cast<off_t>(offset),
+                static_cast<off_t>(size), POSIX_FADV_SEQUENTIAL);
+  return true;
+}
+
+auto AssetLoader::finish(const std::shared_ptr<Load>& load) -> void {
+  if (load->fd >= 0) {
+    close(load->fd);
+    load->fd = -1;
+  }
+
+  const std::lock_guard<std::mutex> lock(lock_);
+  if (load->failed || load->cancelled || !load->request.decode) {
+    done_.push_back(load);
+    return;
+  }
+
+  decoding_ += 1;
+  jobs_->submit([this, load]() {
+    if (!load->cancelled) {
+      load->request.decode(load->data);
+    }
+
+    const std::lock_guard<std::mutex> guard(lock_);
+    done_.push_back(load);
+    decoding_ -= 1;
+    if (decoding_ == 0) {
+      idle_cv_.notify_all();
+    }
+  });
+}
+
+auto AssetLoader::io_uring_loop(IoRing* ring) -> void {
+  struct Slot {
+    std::shared_ptr<Load> load;
+    iovec iov = {};
+    uint64_t offset = 0;
+  };
+
+  auto depth = ring->entries();
+  std::vector<Slot> slots(depth);
+  std::vector<uint32_t> free_slots(depth);
+  for (uint32_t i = 0; i < depth; ++i) {
+    free_slots[i] = depth - i - 1;
+  }
+
+  auto queue_read = [ring, &slots](uint32_t index) {
+    const auto& slot = slots[index];
+    if (!ring->read(slot.load->fd, &slot.iov, slot.offset, index)) {
+      throw std::runtime_error("io_uring submission queue overflow");
+    }
+  };
+
+  std::shared_ptr<Load> current;
+  std::vector<IoRing::Completion> completions;
+  uint32_t in_flight = 0;
+  for (;;) {
+    // Keep the queue full, moving on to the next load once every chunk of
+    // the current one is issued.
+    while (!free_slots.empty()) {
+      if (current == nullptr) {
+        std::unique_lock<std::mutex> lock(lock_);
+        if (in_flight == 0) {
+          work_cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+          if (stop_) {
+            return;
+          }
+        }
+        current = next_load();
+        if (current == nullptr) {
+          break;
+        }
+        lock.unlock();
+
+        if (!open(current.get())) {
+          finish(current);
+          current = nullptr;
+          continue;
+        }
+      }
+
+      if (current->cancelled) {
+        current->issued = current->data.size();
+      }
+      if (current->issued == current->data.size()) {
+        // The last completion finishes loads with reads still in flight.
+        if (current->in_flight == 0) {
+          finish(current);
+        }
+        current = nullptr;
+        continue;
+      }
+
+      auto index = free_slots.back();
+      free_slots.pop_back();
+
+      auto size = std::min(kAssetReadChunk,
+                           current->data.size() - current->issued);
+      auto& slot = slots[index];
+      slot.load = current;
+      slot.iov = {.iov_base = current->data.subspan(current->issued).data(),
+                  .iov_len = size};
+      slot.offset = current->request.offset + current->issued;
+      queue_read(index);
+
+      current->issued += size;
+      current->in_flight += 1;
+      in_flight += 1;
+    }
+
+    if (in_flight == 0) {
+      continue;
+    }
+
+    ring->submit(1);
+    completions.clear();
+    ring->reap(&completions);
+
+    for (const auto& completion : completions) {
+      auto index = static_cast<uint32_t>(completion.user_data);
+      auto& slot = slots[index];
+      auto result = completion.result;
+
+      if (result == -EAGAIN || result == -EINTR) {
+        queue_read(index);
+        continue;
+      }
+      if (result > 0 && static_cast<size_t>(result) < slot.iov.iov_len) {
+        // Short read, issue the rest.
+        auto read = static_cast<size_t>(result);
+        slot.iov.iov_base = static_cast<std::byte*>(slot.iov.iov_base) + read;
+        slot.iov.iov_len -= read;
+        slot.offset += read;
+        queue_read(index);
+        continue;
+      }
+
+      auto load = std::move(slot.load);
+      free_slots.push_back(index);
+      in_flight -= 1;
+      load->in_flight -= 1;
+
+      if (result <= 0) {
+        // Unexpected end of file or an I/O error; stop issuing reads.
+        load->failed = true;
+        load->issued = load->data.size();
+      }
+      if (load != current && load->in_flight == 0) {
+        finish(load);
+      }
+    }
+  }
+}
+
+auto AssetLoader::pread_loop() -> void {
+  for (;;) {
+    std::shared_ptr<Load> load;
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      work_cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (stop_) {
+        return;
+      }
+      load = next_load();
+      if (load == nullptr) {
+        continue;
+      }
+    }
+
+    if (open(load.get())) {
+      while (load->issued < load->data.size() && !load->cancelled) {
+        auto size =
+            std::min(kAssetReadChunk, load->data.size() - load->issued);
+        auto res = pread(load->fd, load->data.subspan(load->issued).data(),
+                         size,
+                         static_cast<off_t>(load->request.offset +
+                                            load->issued));
+        if (res < 0 && errno == EINTR) {
+          continue;
+        }
+        if (res <= 0) {
+          load->failed = true;
+          break;
+        }
+        load->issued += static_cast<uint64_t>(res);
+      }
+    }
+    finish(load);
+  }
+}
+
+}  // namespace el::engine
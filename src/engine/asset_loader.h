@@ -0,0 +1,157 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "src/job_system.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+class IoRing;
+
+// Reads are split into chunks of this size so a single large file keeps
+// several requests in flight.
+constexpr uint64_t kAssetReadChunk = uint64_t{1} * 1024 * 1024;
+constexpr uint32_t kDefaultAssetQueueDepth = 64;
+constexpr uint32_t kDefaultAssetIoThreads = 4;
+
+using AssetId = uint64_t;
+
+enum class AssetStatus : uint8_t {
+  kLoaded,
+  kCancelled,
+  kFailed,
+};
+
+// Runs on a JobSystem worker with the bytes read, before ready is called.
+using AssetDecode = std::function<void(std::span<std::byte> data)>;
+// Runs on the thread calling AssetLoader::poll(). |data| is only valid for
+// the duration of the call; it is empty unless the load succeeded.
+using AssetReady =
+    std::function<void(AssetStatus status, std::span<std::byte> data)>;
+
+struct AssetRequest {
+  std::string path;
+  // Byte range to read. A size of 0 reads to the end of the file.
+  uint64_t offset = 0;
+  uint64_t size = 0;
+  // Where the bytes land, e.g. the mapped memory of a host visible Buffer
+  // handed to StagingUploader::copy(). It has to stay valid until ready
+  // runs. Left empty, the loader allocates the memory itself.
+  std::span<std::byte> destination;
+  AssetDecode decode;
+  AssetReady ready;
+  // Higher priorities are read first.
+  int32_t priority = 0;
+  EL_PAD(4);
+};
+
+class AssetLoaderConfig {
+ public:
+  explicit AssetLoaderConfig(JobSystem* jobs) : jobs_(jobs) {}
+
+  // Reads kept in flight with io_uring, rounded up to a power of two.
+  auto set_queue_depth(uint32_t depth) -> AssetLoaderConfig& {
+    queue_depth_ = depth;
+    return *this;
+  }
+
+  // Threads issuing blocking reads when io_uring is unavailable.
+  auto set_io_threads(uint32_t count) -> AssetLoaderConfig& {
+    io_threads_ = count;
+    return *this;
+  }
+
+  auto set_disable_io_uring() -> AssetLoaderConfig& {
+    disable_io_uring_ = true;
+    return *this;
+  }
+
+  [[nodiscard]] auto jobs() const -> JobSystem* { return jobs_; }
+  [[nodiscard]] auto queue_depth() const -> uint32_t { return queue_depth_; }
+  [[nodiscard]] auto io_threads() const -> uint32_t { return io_threads_; }
+  [[nodiscard]] auto disable_io_uring() const -> bool {
+    return disable_io_uring_;
+  }
+
+ private:
+  JobSystem* jobs_ = nullptr;
+  uint32_t queue_depth_ = kDefaultAssetQueueDepth;
+  uint32_t io_threads_ = kDefaultAssetIoThreads;
+  bool disable_io_uring_ = false;
+  EL_PAD(7);
+};
+
+// Loads files in the background.
+//
+// Reads go through a single io_uring thread which keeps up to
+// queue_depth() chunk reads in flight across all pending assets. If the
+// kernel doesn't offer io_uring, a pool of threads issues blocking preads
+// instead. Finished reads are decoded on the JobSystem and reported by
+// poll(), which the owner calls once per frame; that's where GPU uploads
+// are recorded.
+//
+// load(), cancel() and poll() must be called from a single thread.
+class AssetLoader {
+ public:
+  explicit AssetLoader(const AssetLoaderConfig& config);
+  AssetLoader(const AssetLoader&) = delete;
+  AssetLoader(AssetLoader&&) = delete;
+  // Cancels everything still pending and waits for reads and decodes in
+  // flight. ready is not called for them.
+  ~AssetLoader();
+
+  auto operator=(const AssetLoader&) -> AssetLoader& = delete;
+  auto operator=(AssetLoader&&) -> AssetLoader& = delete;
+
+  auto load(AssetRequest request) -> AssetId;
+
+  // Asks for |id| to be dropped. Reads already issued finish, but no new
+  // ones are and decode is skipped; ready still runs, with kCancelled,
+  // unless the load already completed.
+  auto cancel(AssetId id) -> void;
+
+  // Runs ready for every load finished since the last call.
+  auto poll() -> void;
+
+  [[nodiscard]] auto uses_io_uring() const -> bool { return use_ring_; }
+
+ private:
+  struct Load;
+
+  auto io_uring_loop(IoRing* ring) -> void;
+  auto pread_loop() -> void;
+  // Pops the most urgent load which isn't cancelled. Called with lock_ held.
+  auto next_load() -> std::shared_ptr<Load>;
+  auto open(Load* load) -> bool;
+  auto finish(const std::shared_ptr<Load>& load) -> void;
+
+  JobSystem* jobs_ = nullptr;
+  std::vector<std::thread> threads_;
+
+  std::mutex lock_;
+  std::condition_variable work_cv_;
+  std::condition_variable idle_cv_;
+  // Heap ordered by priority, then submission order.
+  std::vector<std::shared_ptr<Load>> queue_;
+  std::unordered_map<AssetId, std::shared_ptr<Load>> loads_;
+  std::vector<std::shared_ptr<Load>> done_;
+  AssetId next_id_ = 1;
+  // Loads decoding on the JobSystem.
+  size_t decoding_ = 0;
+  bool use_ring_ = false;
+  bool stop_ = false;
+  EL_PAD(6);
+};
+
+}  // namespace el::engine
@@ -0,0 +1,84 @@
+#include "src/engine/buffer.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace el::engine {
+
+Buffer::Buffer(const BufferConfig& config)
+    : device_(config.device()), size_(config.size()) {
+  std::vector<uint32_t> families = config.queue_families();
+  std::sort(std::begin(families), std::end(families));
+  families.erase(std::unique(std::begin(families), std::end(families)),
+                 std::end(families));
+
+  VkBufferCreateInfo create_info = {
+      .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+      .size = size_,
+      .usage = config.usage(),
+      .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+  };
+  if (families.size() > 1) {
+    create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    create_info.queueFamilyIndexCount = uint32_t(families.size());
+    create_info.pQueueFamilyIndices = families.data();
+  }
+
+  auto res = vkCreateBuffer(device_->device(), &create_info, nullptr, &buffer_);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to create buffer: ").append(to_string(res)));
+  }
+
+  VkMemoryRequirements reqs = {};
+  vkGetBufferMemoryRequirements(device_->device(), buffer_, &reqs);
+
+  auto type = device_->find_memory_type(reqs.memoryTypeBits,
+                                        config.memory_properties());
+  if (!type.has_value()) {
+    vkDestroyBuffer(device_->device(), buffer_, nullptr);
+    throw std::runtime_error("Failed to find buffer memory type");
+  }
+
+  VkMemoryAllocateInfo alloc_info = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+      .allocationSize = reqs.size,
+      .memoryTypeIndex = type.value(),
+  };
+  res = device_->allocate_memory(alloc_info, &memory_);
+  if (res != VK_SUCCESS) {
+    vkDestroyBuffer(device_->device(), buffer_, nullptr);
+    throw std::runtime_error(
+        std::string("Failed to allocate buffer memory: ")
+            .append(to_string(res)));
+  }
+  res = vkBindBufferMemory(device_->device(), buffer_, memory_, 0);
+  if (res != VK_SUCCESS) {
+    vkDestroyBuffer(device_->device(), buffer_, nullptr);
+    device_->free_memory(memory_);
+    throw std::runtime_error(
+        std::string("Failed to bind buffer memory: ").append(to_string(res)));
+  }
+
+  if ((config.memory_properties() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) !=
+      0) {
+    void* data = nullptr;
+    res = vkMapMemory(device_->device(), memory_, 0, VK_WHOLE_SIZE, 0, &data);
+    if (res != VK_SUCCESS) {
+      vkDestroyBuffer(device_->device(), buffer_, nullptr);
+      device_->free_memory(memory_);
+      throw std::runtime_error(
+          std::string("Failed to map buffer: ").append(to_string(res)));
+    }
+    mapped_ = {static_cast<std::byte*>(data), size_};
+  }
+}
+
+Buffer::~Buffer() {
+  // Freeing the memory implicitly unmaps it.
+  device_->destroy_deferred(buffer_);
+  device_->destroy_deferred(memory_);
+}
+
+}  // namespace el::engine
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "src/engine/device.h"
+#include "src/engine/vk.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+class BufferConfig {
+ public:
+  explicit BufferConfig(Device* device) : device_(device) {}
+
+  auto set_size(VkDeviceSize size) -> BufferConfig& {
+    size_ = size;
+    return *this;
+  }
+
+  auto set_usage(VkBufferUsageFlags usage) -> BufferConfig& {
+    usage_ = usage;
+    return *this;
+  }
+
+  // Defaults to device local memory.
+  auto set_memory_properties(VkMemoryPropertyFlags properties)
+      -> BufferConfig& {
+    memory_properties_ = properties;
+    return *this;
+  }
+
+  // Queue families using the buffer. With more than one distinct family the
+  // buffer is shared concurrently, so it can pass between queues without
+  // ownership transfers.
+  auto set_queue_families(std::vector<uint32_t> families) -> BufferConfig& {
+    queue_families_ = std::move(families);
+    return *this;
+  }
+
+  // With |shared|, uses the graphics and compute families, for buffers of
+  // passes which may be recorded on the async compute queue.
+  auto set_compute_shared(bool shared) -> BufferConfig& {
+    if (shared) {
+      const auto& indices = device_->queue_families();
+      queue_families_ = {indices.graphics_family.value(),
+                         indices.compute_family.value()};
+    }
+    return *this;
+  }
+
+  [[nodiscard]] auto device() const -> Device* { return device_; }
+  [[nodiscard]] auto size() const -> VkDeviceSize { return size_; }
+  [[nodiscard]] auto usage() const -> VkBufferUsageFlags { return usage_; }
+  [[nodiscard]] auto memory_properties() const -> VkMemoryPropertyFlags {
+    return memory_properties_;
+  }
+  [[nodiscard]] auto queue_families() const -> const std::vector<uint32_t>& {
+    return queue_families_;
+  }
+
+ private:
+  Device* device_ = nullptr;
+  VkDeviceSize size_ = 0;
+  VkBufferUsageFlags usage_ = 0;
+  VkMemoryPropertyFlags memory_properties_ =
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  std::vector<uint32_t> queue_families_;
+};
+
+// A buffer with its own memory allocation. Host visible buffers stay mapped
+// for their whole lifetime.
+//
+// Destruction is deferred until the GPU has finished the current frame, so a
+// buffer can be dropped while frames using it are still in flight.
+class Buffer {
+ public:
+  explicit Buffer(const BufferConfig& config);
+  Buffer(const Buffer&) = delete;
+  Buffer(Buffer&&) = delete;
+  ~Buffer();
+
+  auto operator=(const Buffer&) -> Buffer& = delete;
+  auto operator=(Buffer&&) -> Buffer& = delete;
+
+  [[nodiscard]] auto buffer() const -> VkBuffer { return buffer_; }
+  [[nodiscard]] auto memory() const -> VkDeviceMemory { return memory_; }
+  [[nodiscard]] auto size() const -> VkDeviceSize { return size_; }
+
+  // Empty unless the buffer is host visible.
+  [[nodiscard]] auto mapped() const -> std::span<std::byte> {
+    return mapped_;
+  }
+
+ private:
+  Device* device_ = nullptr;
+  VkBuffer buffer_{};
+  VkDeviceMemory memory_{};
+  VkDeviceSize size_ = 0;
+  std::span<std::byte> mapped_;
+};
+
+}  // namespace el::engine
@@ -0,0 +1,221 @@
+#include "src/engine/clustered_lights.h"
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace el::engine {
+namespace {
+
+// Push constants of src/shaders/light_cull.comp.
+struct ClusterParams {
+  math::Mat4 view;
+  // Reciprocals of the projection's x and y scale, then near and far.
+  std::array<float, 4> projection = {};
+  std::array<float, 2> extent = {};
+  uint32_t light_count = 0;
+  uint32_t index_capacity = 0;
+};
+static_assert(sizeof(ClusterParams) <= 128);
+
+// The Info block of src/shaders/light_cull.comp.
+constexpr VkDeviceSize kClusterInfoSize = 24;
+// Large enough for any minStorageBufferOffsetAlignment.
+constexpr VkDeviceSize kSliceAlignment = 256;
+
+// Bytes a frame slot's share of a buffer holding |size| per slot takes.
+auto slice_size(VkDeviceSize size) -> VkDeviceSize {
+  return (size + kSliceAlignment - 1) / kSliceAlignment * kSliceAlignment;
+}
+
+}  // namespace
+
+ClusteredLights::ClusteredLights(const ClusteredLightsConfig& config)
+    : device_(config.device()),
+      capacity_(config.capacity()),
+      index_capacity_(config.index_capacity()),
+      light_slice_(slice_size(VkDeviceSize{capacity_} * sizeof(PointLight))),
+      cluster_slice_(
+          slice_size(VkDeviceSize{kClusterCount} * 2 * sizeof(uint32_t))),
+      index_slice_(
+          slice_size(VkDeviceSize{index_capacity_} * sizeof(uint32_t))),
+      info_slice_(slice_size(kClusterInfoSize)),
+      async_compute_(config.async_compute()),
+      staging_(BufferConfig(config.device())
+                   .set_size(light_slice_ * kMaxFramesInFlight)
+                   .set_usage(VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+                   .set_memory_properties(
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)),
+      lights_(BufferConfig(config.device())
+                  .set_size(light_slice_ * kMaxFramesInFlight)
+                  .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                             VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+                  .set_compute_shared(config.async_compute())),
+      clusters_(BufferConfig(config.device())
+                    .set_size(cluster_slice_ * kMaxFramesInFlight)
+                    .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+                    .set_compute_shared(config.async_compute())),
+      indices_(BufferConfig(config.device())
+                   .set_size(index_slice_ * kMaxFramesInFlight)
+                   .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+                   .set_compute_shared(config.async_compute())),
+      info_(BufferConfig(config.device())
+                .set_size(info_slice_ * kMaxFramesInFlight)
+                .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                           VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+                .set_compute_shared(config.async_compute())) {
+  std::array<VkDescriptorSetLayoutBinding, 4> bindings = {};
+  for (uint32_t i = 0; i < bindings.size(); ++i) {
+    bindings.at(i) = {
+        .binding = i,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 1,
+        .stageFlags =
+            VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+    };
+  }
+  set_layout_ = config.descriptors()->layout(bindings);
+
+  VkPushConstantRange push_range = {
+      .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+      .offset = 0,
+      .size = sizeof(ClusterParams),
+  };
+  VkPipelineLayoutCreateInfo layout_info = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .setLayoutCount = 1,
+      .pSetLayouts = &set_layout_,
+      .pushConstantRangeCount = 1,
+      .pPushConstantRanges = &push_range,
+  };
+  auto res = vkCreatePipelineLayout(device_->device(), &layout_info, nullptr,
+                                    &layout_);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to create light culling pipeline layout: ")
+            .append(to_string(res)));
+  }
+
+  PipelineState state;
+  state.shaders = {config.shader()};
+  state.layout = layout_;
+  pipeline_ = config.pipelines()->get_blocking(state);
+
+  std::array<DescriptorWrite, 4> writes = {
+      DescriptorWrite{
+          .buffer = {lights_.buffer(), 0, light_slice_},
+          .binding = 0,
+          .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      },
+      DescriptorWrite{
+          .buffer = {clusters_.buffer(), 0, cluster_slice_},
+          .binding = 1,
+          .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      },
+      DescriptorWrite{
+          .buffer = {indices_.buffer(), 0, index_slice_},
+          .binding = 2,
+          .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      },
+      DescriptorWrite{
+          .buffer = {info_.buffer(), 0, info_slice_},
+          .binding = 3,
+          .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      },
+  };
+  for (uint32_t slot = 0; slot < kMaxFramesInFlight; ++slot) {
+    writes[0].buffer.offset = slot * light_slice_;
+    writes[1].buffer.offset = slot * cluster_slice_;
+    writes[2].buffer.offset = slot * index_slice_;
+    writes[3].buffer.offset = slot * info_slice_;
+    sets_.at(slot) =
+        config.descriptors()->allocate_immutable(set_layout_, writes);
+  }
+}
+
+ClusteredLights::~ClusteredLights() {
+  // The pipeline belongs to the registry.
+  vkDestroyPipelineLayout(device_->device(), layout_, nullptr);
+}
+
+auto ClusteredLights::set_lights(std::span<const PointLight> lights)
+    -> void {
+  if (lights.size() > capacity_) {
+    throw std::runtime_error(std::string("Too many lights: ")
+                                 .append(std::to_string(lights.size())));
+  }
+
+  lights_host_.assign(std::begin(lights), std::end(lights));
+  ++version_;
+}
+
+auto ClusteredLights::record(VkCommandBuffer cmd,
+                             uint32_t slot,
+                             const ClusterView& view) -> void {
+  // The slot's previous frame has completed, so its slices are free and no
+  // barrier against earlier fragment shaders is needed on either queue.
+  auto offset = slot * light_slice_;
+  if (slot_versions_.at(slot) != version_) {
+    auto bytes = std::as_bytes(std::span(lights_host_));
+    if (!bytes.empty()) {
+      std::memcpy(staging_.mapped().subspan(offset).data(), bytes.data(),
+                  bytes.size());
+      VkBufferCopy region = {
+          .srcOffset = offset,
+          .dstOffset = offset,
+          .size = bytes.size(),
+      };
+      vkCmdCopyBuffer(cmd, staging_.buffer(), lights_.buffer(), 1, &region);
+    }
+    slot_versions_.at(slot) = version_;
+    light_counts_.at(slot) = uint32_t(lights_host_.size());
+  }
+
+  vkCmdFillBuffer(cmd, info_.buffer(), slot * info_slice_, sizeof(uint32_t),
+                  0);
+
+  VkMemoryBarrier cleared = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+  };
+  vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &cleared, 0,
+                       nullptr, 0, nullptr);
+
+  ClusterParams params = {
+      .view = view.view,
+      .projection = {1.0F / view.projection[0].x,
+                     1.0F / view.projection[1].y, view.near_z, view.far_z},
+      .extent = {float(view.extent.width), float(view.extent.height)},
+      .light_count = light_counts_.at(slot),
+      .index_capacity = index_capacity_,
+  };
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
+  vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout_, 0, 1,
+                          &sets_.at(slot), 0, nullptr);
+  vkCmdPushConstants(cmd, layout_, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                     sizeof(params), &params);
+  // One workgroup per cluster.
+  vkCmdDispatch(cmd, kClusterCount, 1, 1);
+
+  if (async_compute_) {
+    return;
+  }
+  // Fragment shaders read the copied lights as well as the clusters.
+  VkMemoryBarrier binned = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask =
+          VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+  };
+  vkCmdPipelineBarrier(cmd,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT |
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &binned, 0,
+                       nullptr, 0, nullptr);
+}
+
+}  // namespace el::engine
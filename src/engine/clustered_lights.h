@@ -0,0 +1,188 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "src/engine/buffer.h"
+#include "src/engine/descriptor_allocator.h"
+#include "src/engine/device.h"
+#include "src/engine/pipeline_registry.h"
+#include "src/engine/shader.h"
+#include "src/engine/vk.h"
+#include "src/math/mat.h"
+#include "src/math/vec.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+// Match src/shaders/light_cull.comp and src/shaders/clustered_lights.glsl.
+constexpr uint32_t kClusterGridX = 16;
+constexpr uint32_t kClusterGridY = 9;
+constexpr uint32_t kClusterGridZ = 24;
+constexpr uint32_t kClusterCount =
+    kClusterGridX * kClusterGridY * kClusterGridZ;
+constexpr uint32_t kMaxClusterLights = 256;
+
+constexpr uint32_t kDefaultLightCapacity = 4096;
+// Entries of the compacted light index list, enough for an average of 64
+// lights in every cluster.
+constexpr uint32_t kDefaultClusterIndexCapacity = kClusterCount * 64;
+
+// A point light. Laid out as the Light struct of src/shaders/light_cull.comp.
+struct PointLight {
+  // World space.
+  math::Vec3 position;
+  // Distance at which the light has faded out completely.
+  float radius = 0.0F;
+  math::Vec3 color;
+  float intensity = 0.0F;
+};
+static_assert(sizeof(PointLight) == 32);
+
+// The view clusters are built for.
+struct ClusterView {
+  math::Mat4 view;
+  // From math::perspective().
+  math::Mat4 projection;
+  float near_z = 0.0F;
+  float far_z = 0.0F;
+  // Size of the render target the fragment stage shades.
+  VkExtent2D extent = {};
+};
+
+class ClusteredLightsConfig {
+ public:
+  // |shader| is the compute shader built from src/shaders/light_cull.comp.
+  ClusteredLightsConfig(Device* device,
+                        DescriptorAllocator* descriptors,
+                        PipelineRegistry* pipelines,
+                        const Shader* shader)
+      : device_(device),
+        descriptors_(descriptors),
+        pipelines_(pipelines),
+        shader_(shader) {}
+
+  // Maximum number of lights.
+  auto set_capacity(uint32_t capacity) -> ClusteredLightsConfig& {
+    capacity_ = capacity;
+    return *this;
+  }
+
+  // Maximum number of light references over all clusters. Lights past it
+  // are dropped from the clusters binned last.
+  auto set_index_capacity(uint32_t capacity) -> ClusteredLightsConfig& {
+    index_capacity_ = capacity;
+    return *this;
+  }
+
+  // Shares the buffers between the graphics and compute families so
+  // binning can be recorded on the compute queue.
+  auto set_async_compute() -> ClusteredLightsConfig& {
+    async_compute_ = true;
+    return *this;
+  }
+
+  [[nodiscard]] auto device() const -> Device* { return device_; }
+  [[nodiscard]] auto descriptors() const -> DescriptorAllocator* {
+    return descriptors_;
+  }
+  [[nodiscard]] auto pipelines() const -> PipelineRegistry* {
+    return pipelines_;
+  }
+  [[nodiscard]] auto shader() const -> const Shader* { return shader_; }
+  [[nodiscard]] auto capacity() const -> uint32_t { return capacity_; }
+  [[nodiscard]] auto index_capacity() const -> uint32_t {
+    return index_capacity_;
+  }
+  [[nodiscard]] auto async_compute() const -> bool { return async_compute_; }
+
+ private:
+  Device* device_ = nullptr;
+  DescriptorAllocator* descriptors_ = nullptr;
+  PipelineRegistry* pipelines_ = nullptr;
+  const Shader* shader_ = nullptr;
+  uint32_t capacity_ = kDefaultLightCapacity;
+  uint32_t index_capacity_ = kDefaultClusterIndexCapacity;
+  bool async_compute_ = false;
+  EL_PAD(7);
+};
+
+// Clustered forward lighting. A compute pass splits the view frustum into a
+// grid of clusters, screen tiles by exponential depth slices, and bins each
+// light into the clusters its sphere touches, compacting the results into a
+// single index list. Fragment shaders include
+// src/shaders/clustered_lights.glsl and only loop over the lights of their
+// own cluster, so shading cost follows the local light density rather than
+// the total number of lights.
+//
+// Every frame in flight has its own slice of the lights, clusters and index
+// list, so neither set_lights() nor binning the next frame, on either queue,
+// touches memory an earlier frame may still read. record() may go on the
+// graphics queue before the lit draws, or on the compute queue when
+// configured with set_async_compute(); then the caller orders the compute
+// submission before the graphics one with a semaphore.
+class ClusteredLights {
+ public:
+  explicit ClusteredLights(const ClusteredLightsConfig& config);
+  ClusteredLights(const ClusteredLights&) = delete;
+  ClusteredLights(ClusteredLights&&) = delete;
+  ~ClusteredLights();
+
+  auto operator=(const ClusteredLights&) -> ClusteredLights& = delete;
+  auto operator=(ClusteredLights&&) -> ClusteredLights& = delete;
+
+  // Replaces the lights, starting with the next record() of each frame
+  // slot. Throws if there are more than the configured capacity.
+  auto set_lights(std::span<const PointLight> lights) -> void;
+
+  // Records the binning pass for frame |slot|, preceded by a copy of the
+  // lights into the slot's slice when they changed since its last record().
+  // On the graphics queue the clusters are ready for fragment shader reads
+  // afterwards.
+  auto record(VkCommandBuffer cmd, uint32_t slot, const ClusterView& view)
+      -> void;
+
+  // Bind at CLUSTER_SET for the fragment stage of frame |slot|.
+  [[nodiscard]] auto set(uint32_t slot) const -> VkDescriptorSet {
+    return sets_.at(slot);
+  }
+  [[nodiscard]] auto set_layout() const -> VkDescriptorSetLayout {
+    return set_layout_;
+  }
+
+  [[nodiscard]] auto capacity() const -> uint32_t { return capacity_; }
+  [[nodiscard]] auto light_count() const -> uint32_t {
+    return uint32_t(lights_host_.size());
+  }
+
+ private:
+  Device* device_ = nullptr;
+  uint32_t capacity_ = 0;
+  uint32_t index_capacity_ = 0;
+  // Bytes of each frame slot's share of the buffers; staging_ is sliced
+  // like lights_.
+  VkDeviceSize light_slice_ = 0;
+  VkDeviceSize cluster_slice_ = 0;
+  VkDeviceSize index_slice_ = 0;
+  VkDeviceSize info_slice_ = 0;
+  // Bumped by set_lights(), and copied per slot once its slice caught up.
+  uint32_t version_ = 0;
+  bool async_compute_ = false;
+  EL_PAD(3);
+  std::array<uint32_t, kMaxFramesInFlight> slot_versions_ = {};
+  std::array<uint32_t, kMaxFramesInFlight> light_counts_ = {};
+  std::vector<PointLight> lights_host_;
+  Buffer staging_;
+  Buffer lights_;
+  Buffer clusters_;
+  Buffer indices_;
+  Buffer info_;
+  VkDescriptorSetLayout set_layout_ = VK_NULL_HANDLE;
+  VkPipelineLayout layout_ = VK_NULL_HANDLE;
+  VkPipeline pipeline_ = VK_NULL_HANDLE;
+  std::array<VkDescriptorSet, kMaxFramesInFlight> sets_ = {};
+};
+
+}  // namespace el::engine
@@ -0,0 +1,349 @@
+#include "src/engine/cpu_cull.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "src/math/simd.h"
+
+namespace el::engine {
+namespace {
+
+// Frustum planes transposed so each kernel broadcasts one component at a
+// time. The absolute normals project box extents onto the plane normal.
+struct Planes {
+  std::array<float, 6> x = {};
+  std::array<float, 6> y = {};
+  std::array<float, 6> z = {};
+  std::array<float, 6> w = {};
+  std::array<float, 6> abs_x = {};
+  std::array<float, 6> abs_y = {};
+  std::array<float, 6> abs_z = {};
+};
+
+// Center x, y, z then radius, or half extent x, y, z for boxes.
+using Streams = std::array<std::span<const float>, 6>;
+
+using Kernel = size_t (*)(const Planes& planes,
+                          const Streams& streams,
+                          size_t begin,
+                          size_t end,
+                          std::span<uint32_t> out);
+
+auto transpose(const math::Frustum& frustum) -> Planes {
+  Planes p;
+  for (size_t i = 0; i < frustum.planes.size(); ++i) {
+    const auto& plane = frustum.planes.at(i);
+    p.x.at(i) = plane.normal.x;
+    p.y.at(i) = plane.normal.y;
+    p.z.at(i) = plane.normal.z;
+    p.w.at(i) = plane.distance;
+    p.abs_x.at(i) = std::fabs(plane.normal.x);
+    p.abs_y.at(i) = std::fabs(plane.normal.y);
+    p.abs_z.at(i) = std::fabs(plane.normal.z);
+  }
+  return p;
+}
+
+// Appends |base| plus the index of each set bit of |mask| to |out|.
+auto emit(uint32_t mask, size_t base, std::span<uint32_t> out, size_t count)
+    -> size_t {
+  for (; mask != 0; mask &= mask - 1) {
+    out[count++] = uint32_t(base) + uint32_t(std::countr_zero(mask));
+  }
+  return count;
+}
+
+// A volume is outside when it is entirely behind any plane, so the signed
+// distance of its center plus its projected radius is negative. Padding has
+// an infinitely negative radius, or a NaN one for boxes, and always fails.
+template <bool kBoxes>
+auto cull_scalar(const Planes& p,
+                 const Streams& s,
+                 size_t begin,
+                 size_t end,
+                 std::span<uint32_t> out) -> size_t {
+  size_t count = 0;
+  for (auto i = begin; i < end; i += kCullBatch) {
+    uint32_t mask = 0;
+    for (size_t lane = 0; lane < kCullBatch; ++lane) {
+      auto v = i + lane;
+      auto inside = true;
+      for (size_t j = 0; j < p.x.size(); ++j) {
+        auto d = p.x.at(j) * s[0][v] + p.y.at(j) * s[1][v] +
+                 p.z.at(j) * s[2][v] + p.w.at(j);
+        auto r = s[3][v];
+        if constexpr (kBoxes) {
+          r = p.abs_x.at(j) * s[3][v] + p.abs_y.at(j) * s[4][v] +
+              p.abs_z.at(j) * s[5][v];
+        }
+        inside = inside && d + r >= 0.0F;
+      }
+      mask |= uint32_t{inside} << lane;
+    }
+    count = emit(mask, i, out, count);
+  }
+  return count;
+}
+
+#if defined(__x86_64__)
+
+template <bool kBoxes>
+auto sse2_mask(const Planes& p, const Streams& s, size_t i) -> uint32_t {
+  auto x = _mm_loadu_ps(s[0].subspan(i).data());
+  auto y = _mm_loadu_ps(s[1].subspan(i).data());
+  auto z = _mm_loadu_ps(s[2].subspan(i).data());
+  auto e0 = _mm_loadu_ps(s[3].subspan(i).data());
+  auto e1 = kBoxes ? _mm_loadu_ps(s[4].subspan(i).data()) : _mm_setzero_ps();
+  auto e2 = kBoxes ? _mm_loadu_ps(s[5].subspan(i).data()) : _mm_setzero_ps();
+
+  auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+  for (size_t j = 0; j < p.x.size(); ++j) {
+    auto d = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.x.at(j)), x),
+                   _mm_mul_ps(_mm_set1_ps(p.y.at(j)), y)),
+        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.z.at(j)), z),
+                   _mm_set1_ps(p.w.at(j))));
+    auto r = e0;
+    if constexpr (kBoxes) {
+      r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.abs_x.at(j)), e0),
+                                _mm_mul_ps(_mm_set1_ps(p.abs_y.at(j)), e1)),
+                     _mm_mul_ps(_mm_set1_ps(p.abs_z.at(j)), e2));
+    }
+    inside =
+        _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+  }
+  return uint32_t(_mm_movemask_ps(inside));
+}
+
+template <bool kBoxes>
+auto cull_sse2(const Planes& p,
+               const Streams& s,
+               size_t begin,
+               size_t end,
+               std::span<uint32_t> out) -> size_t {
+  size_t count = 0;
+  for (auto i = begin; i < end; i += kCullBatch) {
+    auto mask = sse2_mask<kBoxes>(p, s, i) |
+                (sse2_mask<kBoxes>(p, s, i + kCullBatch / 2) << 4);
+    count = emit(mask, i, out, count);
+  }
+  return count;
+}
+
+template <bool kBoxes>
+__attribute__((target("avx2,fma"))) auto cull_avx2(const Planes& p,
+                                                   const Streams& s,
+                                                   size_t begin,
+                                                   size_t end,
+                                                   std::span<uint32_t> out)
+    -> size_t {
+  size_t count = 0;
+  for (auto i = begin; i < end; i += kCullBatch) {
+    auto x = _mm256_loadu_ps(s[0].subspan(i).data());
+    auto y = _mm256_loadu_ps(s[1].subspan(i).data());
+    auto z = _mm256_loadu_ps(s[2].subspan(i).data());
+    auto e0 = _mm256_loadu_ps(s[3].subspan(i).data());
+    auto e1 =
+        kBoxes ? _mm256_loadu_ps(s[4].subspan(i).data()) : _mm256_setzero_ps();
+    auto e2 =
+        kBoxes ? _mm256_loadu_ps(s[5].subspan(i).data()) : _mm256_setzero_ps();
+
+    auto inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (size_t j = 0; j < p.x.size(); ++j) {
+      auto d = _mm256_fmadd_ps(
+          _mm256_set1_ps(p.x.at(j)), x,
+          _mm256_fmadd_ps(
+              _mm256_set1_ps(p.y.at(j)), y,
+              _mm256_fmadd_ps(_mm256_set1_ps(p.z.at(j)), z,
+                              _mm256_set1_ps(p.w.at(j)))));
+      auto r = e0;
+      if constexpr (kBoxes) {
+        r = _mm256_fmadd_ps(
+            _mm256_set1_ps(p.abs_x.at(j)), e0,
+            _mm256_fmadd_ps(_mm256_set1_ps(p.abs_y.at(j)), e1,
+                            _mm256_mul_ps(_mm256_set1_ps(p.abs_z.at(j)), e2)));
+      }
+      inside = _mm256_and_ps(
+          inside,
+          _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_GE_OQ));
+    }
+    count = emit(uint32_t(_mm256_movemask_ps(inside)), i, out, count);
+  }
+  return count;
+}
+
+#elif defined(__aarch64__)
+
+template <bool kBoxes>
+auto neon_mask(const Planes& p, const Streams& s, size_t i) -> uint32_t {
+  auto x = vld1q_f32(s[0].subspan(i).data());
+  auto y = vld1q_f32(s[1].subspan(i).data());
+  auto z = vld1q_f32(s[2].subspan(i).data());
+  auto e0 = vld1q_f32(s[3].subspan(i).data());
+  auto e1 = kBoxes ? vld1q_f32(s[4].subspan(i).data()) : vdupq_n_f32(0.0F);
+  auto e2 = kBoxes ? vld1q_f32(s[5].subspan(i).data()) : vdupq_n_f32(0.0F);
+
+  auto inside = vdupq_n_u32(~0U);
+  for (size_t j = 0; j < p.x.size(); ++j) {
+    auto d = vfmaq_n_f32(
+        vfmaq_n_f32(vfmaq_n_f32(vdupq_n_f32(p.w.at(j)), z, p.z.at(j)), y,
+                    p.y.at(j)),
+        x, p.x.at(j));
+    auto r = e0;
+    if constexpr (kBoxes) {
+      r = vfmaq_n_f32(
+          vfmaq_n_f32(vmulq_n_f32(e2, p.abs_z.at(j)), e1, p.abs_y.at(j)), e0,
+          p.abs_x.at(j));
+    }
+    inside = vandq_u32(inside, vcgezq_f32(vaddq_f32(d, r)));
+  }
+  const uint32x4_t bits = {1, 2, 4, 8};
+  return vaddvq_u32(vandq_u32(inside, bits));
+}
+
+template <bool kBoxes>
+auto cull_neon(const Planes& p,
+               const Streams& s,
+               size_t begin,
+               size_t end,
+               std::span<uint32_t> out) -> size_t {
+  size_t count = 0;
+  for (auto i = begin; i < end; i += kCullBatch) {
+    auto mask = neon_mask<kBoxes>(p, s, i) |
+                (neon_mask<kBoxes>(p, s, i + kCullBatch / 2) << 4);
+    count = emit(mask, i, out, count);
+  }
+  return count;
+}
+
+#endif
+
+template <bool kBoxes>
+auto select(CullKernel kernel) -> Kernel {
+#if defined(__x86_64__)
+  if (kernel == CullKernel::kAvx2) {
+    return cull_avx2<kBoxes>;
+  }
+  if (kernel == CullKernel::kSse2) {
+    return cull_sse2<kBoxes>;
+  }
+#elif defined(__aarch64__)
+  if (kernel == CullKernel::kNeon) {
+    return cull_neon<kBoxes>;
+  }
+#endif
+  return cull_scalar<kBoxes>;
+}
+
+template <typename Volumes>
+auto streams(const Volumes& volumes) -> Streams {
+  Streams s = {};
+  for (size_t i = 0; i < Volumes::kComponents; ++i) {
+    s.at(i) = volumes.component(i);
+  }
+  return s;
+}
+
+}  // namespace
+
+auto to_string(CullKernel kernel) -> std::string_view {
+  switch (kernel) {
+    case CullKernel::kScalar:
+      return "scalar";
+    case CullKernel::kSse2:
+      return "sse2";
+    case CullKernel::kAvx2:
+      return "avx2";
+    case CullKernel::kNeon:
+      return "neon";
+  }
+  return "unknown";
+}
+
+auto available_cull_kernels() -> std::vector<CullKernel> {
+  std::vector<CullKernel> kernels = {CullKernel::kScalar};
+#if defined(__x86_64__)
+  kernels.push_back(CullKernel::kSse2);
+  if (math::simd::has_avx2()) {
+    kernels.push_back(CullKernel::kAvx2);
+  }
+#elif defined(__aarch64__)
+  kernels.push_back(CullKernel::kNeon);
+#endif
+  return kernels;
+}
+
+auto best_cull_kernel() -> CullKernel {
+  return available_cull_kernels().back();
+}
+
+CpuCuller::CpuCuller(const CpuCullerConfig& config)
+    : jobs_(config.jobs()),
+      grain_((std::max<size_t>(config.grain(), 1) + kCullBatch - 1) /
+             kCullBatch * kCullBatch),
+      kernel_(config.kernel()) {
+  auto kernels = available_cull_kernels();
+  if (std::find(std::begin(kernels), std::end(kernels), kernel_) ==
+      std::end(kernels)) {
+    throw std::runtime_error(std::string("Culling kernel not available: ")
+                                 .append(to_string(kernel_)));
+  }
+}
+
+auto CpuCuller::cull(const math::Frustum& frustum,
+                     const CullSpheres& spheres,
+                     std::vector<uint32_t>* visible) -> void {
+  run(frustum, spheres, visible);
+}
+
+auto CpuCuller::cull(const math::Frustum& frustum,
+                     const CullBoxes& boxes,
+                     std::vector<uint32_t>* visible) -> void {
+  run(frustum, boxes, visible);
+}
+
+template <typename Volumes>
+auto CpuCuller::run(const math::Frustum& frustum,
+                    const Volumes& volumes,
+                    std::vector<uint32_t>* visible) -> void {
+  visible->clear();
+  auto count = volumes.padded_size();
+  if (count == 0) {
+    return;
+  }
+
+  auto planes = transpose(frustum);
+  auto s = streams(volumes);
+  auto kernel = select<std::is_same_v<Volumes, CullBoxes>>(kernel_);
+
+  // Each chunk writes its indices into its own slice of the scratch space
+  // and its count into its own slot, so jobs share nothing.
+  scratch_.resize(count);
+  counts_.assign((count + grain_ - 1) / grain_, 0);
+  auto chunk = [&](size_t begin, size_t end) {
+    counts_.at(begin / grain_) = uint32_t(
+        kernel(planes, s, begin, end, std::span(scratch_).subspan(begin)));
+  };
+  if (jobs_ == nullptr || counts_.size() == 1) {
+    for (size_t begin = 0; begin < count; begin += grain_) {
+      chunk(begin, std::min(begin + grain_, count));
+    }
+  } else {
+    jobs_->parallel_for(count, grain_, chunk);
+  }
+
+  visible->reserve(
+      std::accumulate(std::begin(counts_), std::end(counts_), size_t{0}));
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    auto first = std::begin(scratch_) + std::ptrdiff_t(i * grain_);
+    visible->insert(std::end(*visible), first, first + counts_.at(i));
+  }
+}
+
+}  // namespace el::engine
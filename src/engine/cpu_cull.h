@@ -0,0 +1,201 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "src/job_system.h"
+#include "src/math/geometry.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+// Objects tested per kernel iteration. Volume arrays are padded to a
+// multiple of this so the kernels never need a scalar tail.
+constexpr size_t kCullBatch = 8;
+constexpr size_t kDefaultCpuCullGrain = 16384;
+
+enum class CullKernel : uint8_t {
+  kScalar,
+  // Two 4 wide halves per batch, x86-64 baseline.
+  kSse2,
+  // One 8 wide batch with FMA, selected at runtime on x86-64.
+  kAvx2,
+  // Two 4 wide halves per batch on AArch64.
+  kNeon,
+};
+
+auto to_string(CullKernel kernel) -> std::string_view;
+
+// Kernels this build and CPU can run, kScalar first and the fastest last.
+auto available_cull_kernels() -> std::vector<CullKernel>;
+auto best_cull_kernel() -> CullKernel;
+
+// Bounding volumes in structure of arrays layout, one array per component.
+// Each array is padded with never visible entries to a multiple of
+// kCullBatch.
+template <size_t N>
+class CullVolumes {
+ public:
+  static constexpr size_t kComponents = N;
+
+  [[nodiscard]] auto size() const -> size_t { return size_; }
+  [[nodiscard]] auto padded_size() const -> size_t {
+    return components_[0].size();
+  }
+  [[nodiscard]] auto component(size_t i) const -> std::span<const float> {
+    return components_.at(i);
+  }
+
+  auto reserve(size_t count) -> void {
+    for (auto& c : components_) {
+      c.reserve((count + kCullBatch - 1) / kCullBatch * kCullBatch);
+    }
+  }
+
+  auto clear() -> void {
+    for (auto& c : components_) {
+      c.clear();
+    }
+    size_ = 0;
+  }
+
+ protected:
+  // Components from |kPaddedFrom| on are extents, padded with -infinity so
+  // padding fails every plane test. Centers are padded with 0.
+  static constexpr size_t kPaddedFrom = 3;
+
+  auto push(const std::array<float, N>& values) -> uint32_t {
+    if (size_ == padded_size()) {
+      for (size_t i = 0; i < N; ++i) {
+        components_.at(i).resize(
+            size_ + kCullBatch,
+            i < kPaddedFrom ? 0.0F : -std::numeric_limits<float>::infinity());
+      }
+    }
+    set(size_, values);
+    return uint32_t(size_++);
+  }
+
+  auto set(size_t index, const std::array<float, N>& values) -> void {
+    for (size_t i = 0; i < N; ++i) {
+      components_.at(i).at(index) = values.at(i);
+    }
+  }
+
+ private:
+  std::array<std::vector<float>, N> components_;
+  size_t size_ = 0;
+};
+
+// Spheres as center x, y, z and radius.
+class CullSpheres : public CullVolumes<4> {
+ public:
+  // |sphere| is xyz center and w radius. Returns its index.
+  auto push_back(const std::array<float, 4>& sphere) -> uint32_t {
+    return push(sphere);
+  }
+  auto set(uint32_t index, const std::array<float, 4>& sphere) -> void {
+    CullVolumes::set(index, sphere);
+  }
+};
+
+// Axis aligned boxes as center x, y, z and half extent x, y, z.
+class CullBoxes : public CullVolumes<6> {
+ public:
+  // Returns the index of the box spanning |min| to |max|.
+  auto push_back(const std::array<float, 3>& min,
+                 const std::array<float, 3>& max) -> uint32_t {
+    return push(center_extent(min, max));
+  }
+  auto set(uint32_t index,
+           const std::array<float, 3>& min,
+           const std::array<float, 3>& max) -> void {
+    CullVolumes::set(index, center_extent(min, max));
+  }
+
+ private:
+  static auto center_extent(const std::array<float, 3>& min,
+                            const std::array<float, 3>& max)
+      -> std::array<float, 6> {
+    return {(min[0] + max[0]) * 0.5F, (min[1] + max[1]) * 0.5F,
+            (min[2] + max[2]) * 0.5F, (max[0] - min[0]) * 0.5F,
+            (max[1] - min[1]) * 0.5F, (max[2] - min[2]) * 0.5F};
+  }
+};
+
+class CpuCullerConfig {
+ public:
+  // Without a job system everything is culled on the calling thread.
+  explicit CpuCullerConfig(JobSystem* jobs = nullptr) : jobs_(jobs) {}
+
+  // Volumes per job, rounded up to a multiple of kCullBatch.
+  auto set_grain(size_t grain) -> CpuCullerConfig& {
+    grain_ = grain;
+    return *this;
+  }
+
+  // Overrides the kernel picked by best_cull_kernel(). Throws at
+  // construction if it isn't in available_cull_kernels().
+  auto set_kernel(CullKernel kernel) -> CpuCullerConfig& {
+    kernel_ = kernel;
+    return *this;
+  }
+
+  [[nodiscard]] auto jobs() const -> JobSystem* { return jobs_; }
+  [[nodiscard]] auto grain() const -> size_t { return grain_; }
+  [[nodiscard]] auto kernel() const -> CullKernel { return kernel_; }
+
+ private:
+  JobSystem* jobs_ = nullptr;
+  size_t grain_ = kDefaultCpuCullGrain;
+  CullKernel kernel_ = best_cull_kernel();
+  EL_PAD(7);
+};
+
+// Frustum culling on the CPU for devices where the GPU path is unavailable
+// or slower, such as software rasterizers. Volumes are tested kCullBatch at a
+// time with the SIMD kernel for the host, in parallel over the job system.
+//
+// Not thread safe, the culler keeps scratch space between calls.
+class CpuCuller {
+ public:
+  explicit CpuCuller(const CpuCullerConfig& config);
+  CpuCuller(const CpuCuller&) = delete;
+  CpuCuller(CpuCuller&&) = delete;
+  ~CpuCuller() = default;
+
+  auto operator=(const CpuCuller&) -> CpuCuller& = delete;
+  auto operator=(CpuCuller&&) -> CpuCuller& = delete;
+
+  // Replaces |visible| with the ascending indices of the volumes at least
+  // partly inside |frustum|.
+  auto cull(const math::Frustum& frustum,
+            const CullSpheres& spheres,
+            std::vector<uint32_t>* visible) -> void;
+  auto cull(const math::Frustum& frustum,
+            const CullBoxes& boxes,
+            std::vector<uint32_t>* visible) -> void;
+
+  [[nodiscard]] auto kernel() const -> CullKernel { return kernel_; }
+
+ private:
+  template <typename Volumes>
+  auto run(const math::Frustum& frustum,
+           const Volumes& volumes,
+           std::vector<uint32_t>* visible) -> void;
+
+  JobSystem* jobs_ = nullptr;
+  size_t grain_ = 0;
+  // Per job output, each job writing from its first volume's index on.
+  std::vector<uint32_t> scratch_;
+  std::vector<uint32_t> counts_;
+  CullKernel kernel_ = CullKernel::kScalar;
+  EL_PAD(7);
+};
+
+}  // namespace el::engine
@@ -0,0 +1,40 @@
+#include "src/engine/deletion_queue.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace el::engine {
+
+auto DeletionQueue::push(uint64_t retire_after, Deleter deleter) -> void {
+  const std::lock_guard<std::mutex> lock(lock_);
+  entries_.push_back({.deleter = std::move(deleter),
+                      .retire_after = retire_after});
+}
+
+auto DeletionQueue::collect(uint64_t completed) -> void {
+  std::vector<Entry> ready;
+  {
+    const std::lock_guard<std::mutex> lock(lock_);
+    auto split = std::stable_partition(
+        std::begin(entries_), std::end(entries_),
+        [completed](const Entry& e) { return e.retire_after > completed; });
+    std::move(split, std::end(entries_), std::back_inserter(ready));
+    entries_.erase(split, std::end(entries_));
+  }
+
+  // Run outside the lock so deleters are free to queue more work.
+  std::for_each(std::begin(ready), std::end(ready),
+                [](const Entry& e) { e.deleter(); });
+}
+
+auto DeletionQueue::flush() -> void {
+  collect(std::numeric_limits<uint64_t>::max());
+}
+
+auto DeletionQueue::size() const -> size_t {
+  const std::lock_guard<std::mutex> lock(lock_);
+  return entries_.size();
+}
+
+}  // namespace el::engine
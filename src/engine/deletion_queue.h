@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "src/pad.h"
+
+namespace el::engine {
+
+using Deleter = std::function<void()>;
+
+// Destruction work which has to wait until the GPU is done with a resource.
+//
+// Each entry is tagged with the frame index, or timeline value, after which
+// the GPU can no longer reference it. collect() runs every entry at or below
+// the completed value, so resources can be released mid-session without
+// draining the whole pipeline with vkDeviceWaitIdle.
+class DeletionQueue {
+ public:
+  DeletionQueue() = default;
+  DeletionQueue(const DeletionQueue&) = delete;
+  DeletionQueue(DeletionQueue&&) = delete;
+  ~DeletionQueue() = default;
+
+  auto operator=(const DeletionQueue&) -> DeletionQueue& = delete;
+  auto operator=(DeletionQueue&&) -> DeletionQueue& = delete;
+
+  // Safe to call from any thread.
+  auto push(uint64_t retire_after, Deleter deleter) -> void;
+
+  // Runs every deleter whose value is <= |completed|, in push order.
+  auto collect(uint64_t completed) -> void;
+
+  // Runs everything. Only call once the device is idle.
+  auto flush() -> void;
+
+  [[nodiscard]] auto size() const -> size_t;
+
+ private:
+  struct Entry {
+    Deleter deleter;
+    uint64_t retire_after = 0;
+  };
+
+  std::vector<Entry> entries_;
+  mutable std::mutex lock_;
+};
+
+}  // namespace el::engine
@@ -0,0 +1,279 @@
+#include "src/engine/descriptor_allocator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "src/engine/hash.h"
+#include "src/engine/vk.h"
+
+namespace el::engine {
+namespace {
+
+// Pool ratios, in descriptors per set, used until usage statistics exist.
+constexpr std::array<float, kDescriptorTypeCount> kDefaultRatios = {{
+    0.5F,  // SAMPLER
+    2.0F,  // COMBINED_IMAGE_SAMPLER
+    1.0F,  // SAMPLED_IMAGE
+    0.5F,  // STORAGE_IMAGE
+    0.0F,  // UNIFORM_TEXEL_BUFFER
+    0.0F,  // STORAGE_TEXEL_BUFFER
+    1.0F,  // UNIFORM_BUFFER
+    1.0F,  // STORAGE_BUFFER
+    0.5F,  // UNIFORM_BUFFER_DYNAMIC
+    0.5F,  // STORAGE_BUFFER_DYNAMIC
+    0.0F,  // INPUT_ATTACHMENT
+}};
+
+auto is_pool_exhausted(VkResult res) -> bool {
+  return res == VK_ERROR_OUT_OF_POOL_MEMORY || res == VK_ERROR_FRAGMENTED_POOL;
+}
+
+auto hash_write(uint64_t seed, const DescriptorWrite& w) -> uint64_t {
+  seed = hash_combine(seed, w.binding);
+  seed = hash_combine(seed, static_cast<uint64_t>(w.type));
+  // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+  seed = hash_combine(seed, reinterpret_cast<uint64_t>(w.buffer.buffer));
+  seed = hash_combine(seed, w.buffer.offset);
+  seed = hash_combine(seed, w.buffer.range);
+  seed = hash_combine(seed, reinterpret_cast<uint64_t>(w.image.sampler));
+  seed = hash_combine(seed, reinterpret_cast<uint64_t>(w.image.imageView));
+  // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+  return hash_combine(seed, static_cast<uint64_t>(w.image.imageLayout));
+}
+
+}  // namespace
+
+DescriptorAllocator::DescriptorAllocator(
+    const DescriptorAllocatorConfig& config)
+    : device_(config.device()),
+      frames_(config.frames_in_flight()) {
+  for (auto& list : frames_) {
+    list.sets_per_pool = config.initial_sets_per_pool();
+  }
+  immutable_.sets_per_pool = config.initial_sets_per_pool();
+}
+
+DescriptorAllocator::~DescriptorAllocator() {
+  auto device = device_->device();
+  auto destroy_pools = [device](const PoolList& list) {
+    std::for_each(std::begin(list.pools), std::end(list.pools),
+                  [device](VkDescriptorPool pool) {
+                    vkDestroyDescriptorPool(device, pool, nullptr);
+                  });
+  };
+  std::for_each(std::begin(frames_), std::end(frames_), destroy_pools);
+  destroy_pools(immutable_);
+
+  std::for_each(std::begin(layouts_), std::end(layouts_),
+                [device](const auto& entry) {
+                  vkDestroyDescriptorSetLayout(device, entry.second, nullptr);
+                });
+}
+
+auto DescriptorAllocator::layout(
+    std::span<const VkDescriptorSetLayoutBinding> bindings)
+    -> VkDescriptorSetLayout {
+  uint64_t key = kFnvOffsetBasis;
+  TypeCounts counts = {};
+  for (const auto& b : bindings) {
+    key = hash_combine(key, b.binding);
+    key = hash_combine(key, static_cast<uint64_t>(b.descriptorType));
+    key = hash_combine(key, b.descriptorCount);
+    key = hash_combine(key, b.stageFlags);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    key = hash_combine(key, reinterpret_cast<uint64_t>(b.pImmutableSamplers));
+
+    auto type = static_cast<size_t>(b.descriptorType);
+    if (type < kDescriptorTypeCount) {
+      counts.at(type) += b.descriptorCount;
+    }
+  }
+
+  auto it = layouts_.find(key);
+  if (it != layouts_.end()) {
+    return it->second;
+  }
+
+  VkDescriptorSetLayoutCreateInfo create_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+      .bindingCount = uint32_t(bindings.size()),
+      .pBindings = bindings.data(),
+  };
+
+  VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+  auto res = vkCreateDescriptorSetLayout(device_->device(), &create_info,
+                                         nullptr, &layout);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to create descriptor set layout: ")
+            .append(to_string(res)));
+  }
+
+  layouts_.insert(std::make_pair(key, layout));
+  layout_counts_.insert(std::make_pair(layout, counts));
+  return layout;
+}
+
+auto DescriptorAllocator::begin_frame(uint64_t frame) -> void {
+  frame_slot_ = static_cast<size_t>(frame % frames_.size());
+
+  auto& list = frames_[frame_slot_];
+  std::for_each(std::begin(list.pools), std::end(list.pools),
+                [device = device_->device()](VkDescriptorPool pool) {
+                  vkResetDescriptorPool(device, pool, 0);
+                });
+  list.current = 0;
+}
+
+auto DescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+    -> VkDescriptorSet {
+  return allocate_from(&frames_[frame_slot_], layout);
+}
+
+auto DescriptorAllocator::allocate_immutable(
+    VkDescriptorSetLayout layout,
+    std::span<const DescriptorWrite> writes) -> VkDescriptorSet {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  uint64_t key =
+      hash_combine(kFnvOffsetBasis, reinterpret_cast<uint64_t>(layout));
+  for (const auto& w : writes) {
+    key = hash_write(key, w);
+  }
+
+  auto it = immutable_sets_.find(key);
+  if (it != immutable_sets_.end()) {
+    return it->second;
+  }
+
+  auto set = allocate_from(&immutable_, layout);
+  write(set, writes);
+  immutable_sets_.insert(std::make_pair(key, set));
+  return set;
+}
+
+auto DescriptorAllocator::write(VkDescriptorSet set,
+                                std::span<const DescriptorWrite> writes)
+    -> void {
+  std::vector<VkWriteDescriptorSet> vk_writes(writes.size());
+  std::transform(std::begin(writes), std::end(writes), std::begin(vk_writes),
+                 [set](const DescriptorWrite& w) -> VkWriteDescriptorSet {
+                   bool is_image =
+                       w.type == VK_DESCRIPTOR_TYPE_SAMPLER ||
+                       w.type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
+                       w.type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
+                       w.type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
+                       w.type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                   return {
+                       .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                       .dstSet = set,
+                       .dstBinding = w.binding,
+                       .dstArrayElement = 0,
+                       .descriptorCount = 1,
+                       .descriptorType = w.type,
+                       .pImageInfo = is_image ? &w.image : nullptr,
+                       .pBufferInfo = is_image ? nullptr : &w.buffer,
+                   };
+                 });
+
+  vkUpdateDescriptorSets(device_->device(), uint32_t(vk_writes.size()),
+                         vk_writes.data(), 0, nullptr);
+}
+
+auto DescriptorAllocator::allocate_from(PoolList* list,
+                                        VkDescriptorSetLayout layout)
+    -> VkDescriptorSet {
+  TypeCounts required = {};
+  auto it = layout_counts_.find(layout);
+  if (it != layout_counts_.end()) {
+    required = it->second;
+    record_usage(required);
+  }
+
+  for (;;) {
+    bool fresh = false;
+    if (list->current == list->pools.size()) {
+      // Every pool of the list is full, so the next one has to be larger.
+      if (!list->pools.empty()) {
+        list->sets_per_pool =
+            std::min(list->sets_per_pool * 2, kMaxSetsPerPool);
+      }
+      list->pools.push_back(create_pool(required, list->sets_per_pool));
+      fresh = true;
+    }
+
+    VkDescriptorSetAllocateInfo alloc_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = list->pools[list->current],
+        .descriptorSetCount = 1,
+        .pSetLayouts = &layout,
+    };
+
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    auto res = vkAllocateDescriptorSets(device_->device(), &alloc_info, &set);
+    if (res == VK_SUCCESS) {
+      return set;
+    }
+    if (!is_pool_exhausted(res) || fresh) {
+      throw std::runtime_error(
+          std::string("Failed to allocate descriptor set: ")
+              .append(to_string(res)));
+    }
+
+    list->current += 1;
+  }
+}
+
+auto DescriptorAllocator::create_pool(const TypeCounts& required,
+                                      uint32_t sets) -> VkDescriptorPool {
+  std::vector<VkDescriptorPoolSize> sizes;
+  for (uint32_t type = 0; type < kDescriptorTypeCount; ++type) {
+    float per_set = kDefaultRatios.at(type);
+    if (sets_allocated_ > 0) {
+      per_set = static_cast<float>(descriptors_allocated_.at(type)) /
+                static_cast<float>(sets_allocated_);
+    }
+    // A fresh pool must always fit the layout which asked for it, even if
+    // the statistics have not seen its descriptor types yet.
+    auto count = std::max(
+        required.at(type),
+        static_cast<uint32_t>(
+            std::ceil(per_set * static_cast<float>(sets))));
+    if (count == 0) {
+      continue;
+    }
+
+    sizes.push_back({
+        .type = static_cast<VkDescriptorType>(type),
+        .descriptorCount = count,
+    });
+  }
+
+  VkDescriptorPoolCreateInfo create_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+      .flags = 0,
+      .maxSets = sets,
+      .poolSizeCount = uint32_t(sizes.size()),
+      .pPoolSizes = sizes.data(),
+  };
+
+  VkDescriptorPool pool = VK_NULL_HANDLE;
+  auto res =
+      vkCreateDescriptorPool(device_->device(), &create_info, nullptr, &pool);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(std::string("Failed to create descriptor pool: ")
+                                 .append(to_string(res)));
+  }
+
+  return pool;
+}
+
+auto DescriptorAllocator::record_usage(const TypeCounts& counts) -> void {
+  sets_allocated_ += 1;
+  for (size_t type = 0; type < kDescriptorTypeCount; ++type) {
+    descriptors_allocated_.at(type) += counts.at(type);
+  }
+}
+
+}  // namespace el::engine
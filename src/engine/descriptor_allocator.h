@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "src/engine/device.h"
+#include "src/engine/vk.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+// Number of core descriptor types, VK_DESCRIPTOR_TYPE_SAMPLER through
+// VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT.
+constexpr uint32_t kDescriptorTypeCount = 11;
+
+constexpr uint32_t kDefaultSetsPerPool = 64;
+constexpr uint32_t kMaxSetsPerPool = 4096;
+
+// A single resource binding written into a descriptor set. Either |buffer| or
+// |image| is used depending on |type|.
+struct DescriptorWrite {
+  VkDescriptorBufferInfo buffer = {};
+  VkDescriptorImageInfo image = {};
+  uint32_t binding = 0;
+  VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+};
+
+class DescriptorAllocatorConfig {
+ public:
+  explicit DescriptorAllocatorConfig(Device* device) : device_(device) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
+    assert(device);
+  }
+
+  // At least one.
+  auto set_frames_in_flight(uint32_t frames) -> DescriptorAllocatorConfig& {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
+    assert(frames > 0);
+    frames_in_flight_ = frames;
+    return *this;
+  }
+
+  auto set_initial_sets_per_pool(uint32_t sets) -> DescriptorAllocatorConfig& {
+    initial_sets_per_pool_ = sets;
+    return *this;
+  }
+
+  [[nodiscard]] auto device() const -> Device* { return device_; }
+  [[nodiscard]] auto frames_in_flight() const -> uint32_t {
+    return frames_in_flight_;
+  }
+  [[nodiscard]] auto initial_sets_per_pool() const -> uint32_t {
+    return initial_sets_per_pool_;
+  }
+
+ private:
+  Device* device_ = nullptr;
+  uint32_t frames_in_flight_ = kMaxFramesInFlight;
+  uint32_t initial_sets_per_pool_ = kDefaultSetsPerPool;
+};
+
+// Hands out descriptor sets from growable lists of VkDescriptorPools.
+//
+// Per-frame sets are never freed individually. Each frame slot owns its own
+// pools which are reset wholesale with vkResetDescriptorPool in
+// begin_frame() once the GPU has retired that slot. New pools are sized from
+// the descriptor counts observed so far so the pools match what the
+// renderer actually binds, and each list doubles its pool size only when its
+// own pools run out.
+//
+// Immutable sets live in a separate pool list which is never reset and are
+// de-duplicated by a hash of the layout and the bound resources.
+//
+// The allocator is not thread safe, use one per recording thread.
+class DescriptorAllocator {
+ public:
+  explicit DescriptorAllocator(const DescriptorAllocatorConfig& config);
+  DescriptorAllocator(const DescriptorAllocator&) = delete;
+  DescriptorAllocator(DescriptorAllocator&&) = delete;
+  ~DescriptorAllocator();
+
+  auto operator=(const DescriptorAllocator&) -> DescriptorAllocator& = delete;
+  auto operator=(DescriptorAllocator&&) -> DescriptorAllocator& = delete;
+
+  // Returns a cached layout for |bindings|, creating it on first use. The
+  // layout is owned by the allocator.
+  auto layout(std::span<const VkDescriptorSetLayoutBinding> bindings)
+      -> VkDescriptorSetLayout;
+
+  // Makes |frame| the current frame and resets all pools used the last time
+  // its slot was current. The caller must have waited for that frame's fence.
+  auto begin_frame(uint64_t frame) -> void;
+
+  // Allocates a set which is valid until the current frame slot comes around
+  // again.
+  auto allocate(VkDescriptorSetLayout layout) -> VkDescriptorSet;
+
+  // Allocates and writes a set which lives as long as the allocator. Calls
+  // with the same layout and writes return the same set.
+  auto allocate_immutable(VkDescriptorSetLayout layout,
+                          std::span<const DescriptorWrite> writes)
+      -> VkDescriptorSet;
+
+  auto write(VkDescriptorSet set, std::span<const DescriptorWrite> writes)
+      -> void;
+
+ private:
+  struct PoolList {
+    std::vector<VkDescriptorPool> pools;
+    // Index of the pool currently being allocated from.
+    size_t current = 0;
+    // Size of the next pool, doubled whenever the list's pools run out.
+    uint32_t sets_per_pool = 0;
+    EL_PAD(4);
+  };
+
+  using TypeCounts = std::array<uint32_t, kDescriptorTypeCount>;
+
+  auto allocate_from(PoolList* list, VkDescriptorSetLayout layout)
+      -> VkDescriptorSet;
+  auto create_pool(const TypeCounts& required, uint32_t sets)
+      -> VkDescriptorPool;
+  auto record_usage(const TypeCounts& counts) -> void;
+
+  Device* device_ = nullptr;
+
+  std::vector<PoolList> frames_;
+  PoolList immutable_;
+
+  std::unordered_map<uint64_t, VkDescriptorSetLayout> layouts_;
+  std::unordered_map<VkDescriptorSetLayout, TypeCounts> layout_counts_;
+  std::unordered_map<uint64_t, VkDescriptorSet> immutable_sets_;
+
+  // Usage statistics used to size new pools.
+  std::array<uint64_t, kDescriptorTypeCount> descriptors_allocated_ = {};
+  uint64_t sets_allocated_ = 0;
+
+  size_t frame_slot_ = 0;
+};
+
+}  // namespace el::engine
@@ -4,10 +4,12 @@
 #include <cassert>
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <span>
 #include <sstream>
 #include <stdexcept>
+#include <string_view>
 #include <unordered_set>
 
 #include "src/dimensions.h"
@@ -24,6 +26,8 @@ constexpr uint8_t kEngineMajor = 0;
 constexpr uint8_t kEngineMinor = 1;
 constexpr uint8_t kEnginePatch = 0;
 
+constexpr VersionInfo kApiVersion{0, 1, 2, 0};
+
 constexpr uint32_t kQueueFamilyBits =
     VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
 
@@ -33,79 +37,6 @@ constexpr std::array<const char*, 1> kValidationLayers = {
 constexpr std::array<const char*, 1> kDeviceExtensions = {
     {VK_KHR_SWAPCHAIN_EXTENSION_NAME}};
 
-auto debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
-                    VkDebugUtilsMessageTypeFlagsEXT type,
-                    const VkDebugUtilsMessengerCallbackDataEXT* data,
-                    void* user_data) -> VkBool32 {
-  const auto* err_data = static_cast<ErrorData*>(user_data);
-
-  if (err_data != nullptr && err_data->cb) {
-    ErrorSeverity sev = ErrorSeverity::kError;
-    if ((severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) != 0) {
-      sev = ErrorSeverity::kWarning;
-    } else if ((severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) != 0) {
-      sev = ErrorSeverity::kInfo;
-    } else if ((severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT) !=
-               0) {
-      sev = ErrorSeverity::kVerbose;
-    }
-
-    ErrorType error_type = ErrorType::kGeneral;
-    if ((type & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT) != 0) {
-      error_type = ErrorType::kPerformance;
-    } else if ((type & VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT) != 0) {
-      error_type = ErrorType::kValidation;
-    }
-
-    std::stringstream msg_buf;
-    msg_buf << "Err: " << data->pMessage << std::endl;
-    if (data->pMessageIdName != nullptr) {
-      msg_buf << "MessageId (" << data->messageIdNumber
-              << "): " << data->pMessageIdName << std::endl;
-    }
-    if (data->queueLabelCount > 0) {
-      msg_buf << "Queues:" << std::endl;
-
-      std::span queues(data->pQueueLabels, data->queueLabelCount);
-      std::for_each(std::begin(queues), std::end(queues),
-                    [&msg_buf](const auto& label) {
-                      msg_buf << "  " << label.pLabelName << std::endl;
-                    });
-    }
-    if (data->cmdBufLabelCount > 0) {
-      msg_buf << "Command Buffers:" << std::endl;
-
-      std::span cmdBufLabels(data->pCmdBufLabels, data->cmdBufLabelCount);
-      std::for_each(std::begin(cmdBufLabels), std::end(cmdBufLabels),
-                    [&msg_buf](const auto& buf) {
-                      msg_buf << "  " << buf.pLabelName << std::endl;
-                    });
-    }
-    if (data->objectCount > 0) {
-      msg_buf << "Objects:" << std::endl;
-
-      std::span objects(data->pObjects, data->objectCount);
-      std::for_each(std::begin(objects), std::end(objects),
-                    [&msg_buf](const auto& obj) {
-                      msg_buf << "  " << to_string(obj.objectType);
-                      msg_buf << "(0x" << std::hex << obj.objectHandle << ")";
-                      if (obj.pObjectName) {
-                        msg_buf << " " << obj.pObjectName;
-                      }
-                      msg_buf << std::endl;
-                    });
-    }
-
-    err_data->cb({
-        .severity = sev,
-        .type = error_type,
-        .message = msg_buf.str(),
-        .user_data = err_data->user_data,
-    });
-  }
-  return VK_FALSE;
-}
-
 auto build_app_info(const DeviceConfig& config) -> VkApplicationInfo {
   return {
       .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
@@ -115,7 +46,7 @@ auto build_app_info(const DeviceConfig& config) -> VkApplicationInfo {
       .pEngineName = kEngineName,
       .engineVersion =
           VersionInfo{0, kEngineMajor, kEngineMinor, kEnginePatch}.to_vk(),
-      .apiVersion = VersionInfo{0, 1, 2, 0}.to_vk(),
+      .apiVersion = kApiVersion.to_vk(),
   };
 }
 
@@ -166,16 +97,19 @@ auto find_queue_families(VkPhysicalDevice device, VkSurfaceKHR surface)
       indices.transfer_family = i;
     }
 
-    VkBool32 present_support = VK_FALSE;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
-    if (present_support != VK_FALSE) {
-      indices.present_family = i;
+    if (surface != VK_NULL_HANDLE) {
+      VkBool32 present_support = VK_FALSE;
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface,
+                                           &present_support);
+      if (present_support != VK_FALSE) {
+        indices.present_family = i;
+      }
     }
 
     if (indices.graphics_family.has_value() &&
         indices.compute_family.has_value() &&
         indices.transfer_family.has_value() &&
-        indices.present_family.has_value()) {
+        (surface == VK_NULL_HANDLE || indices.present_family.has_value())) {
       return true;
     }
 
@@ -190,7 +124,8 @@ auto find_queue_families(VkPhysicalDevice device, VkSurfaceKHR surface)
   return {};
 }
 
-auto device_extensions(VkPhysicalDevice device)
+// Headless devices don't need the swapchain extension.
+auto device_extensions(VkPhysicalDevice device, bool headless)
     -> std::optional<std::vector<const char*>> {
   uint32_t count = 0;
   vkEnumerateDeviceExtensionProperties(device, nullptr, &count, nullptr);
@@ -198,8 +133,13 @@ auto device_extensions(VkPhysicalDevice device)
   std::vector<VkExtensionProperties> exts(count);
   vkEnumerateDeviceExtensionProperties(device, nullptr, &count, exts.data());
 
-  std::unordered_set<std::string> required_exts(std::begin(kDeviceExtensions),
-                                                std::end(kDeviceExtensions));
+  std::vector<const char*> ret;
+  if (!headless) {
+    ret.assign(std::begin(kDeviceExtensions), std::end(kDeviceExtensions));
+  }
+
+  std::unordered_set<std::string> required_exts(std::begin(ret),
+                                                std::end(ret));
   std::for_each(
       std::begin(exts), std::end(exts),
       [&required_exts](const VkExtensionProperties prop) {
@@ -209,8 +149,6 @@ auto device_extensions(VkPhysicalDevice device)
     return {};
   }
 
-  std::vector<const char*> ret(std::begin(kDeviceExtensions),
-                               std::end(kDeviceExtensions));
   if (std::any_of(std::begin(exts), std::end(exts),
                   [](const VkExtensionProperties prop) {
                     return std::string(
@@ -219,26 +157,150 @@ auto device_extensions(VkPhysicalDevice device)
                   })) {
     ret.push_back("VK_KHR_portability_subset");
   }
+  // Optional, lets MemoryBudget report usage across the whole system.
+  if (std::any_of(std::begin(exts), std::end(exts),
+                  [](const VkExtensionProperties prop) {
+                    return std::string(
+                               static_cast<const char*>(prop.extensionName)) ==
+                           VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+                  })) {
+    ret.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  }
   return std::move(ret);
 }
 
-auto is_device_suitable(const DeviceConfig& config,
-                        VkPhysicalDevice device,
-                        VkSurfaceKHR surface) -> bool {
+// What device selection learns about a physical device. The picked
+// device's probe is kept so creating the logical device queries nothing
+// twice.
+struct DeviceProbe {
+  Device::QueueFamilyIndices queue_families;
+  std::vector<const char*> extensions;
+  FeatureSet features;
+};
+
+// The cheap property checks run first so the surface is only queried for
+// devices which pass everything else.
+auto probe_device(const DeviceConfig& config,
+                  VkPhysicalDevice device,
+                  VkSurfaceKHR surface) -> std::optional<DeviceProbe> {
   VkPhysicalDeviceProperties props = {};
   vkGetPhysicalDeviceProperties(device, &props);
 
-  return props.apiVersion >= config.version().to_vk() &&
-         device_extensions(device).has_value() &&
-         Swapchain::query_swap_chain_support(device, surface) &&
-         find_queue_families(device, surface);
+  std::string_view name(static_cast<const char*>(props.deviceName));
+  if (name.find(config.device_name()) == std::string_view::npos) {
+    return {};
+  }
+  // The 1.1 and 1.2 feature structs may only be queried on 1.2 devices.
+  if (props.apiVersion < config.version().to_vk() ||
+      props.apiVersion < kApiVersion.to_vk()) {
+    return {};
+  }
+
+  auto headless = surface == VK_NULL_HANDLE;
+  auto extensions = device_extensions(device, headless);
+  if (!extensions.has_value()) {
+    return {};
+  }
+
+  FeatureChain chain;
+  chain.query(device);
+  if (!chain.features().contains(config.required_features())) {
+    return {};
+  }
+
+  auto families = find_queue_families(device, surface);
+  if (!families.has_value()) {
+    return {};
+  }
+  if (!headless && !Swapchain::query_swap_chain_support(device, surface)) {
+    return {};
+  }
+  return DeviceProbe{
+      .queue_families = families.value(),
+      .extensions = std::move(extensions.value()),
+      .features = chain.features(),
+  };
 }
 
 }  // namespace
 
+auto debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                    VkDebugUtilsMessageTypeFlagsEXT type,
+                    const VkDebugUtilsMessengerCallbackDataEXT* data,
+                    void* user_data) -> VkBool32 {
+  const auto* err_data = static_cast<ErrorData*>(user_data);
+
+  if (err_data != nullptr && err_data->cb) {
+    ErrorSeverity sev = ErrorSeverity::kError;
+    if ((severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) != 0) {
+      sev = ErrorSeverity::kWarning;
+    } else if ((severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) != 0) {
+      sev = ErrorSeverity::kInfo;
+    } else if ((severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT) !=
+               0) {
+      sev = ErrorSeverity::kVerbose;
+    }
+
+    ErrorType error_type = ErrorType::kGeneral;
+    if ((type & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT) != 0) {
+      error_type = ErrorType::kPerformance;
+    } else if ((type & VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT) != 0) {
+      error_type = ErrorType::kValidation;
+    }
+
+    std::stringstream msg_buf;
+    msg_buf << "Err: " << data->pMessage << std::endl;
+    if (data->pMessageIdName != nullptr) {
+      msg_buf << "MessageId (" << data->messageIdNumber
+              << "): " << data->pMessageIdName << std::endl;
+    }
+    if (data->queueLabelCount > 0) {
+      msg_buf << "Queues:" << std::endl;
+
+      std::span queues(data->pQueueLabels, data->queueLabelCount);
+      std::for_each(std::begin(queues), std::end(queues),
+                    [&msg_buf](const auto& label) {
+                      msg_buf << "  " << label.pLabelName << std::endl;
+                    });
+    }
+    if (data->cmdBufLabelCount > 0) {
+      msg_buf << "Command Buffers:" << std::endl;
+
+      std::span cmdBufLabels(data->pCmdBufLabels, data->cmdBufLabelCount);
+      std::for_each(std::begin(cmdBufLabels), std::end(cmdBufLabels),
+                    [&msg_buf](const auto& buf) {
+                      msg_buf << "  " << buf.pLabelName << std::endl;
+                    });
+    }
+    if (data->objectCount > 0) {
+      msg_buf << "Objects:" << std::endl;
+
+      std::span objects(data->pObjects, data->objectCount);
+      std::for_each(std::begin(objects), std::end(objects),
+                    [&msg_buf](const auto& obj) {
+                      msg_buf << "  " << to_string(obj.objectType);
+                      msg_buf << "(0x" << std::hex << obj.objectHandle << ")";
+                      if (obj.pObjectName) {
+                        msg_buf << " " << obj.pObjectName;
+                      }
+                      msg_buf << std::endl;
+                    });
+    }
+
+    err_data->cb({
+        .severity = sev,
+        .type = error_type,
+        .message = msg_buf.str(),
+        .user_data = err_data->user_data,
+    });
+  }
+  return VK_FALSE;
+}
+
 Device::Device(const DeviceConfig& config)
     : dimensions_cb_(config.dimensions_cb()),
       event_service_(config.event_service()),
+      error_data_(config.error_data()),
       enable_validation_(config.enable_validation()) {
   // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
   assert(dimensions_cb_);
@@ -246,12 +308,33 @@ Device::Device(const DeviceConfig& config)
   assert(event_service_ != nullptr);
 
   auto create_surface = config.surface_cb();
+  auto* timer = config.startup_timer();
+  auto phase = [timer](std::string_view name, const auto& fn) {
+    if (timer != nullptr) {
+      timer->time(name, fn);
+    } else {
+      fn();
+    }
+  };
 
-  create_instance(config);
-  create_surface(*this);
-  pick_physical_device(config);
-  create_logical_device();
-  create_command_pools();
+  phase("device/instance", [&] { create_instance(config); });
+  if (create_surface) {
+    phase("device/surface", [&] { create_surface(*this); });
+  }
+  phase("device/pick_physical_device", [&] { pick_physical_device(config); });
+  phase("device/logical_device", [&] { create_logical_device(config); });
+  phase("device/command_pools", [&] {
+    create_command_pools();
+    create_frame_timeline();
+  });
+
+  auto has_budget = std::any_of(
+      std::begin(device_extensions_), std::end(device_extensions_),
+      [](const char* ext) {
+        return std::string_view(ext) == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+      });
+  memory_budget_ = std::make_unique<MemoryBudget>(
+      physical_device_.device, physical_device_.memory_properties, has_budget);
 
   event_service_->add(
       el::EventType::kResized,
@@ -259,12 +342,19 @@ Device::Device(const DeviceConfig& config)
 }
 
 Device::~Device() {
+  vkDeviceWaitIdle(device_);
+  deletion_queue_.flush();
+
+  vkDestroySemaphore(device_, frame_timeline_, nullptr);
   vkDestroyCommandPool(device_, compute_cmd_pool_, nullptr);
   vkDestroyCommandPool(device_, transfer_cmd_pool_, nullptr);
   vkDestroyCommandPool(device_, graphics_cmd_pool_, nullptr);
 
   vkDestroyDevice(device_, nullptr);
-  vkDestroySurfaceKHR(instance_, surface_, nullptr);
+  std::for_each(std::begin(surfaces_), std::end(surfaces_),
+                [this](VkSurfaceKHR surface) {
+                  vkDestroySurfaceKHR(instance_, surface, nullptr);
+                });
 
   auto vkDestroyDebugUtilsMessengerEXT =
       // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
@@ -277,22 +367,182 @@ Device::~Device() {
   vkDestroyInstance(instance_, nullptr);
 }
 
-auto Device::find_queue_families() -> Device::QueueFamilyIndices {
-  auto indices =
-      el::engine::find_queue_families(physical_device_.device, surface_);
-  if (!indices.has_value()) {
-    throw std::runtime_error("Unable to retrieve queue family indices");
+auto Device::create_surface(const SurfaceCreateCallback& cb) -> VkSurfaceKHR {
+  auto surface = cb(instance_);
+  if (surfaces_.empty()) {
+    surface_ = surface;
+  }
+  surfaces_.push_back(surface);
+  return surface;
+}
+
+auto Device::destroy_surface(VkSurfaceKHR surface) -> void {
+  if (surface == surface_) {
+    throw std::runtime_error("The primary surface lives as long as the device");
+  }
+  auto it = std::find(std::begin(surfaces_), std::end(surfaces_), surface);
+  if (it == surfaces_.end()) {
+    return;
+  }
+  surfaces_.erase(it);
+  // Queued after the swapchain, so the deletion queue destroys that first.
+  defer([instance = instance_, surface]() {
+    vkDestroySurfaceKHR(instance, surface, nullptr);
+  });
+}
+
+auto Device::supports_present(VkSurfaceKHR surface) const -> bool {
+  if (!queue_families_.present_family.has_value()) {
+    return false;
   }
-  return indices.value();
+  VkBool32 supported = VK_FALSE;
+  vkGetPhysicalDeviceSurfaceSupportKHR(physical_device_.device,
+                                       queue_families_.present_family.value(),
+                                       surface, &supported);
+  return supported != VK_FALSE;
 }
 
-auto Device::create_logical_device() -> void {
-  auto indices = find_queue_families();
+auto Device::probe_queue_families(VkPhysicalDevice device,
+                                  VkSurfaceKHR surface)
+    -> std::optional<QueueFamilyIndices> {
+  return find_queue_families(device, surface);
+}
+
+auto Device::find_memory_type(uint32_t type_bits,
+                              VkMemoryPropertyFlags properties) const
+    -> std::optional<uint32_t> {
+  const auto& mem = physical_device_.memory_properties;
+  for (uint32_t i = 0; i < mem.memoryTypeCount; ++i) {
+    if ((type_bits & (1U << i)) == 0) {
+      continue;
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    if ((mem.memoryTypes[i].propertyFlags & properties) == properties) {
+      return i;
+    }
+  }
+  return {};
+}
+
+auto Device::begin_frame() -> uint64_t {
+  frame_ += 1;
+  deletion_queue_.collect(completed_frame());
+  memory_budget_->update();
+  return frame_;
+}
+
+auto Device::completed_frame() const -> uint64_t {
+  uint64_t completed = 0;
+  if (frame_ > kMaxFramesInFlight) {
+    completed = frame_ - kMaxFramesInFlight;
+  }
+
+  if (frame_timeline_ != VK_NULL_HANDLE) {
+    uint64_t value = 0;
+    if (vkGetSemaphoreCounterValue(device_, frame_timeline_, &value) ==
+        VK_SUCCESS) {
+      completed = std::max(completed, value);
+    }
+  }
+  return completed;
+}
+
+auto Device::allocate_memory(const VkMemoryAllocateInfo& info,
+                             VkDeviceMemory* memory) -> VkResult {
+  // Released resources are only destroyed once the GPU is done with them.
+  auto reclaim_and_retry = [this, &info, memory] {
+    vkDeviceWaitIdle(device_);
+    deletion_queue_.flush();
+    return vkAllocateMemory(device_, &info, nullptr, memory);
+  };
+
+  auto res = vkAllocateMemory(device_, &info, nullptr, memory);
+  if (res == VK_ERROR_OUT_OF_DEVICE_MEMORY && memory_pressure_cb_ &&
+      in_memory_pressure_) {
+    // An evictor replacing a resource with a smaller one. What the
+    // evictions before it released may already make room.
+    res = reclaim_and_retry();
+  } else if (res == VK_ERROR_OUT_OF_DEVICE_MEMORY && memory_pressure_cb_) {
+    auto types = std::span(physical_device_.memory_properties.memoryTypes);
+    auto heap = types[info.memoryTypeIndex].heapIndex;
+
+    in_memory_pressure_ = true;
+    auto released = false;
+    try {
+      released = memory_pressure_cb_(heap, info.allocationSize);
+    } catch (...) {
+      in_memory_pressure_ = false;
+      throw;
+    }
+    in_memory_pressure_ = false;
+
+    if (released) {
+      res = reclaim_and_retry();
+    }
+  }
+
+  if (res == VK_SUCCESS) {
+    memory_budget_->track_allocation(*memory, info.memoryTypeIndex,
+                                     info.allocationSize);
+  }
+  return res;
+}
+
+auto Device::free_memory(VkDeviceMemory memory) -> void {
+  memory_budget_->track_free(memory);
+  vkFreeMemory(device_, memory, nullptr);
+}
+
+auto Device::defer(Deleter deleter) -> void {
+  deletion_queue_.push(frame_, std::move(deleter));
+}
+
+auto Device::destroy_deferred(VkBuffer buffer) -> void {
+  defer([d = device_, buffer]() { vkDestroyBuffer(d, buffer, nullptr); });
+}
+
+auto Device::destroy_deferred(VkImage image) -> void {
+  defer([d = device_, image]() { vkDestroyImage(d, image, nullptr); });
+}
+
+auto Device::destroy_deferred(VkImageView view) -> void {
+  defer([d = device_, view]() { vkDestroyImageView(d, view, nullptr); });
+}
+
+auto Device::destroy_deferred(VkDeviceMemory memory) -> void {
+  defer([this, memory]() { free_memory(memory); });
+}
+
+auto Device::destroy_deferred(VkPipeline pipeline) -> void {
+  defer([d = device_, pipeline]() { vkDestroyPipeline(d, pipeline, nullptr); });
+}
+
+auto Device::destroy_deferred(VkFramebuffer framebuffer) -> void {
+  defer([d = device_, framebuffer]() {
+    vkDestroyFramebuffer(d, framebuffer, nullptr);
+  });
+}
+
+auto Device::destroy_deferred(VkSampler sampler) -> void {
+  defer([d = device_, sampler]() { vkDestroySampler(d, sampler, nullptr); });
+}
+
+auto Device::destroy_deferred(VkSwapchainKHR swapchain) -> void {
+  defer([d = device_, swapchain]() {
+    vkDestroySwapchainKHR(d, swapchain, nullptr);
+  });
+}
+
+auto Device::create_logical_device(const DeviceConfig& config) -> void {
+  const auto& indices = queue_families_;
 
   std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
   std::unordered_set<uint32_t> unique_queue_families = {
       indices.graphics_family.value(), indices.compute_family.value(),
-      indices.transfer_family.value(), indices.present_family.value()};
+      indices.transfer_family.value()};
+  if (indices.present_family.has_value()) {
+    unique_queue_families.insert(indices.present_family.value());
+  }
   float priority = 1.0F;
   std::for_each(std::begin(unique_queue_families),
                 std::end(unique_queue_families), [&](uint32_t idx) {
@@ -303,17 +553,24 @@ auto Device::create_logical_device() -> void {
                        .pQueuePriorities = &priority});
                 });
 
-  auto dev_exts = device_extensions(physical_device_.device).value();
-  VkPhysicalDeviceFeatures device_features{};
+  auto optional = config.optional_features() & supported_features_;
+  enabled_features_ = config.required_features() | optional;
+
+  FeatureChain enabled;
+  enabled.enable(enabled_features_);
+  physical_device_.features = enabled.core();
+
+  const auto& dev_exts = device_extensions_;
   VkDeviceCreateInfo create_info = {
       .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+      .pNext = enabled.head(),
       .queueCreateInfoCount = uint32_t(queue_create_infos.size()),
       .pQueueCreateInfos = queue_create_infos.data(),
       .enabledLayerCount = 0,
       .ppEnabledLayerNames = nullptr,
       .enabledExtensionCount = uint32_t(dev_exts.size()),
       .ppEnabledExtensionNames = dev_exts.data(),
-      .pEnabledFeatures = &device_features,
+      .pEnabledFeatures = nullptr,
   };
 
   auto res =
@@ -328,11 +585,33 @@ auto Device::create_logical_device() -> void {
   vkGetDeviceQueue(device_, indices.compute_family.value(), 0, &compute_queue_);
   vkGetDeviceQueue(device_, indices.transfer_family.value(), 0,
                    &transfer_queue_);
-  vkGetDeviceQueue(device_, indices.present_family.value(), 0, &present_queue_);
+  if (indices.present_family.has_value()) {
+    vkGetDeviceQueue(device_, indices.present_family.value(), 0,
+                     &present_queue_);
+  }
+
+  report_optional_features(config.optional_features(), optional);
+}
+
+auto Device::report_optional_features(const FeatureSet& requested,
+                                      const FeatureSet& enabled) const
+    -> void {
+  if (error_data_ == nullptr || !error_data_->cb || requested.empty()) {
+    return;
+  }
+
+  auto msg = std::string("Optional device features enabled: ")
+                 .append(enabled.empty() ? "none" : enabled.to_string());
+  error_data_->cb({
+      .severity = ErrorSeverity::kInfo,
+      .type = ErrorType::kGeneral,
+      .message = msg,
+      .user_data = error_data_->user_data,
+  });
 }
 
 auto Device::create_command_pools() -> void {
-  auto indices = find_queue_families();
+  const auto& indices = queue_families_;
 
   struct PoolInfo {
     uint32_t index = 0;
@@ -371,6 +650,29 @@ auto Device::create_command_pools() -> void {
   std::for_each(std::begin(pools), std::end(pools), cmd_pool_creator);
 }
 
+void Device::create_frame_timeline() {
+  if (!has_feature(Feature::kTimelineSemaphore)) {
+    return;
+  }
+
+  VkSemaphoreTypeCreateInfo type_info = {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+      .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+      .initialValue = 0,
+  };
+  VkSemaphoreCreateInfo create_info = {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+      .pNext = &type_info,
+  };
+
+  auto res =
+      vkCreateSemaphore(device_, &create_info, nullptr, &frame_timeline_);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(std::string("Failed to create frame timeline: ")
+                                 .append(to_string(res)));
+  }
+}
+
 void Device::check_validation_available_if_needed() const {
   if (!enable_validation_) {
     return;
@@ -447,8 +749,10 @@ void Device::pick_physical_device(const DeviceConfig& config) {
   std::vector<VkPhysicalDevice> devices(count);
   vkEnumeratePhysicalDevices(instance_, &count, devices.data());
 
-  auto is_suitable = [&](const auto& device) noexcept {
-    return is_device_suitable(config, device, surface_);
+  std::optional<DeviceProbe> probe;
+  auto is_suitable = [&](const auto& device) {
+    probe = probe_device(config, device, surface_);
+    return probe.has_value();
   };
   auto iter = std::find_if(std::begin(devices), std::end(devices), is_suitable);
   if (iter == devices.end()) {
@@ -456,6 +760,13 @@ void Device::pick_physical_device(const DeviceConfig& config) {
   }
 
   physical_device_.device = *iter;
+  queue_families_ = probe->queue_families;
+  device_extensions_ = std::move(probe->extensions);
+  supported_features_ = probe->features;
+  vkGetPhysicalDeviceProperties(physical_device_.device,
+                                &physical_device_.properties);
+  vkGetPhysicalDeviceMemoryProperties(physical_device_.device,
+                                      &physical_device_.memory_properties);
 }
 
 void Device::create_instance(const DeviceConfig& config) {
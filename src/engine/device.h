@@ -8,17 +8,35 @@
 #include <vector>
 
 #include "src/dimensions.h"
+#include "src/engine/deletion_queue.h"
 #include "src/engine/error.h"
+#include "src/engine/features.h"
+#include "src/engine/memory_budget.h"
 #include "src/engine/version.h"
 #include "src/engine/vk.h"
 #include "src/event_service.h"
 #include "src/pad.h"
+#include "src/startup_timer.h"
 
 namespace el::engine {
 
+// Number of frames the CPU may record ahead of the GPU.
+constexpr uint32_t kMaxFramesInFlight = 2;
+
 class Device;
 using SurfaceCallback = std::function<void(Device&)>;
 using SurfaceCreateCallback = std::function<VkSurfaceKHR(VkInstance)>;
+// Asked to free |bytes| of memory in |heap| when an allocation ran out of
+// device memory. Returns whether anything was released.
+using MemoryPressureCallback =
+    std::function<bool(uint32_t heap, VkDeviceSize bytes)>;
+
+// The VK_EXT_debug_utils messenger callback. Maps the message onto an Error
+// for the ErrorData passed as |user_data|, which may be null.
+auto debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                    VkDebugUtilsMessageTypeFlagsEXT type,
+                    const VkDebugUtilsMessengerCallbackDataEXT* data,
+                    void* user_data) -> VkBool32;
 
 struct PhysicalDevice {
   VkPhysicalDevice device = VK_NULL_HANDLE;
@@ -62,16 +80,44 @@ class DeviceConfig {
     return *this;
   }
 
+  // Without a surface callback the device is headless: no surface or
+  // swapchain extension is required, and there is no present queue.
   auto set_surface_cb(SurfaceCallback cb) -> DeviceConfig& {
     surface_cb_ = std::move(cb);
     return *this;
   }
 
+  // Only considers devices whose name contains |name|, such as "llvmpipe"
+  // for lavapipe. Empty considers every device.
+  auto set_device_name(std::string_view name) -> DeviceConfig& {
+    device_name_ = name;
+    return *this;
+  }
+
   auto set_event_service(EventService* event_service) -> DeviceConfig& {
     event_service_ = event_service;
     return *this;
   }
 
+  // Records each construction phase, may be null.
+  auto set_startup_timer(StartupTimer* timer) -> DeviceConfig& {
+    startup_timer_ = timer;
+    return *this;
+  }
+
+  // Devices missing any required feature are never picked.
+  auto set_required_features(const FeatureSet& features) -> DeviceConfig& {
+    required_features_ = features;
+    return *this;
+  }
+
+  // Enabled when the picked device supports them. Query the result with
+  // Device::has_feature() to choose between code paths at runtime.
+  auto set_optional_features(const FeatureSet& features) -> DeviceConfig& {
+    optional_features_ = features;
+    return *this;
+  }
+
   [[nodiscard]] auto enable_validation() const -> bool {
     return enable_validation_;
   }
@@ -87,9 +133,21 @@ class DeviceConfig {
   [[nodiscard]] auto surface_cb() const -> SurfaceCallback {
     return surface_cb_;
   }
+  [[nodiscard]] auto device_name() const -> std::string_view {
+    return device_name_;
+  }
   [[nodiscard]] auto event_service() const -> EventService* {
     return event_service_;
   }
+  [[nodiscard]] auto startup_timer() const -> StartupTimer* {
+    return startup_timer_;
+  }
+  [[nodiscard]] auto required_features() const -> const FeatureSet& {
+    return required_features_;
+  }
+  [[nodiscard]] auto optional_features() const -> const FeatureSet& {
+    return optional_features_;
+  }
 
  private:
   std::string_view app_name_;
@@ -98,7 +156,11 @@ class DeviceConfig {
   VersionInfo version_ = {};
   DimensionsCallback dimensions_cb_;
   SurfaceCallback surface_cb_;
+  std::string device_name_;
   EventService* event_service_ = nullptr;
+  StartupTimer* startup_timer_ = nullptr;
+  FeatureSet required_features_;
+  FeatureSet optional_features_;
 
   bool enable_validation_ = false;
   EL_PAD(7);
@@ -123,9 +185,17 @@ class Device {
 
   auto set_resized() -> void { framebuffer_resized_ = true; }
 
-  auto create_surface(const SurfaceCreateCallback& cb) -> void {
-    surface_ = cb(instance_);
-  }
+  // Creates a surface owned by the device. The first one is the primary
+  // surface which the physical device and present queue are picked for,
+  // created from the surface callback; later ones, for further windows,
+  // share the device and are checked with supports_present().
+  auto create_surface(const SurfaceCreateCallback& cb) -> VkSurfaceKHR;
+  // Destroys a surface other than the primary one once the GPU has finished
+  // the current frame. Its swapchain must be destroyed first.
+  auto destroy_surface(VkSurfaceKHR surface) -> void;
+
+  // Whether the present queue can present to |surface|.
+  [[nodiscard]] auto supports_present(VkSurfaceKHR surface) const -> bool;
 
   [[nodiscard]] auto device() const -> VkDevice { return device_; }
 
@@ -133,13 +203,124 @@ class Device {
     return physical_device_.device;
   }
 
+  [[nodiscard]] auto physical_device_info() const -> const PhysicalDevice& {
+    return physical_device_;
+  }
+
+  // Features enabled on the logical device, required and supported optional.
+  [[nodiscard]] auto features() const -> const FeatureSet& {
+    return enabled_features_;
+  }
+
+  [[nodiscard]] auto has_feature(Feature f) const -> bool {
+    return enabled_features_.has(f);
+  }
+
+  // The primary surface, VK_NULL_HANDLE on headless devices.
   [[nodiscard]] auto surface() const -> VkSurfaceKHR { return surface_; }
+  [[nodiscard]] auto surfaces() const -> const std::vector<VkSurfaceKHR>& {
+    return surfaces_;
+  }
+  [[nodiscard]] auto headless() const -> bool {
+    return surface_ == VK_NULL_HANDLE;
+  }
 
   [[nodiscard]] auto dimensions() const -> Dimensions {
     return dimensions_cb_();
   }
 
-  [[nodiscard]] auto find_queue_families() -> QueueFamilyIndices;
+  // Probed once while picking the physical device.
+  [[nodiscard]] auto queue_families() const -> const QueueFamilyIndices& {
+    return queue_families_;
+  }
+
+  // Queries the queue families of |device|, including present support for
+  // |surface| unless it is VK_NULL_HANDLE. Empty when a required family is
+  // missing.
+  [[nodiscard]] static auto probe_queue_families(VkPhysicalDevice device,
+                                                 VkSurfaceKHR surface)
+      -> std::optional<QueueFamilyIndices>;
+
+  [[nodiscard]] auto graphics_queue() const -> VkQueue {
+    return graphics_queue_;
+  }
+  // Passes recorded for this queue skip their barriers against graphics
+  // work, whose stages can't be named here; the semaphores their caller
+  // submits them with order them against the graphics queue instead.
+  [[nodiscard]] auto compute_queue() const -> VkQueue { return compute_queue_; }
+  [[nodiscard]] auto transfer_queue() const -> VkQueue {
+    return transfer_queue_;
+  }
+  // VK_NULL_HANDLE on headless devices.
+  [[nodiscard]] auto present_queue() const -> VkQueue { return present_queue_; }
+
+  [[nodiscard]] auto graphics_cmd_pool() const -> VkCommandPool {
+    return graphics_cmd_pool_;
+  }
+  [[nodiscard]] auto compute_cmd_pool() const -> VkCommandPool {
+    return compute_cmd_pool_;
+  }
+  [[nodiscard]] auto transfer_cmd_pool() const -> VkCommandPool {
+    return transfer_cmd_pool_;
+  }
+
+  // Index of a memory type allowed by |type_bits| which has all of
+  // |properties|, if there is one.
+  [[nodiscard]] auto find_memory_type(uint32_t type_bits,
+                                      VkMemoryPropertyFlags properties) const
+      -> std::optional<uint32_t>;
+
+  // Starts a new CPU frame and returns its index. The caller must already
+  // have waited on the fence of frame `index - kMaxFramesInFlight`, which
+  // lets everything queued for destruction up to that frame be released.
+  auto begin_frame() -> uint64_t;
+
+  [[nodiscard]] auto frame() const -> uint64_t { return frame_; }
+
+  // Newest frame the GPU is known to have finished, from the frames in
+  // flight contract of begin_frame() or the frame timeline, whichever is
+  // further along.
+  [[nodiscard]] auto completed_frame() const -> uint64_t;
+
+  // Timeline semaphore renderers may signal with the frame index from the
+  // last submission of a frame so resources are released as soon as the GPU
+  // passes it. VK_NULL_HANDLE unless timelineSemaphore is enabled.
+  [[nodiscard]] auto frame_timeline() const -> VkSemaphore {
+    return frame_timeline_;
+  }
+
+  // Destroys the handle once the GPU has finished the current frame.
+  auto destroy_deferred(VkBuffer buffer) -> void;
+  auto destroy_deferred(VkImage image) -> void;
+  auto destroy_deferred(VkImageView view) -> void;
+  auto destroy_deferred(VkDeviceMemory memory) -> void;
+  auto destroy_deferred(VkPipeline pipeline) -> void;
+  auto destroy_deferred(VkFramebuffer framebuffer) -> void;
+  auto destroy_deferred(VkSampler sampler) -> void;
+  auto destroy_deferred(VkSwapchainKHR swapchain) -> void;
+
+  // Runs |deleter| once the GPU has finished the current frame.
+  auto defer(Deleter deleter) -> void;
+
+  // vkAllocateMemory, tracked in memory_budget(). When the heap is out of
+  // memory the memory pressure callback may release resources, after which
+  // the device is drained and the allocation retried once. That stalls, so
+  // it is a last resort; keep usage under budget with a ResidencyManager.
+  auto allocate_memory(const VkMemoryAllocateInfo& info,
+                       VkDeviceMemory* memory) -> VkResult;
+  // Frees right away, see destroy_deferred() for memory the GPU may use.
+  auto free_memory(VkDeviceMemory memory) -> void;
+
+  auto set_memory_pressure_cb(MemoryPressureCallback cb) -> void {
+    memory_pressure_cb_ = std::move(cb);
+  }
+
+  [[nodiscard]] auto memory_budget() -> MemoryBudget& {
+    return *memory_budget_;
+  }
+  [[nodiscard]] auto memory_budget() const -> const MemoryBudget& {
+    return *memory_budget_;
+  }
 
  private:
   void check_validation_available_if_needed() const;
@@ -149,17 +330,27 @@ class Device {
       VkDebugUtilsMessengerCreateInfoEXT* debug_create_info);
   void create_instance(const DeviceConfig& config);
   void pick_physical_device(const DeviceConfig& config);
-  void create_logical_device();
+  void create_logical_device(const DeviceConfig& config);
+  void report_optional_features(const FeatureSet& requested,
+                                const FeatureSet& enabled) const;
   void create_command_pools();
+  void create_frame_timeline();
 
   DimensionsCallback dimensions_cb_;
   EventService* event_service_;
+  ErrorData* error_data_ = nullptr;
 
   VkInstance instance_ = {};
   VkDebugUtilsMessengerEXT debug_handler_{};
   PhysicalDevice physical_device_;
+  // Probe results of the picked device, kept for creating the logical device.
+  QueueFamilyIndices queue_families_;
+  std::vector<const char*> device_extensions_;
+  FeatureSet supported_features_;
+  FeatureSet enabled_features_;
   VkDevice device_{};
   VkSurfaceKHR surface_{};
+  std::vector<VkSurfaceKHR> surfaces_;
   VkQueue graphics_queue_{};
   VkQueue compute_queue_{};
   VkQueue transfer_queue_{};
@@ -169,10 +360,20 @@ class Device {
   VkCommandPool transfer_cmd_pool_{};
   VkCommandPool compute_cmd_pool_{};
 
+  DeletionQueue deletion_queue_;
+  VkSemaphore frame_timeline_{};
+  uint64_t frame_ = 0;
+
+  std::unique_ptr<MemoryBudget> memory_budget_;
+  MemoryPressureCallback memory_pressure_cb_;
+
   bool enable_validation_ = false;
   bool framebuffer_resized_ = false;
+  // Set while the memory pressure callback runs, so allocations it makes
+  // don't recurse into it.
+  bool in_memory_pressure_ = false;
 
-  EL_PAD(6);
+  EL_PAD(5);
 };
 
 }  // namespace el::engine
@@ -0,0 +1,149 @@
+#include "src/engine/draw_list.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace el::engine {
+namespace {
+
+constexpr uint32_t kRadixBits = 8;
+constexpr uint32_t kRadixPasses = 64 / kRadixBits;
+constexpr size_t kBuckets = size_t{1} << kRadixBits;
+constexpr uint64_t kDigitMask = kBuckets - 1;
+
+auto digit(uint64_t key, uint32_t pass) -> size_t {
+  return size_t((key >> (pass * kRadixBits)) & kDigitMask);
+}
+
+// The inverse of DrawKey::pack().
+auto unpack(uint64_t key, DrawOrder order) -> DrawKey {
+  auto field = [key](uint32_t shift, uint64_t bits) {
+    return uint16_t((key >> shift) & ((uint64_t{1} << bits) - 1));
+  };
+  if (order == DrawOrder::kBackToFront) {
+    return {.pass = uint16_t(key >> 60),
+            .pipeline = field(32, 12),
+            .material = field(16, 16),
+            .mesh = field(0, 16),
+            .depth = uint16_t(~field(44, 16))};
+  }
+  return {.pass = uint16_t(key >> 60),
+          .pipeline = field(48, 12),
+          .material = field(32, 16),
+          .mesh = field(16, 16),
+          .depth = field(0, 16)};
+}
+
+}  // namespace
+
+auto DrawList::add(const DrawKey& key, uint32_t instance) -> void {
+  if (key.pass >= kMaxDrawPasses || key.pipeline >= kMaxDrawPipelines) {
+    throw std::runtime_error(std::string("Draw key out of range: pass ")
+                                 .append(std::to_string(key.pass))
+                                 .append(", pipeline ")
+                                 .append(std::to_string(key.pipeline)));
+  }
+  auto order = orders_.at(key.pass);
+  entries_.push_back(
+      {.key = key.pack(order), .instance = instance, .order = order});
+}
+
+auto DrawList::clear() -> void {
+  entries_.clear();
+  batches_.clear();
+  instances_.clear();
+}
+
+auto DrawList::sort() -> void {
+  // LSD radix sort, one byte per pass. All the histograms come from a single
+  // read of the keys, and digits every key shares, like the unused high bits
+  // of small ids, are skipped without moving anything.
+  std::array<std::array<uint32_t, kBuckets>, kRadixPasses> counts = {};
+  for (const auto& e : entries_) {
+    for (uint32_t p = 0; p < kRadixPasses; ++p) {
+      ++counts.at(p).at(digit(e.key, p));
+    }
+  }
+
+  scratch_.resize(entries_.size());
+  for (uint32_t p = 0; p < kRadixPasses; ++p) {
+    auto& count = counts.at(p);
+    if (entries_.empty() ||
+        count.at(digit(entries_.front().key, p)) == entries_.size()) {
+      continue;
+    }
+
+    // Bucket offsets from the counts.
+    uint32_t offset = 0;
+    for (auto& c : count) {
+      offset += std::exchange(c, offset);
+    }
+    for (const auto& e : entries_) {
+      scratch_[count.at(digit(e.key, p))++] = e;
+    }
+    entries_.swap(scratch_);
+  }
+
+  batches_.clear();
+  instances_.resize(entries_.size());
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const auto& e = entries_[i];
+    instances_[i] = e.instance;
+
+    auto key = unpack(e.key, e.order);
+    if (!batches_.empty()) {
+      auto& last = batches_.back();
+      if (last.pass == key.pass && last.pipeline == key.pipeline &&
+          last.material == key.material && last.mesh == key.mesh) {
+        ++last.instance_count;
+        continue;
+      }
+    }
+    batches_.push_back({
+        .pass = key.pass,
+        .pipeline = key.pipeline,
+        .material = key.material,
+        .mesh = key.mesh,
+        .first_instance = uint32_t(i),
+        .instance_count = 1,
+    });
+  }
+}
+
+auto DrawList::batches(uint32_t pass) const -> std::span<const DrawBatch> {
+  auto [first, last] = std::equal_range(
+      std::begin(batches_), std::end(batches_), DrawBatch{.pass = pass},
+      [](const DrawBatch& a, const DrawBatch& b) { return a.pass < b.pass; });
+  return {first, last};
+}
+
+auto DrawList::record(VkCommandBuffer cmd,
+                      uint32_t pass,
+                      const DrawCallbacks& callbacks) const -> DrawStats {
+  DrawStats stats;
+  const DrawBatch* bound = nullptr;
+  for (const auto& batch : batches(pass)) {
+    auto new_pipeline = bound == nullptr || bound->pipeline != batch.pipeline;
+    if (new_pipeline) {
+      callbacks.bind_pipeline(cmd, batch.pipeline);
+      ++stats.pipeline_binds;
+    }
+    if (new_pipeline || bound->material != batch.material) {
+      callbacks.bind_material(cmd, batch.pipeline, batch.material);
+      ++stats.material_binds;
+    }
+    if (bound == nullptr || bound->mesh != batch.mesh) {
+      callbacks.bind_mesh(cmd, batch.mesh);
+      ++stats.mesh_binds;
+    }
+    callbacks.draw(cmd, batch);
+    ++stats.draws;
+    stats.instances += batch.instance_count;
+    bound = &batch;
+  }
+  return stats;
+}
+
+}  // namespace el::engine
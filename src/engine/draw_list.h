@@ -0,0 +1,167 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "src/engine/vk.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+constexpr uint32_t kMaxDrawPasses = 16;
+constexpr uint32_t kMaxDrawPipelines = 4096;
+// DrawKey::pack() masks with them.
+static_assert((kMaxDrawPasses & (kMaxDrawPasses - 1)) == 0);
+static_assert((kMaxDrawPipelines & (kMaxDrawPipelines - 1)) == 0);
+
+// How draws within a pass are ordered.
+enum class DrawOrder : uint8_t {
+  // By pipeline, material and mesh, then front to back, minimizing state
+  // changes. For opaque geometry.
+  kState,
+  // Back to front first, then by state. For blended geometry.
+  kBackToFront,
+};
+
+// What a draw needs bound, as small ids the caller maps to its own
+// pipelines, descriptor sets and meshes.
+struct DrawKey {
+  uint16_t pass = 0;
+  uint16_t pipeline = 0;
+  uint16_t material = 0;
+  uint16_t mesh = 0;
+  // Quantized view depth, see depth_bucket().
+  uint16_t depth = 0;
+
+  // Packs the key so sorting the integers orders the draws as |order|
+  // asks. Bits, from the top:
+  //   kState:       pass:4 pipeline:12 material:16 mesh:16 depth:16
+  //   kBackToFront: pass:4 ~depth:16 pipeline:12 material:16 mesh:16
+  //
+  // Pass and pipeline are masked to their widths so an out of range id can
+  // never spill into a neighboring field; DrawList::add() rejects them.
+  [[nodiscard]] constexpr auto pack(DrawOrder order) const -> uint64_t {
+    auto packed_pass = uint64_t{pass} & (kMaxDrawPasses - 1);
+    auto state = ((uint64_t{pipeline} & (kMaxDrawPipelines - 1)) << 32) |
+                 (uint64_t{material} << 16) | uint64_t{mesh};
+    if (order == DrawOrder::kBackToFront) {
+      return (packed_pass << 60) | (uint64_t{uint16_t(~depth)} << 44) | state;
+    }
+    return (packed_pass << 60) | (state << 16) | uint64_t{depth};
+  }
+};
+
+// Maps |depth| in [0, 1], such as view depth over the far plane, to a
+// bucket. Out of range values are clamped and NaN maps to bucket 0.
+constexpr auto depth_bucket(float depth) -> uint16_t {
+  constexpr auto kMax = float(UINT16_MAX);
+  auto scaled = depth * kMax;
+  // Written so NaN fails the comparison.
+  if (!(scaled > 0.0F)) {
+    return 0;
+  }
+  return scaled >= kMax ? UINT16_MAX : uint16_t(scaled);
+}
+
+// Consecutive draws of the same pipeline, material and mesh, merged into
+// one instanced draw.
+struct DrawBatch {
+  uint32_t pass = 0;
+  uint32_t pipeline = 0;
+  uint32_t material = 0;
+  uint32_t mesh = 0;
+  // Range of DrawList::instances(), passed as the draw's firstInstance and
+  // instanceCount.
+  uint32_t first_instance = 0;
+  uint32_t instance_count = 0;
+};
+
+// Called by DrawList::record() only when what is bound has to change.
+struct DrawCallbacks {
+  std::function<void(VkCommandBuffer cmd, uint32_t pipeline)> bind_pipeline;
+  // Also called after every pipeline change, as pipelines with different
+  // layouts disturb bound descriptor sets.
+  std::function<
+      void(VkCommandBuffer cmd, uint32_t pipeline, uint32_t material)>
+      bind_material;
+  std::function<void(VkCommandBuffer cmd, uint32_t mesh)> bind_mesh;
+  std::function<void(VkCommandBuffer cmd, const DrawBatch& batch)> draw;
+};
+
+struct DrawStats {
+  uint32_t draws = 0;
+  uint32_t instances = 0;
+  uint32_t pipeline_binds = 0;
+  uint32_t material_binds = 0;
+  uint32_t mesh_binds = 0;
+};
+
+// A frame's draws, collected in any order, radix sorted by their packed
+// keys and merged into instanced batches.
+//
+// Each draw carries a caller defined instance index, typically into the
+// frame's per object data. After sort(), instances() lists them in batch
+// order; uploading it lets shaders fetch their object as
+// instances[gl_InstanceIndex], with each batch drawn from first_instance.
+class DrawList {
+ public:
+  DrawList() = default;
+  DrawList(const DrawList&) = delete;
+  DrawList(DrawList&&) = delete;
+  ~DrawList() = default;
+
+  auto operator=(const DrawList&) -> DrawList& = delete;
+  auto operator=(DrawList&&) -> DrawList& = delete;
+
+  // Passes are ordered by state unless set otherwise. Applies to draws
+  // added afterwards.
+  auto set_order(uint32_t pass, DrawOrder order) -> void {
+    orders_.at(pass) = order;
+  }
+
+  // Throws if the key's pass or pipeline is out of range.
+  auto add(const DrawKey& key, uint32_t instance) -> void;
+
+  // Drops the draws, keeping the memory for the next frame.
+  auto clear() -> void;
+
+  // Sorts the draws and builds the batches.
+  auto sort() -> void;
+
+  // Records |pass|'s batches, skipping binds of what is already bound.
+  auto record(VkCommandBuffer cmd,
+              uint32_t pass,
+              const DrawCallbacks& callbacks) const -> DrawStats;
+
+  [[nodiscard]] auto size() const -> size_t { return entries_.size(); }
+  [[nodiscard]] auto batches() const -> std::span<const DrawBatch> {
+    return batches_;
+  }
+  // The batches of |pass|, which are contiguous.
+  [[nodiscard]] auto batches(uint32_t pass) const
+      -> std::span<const DrawBatch>;
+  [[nodiscard]] auto instances() const -> std::span<const uint32_t> {
+    return instances_;
+  }
+
+ private:
+  struct Entry {
+    uint64_t key = 0;
+    uint32_t instance = 0;
+    // Which layout |key| was packed with.
+    DrawOrder order = DrawOrder::kState;
+    EL_PAD(3);
+  };
+
+  std::vector<Entry> entries_;
+  // Ping-pong buffer for the radix passes.
+  std::vector<Entry> scratch_;
+  std::vector<DrawBatch> batches_;
+  std::vector<uint32_t> instances_;
+  std::array<DrawOrder, kMaxDrawPasses> orders_ = {};
+};
+
+}  // namespace el::engine
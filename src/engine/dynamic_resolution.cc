@@ -0,0 +1,113 @@
+#include "src/engine/dynamic_resolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "src/engine/device.h"
+
+namespace el::engine {
+namespace {
+
+// Scales move in steps of this, so small jitter in the frame times doesn't
+// resize every frame.
+constexpr double kScaleStep = 0.025;
+// Largest increase of a single change. Decreases are not limited, a frame
+// over budget is worse than one rendered a little softer.
+constexpr double kMaxScaleUp = 0.05;
+// GPU times arrive once the frame's fence has signaled, so the frames
+// already in flight were recorded at the old scale.
+constexpr uint32_t kSettleFrames = kMaxFramesInFlight + 1;
+
+}  // namespace
+
+DynamicResolution::DynamicResolution(const DynamicResolutionConfig& config)
+    : budget_ms_(config.budget_ms()),
+      min_scale_(config.min_scale()),
+      max_scale_(std::max(config.min_scale(), config.max_scale())),
+      smoothing_(std::clamp(config.smoothing(), 0.0, 1.0)),
+      headroom_(config.headroom()),
+      scale_(max_scale_),
+      granularity_(std::max(1U, config.granularity())) {}
+
+auto DynamicResolution::update(double gpu_ms) -> bool {
+  if (smoothed_ms_ <= 0) {
+    smoothed_ms_ = gpu_ms;
+  } else {
+    smoothed_ms_ += (gpu_ms - smoothed_ms_) * smoothing_;
+  }
+
+  if (settle_frames_ > 0) {
+    --settle_frames_;
+    return false;
+  }
+
+  // GPU time is roughly proportional to the pixel count, the square of the
+  // scale.
+  auto target = scale_;
+  if (smoothed_ms_ > budget_ms_) {
+    target = scale_ * std::sqrt(budget_ms_ / smoothed_ms_);
+    target = std::floor(target / kScaleStep) * kScaleStep;
+  } else if (smoothed_ms_ < budget_ms_ * headroom_) {
+    target = scale_ * std::sqrt(budget_ms_ * headroom_ / smoothed_ms_);
+    target = std::min(target, scale_ + kMaxScaleUp);
+    target = std::floor(target / kScaleStep) * kScaleStep;
+  }
+  target = std::clamp(target, min_scale_, max_scale_);
+  if (std::abs(target - scale_) < kScaleStep / 2) {
+    return false;
+  }
+
+  // Expected time at the new scale, so the smoothing doesn't have to catch
+  // up with the change before the next one.
+  auto ratio = target / scale_;
+  smoothed_ms_ *= ratio * ratio;
+  scale_ = target;
+  settle_frames_ = kSettleFrames;
+  return true;
+}
+
+auto DynamicResolution::render_extent(VkExtent2D output) const -> VkExtent2D {
+  return scaled(output, scale_);
+}
+
+auto DynamicResolution::max_extent(VkExtent2D output) const -> VkExtent2D {
+  return scaled(output, max_scale_);
+}
+
+auto DynamicResolution::scaled(VkExtent2D output, double scale) const
+    -> VkExtent2D {
+  auto side = [this, scale](uint32_t size) {
+    auto scaled = uint32_t(double(size) * scale);
+    scaled -= scaled % granularity_;
+    return std::max(scaled, std::min(size, granularity_));
+  };
+  return {.width = side(output.width), .height = side(output.height)};
+}
+
+auto record_upscale(VkCommandBuffer cmd,
+                    VkImage src,
+                    VkExtent2D src_extent,
+                    VkImage dst,
+                    VkExtent2D dst_extent) -> void {
+  VkImageBlit region = {
+      .srcSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                         .mipLevel = 0,
+                         .baseArrayLayer = 0,
+                         .layerCount = 1},
+      .srcOffsets = {{0, 0, 0},
+                     {int32_t(src_extent.width), int32_t(src_extent.height),
+                      1}},
+      .dstSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                         .mipLevel = 0,
+                         .baseArrayLayer = 0,
+                         .layerCount = 1},
+      .dstOffsets = {{0, 0, 0},
+                     {int32_t(dst_extent.width), int32_t(dst_extent.height),
+                      1}},
+  };
+  vkCmdBlitImage(cmd, src, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst,
+                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region,
+                 VK_FILTER_LINEAR);
+}
+
+}  // namespace el::engine
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+
+#include "src/engine/vk.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+// A 60Hz frame.
+constexpr double kDefaultFrameBudgetMs = 1000.0 / 60.0;
+constexpr double kDefaultMinScale = 0.5;
+constexpr double kDefaultMaxScale = 1.0;
+// Weight of the newest GPU time in the smoothed one.
+constexpr double kDefaultSmoothing = 0.1;
+// Share of the budget the smoothed GPU time has to stay under before the
+// scale goes back up, so it doesn't flip back and forth at the budget.
+constexpr double kDefaultHeadroom = 0.85;
+// Render extents are rounded down to a multiple of this.
+constexpr uint32_t kDefaultGranularity = 8;
+
+class DynamicResolutionConfig {
+ public:
+  // GPU time per frame the render scale is adjusted to meet.
+  auto set_budget_ms(double ms) -> DynamicResolutionConfig& {
+    budget_ms_ = ms;
+    return *this;
+  }
+
+  // Bounds of the scale applied to both sides of the output extent.
+  auto set_min_scale(double scale) -> DynamicResolutionConfig& {
+    min_scale_ = scale;
+    return *this;
+  }
+  auto set_max_scale(double scale) -> DynamicResolutionConfig& {
+    max_scale_ = scale;
+    return *this;
+  }
+
+  auto set_smoothing(double smoothing) -> DynamicResolutionConfig& {
+    smoothing_ = smoothing;
+    return *this;
+  }
+
+  auto set_headroom(double headroom) -> DynamicResolutionConfig& {
+    headroom_ = headroom;
+    return *this;
+  }
+
+  auto set_granularity(uint32_t granularity) -> DynamicResolutionConfig& {
+    granularity_ = granularity;
+    return *this;
+  }
+
+  [[nodiscard]] auto budget_ms() const -> double { return budget_ms_; }
+  [[nodiscard]] auto min_scale() const -> double { return min_scale_; }
+  [[nodiscard]] auto max_scale() const -> double { return max_scale_; }
+  [[nodiscard]] auto smoothing() const -> double { return smoothing_; }
+  [[nodiscard]] auto headroom() const -> double { return headroom_; }
+  [[nodiscard]] auto granularity() const -> uint32_t { return granularity_; }
+
+ private:
+  double budget_ms_ = kDefaultFrameBudgetMs;
+  double min_scale_ = kDefaultMinScale;
+  double max_scale_ = kDefaultMaxScale;
+  double smoothing_ = kDefaultSmoothing;
+  double headroom_ = kDefaultHeadroom;
+  uint32_t granularity_ = kDefaultGranularity;
+  EL_PAD(4);
+};
+
+// Sizes the internal render resolution from measured GPU frame times, such
+// as GpuTimer's, lowering it when frames go over budget and raising it back
+// while there is headroom.
+//
+// Render targets are allocated once at max_extent() and rendered into at
+// render_extent(), so changing the scale never reallocates. The result is
+// upscaled to the output, the Swapchain extent, with record_upscale().
+class DynamicResolution {
+ public:
+  explicit DynamicResolution(const DynamicResolutionConfig& config);
+
+  // Feeds the GPU time of a finished frame. Returns whether the scale
+  // changed.
+  auto update(double gpu_ms) -> bool;
+
+  [[nodiscard]] auto scale() const -> double { return scale_; }
+  // GPU time smoothed over the last frames. 0 before the first update().
+  [[nodiscard]] auto smoothed_ms() const -> double { return smoothed_ms_; }
+
+  // Extent to render at for an |output| sized presentation.
+  [[nodiscard]] auto render_extent(VkExtent2D output) const -> VkExtent2D;
+  // Extent to allocate render targets at, the render extent at max scale.
+  [[nodiscard]] auto max_extent(VkExtent2D output) const -> VkExtent2D;
+
+ private:
+  [[nodiscard]] auto scaled(VkExtent2D output, double scale) const
+      -> VkExtent2D;
+
+  double budget_ms_ = 0;
+  double min_scale_ = 0;
+  double max_scale_ = 0;
+  double smoothing_ = 0;
+  double headroom_ = 0;
+  double scale_ = 0;
+  double smoothed_ms_ = 0;
+  // Frames left before the last change shows up in the measured times.
+  uint32_t settle_frames_ = 0;
+  uint32_t granularity_ = 0;
+};
+
+// Records a linear filtered blit of the |src_extent| corner of |src| onto
+// all of |dst|. |src| must be in TRANSFER_SRC_OPTIMAL and |dst|, such as a
+// writable() swapchain image, in TRANSFER_DST_OPTIMAL layout.
+auto record_upscale(VkCommandBuffer cmd,
+                    VkImage src,
+                    VkExtent2D src_extent,
+                    VkImage dst,
+                    VkExtent2D dst_extent) -> void;
+
+}  // namespace el::engine
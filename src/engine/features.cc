@@ -0,0 +1,159 @@
+#include "src/engine/features.h"
+
+#include <stdexcept>
+#include <string>
+
+#include "src/engine/vk.h"
+
+namespace el::engine {
+
+auto feature_name(Feature f) -> std::string_view {
+  switch (f) {
+    case Feature::kMultiDrawIndirect:
+      return "multiDrawIndirect";
+    case Feature::kDrawIndirectFirstInstance:
+      return "drawIndirectFirstInstance";
+    case Feature::kFillModeNonSolid:
+      return "fillModeNonSolid";
+    case Feature::kSamplerAnisotropy:
+      return "samplerAnisotropy";
+    case Feature::kTextureCompressionBC:
+      return "textureCompressionBC";
+    case Feature::kShaderInt64:
+      return "shaderInt64";
+    case Feature::kShaderInt16:
+      return "shaderInt16";
+    case Feature::kStorageBuffer16BitAccess:
+      return "storageBuffer16BitAccess";
+    case Feature::kShaderDrawParameters:
+      return "shaderDrawParameters";
+    case Feature::kDrawIndirectCount:
+      return "drawIndirectCount";
+    case Feature::kStorageBuffer8BitAccess:
+      return "storageBuffer8BitAccess";
+    case Feature::kShaderInt8:
+      return "shaderInt8";
+    case Feature::kShaderFloat16:
+      return "shaderFloat16";
+    case Feature::kDescriptorIndexing:
+      return "descriptorIndexing";
+    case Feature::kRuntimeDescriptorArray:
+      return "runtimeDescriptorArray";
+    case Feature::kDescriptorBindingPartiallyBound:
+      return "descriptorBindingPartiallyBound";
+    case Feature::kSampledImageArrayNonUniformIndexing:
+      return "shaderSampledImageArrayNonUniformIndexing";
+    case Feature::kScalarBlockLayout:
+      return "scalarBlockLayout";
+    case Feature::kHostQueryReset:
+      return "hostQueryReset";
+    case Feature::kTimelineSemaphore:
+      return "timelineSemaphore";
+    case Feature::kBufferDeviceAddress:
+      return "bufferDeviceAddress";
+    case Feature::kCount:
+      break;
+  }
+  return "unknown";
+}
+
+auto FeatureSet::to_string() const -> std::string {
+  std::string ret;
+  for (size_t i = 0; i < kFeatureCount; ++i) {
+    if (!bits_.test(i)) {
+      continue;
+    }
+    if (!ret.empty()) {
+      ret.append(", ");
+    }
+    ret.append(feature_name(static_cast<Feature>(i)));
+  }
+  return ret;
+}
+
+FeatureChain::FeatureChain() {
+  features12_.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  features11_.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+  features11_.pNext = &features12_;
+  features2_.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features2_.pNext = &features11_;
+}
+
+template <typename Self>
+auto FeatureChain::bit(Self& self, Feature f) -> auto& {
+  auto& core = self.features2_.features;
+  auto& v11 = self.features11_;
+  auto& v12 = self.features12_;
+
+  switch (f) {
+    case Feature::kMultiDrawIndirect:
+      return core.multiDrawIndirect;
+    case Feature::kDrawIndirectFirstInstance:
+      return core.drawIndirectFirstInstance;
+    case Feature::kFillModeNonSolid:
+      return core.fillModeNonSolid;
+    case Feature::kSamplerAnisotropy:
+      return core.samplerAnisotropy;
+    case Feature::kTextureCompressionBC:
+      return core.textureCompressionBC;
+    case Feature::kShaderInt64:
+      return core.shaderInt64;
+    case Feature::kShaderInt16:
+      return core.shaderInt16;
+    case Feature::kStorageBuffer16BitAccess:
+      return v11.storageBuffer16BitAccess;
+    case Feature::kShaderDrawParameters:
+      return v11.shaderDrawParameters;
+    case Feature::kDrawIndirectCount:
+      return v12.drawIndirectCount;
+    case Feature::kStorageBuffer8BitAccess:
+      return v12.storageBuffer8BitAccess;
+    case Feature::kShaderInt8:
+      return v12.shaderInt8;
+    case Feature::kShaderFloat16:
+      return v12.shaderFloat16;
+    case Feature::kDescriptorIndexing:
+      return v12.descriptorIndexing;
+    case Feature::kRuntimeDescriptorArray:
+      return v12.runtimeDescriptorArray;
+    case Feature::kDescriptorBindingPartiallyBound:
+      return v12.descriptorBindingPartiallyBound;
+    case Feature::kSampledImageArrayNonUniformIndexing:
+      return v12.shaderSampledImageArrayNonUniformIndexing;
+    case Feature::kScalarBlockLayout:
+      return v12.scalarBlockLayout;
+    case Feature::kHostQueryReset:
+      return v12.hostQueryReset;
+    case Feature::kTimelineSemaphore:
+      return v12.timelineSemaphore;
+    case Feature::kBufferDeviceAddress:
+      return v12.bufferDeviceAddress;
+    case Feature::kCount:
+      break;
+  }
+  throw std::logic_error("Unknown device feature");
+}
+
+auto FeatureChain::query(VkPhysicalDevice device) -> void {
+  vkGetPhysicalDeviceFeatures2(device, &features2_);
+}
+
+auto FeatureChain::features() const -> FeatureSet {
+  FeatureSet ret;
+  for (size_t i = 0; i < kFeatureCount; ++i) {
+    auto f = static_cast<Feature>(i);
+    ret.set(f, bit(*this, f) != VK_FALSE);
+  }
+  return ret;
+}
+
+auto FeatureChain::enable(const FeatureSet& features) -> void {
+  for (size_t i = 0; i < kFeatureCount; ++i) {
+    auto f = static_cast<Feature>(i);
+    if (features.has(f)) {
+      bit(*this, f) = VK_TRUE;
+    }
+  }
+}
+
+}  // namespace el::engine
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+#include "src/engine/vk.h"
+
+namespace el::engine {
+
+// Device features the engine knows how to negotiate. Each maps onto a single
+// VkBool32 in the Vulkan 1.0, 1.1 or 1.2 feature structs.
+enum class Feature : uint32_t {
+  // Vulkan 1.0
+  kMultiDrawIndirect,
+  kDrawIndirectFirstInstance,
+  kFillModeNonSolid,
+  kSamplerAnisotropy,
+  kTextureCompressionBC,
+  kShaderInt64,
+  kShaderInt16,
+  // Vulkan 1.1
+  kStorageBuffer16BitAccess,
+  kShaderDrawParameters,
+  // Vulkan 1.2
+  kDrawIndirectCount,
+  kStorageBuffer8BitAccess,
+  kShaderInt8,
+  kShaderFloat16,
+  kDescriptorIndexing,
+  kRuntimeDescriptorArray,
+  kDescriptorBindingPartiallyBound,
+  kSampledImageArrayNonUniformIndexing,
+  kScalarBlockLayout,
+  kHostQueryReset,
+  kTimelineSemaphore,
+  kBufferDeviceAddress,
+
+  kCount,
+};
+
+constexpr auto kFeatureCount = static_cast<size_t>(Feature::kCount);
+
+class FeatureSet {
+ public:
+  FeatureSet() = default;
+  FeatureSet(std::initializer_list<Feature> features) {
+    for (auto f : features) {
+      set(f);
+    }
+  }
+
+  auto set(Feature f, bool value = true) -> FeatureSet& {
+    bits_.set(static_cast<size_t>(f), value);
+    return *this;
+  }
+
+  [[nodiscard]] auto has(Feature f) const -> bool {
+    return bits_.test(static_cast<size_t>(f));
+  }
+
+  [[nodiscard]] auto contains(const FeatureSet& other) const -> bool {
+    return (bits_ & other.bits_) == other.bits_;
+  }
+
+  [[nodiscard]] auto empty() const -> bool { return bits_.none(); }
+
+  [[nodiscard]] auto operator&(const FeatureSet& other) const -> FeatureSet {
+    FeatureSet ret;
+    ret.bits_ = bits_ & other.bits_;
+    return ret;
+  }
+
+  [[nodiscard]] auto operator|(const FeatureSet& other) const -> FeatureSet {
+    FeatureSet ret;
+    ret.bits_ = bits_ | other.bits_;
+    return ret;
+  }
+
+  // Comma separated list of the Vulkan names of the features in the set.
+  [[nodiscard]] auto to_string() const -> std::string;
+
+ private:
+  std::bitset<kFeatureCount> bits_;
+};
+
+auto feature_name(Feature f) -> std::string_view;
+
+// The chained VkPhysicalDeviceFeatures2 / Vulkan11 / Vulkan12 structs used to
+// both query and enable features. The chain links to itself, so it cannot be
+// copied or moved.
+class FeatureChain {
+ public:
+  FeatureChain();
+  FeatureChain(const FeatureChain&) = delete;
+  FeatureChain(FeatureChain&&) = delete;
+  ~FeatureChain() = default;
+
+  auto operator=(const FeatureChain&) -> FeatureChain& = delete;
+  auto operator=(FeatureChain&&) -> FeatureChain& = delete;
+
+  // Fills the chain with what |device| supports.
+  auto query(VkPhysicalDevice device) -> void;
+
+  [[nodiscard]] auto features() const -> FeatureSet;
+  auto enable(const FeatureSet& features) -> void;
+
+  // Head of the chain, suitable for VkDeviceCreateInfo::pNext.
+  [[nodiscard]] auto head() -> VkPhysicalDeviceFeatures2* {
+    return &features2_;
+  }
+  [[nodiscard]] auto core() const -> const VkPhysicalDeviceFeatures& {
+    return features2_.features;
+  }
+
+ private:
+  // Returns the VkBool32 backing |f| in |self|'s chain.
+  template <typename Self>
+  static auto bit(Self& self, Feature f) -> auto&;
+
+  VkPhysicalDeviceFeatures2 features2_{};
+  VkPhysicalDeviceVulkan11Features features11_{};
+  VkPhysicalDeviceVulkan12Features features12_{};
+};
+
+}  // namespace el::engine
@@ -0,0 +1,233 @@
+#include "src/engine/frame_sink.h"
+
+#include <pthread.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace el::engine {
+namespace {
+
+constexpr size_t kPpmTexelSize = 3;
+
+auto is_bgra8(VkFormat format) -> bool {
+  return format == VK_FORMAT_B8G8R8A8_UNORM ||
+         format == VK_FORMAT_B8G8R8A8_SRGB;
+}
+
+auto is_rgba8(VkFormat format) -> bool {
+  return format == VK_FORMAT_R8G8B8A8_UNORM ||
+         format == VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+}  // namespace
+
+FrameSink::FrameSink(const FrameSinkConfig& config)
+    : directory_(config.directory()),
+      max_queued_(std::max(1U, config.max_queued())),
+      format_(config.format()) {
+  if (directory_.empty() == config.command().empty()) {
+    throw std::runtime_error(
+        "Frame sinks need either a directory or a command");
+  }
+
+  if (!directory_.empty()) {
+    std::filesystem::create_directories(directory_);
+  } else {
+    auto command = std::string(config.command());
+    pipe_ = popen(command.c_str(), "w");
+    if (pipe_ == nullptr) {
+      throw std::runtime_error(
+          std::string("Failed to start frame encoder: ").append(command));
+    }
+  }
+
+  thread_ = std::thread([this] { run(); });
+}
+
+FrameSink::~FrameSink() {
+  try {
+    close();
+  } catch (const std::exception&) {
+    // Nothing to report to from a destructor; call close() to see errors.
+  }
+}
+
+auto FrameSink::write(const ReadbackImage& image) -> void {
+  if (format_ == FrameFormat::kPpm && !is_rgba8(image.format) &&
+      !is_bgra8(image.format)) {
+    throw std::runtime_error("PPM frames need 8 bit RGBA or BGRA images");
+  }
+
+  std::unique_lock<std::mutex> lock(lock_);
+  space_cv_.wait(lock, [this] {
+    return queue_.size() < max_queued_ || error_ != nullptr;
+  });
+  if (error_ != nullptr) {
+    std::rethrow_exception(error_);
+  }
+
+  Frame frame{.format = image.format, .extent = image.extent};
+  if (!free_.empty()) {
+    frame.data = std::move(free_.back());
+    free_.pop_back();
+  }
+  frame.data.assign(std::begin(image.data), std::end(image.data));
+  queue_.push_back(std::move(frame));
+  lock.unlock();
+
+  work_cv_.notify_one();
+}
+
+auto FrameSink::written() const -> uint64_t {
+  const std::lock_guard<std::mutex> lock(lock_);
+  return written_;
+}
+
+auto FrameSink::close() -> void {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    const std::lock_guard<std::mutex> lock(lock_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  thread_.join();
+
+  // The writer thread flushed every frame, so pclose() has nothing left to
+  // write into a closed pipe.
+  auto status = 0;
+  if (pipe_ != nullptr) {
+    status = pclose(pipe_);
+    pipe_ = nullptr;
+  }
+  if (error_ != nullptr) {
+    std::rethrow_exception(error_);
+  }
+  if (status == -1) {
+    throw std::runtime_error("Failed to wait for the frame encoder");
+  }
+  if (WIFSIGNALED(status)) {
+    throw std::runtime_error(
+        std::string("Frame encoder killed by signal ")
+            .append(std::to_string(WTERMSIG(status))));
+  }
+  if (WEXITSTATUS(status) != 0) {
+    throw std::runtime_error(
+        std::string("Frame encoder exited with status ")
+            .append(std::to_string(WEXITSTATUS(status))));
+  }
+}
+
+auto FrameSink::run() -> void {
+  if (pipe_ != nullptr) {
+    // Writing to an encoder which exited raises SIGPIPE, killing the whole
+    // process. Blocked, the write fails with EPIPE instead.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+  }
+
+  std::unique_lock<std::mutex> lock(lock_);
+  for (;;) {
+    work_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+
+    auto frame = std::move(queue_.front());
+    queue_.pop_front();
+    auto index = written_;
+    // After a failure the queue is only drained, so write() can't block.
+    auto failed = error_ != nullptr;
+    lock.unlock();
+
+    std::exception_ptr error;
+    if (!failed) {
+      try {
+        write_frame(frame, index);
+      } catch (...) {
+        error = std::current_exception();
+      }
+    }
+
+    lock.lock();
+    if (error != nullptr) {
+      error_ = error;
+    } else if (!failed) {
+      written_ += 1;
+    }
+    free_.push_back(std::move(frame.data));
+    space_cv_.notify_all();
+  }
+}
+
+auto FrameSink::write_frame(const Frame& frame, uint64_t index) -> void {
+  std::ofstream file;
+  std::string path;
+  if (pipe_ == nullptr) {
+    std::ostringstream name;
+    name << directory_ << "/frame_" << std::setw(6) << std::setfill('0')
+         << index << (format_ == FrameFormat::kPpm ? ".ppm" : ".raw");
+    path = name.str();
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      throw std::runtime_error(
+          std::string("Failed to open frame file: ").append(path));
+    }
+  }
+
+  auto put = [this, &file](const void* data, size_t size) {
+    if (pipe_ == nullptr) {
+      file.write(static_cast<const char*>(data), std::streamsize(size));
+    } else if (std::fwrite(data, 1, size, pipe_) != size) {
+      throw std::runtime_error("Failed to write frame to the encoder");
+    }
+  };
+
+  if (format_ == FrameFormat::kRaw) {
+    put(frame.data.data(), frame.data.size());
+  } else {
+    std::ostringstream header;
+    header << "P6\n" << frame.extent.width << " " << frame.extent.height
+           << "\n255\n";
+    auto text = header.str();
+    put(text.data(), text.size());
+
+    // Swaps BGRA back to RGB order and drops alpha, a row at a time.
+    auto red = is_bgra8(frame.format) ? 2U : 0U;
+    auto blue = 2U - red;
+    row_.resize(size_t{frame.extent.width} * kPpmTexelSize);
+    auto texels = std::span(frame.data);
+    for (uint32_t y = 0; y < frame.extent.height; ++y) {
+      auto src = texels.subspan(size_t{y} * frame.extent.width * 4);
+      for (size_t x = 0; x < frame.extent.width; ++x) {
+        row_[x * kPpmTexelSize] = src[x * 4 + red];
+        row_[x * kPpmTexelSize + 1] = src[x * 4 + 1];
+        row_[x * kPpmTexelSize + 2] = src[x * 4 + blue];
+      }
+      put(row_.data(), row_.size());
+    }
+  }
+
+  if (pipe_ == nullptr && !file) {
+    throw std::runtime_error(
+        std::string("Failed to write frame file: ").append(path));
+  }
+  // Hands the frame over now, so a closed pipe fails this frame.
+  if (pipe_ != nullptr && std::fflush(pipe_) != 0) {
+    throw std::runtime_error("Failed to write frame to the encoder");
+  }
+}
+
+}  // namespace el::engine
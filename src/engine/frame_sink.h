@@ -0,0 +1,138 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "src/engine/readback.h"
+#include "src/engine/vk.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+constexpr uint32_t kDefaultMaxQueuedFrames = 8;
+
+enum class FrameFormat : uint8_t {
+  // Texels exactly as read back, without a header.
+  kRaw,
+  // Binary 8 bit RGB PPM. Only for 8 bit RGBA and BGRA images.
+  kPpm,
+};
+
+class FrameSinkConfig {
+ public:
+  // Writes each frame to its own numbered file, frame_000000.ppm and so on,
+  // in |dir|.
+  auto set_directory(std::string_view dir) -> FrameSinkConfig& {
+    directory_ = dir;
+    return *this;
+  }
+
+  // Pipes all frames, back to back, into the standard input of |command|,
+  // such as an encoder:
+  //   ffmpeg -f image2pipe -c:v ppm -i - out.mp4
+  auto set_command(std::string_view command) -> FrameSinkConfig& {
+    command_ = command;
+    return *this;
+  }
+
+  auto set_format(FrameFormat format) -> FrameSinkConfig& {
+    format_ = format;
+    return *this;
+  }
+
+  // write() blocks once this many frames are waiting to be written.
+  auto set_max_queued(uint32_t frames) -> FrameSinkConfig& {
+    max_queued_ = frames;
+    return *this;
+  }
+
+  [[nodiscard]] auto directory() const -> std::string_view {
+    return directory_;
+  }
+  [[nodiscard]] auto command() const -> std::string_view { return command_; }
+  [[nodiscard]] auto format() const -> FrameFormat { return format_; }
+  [[nodiscard]] auto max_queued() const -> uint32_t { return max_queued_; }
+
+ private:
+  std::string directory_;
+  std::string command_;
+  uint32_t max_queued_ = kDefaultMaxQueuedFrames;
+  FrameFormat format_ = FrameFormat::kPpm;
+  EL_PAD(3);
+};
+
+// Writes read back frames to disk, or to an encoder process, on a thread of
+// its own so file IO never holds up the frame. Pass callback() to a
+// ReadbackService to capture every frame it reads back.
+//
+// A disk or encoder slower than the renderer eventually blocks write(),
+// throttling rendering rather than dropping frames or buffering without
+// bound. An encoder that exits early fails the next write() instead of
+// raising SIGPIPE.
+class FrameSink {
+ public:
+  explicit FrameSink(const FrameSinkConfig& config);
+  FrameSink(const FrameSink&) = delete;
+  FrameSink(FrameSink&&) = delete;
+  // Same as close(), but errors are dropped.
+  ~FrameSink();
+
+  auto operator=(const FrameSink&) -> FrameSink& = delete;
+  auto operator=(FrameSink&&) -> FrameSink& = delete;
+
+  // Copies |image| and queues it for writing. Rethrows the first error the
+  // writer thread ran into.
+  auto write(const ReadbackImage& image) -> void;
+
+  [[nodiscard]] auto callback() -> ReadbackCallback {
+    return [this](const ReadbackImage& image) { write(image); };
+  }
+
+  // Frames written so far.
+  [[nodiscard]] auto written() const -> uint64_t;
+
+  // Writes everything still queued and waits for the encoder to exit.
+  // Throws when a frame couldn't be written or the encoder didn't exit
+  // cleanly. No frames may be written afterwards.
+  auto close() -> void;
+
+ private:
+  struct Frame {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent = {};
+    EL_PAD(4);
+    std::vector<std::byte> data;
+  };
+
+  auto run() -> void;
+  auto write_frame(const Frame& frame, uint64_t index) -> void;
+
+  std::string directory_;
+  FILE* pipe_ = nullptr;
+  uint32_t max_queued_ = 0;
+  FrameFormat format_ = FrameFormat::kPpm;
+  bool stop_ = false;
+  EL_PAD(2);
+  uint64_t written_ = 0;
+
+  mutable std::mutex lock_;
+  std::condition_variable work_cv_;
+  std::condition_variable space_cv_;
+  std::deque<Frame> queue_;
+  // Buffers of written frames, reused by write().
+  std::vector<std::vector<std::byte>> free_;
+  std::exception_ptr error_;
+  std::vector<std::byte> row_;
+  std::thread thread_;
+};
+
+}  // namespace el::engine
@@ -0,0 +1,174 @@
+#include "src/engine/gpu_cull.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace el::engine {
+namespace {
+
+// Push constants of src/shaders/cull.comp.
+struct CullParams {
+  std::array<math::Plane, 6> planes = {};
+  uint32_t instance_count = 0;
+};
+
+}  // namespace
+
+GpuCuller::GpuCuller(const GpuCullerConfig& config)
+    : device_(config.device()),
+      capacity_(config.capacity()),
+      instances_(BufferConfig(config.device())
+                     .set_size(VkDeviceSize{capacity_} * sizeof(CullInstance))
+                     .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+                     .set_compute_shared(config.async_compute())),
+      draws_(BufferConfig(config.device())
+                 .set_size(VkDeviceSize{capacity_} *
+                           sizeof(VkDrawIndexedIndirectCommand))
+                 .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+                 .set_compute_shared(config.async_compute())),
+      count_(BufferConfig(config.device())
+                 .set_size(sizeof(uint32_t))
+                 .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                            VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+                 .set_compute_shared(config.async_compute())) {
+  if (!device_->has_feature(Feature::kDrawIndirectCount) ||
+      !device_->has_feature(Feature::kMultiDrawIndirect) ||
+      !device_->has_feature(Feature::kDrawIndirectFirstInstance)) {
+    throw std::runtime_error(
+        "GPU culling requires drawIndirectCount, multiDrawIndirect and "
+        "drawIndirectFirstInstance");
+  }
+
+  std::array<VkDescriptorSetLayoutBinding, 3> bindings = {};
+  for (uint32_t i = 0; i < bindings.size(); ++i) {
+    bindings.at(i) = {
+        .binding = i,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+    };
+  }
+  auto set_layout = config.descriptors()->layout(bindings);
+
+  VkPushConstantRange push_range = {
+      .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+      .offset = 0,
+      .size = sizeof(CullParams),
+  };
+  VkPipelineLayoutCreateInfo layout_info = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .setLayoutCount = 1,
+      .pSetLayouts = &set_layout,
+      .pushConstantRangeCount = 1,
+      .pPushConstantRanges = &push_range,
+  };
+  auto res = vkCreatePipelineLayout(device_->device(), &layout_info, nullptr,
+                                    &layout_);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to create culling pipeline layout: ")
+            .append(to_string(res)));
+  }
+
+  PipelineState state;
+  state.shaders = {config.shader()};
+  state.layout = layout_;
+  pipeline_ = config.pipelines()->get_blocking(state);
+
+  std::array<DescriptorWrite, 3> writes = {
+      DescriptorWrite{
+          .buffer = {instances_.buffer(), 0, VK_WHOLE_SIZE},
+          .binding = 0,
+          .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      },
+      DescriptorWrite{
+          .buffer = {draws_.buffer(), 0, VK_WHOLE_SIZE},
+          .binding = 1,
+          .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      },
+      DescriptorWrite{
+          .buffer = {count_.buffer(), 0, VK_WHOLE_SIZE},
+          .binding = 2,
+          .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      },
+  };
+  set_ = config.descriptors()->allocate_immutable(set_layout, writes);
+}
+
+GpuCuller::~GpuCuller() {
+  // The pipeline belongs to the registry.
+  vkDestroyPipelineLayout(device_->device(), layout_, nullptr);
+}
+
+auto GpuCuller::set_instances(StagingUploader* uploader,
+                              std::span<const CullInstance> instances)
+    -> void {
+  if (instances.size() > capacity_) {
+    throw std::runtime_error(
+        std::string("Too many instances to cull: ")
+            .append(std::to_string(instances.size())));
+  }
+
+  if (used_frame_ > device_->completed_frame()) {
+    check(vkDeviceWaitIdle(device_->device()), "wait for culling to finish");
+  }
+  uploader->upload(instances_, 0, std::as_bytes(instances));
+  uploader->flush();
+  instance_count_ = uint32_t(instances.size());
+}
+
+auto GpuCuller::record(VkCommandBuffer cmd, const math::Frustum& frustum)
+    -> void {
+  used_frame_ = device_->frame();
+
+  // Last frame's draws have to be done reading the outputs before they are
+  // overwritten.
+  vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT |
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+  vkCmdFillBuffer(cmd, count_.buffer(), 0, sizeof(uint32_t), 0);
+
+  VkMemoryBarrier cleared = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+  };
+  vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &cleared, 0,
+                       nullptr, 0, nullptr);
+
+  CullParams params = {
+      .planes = frustum.planes,
+      .instance_count = instance_count_,
+  };
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
+  vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout_, 0, 1,
+                          &set_, 0, nullptr);
+  vkCmdPushConstants(cmd, layout_, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                     sizeof(params), &params);
+  vkCmdDispatch(cmd, (instance_count_ + kCullGroupSize - 1) / kCullGroupSize,
+                1, 1);
+
+  VkMemoryBarrier culled = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+  };
+  vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &culled, 0,
+                       nullptr, 0, nullptr);
+}
+
+auto GpuCuller::draw(VkCommandBuffer cmd) const -> void {
+  vkCmdDrawIndexedIndirectCount(cmd, draws_.buffer(), 0, count_.buffer(), 0,
+                                instance_count_,
+                                sizeof(VkDrawIndexedIndirectCommand));
+}
+
+}  // namespace el::engine
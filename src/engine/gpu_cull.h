@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "src/engine/buffer.h"
+#include "src/engine/descriptor_allocator.h"
+#include "src/engine/device.h"
+#include "src/engine/pipeline_registry.h"
+#include "src/engine/shader.h"
+#include "src/engine/uploader.h"
+#include "src/engine/vk.h"
+#include "src/math/geometry.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+constexpr uint32_t kDefaultCullCapacity = 65536;
+// Matches local_size_x in src/shaders/cull.comp.
+constexpr uint32_t kCullGroupSize = 64;
+
+// One culling candidate and the draw emitted for it when visible. Laid out
+// as the Instance struct of src/shaders/cull.comp.
+struct CullInstance {
+  // World space bounding sphere, xyz center and w radius.
+  std::array<float, 4> sphere = {};
+  uint32_t index_count = 0;
+  uint32_t first_index = 0;
+  int32_t vertex_offset = 0;
+  // Passed through as the draw's firstInstance, usually the index of the
+  // instance's data for the vertex shader.
+  uint32_t first_instance = 0;
+};
+static_assert(sizeof(CullInstance) == 32);
+
+class GpuCullerConfig {
+ public:
+  // |shader| is the compute shader built from src/shaders/cull.comp.
+  GpuCullerConfig(Device* device,
+                  DescriptorAllocator* descriptors,
+                  PipelineRegistry* pipelines,
+                  const Shader* shader)
+      : device_(device),
+        descriptors_(descriptors),
+        pipelines_(pipelines),
+        shader_(shader) {}
+
+  // Maximum number of instances, and so of draws.
+  auto set_capacity(uint32_t capacity) -> GpuCullerConfig& {
+    capacity_ = capacity;
+    return *this;
+  }
+
+  // Shares the output buffers between the graphics and compute families so
+  // culling can be recorded on the compute queue.
+  auto set_async_compute() -> GpuCullerConfig& {
+    async_compute_ = true;
+    return *this;
+  }
+
+  [[nodiscard]] auto device() const -> Device* { return device_; }
+  [[nodiscard]] auto descriptors() const -> DescriptorAllocator* {
+    return descriptors_;
+  }
+  [[nodiscard]] auto pipelines() const -> PipelineRegistry* {
+    return pipelines_;
+  }
+  [[nodiscard]] auto shader() const -> const Shader* { return shader_; }
+  [[nodiscard]] auto capacity() const -> uint32_t { return capacity_; }
+  [[nodiscard]] auto async_compute() const -> bool { return async_compute_; }
+
+ private:
+  Device* device_ = nullptr;
+  DescriptorAllocator* descriptors_ = nullptr;
+  PipelineRegistry* pipelines_ = nullptr;
+  const Shader* shader_ = nullptr;
+  uint32_t capacity_ = kDefaultCullCapacity;
+  bool async_compute_ = false;
+  EL_PAD(3);
+};
+
+// Frustum culling on the GPU. A compute pass tests every instance's bounding
+// sphere and appends a VkDrawIndexedIndirectCommand for each visible one,
+// along with a count, which draw() then consumes with
+// vkCmdDrawIndexedIndirectCount. The CPU cost per frame is a dispatch and a
+// draw call regardless of the number of instances.
+//
+// record() may go on the graphics queue before the draws, or on the compute
+// queue when configured with set_async_compute(); then the caller orders the
+// compute submission before the graphics one with a semaphore.
+class GpuCuller {
+ public:
+  explicit GpuCuller(const GpuCullerConfig& config);
+  GpuCuller(const GpuCuller&) = delete;
+  GpuCuller(GpuCuller&&) = delete;
+  ~GpuCuller();
+
+  auto operator=(const GpuCuller&) -> GpuCuller& = delete;
+  auto operator=(GpuCuller&&) -> GpuCuller& = delete;
+
+  // Replaces the instances to cull. Throws if there are more than the
+  // configured capacity. The instances live in a single buffer, so when a
+  // frame recorded with the old ones may still be running this waits for the
+  // device to go idle; change them between scenes, not every frame.
+  auto set_instances(StagingUploader* uploader,
+                     std::span<const CullInstance> instances) -> void;
+
+  // Records the culling pass for the device's current frame. The results
+  // are ready for indirect reads at VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+  // afterwards.
+  auto record(VkCommandBuffer cmd, const math::Frustum& frustum) -> void;
+
+  // Draws the visible instances. The caller binds the graphics pipeline,
+  // descriptor sets and the vertex and index buffers the instances refer to.
+  auto draw(VkCommandBuffer cmd) const -> void;
+
+  [[nodiscard]] auto capacity() const -> uint32_t { return capacity_; }
+  [[nodiscard]] auto instance_count() const -> uint32_t {
+    return instance_count_;
+  }
+
+ private:
+  Device* device_ = nullptr;
+  uint32_t capacity_ = 0;
+  uint32_t instance_count_ = 0;
+  // Last frame which read instances_.
+  uint64_t used_frame_ = 0;
+  Buffer instances_;
+  Buffer draws_;
+  Buffer count_;
+  VkPipelineLayout layout_ = VK_NULL_HANDLE;
+  VkPipeline pipeline_ = VK_NULL_HANDLE;
+  VkDescriptorSet set_ = VK_NULL_HANDLE;
+};
+
+}  // namespace el::engine
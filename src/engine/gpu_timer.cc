@@ -0,0 +1,84 @@
+#include "src/engine/gpu_timer.h"
+
+#include <array>
+#include <stdexcept>
+#include <string>
+
+namespace el::engine {
+
+GpuTimer::GpuTimer(Device* device, uint32_t slots)
+    : device_(device), pending_(slots) {
+  const auto& limits = device_->physical_device_info().properties.limits;
+  auto family = device_->queue_families().graphics_family.value();
+
+  uint32_t count = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(device_->physical_device(), &count,
+                                           nullptr);
+  std::vector<VkQueueFamilyProperties> families(count);
+  vkGetPhysicalDeviceQueueFamilyProperties(device_->physical_device(), &count,
+                                           families.data());
+
+  auto bits = families.at(family).timestampValidBits;
+  if (bits == 0 || limits.timestampPeriod <= 0.0F) {
+    return;
+  }
+
+  VkQueryPoolCreateInfo create_info = {
+      .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+      .queryType = VK_QUERY_TYPE_TIMESTAMP,
+      .queryCount = slots * 2,
+  };
+  auto res =
+      vkCreateQueryPool(device_->device(), &create_info, nullptr, &pool_);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to create timestamp query pool: ")
+            .append(to_string(res)));
+  }
+
+  mask_ = bits >= 64 ? UINT64_MAX : (uint64_t{1} << bits) - 1;
+  period_ns_ = double(limits.timestampPeriod);
+}
+
+GpuTimer::~GpuTimer() {
+  if (pool_ != VK_NULL_HANDLE) {
+    vkDestroyQueryPool(device_->device(), pool_, nullptr);
+  }
+}
+
+auto GpuTimer::begin(VkCommandBuffer cmd, uint32_t slot) -> void {
+  if (!available()) {
+    return;
+  }
+  vkCmdResetQueryPool(cmd, pool_, slot * 2, 2);
+  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pool_,
+                      slot * 2);
+}
+
+auto GpuTimer::end(VkCommandBuffer cmd, uint32_t slot) -> void {
+  if (!available()) {
+    return;
+  }
+  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pool_,
+                      slot * 2 + 1);
+  pending_[slot] = true;
+}
+
+auto GpuTimer::read(uint32_t slot) -> std::optional<double> {
+  if (!available() || !pending_[slot]) {
+    return {};
+  }
+  pending_[slot] = false;
+
+  std::array<uint64_t, 2> ticks = {};
+  auto res = vkGetQueryPoolResults(device_->device(), pool_, slot * 2, 2,
+                                   sizeof(ticks), ticks.data(),
+                                   sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+  if (res != VK_SUCCESS) {
+    return {};
+  }
+  auto elapsed = (ticks[1] - ticks[0]) & mask_;
+  return double(elapsed) * period_ns_ / 1e6;
+}
+
+}  // namespace el::engine
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "src/engine/device.h"
+#include "src/engine/vk.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+// Measures GPU time on the graphics queue with a pair of timestamp queries
+// per slot, one slot per frame in flight.
+//
+// Record begin() and end() around the work to time and read() the slot once
+// the submission's fence has signaled, before the slot is recorded again.
+// Queues without timestamp support leave available() false, which makes
+// every call a no-op. Not thread safe.
+class GpuTimer {
+ public:
+  explicit GpuTimer(Device* device, uint32_t slots = kMaxFramesInFlight);
+  GpuTimer(const GpuTimer&) = delete;
+  GpuTimer(GpuTimer&&) = delete;
+  ~GpuTimer();
+
+  auto operator=(const GpuTimer&) -> GpuTimer& = delete;
+  auto operator=(GpuTimer&&) -> GpuTimer& = delete;
+
+  [[nodiscard]] auto available() const -> bool {
+    return pool_ != VK_NULL_HANDLE;
+  }
+
+  auto begin(VkCommandBuffer cmd, uint32_t slot) -> void;
+  auto end(VkCommandBuffer cmd, uint32_t slot) -> void;
+
+  // Milliseconds between begin() and end() of the last submission of
+  // |slot|. Empty when nothing was timed since the last read.
+  auto read(uint32_t slot) -> std::optional<double>;
+
+ private:
+  Device* device_ = nullptr;
+  VkQueryPool pool_ = VK_NULL_HANDLE;
+  uint64_t mask_ = 0;
+  double period_ns_ = 0;
+  // Whether the slot's queries were recorded and not yet read.
+  std::vector<bool> pending_;
+};
+
+}  // namespace el::engine
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace el::engine {
+
+// FNV-1a constants for the 64-bit variant.
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ULL;
+constexpr uint64_t kFnvPrime = 0x100000001b3ULL;
+
+// Golden ratio constant used to spread bits when combining hashes.
+constexpr uint64_t kHashCombineSeed = 0x9e3779b97f4a7c15ULL;
+constexpr uint64_t kHashCombineLeft = 6;
+constexpr uint64_t kHashCombineRight = 2;
+
+constexpr auto hash_bytes(std::span<const std::byte> bytes,
+                          uint64_t seed = kFnvOffsetBasis) -> uint64_t {
+  uint64_t hash = seed;
+  for (auto b : bytes) {
+    hash ^= static_cast<uint64_t>(b);
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+constexpr auto hash_combine(uint64_t seed, uint64_t value) -> uint64_t {
+  return seed ^ (value + kHashCombineSeed + (seed << kHashCombineLeft) +
+                 (seed >> kHashCombineRight));
+}
+
+// Hashes the object representation of |value|. Only use with types that
+// have no padding, otherwise the padding bytes leak into the hash.
+template <typename T>
+auto hash_value(const T& value, uint64_t seed = kFnvOffsetBasis) -> uint64_t {
+  return hash_bytes(std::as_bytes(std::span<const T, 1>(&value, 1)), seed);
+}
+
+template <typename T>
+auto hash_span(std::span<const T> values, uint64_t seed = kFnvOffsetBasis)
+    -> uint64_t {
+  return hash_bytes(std::as_bytes(values), seed);
+}
+
+}  // namespace el::engine
@@ -0,0 +1,158 @@
+#include "src/engine/io_ring.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace el::engine {
+namespace {
+
+auto map_ring(int fd, size_t size, uint64_t offset) -> std::span<std::byte> {
+  void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, static_cast<off_t>(offset));
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast)
+  if (addr == MAP_FAILED) {
+    return {};
+  }
+  return {static_cast<std::byte*>(addr), size};
+}
+
+auto unmap_ring(std::span<std::byte> map) -> void {
+  if (!map.empty()) {
+    munmap(map.data(), map.size());
+  }
+}
+
+template <typename T>
+auto at(std::span<std::byte> map, uint32_t offset) -> T* {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return reinterpret_cast<T*>(map.subspan(offset).data());
+}
+
+// The kernel reads the tails and writes the heads concurrently.
+auto load_acquire(uint32_t* p) -> uint32_t {
+  return std::atomic_ref<uint32_t>(*p).load(std::memory_order_acquire);
+}
+
+auto store_release(uint32_t* p, uint32_t value) -> void {
+  std::atomic_ref<uint32_t>(*p).store(value, std::memory_order_release);
+}
+
+}  // namespace
+
+IoRing::IoRing(uint32_t entries) {
+  io_uring_params params = {};
+  fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (fd_ < 0) {
+    throw std::runtime_error(std::string("Failed to create io_uring: ")
+                                 .append(std::strerror(errno)));
+  }
+
+  sq_entries_ = params.sq_entries;
+  auto sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  auto cq_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+  // Newer kernels share one mapping between both rings.
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+    sq_map_ = map_ring(fd_, std::max(sq_size, cq_size), IORING_OFF_SQ_RING);
+    cq_map_ = sq_map_;
+  } else {
+    sq_map_ = map_ring(fd_, sq_size, IORING_OFF_SQ_RING);
+    cq_map_ = map_ring(fd_, cq_size, IORING_OFF_CQ_RING);
+  }
+  sqe_map_ = map_ring(fd_, params.sq_entries * sizeof(io_uring_sqe),
+                      IORING_OFF_SQES);
+  if (sq_map_.empty() || cq_map_.empty() || sqe_map_.empty()) {
+    release();
+    throw std::runtime_error("Failed to map io_uring");
+  }
+
+  sq_head_ = at<uint32_t>(sq_map_, params.sq_off.head);
+  sq_tail_ = at<uint32_t>(sq_map_, params.sq_off.tail);
+  sq_mask_ = *at<uint32_t>(sq_map_, params.sq_off.ring_mask);
+  sq_array_ = at<uint32_t>(sq_map_, params.sq_off.array);
+  sqes_ = at<io_uring_sqe>(sqe_map_, 0);
+
+  cq_head_ = at<uint32_t>(cq_map_, params.cq_off.head);
+  cq_tail_ = at<uint32_t>(cq_map_, params.cq_off.tail);
+  cq_mask_ = *at<uint32_t>(cq_map_, params.cq_off.ring_mask);
+  cqes_ = at<io_uring_cqe>(cq_map_, params.cq_off.cqes);
+}
+
+IoRing::~IoRing() {
+  release();
+}
+
+auto IoRing::release() -> void {
+  unmap_ring(sqe_map_);
+  if (cq_map_.data() != sq_map_.data()) {
+    unmap_ring(cq_map_);
+  }
+  unmap_ring(sq_map_);
+  close(fd_);
+
+  sqe_map_ = {};
+  cq_map_ = {};
+  sq_map_ = {};
+}
+
+auto IoRing::read(int fd, const iovec* iov, uint64_t offset, uint64_t user_data)
+    -> bool {
+  auto tail = *sq_tail_;
+  if (tail - load_acquire(sq_head_) >= sq_entries_) {
+    return false;
+  }
+
+  auto index = tail & sq_mask_;
+  auto* sqe = &sqes_[index];
+  std::memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_READV;
+  sqe->fd = fd;
+  sqe->off = offset;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  sqe->addr = reinterpret_cast<uint64_t>(iov);
+  sqe->len = 1;
+  sqe->user_data = user_data;
+  sq_array_[index] = index;
+
+  store_release(sq_tail_, tail + 1);
+  ++to_submit_;
+  return true;
+}
+
+auto IoRing::submit(uint32_t wait_for) -> void {
+  for (;;) {
+    auto flags = wait_for > 0 ? IORING_ENTER_GETEVENTS : 0U;
+    auto res = syscall(__NR_io_uring_enter, fd_, to_submit_, wait_for, flags,
+                       nullptr, 0);
+    if (res >= 0) {
+      to_submit_ -= static_cast<uint32_t>(res);
+      return;
+    }
+    if (errno != EINTR) {
+      throw std::runtime_error(std::string("Failed to submit io_uring: ")
+                                   .append(std::strerror(errno)));
+    }
+  }
+}
+
+auto IoRing::reap(std::vector<Completion>* out) -> void {
+  auto head = *cq_head_;
+  auto tail = load_acquire(cq_tail_);
+  for (; head != tail; ++head) {
+    const auto& cqe = cqes_[head & cq_mask_];
+    out->push_back({.user_data = cqe.user_data, .result = cqe.res});
+  }
+  store_release(cq_head_, head);
+}
+
+}  // namespace el::engine
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "src/pad.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace el::engine {
+
+// A minimal io_uring submission/completion queue pair for file reads, using
+// the raw system calls. Throws from the constructor when the kernel has no
+// io_uring or it is disabled, so callers can fall back to blocking reads.
+// Not thread safe.
+class IoRing {
+ public:
+  struct Completion {
+    uint64_t user_data = 0;
+    // Bytes read, or a negated errno.
+    int32_t result = 0;
+    EL_PAD(4);
+  };
+
+  explicit IoRing(uint32_t entries);
+  IoRing(const IoRing&) = delete;
+  IoRing(IoRing&&) = delete;
+  ~IoRing();
+
+  auto operator=(const IoRing&) -> IoRing& = delete;
+  auto operator=(IoRing&&) -> IoRing& = delete;
+
+  // Queues a read of |iov| from |fd| at |offset|. |iov| has to stay valid
+  // until submit() returns. Returns false when the submission queue is full.
+  auto read(int fd, const iovec* iov, uint64_t offset, uint64_t user_data)
+      -> bool;
+
+  // Submits everything queued by read() and blocks until at least
+  // |wait_for| reads have completed.
+  auto submit(uint32_t wait_for) -> void;
+
+  // Appends all available completions to |out|.
+  auto reap(std::vector<Completion>* out) -> void;
+
+  [[nodiscard]] auto entries() const -> uint32_t { return sq_entries_; }
+
+ private:
+  auto release() -> void;
+
+  int fd_ = -1;
+  uint32_t sq_entries_ = 0;
+  uint32_t sq_mask_ = 0;
+  uint32_t cq_mask_ = 0;
+  // Reads queued since the last submit().
+  uint32_t to_submit_ = 0;
+  EL_PAD(4);
+
+  std::span<std::byte> sq_map_;
+  std::span<std::byte> cq_map_;
+  std::span<std::byte> sqe_map_;
+
+  uint32_t* sq_head_ = nullptr;
+  uint32_t* sq_tail_ = nullptr;
+  uint32_t* sq_array_ = nullptr;
+  io_uring_sqe* sqes_ = nullptr;
+  uint32_t* cq_head_ = nullptr;
+  uint32_t* cq_tail_ = nullptr;
+  io_uring_cqe* cqes_ = nullptr;
+};
+
+}  // namespace el::engine
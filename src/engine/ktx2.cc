@@ -0,0 +1,109 @@
+#include "src/engine/ktx2.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace el::engine {
+namespace {
+
+constexpr std::array<uint8_t, 12> kIdentifier = {
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+// Byte offsets into the KTX2 header.
+constexpr size_t kFormatOffset = 12;
+constexpr size_t kWidthOffset = 20;
+constexpr size_t kHeightOffset = 24;
+constexpr size_t kDepthOffset = 28;
+constexpr size_t kLayerCountOffset = 32;
+constexpr size_t kFaceCountOffset = 36;
+constexpr size_t kLevelCountOffset = 40;
+constexpr size_t kSupercompressionOffset = 44;
+constexpr size_t kLevelIndexOffset = 80;
+constexpr size_t kLevelIndexEntrySize = 24;
+
+template <typename T>
+auto read(std::span<const std::byte> data, size_t offset) -> T {
+  T value{};
+  std::memcpy(&value, data.subspan(offset, sizeof(T)).data(), sizeof(T));
+  return value;
+}
+
+}  // namespace
+
+auto is_block_compressed(VkFormat format) -> bool {
+  return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK &&
+         format <= VK_FORMAT_BC7_SRGB_BLOCK;
+}
+
+auto block_size(VkFormat format) -> uint32_t {
+  switch (format) {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+      return 8;
+    default:
+      return 16;
+  }
+}
+
+Ktx2File::Ktx2File(const std::string& path) : file_(path) {
+  auto data = file_.data();
+  if (data.size() < kLevelIndexOffset ||
+      std::memcmp(data.data(), kIdentifier.data(), kIdentifier.size()) != 0) {
+    throw std::runtime_error(std::string("Not a KTX2 file: ").append(path));
+  }
+
+  format_ = static_cast<VkFormat>(read<uint32_t>(data, kFormatOffset));
+  width_ = read<uint32_t>(data, kWidthOffset);
+  height_ = read<uint32_t>(data, kHeightOffset);
+  if (!is_block_compressed(format_) || width_ == 0 || height_ == 0 ||
+      read<uint32_t>(data, kDepthOffset) > 1 ||
+      read<uint32_t>(data, kLayerCountOffset) > 1 ||
+      read<uint32_t>(data, kFaceCountOffset) != 1 ||
+      read<uint32_t>(data, kSupercompressionOffset) != 0) {
+    throw std::runtime_error(
+        std::string("Unsupported KTX2 texture, expected a single 2D BC "
+                    "image without supercompression: ")
+            .append(path));
+  }
+
+  // A level count of 0 asks the loader to generate mips; only the base level
+  // is stored then.
+  auto level_count = std::max(1U, read<uint32_t>(data, kLevelCountOffset));
+  if (level_count > uint32_t(std::bit_width(std::max(width_, height_))) ||
+      data.size() < kLevelIndexOffset + level_count * kLevelIndexEntrySize) {
+    throw std::runtime_error(std::string("Corrupt KTX2 file: ").append(path));
+  }
+
+  auto bytes_per_block = block_size(format_);
+  for (uint32_t i = 0; i < level_count; ++i) {
+    auto entry = kLevelIndexOffset + i * kLevelIndexEntrySize;
+    Level level = {
+        .offset = read<uint64_t>(data, entry),
+        .size = read<uint64_t>(data, entry + sizeof(uint64_t)),
+    };
+
+    auto extent = level_extent(i);
+    auto expected = uint64_t{(extent.width + 3) / 4} *
+                    ((extent.height + 3) / 4) * bytes_per_block;
+    if (level.offset > data.size() || level.size > data.size() - level.offset ||
+        level.size != expected) {
+      throw std::runtime_error(
+          std::string("Corrupt KTX2 mip level: ").append(path));
+    }
+    levels_.push_back(level);
+  }
+}
+
+auto Ktx2File::level(uint32_t level) const -> std::span<const std::byte> {
+  const auto& l = levels_.at(level);
+  return file_.data().subspan(l.offset, l.size);
+}
+
+}  // namespace el::engine
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "src/engine/mapped_file.h"
+#include "src/engine/vk.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+// Returns true for the BC1 to BC7 block compressed formats.
+[[nodiscard]] auto is_block_compressed(VkFormat format) -> bool;
+
+// Bytes per 4x4 block of a block compressed format.
+[[nodiscard]] auto block_size(VkFormat format) -> uint32_t;
+
+// A KTX2 container holding a single 2D, block compressed image with its mip
+// chain, mapped into memory. Supercompressed files, arrays, cube maps and 3D
+// textures are rejected.
+class Ktx2File {
+ public:
+  explicit Ktx2File(const std::string& path);
+  Ktx2File(const Ktx2File&) = delete;
+  Ktx2File(Ktx2File&&) = delete;
+  ~Ktx2File() = default;
+
+  auto operator=(const Ktx2File&) -> Ktx2File& = delete;
+  auto operator=(Ktx2File&&) -> Ktx2File& = delete;
+
+  [[nodiscard]] auto format() const -> VkFormat { return format_; }
+  [[nodiscard]] auto width() const -> uint32_t { return width_; }
+  [[nodiscard]] auto height() const -> uint32_t { return height_; }
+  [[nodiscard]] auto level_count() const -> uint32_t {
+    return uint32_t(levels_.size());
+  }
+
+  // Compressed data of mip |level|, 0 being the largest.
+  [[nodiscard]] auto level(uint32_t level) const -> std::span<const std::byte>;
+
+  [[nodiscard]] auto level_extent(uint32_t level) const -> VkExtent2D {
+    return {std::max(1U, width_ >> level), std::max(1U, height_ >> level)};
+  }
+
+ private:
+  struct Level {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+  };
+
+  MappedFile file_;
+  std::vector<Level> levels_;
+  VkFormat format_ = VK_FORMAT_UNDEFINED;
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  EL_PAD(4);
+};
+
+}  // namespace el::engine
@@ -0,0 +1,88 @@
+#include "src/engine/lod.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace el::engine {
+namespace {
+
+// Keeps the projection finite for cameras inside a bounding sphere; such
+// instances always get the finest level.
+constexpr float kMinDistance = 1e-4F;
+
+}  // namespace
+
+LodSelector::LodSelector(float threshold, float hysteresis)
+    : threshold_(threshold),
+      coarsen_threshold_(threshold * (1.0F - hysteresis)) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
+  assert(hysteresis >= 0.0F && hysteresis < 1.0F);
+}
+
+auto LodSelector::projection_scale(float fov_y, uint32_t viewport_height)
+    -> float {
+  return float(viewport_height) / (2.0F * std::tan(fov_y * 0.5F));
+}
+
+auto LodSelector::pixels_per_unit(const std::array<float, 4>& sphere) const
+    -> float {
+  float dx = sphere[0] - eye_[0];
+  float dy = sphere[1] - eye_[1];
+  float dz = sphere[2] - eye_[2];
+  float distance = std::sqrt(dx * dx + dy * dy + dz * dz) - sphere[3];
+  if (distance <= kMinDistance) {
+    return std::numeric_limits<float>::infinity();
+  }
+  return projection_scale_ / distance;
+}
+
+auto LodSelector::screen_size(const std::array<float, 4>& sphere) const
+    -> float {
+  return sphere[3] * pixels_per_unit(sphere);
+}
+
+auto LodSelector::select(std::span<const mesh::Lod> lods,
+                         const LodInstance& instance,
+                         uint32_t current) const -> uint32_t {
+  if (lods.empty()) {
+    return 0;
+  }
+
+  auto count = uint32_t(lods.size());
+  current = std::min(current, count - 1);
+  float scale = instance.scale * pixels_per_unit(instance.sphere);
+  auto projected = [&lods, &scale](uint32_t level) {
+    // Avoids inf * 0 for the finest level when the camera is inside.
+    return lods[level].error > 0.0F ? lods[level].error * scale : 0.0F;
+  };
+
+  // Errors grow with the level, so walk from the current one towards the
+  // first level which fits. Refining happens as soon as the threshold is
+  // crossed, coarsening only once a level is comfortably below it.
+  if (projected(current) > threshold_) {
+    while (current > 0 && projected(current) > threshold_) {
+      --current;
+    }
+    return current;
+  }
+  while (current + 1 < count && projected(current + 1) <= coarsen_threshold_) {
+    ++current;
+  }
+  return current;
+}
+
+auto LodSelector::select(std::span<const mesh::Lod> lods,
+                         std::span<const LodInstance> instances,
+                         std::span<uint8_t> levels) const -> void {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
+  assert(levels.size() >= instances.size());
+  static_assert(mesh::kMaxLods <= std::numeric_limits<uint8_t>::max());
+
+  for (size_t i = 0; i < instances.size(); ++i) {
+    levels[i] = uint8_t(select(lods, instances[i], levels[i]));
+  }
+}
+
+}  // namespace el::engine
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "src/engine/mesh_format.h"
+
+namespace el::engine {
+
+// Screen space error, in pixels, a level of detail may show.
+constexpr float kDefaultLodThreshold = 1.0F;
+// Fraction below the threshold a coarser level has to reach before it is
+// switched to, so instances near a boundary don't flicker between levels.
+constexpr float kDefaultLodHysteresis = 0.25F;
+
+struct LodInstance {
+  // World space bounding sphere, xyz center and w radius.
+  std::array<float, 4> sphere = {};
+  // Largest axis scale of the object to world transform.
+  float scale = 1.0F;
+};
+
+// Picks levels of detail from the projected size of each level's maximum
+// quadric distance, mesh::Lod::error. Stateless apart from the view; the
+// level each instance used last frame is kept by the caller and passed back
+// in.
+class LodSelector {
+ public:
+  explicit LodSelector(float threshold = kDefaultLodThreshold,
+                       float hysteresis = kDefaultLodHysteresis);
+
+  // Pixels per world unit at distance 1 for a perspective projection with
+  // vertical field of view |fov_y|, in radians.
+  [[nodiscard]] static auto projection_scale(float fov_y,
+                                             uint32_t viewport_height)
+      -> float;
+
+  auto set_view(const std::array<float, 3>& eye, float projection_scale)
+      -> void {
+    eye_ = eye;
+    projection_scale_ = projection_scale;
+  }
+
+  // Projected radius of |sphere| in pixels.
+  [[nodiscard]] auto screen_size(const std::array<float, 4>& sphere) const
+      -> float;
+
+  // Level to draw |instance| with this frame, given the |current| level.
+  [[nodiscard]] auto select(std::span<const mesh::Lod> lods,
+                            const LodInstance& instance,
+                            uint32_t current) const -> uint32_t;
+
+  // Updates |levels|, one per instance, in place.
+  auto select(std::span<const mesh::Lod> lods,
+              std::span<const LodInstance> instances,
+              std::span<uint8_t> levels) const -> void;
+
+ private:
+  // Pixels per world unit at the nearest point of |sphere|.
+  [[nodiscard]] auto pixels_per_unit(const std::array<float, 4>& sphere) const
+      -> float;
+
+  std::array<float, 3> eye_ = {};
+  float projection_scale_ = 1.0F;
+  float threshold_ = kDefaultLodThreshold;
+  float coarsen_threshold_ = kDefaultLodThreshold;
+};
+
+}  // namespace el::engine
@@ -0,0 +1,189 @@
+#include "src/engine/lz4.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace el::engine::lz4 {
+namespace {
+
+constexpr size_t kMinMatch = 4;
+// The format requires the last match to start at least 12 bytes before the
+// end of the block and the last 5 bytes to be literals.
+constexpr size_t kMatchStartLimit = 12;
+constexpr size_t kLastLiterals = 5;
+constexpr size_t kMaxOffset = 65535;
+constexpr uint32_t kHashLog = 12;
+// Knuth's multiplicative hash.
+constexpr uint32_t kHashPrime = 2654435761U;
+constexpr uint8_t kRunMask = 15;
+constexpr uint8_t kExtraByteMax = 255;
+
+auto read32(std::span<const std::byte> src, size_t pos) -> uint32_t {
+  uint32_t value = 0;
+  std::memcpy(&value, src.subspan(pos).data(), sizeof(value));
+  return value;
+}
+
+auto hash(uint32_t sequence) -> uint32_t {
+  return (sequence * kHashPrime) >> (32 - kHashLog);
+}
+
+// Lengths of 15 and more spill into extra bytes of 255, ended by one below.
+auto write_length(std::vector<std::byte>* out, size_t length) -> void {
+  for (; length >= kExtraByteMax; length -= kExtraByteMax) {
+    out->push_back(std::byte{kExtraByteMax});
+  }
+  out->push_back(static_cast<std::byte>(length));
+}
+
+auto write_sequence(std::vector<std::byte>* out,
+                    std::span<const std::byte> literals,
+                    size_t offset,
+                    size_t match_length) -> void {
+  auto literal_nibble = std::min<size_t>(literals.size(), kRunMask);
+  auto match_nibble =
+      match_length == 0 ? 0 : std::min<size_t>(match_length - kMinMatch, 15);
+  out->push_back(static_cast<std::byte>((literal_nibble << 4) | match_nibble));
+  if (literal_nibble == kRunMask) {
+    write_length(out, literals.size() - kRunMask);
+  }
+  out->insert(std::end(*out), std::begin(literals), std::end(literals));
+
+  // The final sequence is literals only.
+  if (match_length == 0) {
+    return;
+  }
+  out->push_back(static_cast<std::byte>(offset & 0xff));
+  out->push_back(static_cast<std::byte>(offset >> 8));
+  if (match_nibble == kRunMask) {
+    write_length(out, match_length - kMinMatch - kRunMask);
+  }
+}
+
+// Reads the extra bytes of a length nibble of 15. Returns false when the
+// input runs out first.
+auto read_length(std::span<const std::byte> src, size_t* pos, size_t* length)
+    -> bool {
+  for (;;) {
+    if (*pos >= src.size()) {
+      return false;
+    }
+    auto b = std::to_integer<uint8_t>(src[(*pos)++]);
+    *length += b;
+    if (b != kExtraByteMax) {
+      return true;
+    }
+  }
+}
+
+}  // namespace
+
+auto compress(std::span<const std::byte> src) -> std::vector<std::byte> {
+  std::vector<std::byte> out;
+  out.reserve(compress_bound(src.size()));
+
+  // Positions of the last sequence seen for each hash. A stale or colliding
+  // slot is caught by comparing the bytes.
+  std::array<uint32_t, size_t{1} << kHashLog> table = {};
+
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (src.size() >= kMatchStartLimit &&
+         pos <= src.size() - kMatchStartLimit) {
+    auto sequence = read32(src, pos);
+    auto& slot = table.at(hash(sequence));
+    auto candidate = size_t{slot};
+    slot = uint32_t(pos);
+
+    if (candidate >= pos || pos - candidate > kMaxOffset ||
+        read32(src, candidate) != sequence) {
+      ++pos;
+      continue;
+    }
+
+    auto length = kMinMatch;
+    auto limit = src.size() - kLastLiterals;
+    while (pos + length < limit &&
+           src[candidate + length] == src[pos + length]) {
+      ++length;
+    }
+    // Grow the match backwards over literals which also match.
+    while (pos > anchor && candidate > 0 &&
+           src[pos - 1] == src[candidate - 1]) {
+      --pos;
+      --candidate;
+      ++length;
+    }
+
+    write_sequence(&out, src.subspan(anchor, pos - anchor), pos - candidate,
+                   length);
+    pos += length;
+    anchor = pos;
+  }
+
+  write_sequence(&out, src.subspan(anchor), 0, 0);
+  return out;
+}
+
+auto decompress(std::span<const std::byte> src, std::span<std::byte> dst)
+    -> bool {
+  size_t in = 0;
+  size_t out = 0;
+  while (in < src.size()) {
+    auto token = std::to_integer<uint8_t>(src[in++]);
+
+    size_t literals = token >> 4;
+    if (literals == kRunMask && !read_length(src, &in, &literals)) {
+      return false;
+    }
+    if (literals > src.size() - in || literals > dst.size() - out) {
+      return false;
+    }
+    if (literals > 0) {
+      std::memcpy(dst.subspan(out).data(), src.subspan(in).data(), literals);
+    }
+    in += literals;
+    out += literals;
+
+    // The last sequence ends after its literals.
+    if (in == src.size()) {
+      break;
+    }
+
+    if (src.size() - in < 2) {
+      return false;
+    }
+    auto offset = std::to_integer<size_t>(src[in]) |
+                  (std::to_integer<size_t>(src[in + 1]) << 8);
+    in += 2;
+    if (offset == 0 || offset > out) {
+      return false;
+    }
+
+    size_t length = token & kRunMask;
+    if (length == kRunMask && !read_length(src, &in, &length)) {
+      return false;
+    }
+    length += kMinMatch;
+    if (length > dst.size() - out) {
+      return false;
+    }
+
+    // Matches may overlap their own output, repeating the last |offset|
+    // bytes, so only copy in bulk when they don't.
+    if (offset >= length) {
+      std::memcpy(dst.subspan(out).data(), dst.subspan(out - offset).data(),
+                  length);
+    } else {
+      for (size_t i = 0; i < length; ++i) {
+        dst[out + i] = dst[out - offset + i];
+      }
+    }
+    out += length;
+  }
+  return out == dst.size();
+}
+
+}  // namespace el::engine::lz4
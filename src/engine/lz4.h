@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// LZ4 block format compression. Kept in tree so neither the engine nor the
+// offline tools pick up another dependency; the output is readable by any
+// LZ4 block decoder and the decoder accepts blocks produced by liblz4.
+namespace el::engine::lz4 {
+
+// Upper bound of the compressed size of |size| input bytes.
+[[nodiscard]] constexpr auto compress_bound(size_t size) -> size_t {
+  return size + size / 255 + 16;
+}
+
+// Greedy, single pass compression tuned for decode speed over ratio.
+[[nodiscard]] auto compress(std::span<const std::byte> src)
+    -> std::vector<std::byte>;
+
+// Decompresses |src| into |dst|, which must be exactly the size of the
+// original data. Returns false for malformed input instead of reading or
+// writing out of bounds.
+[[nodiscard]] auto decompress(std::span<const std::byte> src,
+                              std::span<std::byte> dst) -> bool;
+
+}  // namespace el::engine::lz4
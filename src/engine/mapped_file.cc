@@ -0,0 +1,51 @@
+#include "src/engine/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdexcept>
+
+namespace el::engine {
+
+MappedFile::MappedFile(const std::string& path) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(std::string("Failed to open: ").append(path));
+  }
+
+  struct stat st = {};
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    throw std::runtime_error(std::string("Failed to stat: ").append(path));
+  }
+
+  auto size = static_cast<size_t>(st.st_size);
+  void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast)
+  if (addr == MAP_FAILED) {
+    throw std::runtime_error(std::string("Failed to map: ").append(path));
+  }
+  data_ = {static_cast<const std::byte*>(addr), size};
+}
+
+MappedFile::~MappedFile() {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  munmap(const_cast<std::byte*>(data_.data()), data_.size());
+}
+
+auto MappedFile::advise_sequential(std::span<const std::byte> region) const
+    -> void {
+  // posix_madvise wants a page aligned start.
+  auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  auto offset = static_cast<size_t>(region.data() - data_.data());
+  auto aligned = offset / page * page;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  posix_madvise(const_cast<std::byte*>(data_.data() + aligned),
+                region.size() + (offset - aligned), POSIX_MADV_SEQUENTIAL);
+}
+
+}  // namespace el::engine
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+namespace el::engine {
+
+// A whole file mapped read only into memory.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path);
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&&) = delete;
+  ~MappedFile();
+
+  auto operator=(const MappedFile&) -> MappedFile& = delete;
+  auto operator=(MappedFile&&) -> MappedFile& = delete;
+
+  [[nodiscard]] auto data() const -> std::span<const std::byte> {
+    return data_;
+  }
+
+  // Hints that |region| will be read once, front to back.
+  auto advise_sequential(std::span<const std::byte> region) const -> void;
+
+ private:
+  std::span<const std::byte> data_;
+};
+
+}  // namespace el::engine
@@ -0,0 +1,107 @@
+#include "src/engine/memory_budget.h"
+
+#include <algorithm>
+#include <span>
+
+namespace el::engine {
+
+MemoryBudget::MemoryBudget(VkPhysicalDevice device,
+                           const VkPhysicalDeviceMemoryProperties& properties,
+                           bool use_extension)
+    : device_(device),
+      properties_(properties),
+      use_extension_(use_extension),
+      allocated_(properties.memoryHeapCount),
+      allocated_at_update_(properties.memoryHeapCount),
+      reported_usage_(properties.memoryHeapCount),
+      reported_budget_(properties.memoryHeapCount) {
+  update();
+}
+
+auto MemoryBudget::track_allocation(VkDeviceMemory memory,
+                                    uint32_t type_index,
+                                    VkDeviceSize size) -> void {
+  auto types = std::span(properties_.memoryTypes);
+  auto heap = types[type_index].heapIndex;
+
+  const std::lock_guard<std::mutex> lock(lock_);
+  allocations_[memory] = {.heap = heap, .size = size};
+  allocated_[heap] += size;
+}
+
+auto MemoryBudget::track_free(VkDeviceMemory memory) -> void {
+  const std::lock_guard<std::mutex> lock(lock_);
+  auto it = allocations_.find(memory);
+  if (it == allocations_.end()) {
+    return;
+  }
+  allocated_[it->second.heap] -= it->second.size;
+  allocations_.erase(it);
+}
+
+auto MemoryBudget::update() -> void {
+  if (!use_extension_) {
+    return;
+  }
+
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+  };
+  VkPhysicalDeviceMemoryProperties2 props = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+      .pNext = &budget,
+  };
+  vkGetPhysicalDeviceMemoryProperties2(device_, &props);
+
+  auto usage = std::span(budget.heapUsage);
+  auto budgets = std::span(budget.heapBudget);
+  const std::lock_guard<std::mutex> lock(lock_);
+  for (uint32_t i = 0; i < properties_.memoryHeapCount; ++i) {
+    reported_usage_[i] = usage[i];
+    reported_budget_[i] = budgets[i];
+  }
+  allocated_at_update_ = allocated_;
+}
+
+auto MemoryBudget::heap_budget(uint32_t heap) const -> HeapBudget {
+  const auto& props = std::span(properties_.memoryHeaps)[heap];
+  HeapBudget ret = {.size = props.size, .flags = props.flags};
+  if (use_extension_) {
+    // Allocations since the last report are added on top so the usage
+    // doesn't lag a frame behind.
+    ret.usage = reported_usage_[heap] + allocated_[heap];
+    ret.usage -= std::min(ret.usage, allocated_at_update_[heap]);
+    ret.budget = reported_budget_[heap];
+  } else {
+    ret.usage = allocated_[heap];
+    ret.budget = VkDeviceSize(double(props.size) * kFallbackBudgetFraction);
+  }
+  return ret;
+}
+
+auto MemoryBudget::heaps() const -> std::vector<HeapBudget> {
+  const std::lock_guard<std::mutex> lock(lock_);
+  std::vector<HeapBudget> ret;
+  ret.reserve(properties_.memoryHeapCount);
+  for (uint32_t i = 0; i < properties_.memoryHeapCount; ++i) {
+    ret.push_back(heap_budget(i));
+  }
+  return ret;
+}
+
+auto MemoryBudget::device_local() const -> HeapBudget {
+  const std::lock_guard<std::mutex> lock(lock_);
+  HeapBudget ret = {.flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT};
+  for (uint32_t i = 0; i < properties_.memoryHeapCount; ++i) {
+    auto heap = heap_budget(i);
+    if ((heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) == 0) {
+      continue;
+    }
+    ret.size += heap.size;
+    ret.usage += heap.usage;
+    ret.budget += heap.budget;
+  }
+  return ret;
+}
+
+}  // namespace el::engine
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "src/engine/vk.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+// Share of a heap assumed to be ours without VK_EXT_memory_budget. The rest
+// is left for the driver, the compositor and other processes.
+constexpr double kFallbackBudgetFraction = 0.8;
+
+struct HeapBudget {
+  VkDeviceSize size = 0;
+  // Bytes in use, by this process with VK_EXT_memory_budget and by our own
+  // allocations without it.
+  VkDeviceSize usage = 0;
+  // Bytes this process can use before allocations are likely to fail or
+  // page.
+  VkDeviceSize budget = 0;
+  VkMemoryHeapFlags flags = 0;
+  EL_PAD(4);
+};
+
+// Per heap usage and budget. Reported by VK_EXT_memory_budget when the
+// device has it, otherwise accounted from the allocations made through
+// Device::allocate_memory() against a share of each heap's size.
+//
+// Allocations are tracked as they happen, so usage stays current between
+// the per frame update() calls. Thread safe.
+class MemoryBudget {
+ public:
+  MemoryBudget(VkPhysicalDevice device,
+               const VkPhysicalDeviceMemoryProperties& properties,
+               bool use_extension);
+  MemoryBudget(const MemoryBudget&) = delete;
+  MemoryBudget(MemoryBudget&&) = delete;
+  ~MemoryBudget() = default;
+
+  auto operator=(const MemoryBudget&) -> MemoryBudget& = delete;
+  auto operator=(MemoryBudget&&) -> MemoryBudget& = delete;
+
+  auto track_allocation(VkDeviceMemory memory,
+                        uint32_t type_index,
+                        VkDeviceSize size) -> void;
+  // Memory which was never tracked is ignored.
+  auto track_free(VkDeviceMemory memory) -> void;
+
+  // Refreshes usage and budget from VK_EXT_memory_budget.
+  auto update() -> void;
+
+  [[nodiscard]] auto heaps() const -> std::vector<HeapBudget>;
+  // All device local heaps summed up. The host heaps on integrated GPUs
+  // which are also device local are included.
+  [[nodiscard]] auto device_local() const -> HeapBudget;
+
+  [[nodiscard]] auto uses_extension() const -> bool { return use_extension_; }
+
+ private:
+  struct Allocation {
+    uint32_t heap = 0;
+    EL_PAD(4);
+    VkDeviceSize size = 0;
+  };
+
+  [[nodiscard]] auto heap_budget(uint32_t heap) const -> HeapBudget;
+
+  VkPhysicalDevice device_ = VK_NULL_HANDLE;
+  VkPhysicalDeviceMemoryProperties properties_ = {};
+  bool use_extension_ = false;
+  EL_PAD(7);
+
+  mutable std::mutex lock_;
+  std::unordered_map<VkDeviceMemory, Allocation> allocations_;
+  // Our own allocations per heap, now and at the last update().
+  std::vector<VkDeviceSize> allocated_;
+  std::vector<VkDeviceSize> allocated_at_update_;
+  // From VK_EXT_memory_budget at the last update().
+  std::vector<VkDeviceSize> reported_usage_;
+  std::vector<VkDeviceSize> reported_budget_;
+};
+
+}  // namespace el::engine
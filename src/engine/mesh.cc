@@ -0,0 +1,242 @@
+#include "src/engine/mesh.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace el::engine {
+namespace {
+
+auto fits(uint64_t offset, uint64_t size, uint64_t limit) -> bool {
+  return offset <= limit && size <= limit - offset;
+}
+
+auto validate(const mesh::Header& header, uint64_t file_size) -> void {
+  if (header.magic != mesh::kMagic) {
+    throw std::runtime_error("Not a mesh file");
+  }
+  if (header.version != mesh::kVersion) {
+    throw std::runtime_error(std::string("Unsupported mesh version: ")
+                                 .append(std::to_string(header.version)));
+  }
+  if (header.index_type != mesh::IndexType::kUint16 &&
+      header.index_type != mesh::IndexType::kUint32) {
+    throw std::runtime_error(
+        std::string("Unsupported mesh index type: ")
+            .append(std::to_string(uint32_t(header.index_type))));
+  }
+
+  auto vertex_size =
+      uint64_t{header.vertex_count} * sizeof(mesh::PackedVertex);
+  auto index_size =
+      uint64_t{header.index_count} * mesh::index_size(header.index_type);
+  auto submesh_size = uint64_t{header.submesh_count} * sizeof(mesh::Submesh);
+  auto lod_size = uint64_t{header.lod_count} * sizeof(mesh::Lod);
+
+  if (header.data_offset % mesh::kDataAlignment != 0 ||
+      header.index_offset % mesh::kDataAlignment != 0 ||
+      header.vertex_offset % sizeof(mesh::PackedVertex) != 0 ||
+      header.submesh_offset % alignof(mesh::Submesh) != 0 ||
+      header.lod_offset % alignof(mesh::Lod) != 0 ||
+      !fits(header.submesh_offset, submesh_size, file_size) ||
+      !fits(header.lod_offset, lod_size, file_size) ||
+      !fits(header.data_offset, header.data_size, file_size) ||
+      !fits(header.vertex_offset, vertex_size, header.data_size) ||
+      !fits(header.index_offset, index_size, header.data_size)) {
+    throw std::runtime_error("Corrupt mesh file");
+  }
+}
+
+// Largest of |lod|'s indices, 0 when it has none.
+auto max_index(std::span<const std::byte> indices,
+               mesh::IndexType type,
+               const mesh::Lod& lod) -> uint32_t {
+  auto size = mesh::index_size(type);
+  auto bytes = indices.subspan(size_t{lod.first_index} * size,
+                               size_t{lod.index_count} * size);
+  uint32_t largest = 0;
+  for (size_t i = 0; i < bytes.size(); i += size) {
+    uint32_t index = 0;
+    if (type == mesh::IndexType::kUint16) {
+      uint16_t narrow = 0;
+      std::memcpy(&narrow, &bytes[i], sizeof(narrow));
+      index = narrow;
+    } else {
+      std::memcpy(&index, &bytes[i], sizeof(index));
+    }
+    largest = std::max(largest, index);
+  }
+  return largest;
+}
+
+// Per submesh and per level checks. Indices are checked against their
+// submesh's vertices so no draw reads past them; the vertex data itself is
+// left to the GPU.
+auto validate_ranges(const mesh::Header& header,
+                     std::span<const mesh::Submesh> submeshes,
+                     std::span<const mesh::Lod> lods,
+                     std::span<const std::byte> indices) -> void {
+  auto bad_lod = [&header](const mesh::Lod& lod) {
+    return !fits(lod.first_index, lod.index_count, header.index_count);
+  };
+  auto bad_submesh = [&header, &lods](const mesh::Submesh& sm) {
+    return sm.lod_count == 0 || sm.lod_count > mesh::kMaxLods ||
+           !fits(sm.first_lod, sm.lod_count, lods.size()) ||
+           !fits(sm.vertex_offset, sm.vertex_count, header.vertex_count);
+  };
+  if (std::any_of(std::begin(lods), std::end(lods), bad_lod) ||
+      std::any_of(std::begin(submeshes), std::end(submeshes), bad_submesh)) {
+    throw std::runtime_error("Corrupt mesh file");
+  }
+
+  for (const auto& sm : submeshes) {
+    for (const auto& lod : lods.subspan(sm.first_lod, sm.lod_count)) {
+      if (lod.index_count > 0 &&
+          max_index(indices, header.index_type, lod) >= sm.vertex_count) {
+        throw std::runtime_error("Mesh index out of range");
+      }
+    }
+  }
+}
+
+}  // namespace
+
+MeshFile::MeshFile(const std::string& path) : file_(path) {
+  if (file_.data().size() < sizeof(mesh::Header)) {
+    throw std::runtime_error(std::string("Invalid mesh: ").append(path));
+  }
+  validate(header(), file_.data().size());
+  validate_ranges(header(), submeshes(), lods(), indices());
+
+  // Past the index checks, the payload is read front to back once, by the
+  // upload.
+  file_.advise_sequential(payload());
+}
+
+auto MeshFile::header() const -> const mesh::Header& {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return *reinterpret_cast<const mesh::Header*>(file_.data().data());
+}
+
+auto MeshFile::submeshes() const -> std::span<const mesh::Submesh> {
+  const auto& h = header();
+  return {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      reinterpret_cast<const mesh::Submesh*>(
+          file_.data().subspan(h.submesh_offset).data()),
+      h.submesh_count};
+}
+
+auto MeshFile::lods() const -> std::span<const mesh::Lod> {
+  const auto& h = header();
+  return {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      reinterpret_cast<const mesh::Lod*>(
+          file_.data().subspan(h.lod_offset).data()),
+      h.lod_count};
+}
+
+auto MeshFile::payload() const -> std::span<const std::byte> {
+  const auto& h = header();
+  return file_.data().subspan(h.data_offset, h.data_size);
+}
+
+auto MeshFile::vertices() const -> std::span<const mesh::PackedVertex> {
+  const auto& h = header();
+  return {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      reinterpret_cast<const mesh::PackedVertex*>(
+          payload().subspan(h.vertex_offset).data()),
+      h.vertex_count};
+}
+
+auto MeshFile::indices() const -> std::span<const std::byte> {
+  const auto& h = header();
+  return payload().subspan(h.index_offset,
+                           h.index_count * mesh::index_size(h.index_type));
+}
+
+Mesh::Mesh(StagingUploader* uploader, const MeshFile& file)
+    : buffer_(BufferConfig(uploader->device())
+                  .set_size(file.header().data_size)
+                  .set_usage(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                             VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                             VK_BUFFER_USAGE_TRANSFER_DST_BIT)) {
+  auto submeshes = file.submeshes();
+  submeshes_.assign(std::begin(submeshes), std::end(submeshes));
+  auto lods = file.lods();
+  lods_.assign(std::begin(lods), std::end(lods));
+
+  const auto& h = file.header();
+  dequantize_ = {
+      .position_min = h.position_min,
+      .position_scale = h.position_scale,
+      .uv = {h.uv_min[0], h.uv_min[1], h.uv_scale[0], h.uv_scale[1]},
+  };
+  vertex_offset_ = h.vertex_offset;
+  index_offset_ = h.index_offset;
+  index_type_ = h.index_type == mesh::IndexType::kUint16
+                    ? VK_INDEX_TYPE_UINT16
+                    : VK_INDEX_TYPE_UINT32;
+
+  uploader->upload(buffer_, 0, file.payload());
+  uploader->flush();
+}
+
+auto Mesh::vertex_binding() -> VkVertexInputBindingDescription {
+  return {
+      .binding = 0,
+      .stride = sizeof(mesh::PackedVertex),
+      .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+  };
+}
+
+auto Mesh::vertex_attributes()
+    -> std::array<VkVertexInputAttributeDescription, 3> {
+  return {{
+      {
+          .location = 0,
+          .binding = 0,
+          .format = VK_FORMAT_R16G16B16A16_UNORM,
+          .offset = offsetof(mesh::PackedVertex, position),
+      },
+      {
+          .location = 1,
+          .binding = 0,
+          .format = VK_FORMAT_R16G16_SNORM,
+          .offset = offsetof(mesh::PackedVertex, normal),
+      },
+      {
+          .location = 2,
+          .binding = 0,
+          .format = VK_FORMAT_R16G16_UNORM,
+          .offset = offsetof(mesh::PackedVertex, uv),
+      },
+  }};
+}
+
+auto Mesh::bind(VkCommandBuffer cmd) const -> void {
+  VkBuffer buf = buffer_.buffer();
+  vkCmdBindVertexBuffers(cmd, 0, 1, &buf, &vertex_offset_);
+  vkCmdBindIndexBuffer(cmd, buf, index_offset_, index_type_);
+}
+
+auto Mesh::lods(size_t submesh) const -> std::span<const mesh::Lod> {
+  const auto& sm = submeshes_.at(submesh);
+  return std::span(lods_).subspan(sm.first_lod, sm.lod_count);
+}
+
+auto Mesh::draw(VkCommandBuffer cmd,
+                size_t submesh,
+                size_t lod,
+                uint32_t instance_count,
+                uint32_t first_instance) const -> void {
+  const auto& sm = submeshes_.at(submesh);
+  const auto& level = lods(submesh)[std::min(lod, size_t{sm.lod_count} - 1)];
+  vkCmdDrawIndexed(cmd, level.index_count, instance_count, level.first_index,
+                   int32_t(sm.vertex_offset), first_instance);
+}
+
+}  // namespace el::engine
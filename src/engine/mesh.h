@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "src/engine/buffer.h"
+#include "src/engine/mapped_file.h"
+#include "src/engine/mesh_format.h"
+#include "src/engine/uploader.h"
+#include "src/engine/vk.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+// Read only view of an .elm file mapped into memory. Construction checks the
+// header and that every region lies inside the file; vertex data is never
+// touched on the CPU.
+class MeshFile {
+ public:
+  explicit MeshFile(const std::string& path);
+  MeshFile(const MeshFile&) = delete;
+  MeshFile(MeshFile&&) = delete;
+  ~MeshFile() = default;
+
+  auto operator=(const MeshFile&) -> MeshFile& = delete;
+  auto operator=(MeshFile&&) -> MeshFile& = delete;
+
+  [[nodiscard]] auto header() const -> const mesh::Header&;
+  [[nodiscard]] auto submeshes() const -> std::span<const mesh::Submesh>;
+  [[nodiscard]] auto lods() const -> std::span<const mesh::Lod>;
+
+  // Everything which is uploaded to the GPU, vertices followed by indices.
+  [[nodiscard]] auto payload() const -> std::span<const std::byte>;
+
+  [[nodiscard]] auto vertices() const -> std::span<const mesh::PackedVertex>;
+  [[nodiscard]] auto indices() const -> std::span<const std::byte>;
+
+ private:
+  MappedFile file_;
+};
+
+// Per mesh dequantization constants, laid out to be pushed as is.
+struct MeshDequantize {
+  std::array<float, 4> position_min = {};
+  std::array<float, 4> position_scale = {};
+  // xy uv min, zw uv scale.
+  std::array<float, 4> uv = {};
+};
+
+// A mesh resident in a single device local buffer holding both vertices and
+// indices, in the file's payload layout.
+class Mesh {
+ public:
+  Mesh(StagingUploader* uploader, const MeshFile& file);
+  Mesh(const Mesh&) = delete;
+  Mesh(Mesh&&) = delete;
+  ~Mesh() = default;
+
+  auto operator=(const Mesh&) -> Mesh& = delete;
+  auto operator=(Mesh&&) -> Mesh& = delete;
+
+  // Vertex input state for pipelines drawing meshes. The attributes are
+  // normalized formats, so the vertex shader only applies the dequantize
+  // scale and bias and decodes the octahedral normal.
+  [[nodiscard]] static auto vertex_binding()
+      -> VkVertexInputBindingDescription;
+  [[nodiscard]] static auto vertex_attributes()
+      -> std::array<VkVertexInputAttributeDescription, 3>;
+
+  [[nodiscard]] auto buffer() const -> const Buffer& { return buffer_; }
+  [[nodiscard]] auto submeshes() const -> std::span<const mesh::Submesh> {
+    return submeshes_;
+  }
+  // Levels of detail of |submesh|, finest first.
+  [[nodiscard]] auto lods(size_t submesh) const -> std::span<const mesh::Lod>;
+  [[nodiscard]] auto dequantize() const -> const MeshDequantize& {
+    return dequantize_;
+  }
+  [[nodiscard]] auto vertex_offset() const -> VkDeviceSize {
+    return vertex_offset_;
+  }
+  [[nodiscard]] auto index_offset() const -> VkDeviceSize {
+    return index_offset_;
+  }
+  [[nodiscard]] auto index_type() const -> VkIndexType { return index_type_; }
+
+  auto bind(VkCommandBuffer cmd) const -> void;
+  auto draw(VkCommandBuffer cmd,
+            size_t submesh,
+            size_t lod = 0,
+            uint32_t instance_count = 1,
+            uint32_t first_instance = 0) const -> void;
+
+ private:
+  Buffer buffer_;
+  std::vector<mesh::Submesh> submeshes_;
+  std::vector<mesh::Lod> lods_;
+  MeshDequantize dequantize_;
+  VkDeviceSize vertex_offset_ = 0;
+  VkDeviceSize index_offset_ = 0;
+  VkIndexType index_type_ = VK_INDEX_TYPE_UINT16;
+  EL_PAD(4);
+};
+
+}  // namespace el::engine
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// On disk layout of .elm mesh files. Shared by the engine loader and the
+// offline converter, so this header must not depend on Vulkan.
+//
+//   Header
+//   Submesh[submesh_count]
+//   Lod[lod_count]
+//   <padding to kDataAlignment>
+//   payload: PackedVertex[vertex_count], <padding>, indices
+//
+// The payload is uploaded into a single GPU buffer unchanged. Vertex and
+// index offsets in the header are relative to the start of the payload, so
+// they are also the offsets to bind within that buffer.
+namespace el::engine::mesh {
+
+constexpr uint32_t kMagic = 0x534d4c45;  // "ELMS"
+constexpr uint32_t kVersion = 2;
+
+// Alignment of the payload in the file and of the index data inside it.
+// Large enough for any minStorageBufferOffsetAlignment.
+constexpr uint64_t kDataAlignment = 256;
+
+enum class IndexType : uint32_t {
+  kUint16 = 0,
+  kUint32 = 1,
+};
+
+// 16 bytes per vertex.
+//
+// position: unorm16, mapped onto the mesh bounds by Header::position_min and
+//           Header::position_scale. w is unused.
+// normal:   octahedral encoded unit vector, snorm16.
+// uv:       unorm16, mapped by Header::uv_min and Header::uv_scale.
+struct PackedVertex {
+  std::array<uint16_t, 4> position = {};
+  std::array<int16_t, 2> normal = {};
+  std::array<uint16_t, 2> uv = {};
+};
+static_assert(sizeof(PackedVertex) == 16);
+
+// Maximum number of levels of detail per submesh, including the full
+// detail one.
+constexpr uint32_t kMaxLods = 8;
+
+// One level of detail: a range of the index buffer. Every level of a submesh
+// indexes the same vertices, coarser levels simply reference fewer of them.
+struct Lod {
+  uint32_t first_index = 0;
+  uint32_t index_count = 0;
+  // Maximum quadric distance of the simplification that built the level,
+  // in object space: the largest RMS distance of a kept vertex to the
+  // planes it absorbed. Zero for the first level, increasing after that.
+  float error = 0.0F;
+  uint32_t reserved = 0;
+};
+static_assert(sizeof(Lod) == 16);
+
+// The part of a mesh drawn with a single material. Indices are relative to
+// vertex_offset, which keeps 16 bit indices usable for meshes with more than
+// 65536 vertices in total.
+struct Submesh {
+  uint32_t vertex_offset = 0;
+  uint32_t vertex_count = 0;
+  // Range of the Lod table, finest level first.
+  uint32_t first_lod = 0;
+  uint32_t lod_count = 0;
+  // Bounding sphere, xyz center and w radius, in object space.
+  std::array<float, 4> bounds = {};
+};
+static_assert(sizeof(Submesh) == 32);
+
+struct Header {
+  uint32_t magic = kMagic;
+  uint32_t version = kVersion;
+  uint32_t vertex_count = 0;
+  uint32_t index_count = 0;
+  uint32_t submesh_count = 0;
+  uint32_t lod_count = 0;
+  IndexType index_type = IndexType::kUint16;
+  uint32_t reserved = 0;
+
+  // Absolute file offsets.
+  uint64_t submesh_offset = 0;
+  uint64_t lod_offset = 0;
+  uint64_t data_offset = 0;
+  uint64_t data_size = 0;
+
+  // Relative to data_offset.
+  uint64_t vertex_offset = 0;
+  uint64_t index_offset = 0;
+
+  // Dequantization: value = min + unorm * scale.
+  std::array<float, 4> position_min = {};
+  std::array<float, 4> position_scale = {};
+  std::array<float, 2> uv_min = {};
+  std::array<float, 2> uv_scale = {};
+};
+static_assert(sizeof(Header) == 128);
+
+[[nodiscard]] constexpr auto index_size(IndexType type) -> uint32_t {
+  return type == IndexType::kUint16 ? 2 : 4;
+}
+
+}  // namespace el::engine::mesh
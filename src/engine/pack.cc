@@ -0,0 +1,126 @@
+#include "src/engine/pack.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+#include "src/engine/lz4.h"
+
+namespace el::engine {
+namespace {
+
+auto fits(uint64_t offset, uint64_t size, uint64_t limit) -> bool {
+  return offset <= limit && size <= limit - offset;
+}
+
+using Key = std::tuple<uint64_t, std::string_view>;
+
+// Orders entries the way tools/pack writes them.
+auto entry_key(const pack::Entry& entry, std::string_view name) -> Key {
+  return {entry.name_hash, name};
+}
+
+}  // namespace
+
+PackFile::PackFile(const std::string& path) : file_(path) {
+  auto file_size = file_.data().size();
+  if (file_size < sizeof(pack::Header) || header().magic != pack::kMagic) {
+    throw std::runtime_error(std::string("Not an asset pack: ").append(path));
+  }
+
+  const auto& h = header();
+  if (h.version != pack::kVersion) {
+    throw std::runtime_error(std::string("Unsupported pack version: ")
+                                 .append(std::to_string(h.version)));
+  }
+  if (h.entry_offset % alignof(pack::Entry) != 0 ||
+      !fits(h.entry_offset, uint64_t{h.entry_count} * sizeof(pack::Entry),
+            file_size) ||
+      !fits(h.names_offset, h.names_size, file_size)) {
+    throw std::runtime_error(std::string("Corrupt asset pack: ").append(path));
+  }
+
+  // Only the index is checked, the entry data is not touched until used.
+  auto bad_entry = [&h, file_size](const pack::Entry& e) {
+    auto bad_size = e.compression == pack::Compression::kNone
+                        ? e.stored_size != e.size
+                        : e.compression != pack::Compression::kLz4;
+    return bad_size || e.offset % pack::kEntryAlignment != 0 ||
+           !fits(e.offset, e.stored_size, file_size) ||
+           !fits(e.name_offset, e.name_size, h.names_size);
+  };
+  auto all = entries();
+  auto unsorted = [this](const pack::Entry& a, const pack::Entry& b) {
+    return entry_key(b, name(b)) <= entry_key(a, name(a));
+  };
+  if (std::any_of(std::begin(all), std::end(all), bad_entry) ||
+      std::adjacent_find(std::begin(all), std::end(all), unsorted) !=
+          std::end(all)) {
+    throw std::runtime_error(std::string("Corrupt asset pack: ").append(path));
+  }
+}
+
+auto PackFile::header() const -> const pack::Header& {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return *reinterpret_cast<const pack::Header*>(file_.data().data());
+}
+
+auto PackFile::entries() const -> std::span<const pack::Entry> {
+  const auto& h = header();
+  return {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      reinterpret_cast<const pack::Entry*>(
+          file_.data().subspan(h.entry_offset).data()),
+      h.entry_count};
+}
+
+auto PackFile::name(const pack::Entry& entry) const -> std::string_view {
+  auto bytes = file_.data().subspan(header().names_offset + entry.name_offset,
+                                    entry.name_size);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+}
+
+auto PackFile::find(std::string_view name) const -> const pack::Entry* {
+  auto all = entries();
+  auto key = Key(pack::name_hash(name), name);
+  auto it = std::lower_bound(std::begin(all), std::end(all), key,
+                             [this](const pack::Entry& e, const Key& k) {
+                               return entry_key(e, this->name(e)) < k;
+                             });
+  if (it == std::end(all) || entry_key(*it, this->name(*it)) != key) {
+    return nullptr;
+  }
+  return &*it;
+}
+
+auto PackFile::stored(const pack::Entry& entry) const
+    -> std::span<const std::byte> {
+  return file_.data().subspan(entry.offset, entry.stored_size);
+}
+
+auto PackFile::read(const pack::Entry& entry, std::span<std::byte> dst) const
+    -> void {
+  if (dst.size() != entry.size) {
+    throw std::runtime_error("Pack read size mismatch");
+  }
+
+  auto src = stored(entry);
+  if (entry.compression == pack::Compression::kNone) {
+    std::copy(std::begin(src), std::end(src), std::begin(dst));
+    return;
+  }
+  if (!lz4::decompress(src, dst)) {
+    throw std::runtime_error(
+        std::string("Corrupt pack entry: ").append(name(entry)));
+  }
+}
+
+auto PackFile::read(const pack::Entry& entry) const -> std::vector<std::byte> {
+  std::vector<std::byte> data(entry.size);
+  read(entry, data);
+  return data;
+}
+
+}  // namespace el::engine
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/engine/mapped_file.h"
+#include "src/engine/pack_format.h"
+
+namespace el::engine {
+
+// A read only, memory mapped .elp asset pack as written by tools/pack.
+class PackFile {
+ public:
+  explicit PackFile(const std::string& path);
+  PackFile(const PackFile&) = delete;
+  PackFile(PackFile&&) = delete;
+  ~PackFile() = default;
+
+  auto operator=(const PackFile&) -> PackFile& = delete;
+  auto operator=(PackFile&&) -> PackFile& = delete;
+
+  [[nodiscard]] auto entries() const -> std::span<const pack::Entry>;
+  [[nodiscard]] auto name(const pack::Entry& entry) const -> std::string_view;
+
+  // Binary search of the index, nullptr when |name| isn't in the pack.
+  [[nodiscard]] auto find(std::string_view name) const -> const pack::Entry*;
+
+  // The bytes of |entry| as stored, pointing straight into the mapping.
+  // These are the contents themselves only for uncompressed entries.
+  [[nodiscard]] auto stored(const pack::Entry& entry) const
+      -> std::span<const std::byte>;
+
+  // Copies or decompresses the contents of |entry| into |dst|, which must be
+  // entry.size bytes.
+  auto read(const pack::Entry& entry, std::span<std::byte> dst) const -> void;
+  [[nodiscard]] auto read(const pack::Entry& entry) const
+      -> std::vector<std::byte>;
+
+ private:
+  [[nodiscard]] auto header() const -> const pack::Header&;
+
+  MappedFile file_;
+};
+
+}  // namespace el::engine
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "src/engine/hash.h"
+
+// On disk layout of .elp asset packs. Shared by the engine reader and the
+// offline packer, so this header must not depend on Vulkan.
+//
+//   Header
+//   Entry[entry_count], sorted by (hash, name)
+//   names: entry names, not null terminated
+//   <padding to kEntryAlignment>
+//   entry data, each entry starting on a kEntryAlignment boundary
+//
+// The header and index sit in the first pages of the file, so opening a pack
+// costs one open() and a handful of page faults however many assets it
+// holds. Uncompressed entries are page aligned and can be used straight
+// from the mapping.
+namespace el::engine::pack {
+
+constexpr uint32_t kMagic = 0x4b504c45;  // "ELPK"
+constexpr uint32_t kVersion = 1;
+
+constexpr uint64_t kEntryAlignment = 4096;
+
+enum class Compression : uint32_t {
+  kNone = 0,
+  // LZ4 block format, see src/engine/lz4.h.
+  kLz4 = 1,
+};
+
+struct Entry {
+  uint64_t name_hash = 0;
+  // Absolute file offset of the stored bytes.
+  uint64_t offset = 0;
+  uint64_t stored_size = 0;
+  uint64_t size = 0;
+  // Relative to Header::names_offset.
+  uint32_t name_offset = 0;
+  uint32_t name_size = 0;
+  Compression compression = Compression::kNone;
+  uint32_t reserved = 0;
+};
+static_assert(sizeof(Entry) == 48);
+
+struct Header {
+  uint32_t magic = kMagic;
+  uint32_t version = kVersion;
+  uint32_t entry_count = 0;
+  uint32_t reserved = 0;
+
+  // Absolute file offsets.
+  uint64_t entry_offset = 0;
+  uint64_t names_offset = 0;
+  uint64_t names_size = 0;
+};
+static_assert(sizeof(Header) == 40);
+
+// Entry names are '/' separated paths relative to the packed directory.
+constexpr auto name_hash(std::string_view name) -> uint64_t {
+  uint64_t hash = kFnvOffsetBasis;
+  for (auto c : name) {
+    hash ^= static_cast<uint64_t>(static_cast<unsigned char>(c));
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+}  // namespace el::engine::pack
@@ -0,0 +1,394 @@
+#include "src/engine/particles.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace el::engine {
+namespace {
+
+// Push constants of the particle compute stages, see
+// src/shaders/particle_params.glsl.
+struct SimulateParams {
+  math::Vec4 emitter;
+  math::Vec4 emit_velocity;
+  std::array<float, 4> emit_color = {};
+  math::Vec4 gravity;
+  float dt = 0.0F;
+  float lifetime = 0.0F;
+  float size = 0.0F;
+  uint32_t emit_count = 0;
+  uint32_t seed = 0;
+  uint32_t list = 0;
+  uint32_t capacity = 0;
+  EL_PAD(4);
+};
+static_assert(sizeof(SimulateParams) <= 128);
+
+// Push constants of src/shaders/particle.vert.
+struct DrawParams {
+  math::Mat4 view_projection;
+  math::Vec4 right;
+  math::Vec4 up;
+};
+static_assert(sizeof(DrawParams) <= 128);
+
+// The State block of src/shaders/particles.glsl.
+struct ParticleState {
+  uint32_t dead_count = 0;
+  uint32_t dead_top = 0;
+  uint32_t alive_count = 0;
+  uint32_t alive_next = 0;
+  VkDispatchIndirectCommand simulate = {};
+  uint32_t unused = 0;
+  VkDrawIndirectCommand draw = {};
+};
+static_assert(offsetof(ParticleState, simulate) == 16);
+static_assert(offsetof(ParticleState, draw) == 32);
+
+// Each particle is a quad of two triangles.
+constexpr uint32_t kParticleVertices = 6;
+
+}  // namespace
+
+ParticleSystem::ParticleSystem(const ParticleSystemConfig& config)
+    : device_(config.device()),
+      capacity_(config.capacity()),
+      gravity_(config.gravity()),
+      drag_(config.drag()),
+      async_compute_(config.async_compute()),
+      particles_(BufferConfig(config.device())
+                     .set_size(VkDeviceSize{capacity_} * kParticleStride)
+                     .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+                     .set_compute_shared(config.async_compute())),
+      dead_(BufferConfig(config.device())
+                .set_size(VkDeviceSize{capacity_} * sizeof(uint32_t))
+                .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                           VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+                .set_compute_shared(config.async_compute())),
+      alive_(BufferConfig(config.device())
+                 .set_size(VkDeviceSize{capacity_} * 2 * sizeof(uint32_t))
+                 .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+                 .set_compute_shared(config.async_compute())),
+      state_(BufferConfig(config.device())
+                 .set_size(sizeof(ParticleState))
+                 .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                            VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+                 .set_compute_shared(config.async_compute())) {
+  if (!device_->has_feature(Feature::kDrawIndirectFirstInstance)) {
+    throw std::runtime_error(
+        "GPU particles require drawIndirectFirstInstance");
+  }
+
+  create_layouts(config);
+
+  std::array<DescriptorWrite, 4> writes = {
+      DescriptorWrite{
+          .buffer = {particles_.buffer(), 0, VK_WHOLE_SIZE},
+          .binding = 0,
+          .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      },
+      DescriptorWrite{
+          .buffer = {dead_.buffer(), 0, VK_WHOLE_SIZE},
+          .binding = 1,
+          .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      },
+      DescriptorWrite{
+          .buffer = {alive_.buffer(), 0, VK_WHOLE_SIZE},
+          .binding = 2,
+          .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      },
+      DescriptorWrite{
+          .buffer = {state_.buffer(), 0, VK_WHOLE_SIZE},
+          .binding = 3,
+          .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      },
+  };
+  set_ = config.descriptors()->allocate_immutable(set_layout_, writes);
+
+  create_pipelines(config);
+  if (async_compute_) {
+    create_submission();
+  }
+}
+
+ParticleSystem::~ParticleSystem() {
+  if (async_compute_) {
+    vkWaitForFences(device_->device(), uint32_t(fences_.size()),
+                    fences_.data(), VK_TRUE, UINT64_MAX);
+    std::for_each(std::begin(fences_), std::end(fences_),
+                  [this](VkFence fence) {
+                    vkDestroyFence(device_->device(), fence, nullptr);
+                  });
+    vkFreeCommandBuffers(device_->device(), device_->compute_cmd_pool(),
+                         uint32_t(cmds_.size()), cmds_.data());
+  }
+  // The pipelines belong to the registry.
+  vkDestroyPipelineLayout(device_->device(), draw_layout_, nullptr);
+  vkDestroyPipelineLayout(device_->device(), compute_layout_, nullptr);
+}
+
+auto ParticleSystem::create_layouts(const ParticleSystemConfig& config)
+    -> void {
+  std::array<VkDescriptorSetLayoutBinding, 4> bindings = {};
+  for (uint32_t i = 0; i < bindings.size(); ++i) {
+    bindings.at(i) = {
+        .binding = i,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT,
+    };
+  }
+  set_layout_ = config.descriptors()->layout(bindings);
+
+  auto create_layout = [this](VkShaderStageFlags stages, uint32_t size,
+                              VkPipelineLayout* layout, const char* what) {
+    VkPushConstantRange push_range = {
+        .stageFlags = stages,
+        .offset = 0,
+        .size = size,
+    };
+    VkPipelineLayoutCreateInfo layout_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &set_layout_,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push_range,
+    };
+    check(vkCreatePipelineLayout(device_->device(), &layout_info, nullptr,
+                                 layout),
+          what);
+  };
+  create_layout(VK_SHADER_STAGE_COMPUTE_BIT, sizeof(SimulateParams),
+                &compute_layout_, "create particle simulation layout");
+  create_layout(VK_SHADER_STAGE_VERTEX_BIT, sizeof(DrawParams), &draw_layout_,
+                "create particle draw layout");
+}
+
+auto ParticleSystem::create_pipelines(const ParticleSystemConfig& config)
+    -> void {
+  const auto& shaders = config.shaders();
+  auto compute = [this, &config](const Shader* shader) {
+    PipelineState state;
+    state.shaders = {shader};
+    state.layout = compute_layout_;
+    return config.pipelines()->get_blocking(state);
+  };
+  emit_ = compute(shaders.emit);
+  simulate_ = compute(shaders.simulate);
+  compact_ = compute(shaders.compact);
+
+  if (config.render_pass() == VK_NULL_HANDLE) {
+    return;
+  }
+  PipelineState state;
+  state.shaders = {shaders.vertex, shaders.fragment};
+  state.layout = draw_layout_;
+  state.render_pass = config.render_pass();
+  state.color_formats = {config.color_format()};
+  state.blend_attachments = {VkPipelineColorBlendAttachmentState{
+      .blendEnable = VK_TRUE,
+      .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
+      .dstColorBlendFactor = VK_BLEND_FACTOR_ONE,
+      .colorBlendOp = VK_BLEND_OP_ADD,
+      .srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+      .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+      .alphaBlendOp = VK_BLEND_OP_ADD,
+      .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                        VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+  }};
+  state.raster.cull_mode = VK_CULL_MODE_NONE;
+  // Tested against the scene, but unsorted so they must not occlude each
+  // other.
+  state.depth.write_enable = VK_FALSE;
+  state.depth_format = config.depth_format();
+  draw_ = config.pipelines()->get_blocking(state);
+}
+
+auto ParticleSystem::create_submission() -> void {
+  VkCommandBufferAllocateInfo alloc_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool = device_->compute_cmd_pool(),
+      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = uint32_t(cmds_.size()),
+  };
+  check(vkAllocateCommandBuffers(device_->device(), &alloc_info, cmds_.data()),
+        "allocate particle command buffers");
+
+  // Signaled so the first submit() of each slot doesn't wait.
+  VkFenceCreateInfo fence_info = {
+      .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+      .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+  };
+  std::for_each(std::begin(fences_), std::end(fences_),
+                [this, &fence_info](VkFence& fence) {
+                  check(vkCreateFence(device_->device(), &fence_info, nullptr,
+                                      &fence),
+                        "create particle fence");
+                });
+}
+
+auto ParticleSystem::draw_offset() -> VkDeviceSize {
+  return offsetof(ParticleState, draw);
+}
+
+auto ParticleSystem::reset(StagingUploader* uploader) -> void {
+  std::vector<uint32_t> dead(capacity_);
+  std::iota(std::begin(dead), std::end(dead), 0);
+  ParticleState state = {
+      .dead_count = capacity_,
+      .simulate = {0, 1, 1},
+      .draw = {kParticleVertices, 0, 0, 0},
+  };
+
+  uploader->upload(dead_, 0, std::as_bytes(std::span(dead)));
+  uploader->upload(state_, 0, std::as_bytes(std::span(&state, 1)));
+  uploader->flush();
+  list_ = 0;
+  emit_carry_ = 0.0F;
+}
+
+auto ParticleSystem::record(VkCommandBuffer cmd, float dt) -> void {
+  // Last frame's draw has to be done reading the lists and draw arguments
+  // before they are rewritten. See Device::compute_queue() for async
+  // compute.
+  if (!async_compute_) {
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                             VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr,
+                         0, nullptr, 0, nullptr);
+  }
+
+  auto emit =
+      std::clamp(emitter_.rate * dt + emit_carry_, 0.0F, float(capacity_));
+  auto emit_count = uint32_t(emit);
+  emit_carry_ = emit - float(emit_count);
+
+  SimulateParams params = {
+      .emitter = {emitter_.position.x, emitter_.position.y,
+                  emitter_.position.z, emitter_.radius},
+      .emit_velocity = {emitter_.velocity.x, emitter_.velocity.y,
+                        emitter_.velocity.z, emitter_.velocity_jitter},
+      .emit_color = emitter_.color,
+      .gravity = {gravity_.x, gravity_.y, gravity_.z, drag_},
+      .dt = dt,
+      .lifetime = emitter_.lifetime,
+      .size = emitter_.size,
+      .emit_count = emit_count,
+      .seed = seed_++,
+      .list = list_,
+      .capacity = capacity_,
+  };
+  vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          compute_layout_, 0, 1, &set_, 0, nullptr);
+  vkCmdPushConstants(cmd, compute_layout_, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                     sizeof(params), &params);
+
+  VkMemoryBarrier written = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+                       VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+  };
+  auto stage_barrier = [cmd, &written]() {
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 1, &written, 0, nullptr, 0, nullptr);
+  };
+
+  // Invocation 0 sets up the simulate dispatch, so there is always at least
+  // one group.
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, emit_);
+  vkCmdDispatch(cmd,
+                std::max((emit_count + kParticleGroupSize - 1) /
+                             kParticleGroupSize,
+                         1U),
+                1, 1);
+  stage_barrier();
+
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, simulate_);
+  vkCmdDispatchIndirect(cmd, state_.buffer(),
+                        offsetof(ParticleState, simulate));
+  stage_barrier();
+
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, compact_);
+  vkCmdDispatch(cmd, 1, 1, 1);
+  list_ ^= 1U;
+
+  if (async_compute_) {
+    return;
+  }
+  VkMemoryBarrier compacted = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+      .dstAccessMask =
+          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+  };
+  vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                           VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                       0, 1, &compacted, 0, nullptr, 0, nullptr);
+}
+
+auto ParticleSystem::submit(uint32_t slot,
+                            float dt,
+                            VkSemaphore wait,
+                            VkSemaphore signal) -> void {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
+  assert(async_compute_);
+  auto* fence = &fences_.at(slot);
+  auto cmd = cmds_.at(slot);
+  vkWaitForFences(device_->device(), 1, fence, VK_TRUE, UINT64_MAX);
+  vkResetFences(device_->device(), 1, fence);
+
+  check(vkResetCommandBuffer(cmd, 0), "reset particle command buffer");
+  VkCommandBufferBeginInfo begin_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+  };
+  check(vkBeginCommandBuffer(cmd, &begin_info),
+        "begin particle command buffer");
+  record(cmd, dt);
+  check(vkEndCommandBuffer(cmd), "end particle command buffer");
+
+  VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  VkSubmitInfo submit_info = {
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .waitSemaphoreCount = wait != VK_NULL_HANDLE ? 1U : 0U,
+      .pWaitSemaphores = &wait,
+      .pWaitDstStageMask = &wait_stage,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &cmd,
+      .signalSemaphoreCount = signal != VK_NULL_HANDLE ? 1U : 0U,
+      .pSignalSemaphores = &signal,
+  };
+  check(vkQueueSubmit(device_->compute_queue(), 1, &submit_info, *fence),
+        "submit particle simulation");
+}
+
+auto ParticleSystem::record_draw(VkCommandBuffer cmd,
+                                 const ParticleView& view) const -> void {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
+  assert(draw_ != VK_NULL_HANDLE);
+  DrawParams params = {
+      .view_projection = view.view_projection,
+      .right = {view.right.x, view.right.y, view.right.z, 0},
+      .up = {view.up.x, view.up.y, view.up.z, 0},
+  };
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, draw_);
+  vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, draw_layout_,
+                          0, 1, &set_, 0, nullptr);
+  vkCmdPushConstants(cmd, draw_layout_, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                     sizeof(params), &params);
+  vkCmdDrawIndirect(cmd, state_.buffer(), draw_offset(), 1, 0);
+}
+
+}  // namespace el::engine
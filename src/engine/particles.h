@@ -0,0 +1,245 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "src/engine/buffer.h"
+#include "src/engine/descriptor_allocator.h"
+#include "src/engine/device.h"
+#include "src/engine/pipeline_registry.h"
+#include "src/engine/shader.h"
+#include "src/engine/uploader.h"
+#include "src/engine/vk.h"
+#include "src/math/mat.h"
+#include "src/math/vec.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+constexpr uint32_t kDefaultParticleCapacity = 262144;
+// Matches local_size_x in src/shaders/particle_emit.comp and
+// src/shaders/particle_simulate.comp.
+constexpr uint32_t kParticleGroupSize = 64;
+// Size of the Particle struct of src/shaders/particles.glsl.
+constexpr VkDeviceSize kParticleStride = 48;
+
+// Where and how particles are born.
+struct ParticleEmitter {
+  // Center of the sphere particles spawn in.
+  math::Vec3 position;
+  float radius = 0.0F;
+  math::Vec3 velocity;
+  // Length of the random offset added to each particle's velocity.
+  float velocity_jitter = 0.0F;
+  std::array<float, 4> color = {1, 1, 1, 1};
+  // Seconds, varied by +-25% per particle.
+  float lifetime = 1.0F;
+  // Half the quad's edge, in world units.
+  float size = 0.1F;
+  // Particles per second.
+  float rate = 0.0F;
+};
+
+// The camera particles are drawn for.
+struct ParticleView {
+  math::Mat4 view_projection;
+  // World space directions of the screen's x and y axes.
+  math::Vec3 right;
+  math::Vec3 up;
+  EL_PAD(8);
+};
+
+// Shaders built from src/shaders.
+struct ParticleShaders {
+  // particle_emit.comp
+  const Shader* emit = nullptr;
+  // particle_simulate.comp
+  const Shader* simulate = nullptr;
+  // particle_compact.comp
+  const Shader* compact = nullptr;
+  // particle.vert
+  const Shader* vertex = nullptr;
+  // particle.frag
+  const Shader* fragment = nullptr;
+};
+
+class ParticleSystemConfig {
+ public:
+  ParticleSystemConfig(Device* device,
+                       DescriptorAllocator* descriptors,
+                       PipelineRegistry* pipelines,
+                       const ParticleShaders& shaders)
+      : device_(device),
+        descriptors_(descriptors),
+        pipelines_(pipelines),
+        shaders_(shaders) {}
+
+  // Maximum number of live particles.
+  auto set_capacity(uint32_t capacity) -> ParticleSystemConfig& {
+    capacity_ = capacity;
+    return *this;
+  }
+
+  // Render pass and formats of the pass particles are drawn in. Without
+  // one, only the simulation is set up and record_draw() can't be used.
+  auto set_render_pass(VkRenderPass render_pass,
+                       VkFormat color_format,
+                       VkFormat depth_format) -> ParticleSystemConfig& {
+    render_pass_ = render_pass;
+    color_format_ = color_format;
+    depth_format_ = depth_format;
+    return *this;
+  }
+
+  auto set_gravity(math::Vec3 gravity) -> ParticleSystemConfig& {
+    gravity_ = gravity;
+    return *this;
+  }
+
+  // Share of its velocity a particle loses per second.
+  auto set_drag(float drag) -> ParticleSystemConfig& {
+    drag_ = drag;
+    return *this;
+  }
+
+  // Shares the buffers between the graphics and compute families and
+  // allocates command buffers from the device's compute pool, so the
+  // simulation can be submitted to the compute queue with submit().
+  auto set_async_compute() -> ParticleSystemConfig& {
+    async_compute_ = true;
+    return *this;
+  }
+
+  [[nodiscard]] auto device() const -> Device* { return device_; }
+  [[nodiscard]] auto descriptors() const -> DescriptorAllocator* {
+    return descriptors_;
+  }
+  [[nodiscard]] auto pipelines() const -> PipelineRegistry* {
+    return pipelines_;
+  }
+  [[nodiscard]] auto shaders() const -> const ParticleShaders& {
+    return shaders_;
+  }
+  [[nodiscard]] auto capacity() const -> uint32_t { return capacity_; }
+  [[nodiscard]] auto render_pass() const -> VkRenderPass {
+    return render_pass_;
+  }
+  [[nodiscard]] auto color_format() const -> VkFormat {
+    return color_format_;
+  }
+  [[nodiscard]] auto depth_format() const -> VkFormat {
+    return depth_format_;
+  }
+  [[nodiscard]] auto gravity() const -> math::Vec3 { return gravity_; }
+  [[nodiscard]] auto drag() const -> float { return drag_; }
+  [[nodiscard]] auto async_compute() const -> bool { return async_compute_; }
+
+ private:
+  Device* device_ = nullptr;
+  DescriptorAllocator* descriptors_ = nullptr;
+  PipelineRegistry* pipelines_ = nullptr;
+  ParticleShaders shaders_;
+  VkRenderPass render_pass_ = VK_NULL_HANDLE;
+  VkFormat color_format_ = VK_FORMAT_UNDEFINED;
+  VkFormat depth_format_ = VK_FORMAT_UNDEFINED;
+  uint32_t capacity_ = kDefaultParticleCapacity;
+  math::Vec3 gravity_ = {0, -9.81F, 0};
+  float drag_ = 0.0F;
+  bool async_compute_ = false;
+  EL_PAD(3);
+};
+
+// A particle system living entirely on the GPU. Each frame three compute
+// stages run: emit pops free particles off a dead list and appends them to
+// the alive list, simulate ages and moves the live ones while compacting
+// survivors into a second alive list and returning expired particles to the
+// dead list, and compact publishes the new counts along with the indirect
+// draw arguments. The CPU only sets the emitter and frame time, and never
+// reads anything back.
+//
+// record() may go on the graphics queue before the draw. With
+// set_async_compute(), submit() records into a command buffer from the
+// device's compute pool and submits it to the compute queue instead; then
+// the caller's semaphores order it after the previous frame's draw and
+// before this frame's.
+class ParticleSystem {
+ public:
+  explicit ParticleSystem(const ParticleSystemConfig& config);
+  ParticleSystem(const ParticleSystem&) = delete;
+  ParticleSystem(ParticleSystem&&) = delete;
+  ~ParticleSystem();
+
+  auto operator=(const ParticleSystem&) -> ParticleSystem& = delete;
+  auto operator=(ParticleSystem&&) -> ParticleSystem& = delete;
+
+  // Kills all particles. Has to run once before the first record().
+  auto reset(StagingUploader* uploader) -> void;
+
+  auto set_emitter(const ParticleEmitter& emitter) -> void {
+    emitter_ = emitter;
+  }
+
+  // Records one simulation step of |dt| seconds. On the graphics queue the
+  // particles are ready to draw afterwards.
+  auto record(VkCommandBuffer cmd, float dt) -> void;
+
+  // Records a step into frame |slot|'s compute command buffer and submits
+  // it to the compute queue, waiting on |wait| and signaling |signal|.
+  // Either may be VK_NULL_HANDLE. Requires set_async_compute().
+  auto submit(uint32_t slot, float dt, VkSemaphore wait, VkSemaphore signal)
+      -> void;
+
+  // Draws the live particles inside the configured render pass with one
+  // indirect draw, additively blended.
+  auto record_draw(VkCommandBuffer cmd, const ParticleView& view) const
+      -> void;
+
+  // For custom particle shaders, which include src/shaders/particles.glsl.
+  [[nodiscard]] auto set() const -> VkDescriptorSet { return set_; }
+  [[nodiscard]] auto set_layout() const -> VkDescriptorSetLayout {
+    return set_layout_;
+  }
+  // The draw arguments, a VkDrawIndirectCommand at draw_offset().
+  [[nodiscard]] auto draw_buffer() const -> VkBuffer { return state_.buffer(); }
+  [[nodiscard]] static auto draw_offset() -> VkDeviceSize;
+
+  [[nodiscard]] auto capacity() const -> uint32_t { return capacity_; }
+
+ private:
+  auto create_layouts(const ParticleSystemConfig& config) -> void;
+  auto create_pipelines(const ParticleSystemConfig& config) -> void;
+  auto create_submission() -> void;
+
+  Device* device_ = nullptr;
+  uint32_t capacity_ = 0;
+  // The alive list simulated next, 0 or 1.
+  uint32_t list_ = 0;
+  ParticleEmitter emitter_;
+  math::Vec3 gravity_;
+  float drag_ = 0.0F;
+  // Fractional particles left over from previous frames' emission.
+  float emit_carry_ = 0.0F;
+  uint32_t seed_ = 0;
+  bool async_compute_ = false;
+  EL_PAD(3);
+
+  Buffer particles_;
+  Buffer dead_;
+  Buffer alive_;
+  Buffer state_;
+
+  VkDescriptorSetLayout set_layout_ = VK_NULL_HANDLE;
+  VkDescriptorSet set_ = VK_NULL_HANDLE;
+  VkPipelineLayout compute_layout_ = VK_NULL_HANDLE;
+  VkPipelineLayout draw_layout_ = VK_NULL_HANDLE;
+  VkPipeline emit_ = VK_NULL_HANDLE;
+  VkPipeline simulate_ = VK_NULL_HANDLE;
+  VkPipeline compact_ = VK_NULL_HANDLE;
+  VkPipeline draw_ = VK_NULL_HANDLE;
+
+  // With async compute, per frame slot.
+  std::array<VkCommandBuffer, kMaxFramesInFlight> cmds_ = {};
+  std::array<VkFence, kMaxFramesInFlight> fences_ = {};
+};
+
+}  // namespace el::engine
@@ -0,0 +1,338 @@
+#include "src/engine/pipeline_registry.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "src/engine/hash.h"
+#include "src/engine/vk.h"
+
+namespace el::engine {
+namespace {
+
+constexpr VkColorComponentFlags kColorWriteAll =
+    VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+    VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+constexpr std::array<VkDynamicState, 2> kDynamicStates = {
+    {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR}};
+
+auto build_compute(VkDevice device,
+                   VkPipelineCache cache,
+                   const PipelineState& state) -> VkPipeline {
+  VkComputePipelineCreateInfo create_info = {
+      .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+      .stage = state.shaders.front()->create_info(),
+      .layout = state.layout,
+      .basePipelineHandle = VK_NULL_HANDLE,
+      .basePipelineIndex = -1,
+  };
+
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  auto res = vkCreateComputePipelines(device, cache, 1, &create_info, nullptr,
+                                      &pipeline);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(std::string("Failed to create compute pipeline: ")
+                                 .append(to_string(res)));
+  }
+  return pipeline;
+}
+
+auto build_graphics(VkDevice device,
+                    VkPipelineCache cache,
+                    const PipelineState& state) -> VkPipeline {
+  std::vector<VkPipelineShaderStageCreateInfo> stages(state.shaders.size());
+  std::transform(std::begin(state.shaders), std::end(state.shaders),
+                 std::begin(stages),
+                 [](const Shader* shader) { return shader->create_info(); });
+
+  VkPipelineVertexInputStateCreateInfo vertex_input = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+      .vertexBindingDescriptionCount = uint32_t(state.vertex_bindings.size()),
+      .pVertexBindingDescriptions = state.vertex_bindings.data(),
+      .vertexAttributeDescriptionCount =
+          uint32_t(state.vertex_attributes.size()),
+      .pVertexAttributeDescriptions = state.vertex_attributes.data(),
+  };
+
+  VkPipelineInputAssemblyStateCreateInfo input_assembly = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+      .topology = state.raster.topology,
+      .primitiveRestartEnable = VK_FALSE,
+  };
+
+  // Viewport and scissor are dynamic so resizes never invalidate pipelines.
+  VkPipelineViewportStateCreateInfo viewport = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+      .viewportCount = 1,
+      .scissorCount = 1,
+  };
+
+  VkPipelineRasterizationStateCreateInfo raster = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+      .depthClampEnable = VK_FALSE,
+      .rasterizerDiscardEnable = VK_FALSE,
+      .polygonMode = state.raster.polygon_mode,
+      .cullMode = state.raster.cull_mode,
+      .frontFace = state.raster.front_face,
+      .depthBiasEnable = VK_FALSE,
+      .lineWidth = 1.0F,
+  };
+
+  VkPipelineMultisampleStateCreateInfo multisample = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+      .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+      .sampleShadingEnable = VK_FALSE,
+  };
+
+  VkPipelineDepthStencilStateCreateInfo depth = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+      .depthTestEnable = state.depth.test_enable,
+      .depthWriteEnable = state.depth.write_enable,
+      .depthCompareOp = state.depth.compare_op,
+      .depthBoundsTestEnable = VK_FALSE,
+      .stencilTestEnable = VK_FALSE,
+  };
+
+  std::vector<VkPipelineColorBlendAttachmentState> attachments(
+      state.color_formats.size(),
+      {.blendEnable = VK_FALSE, .colorWriteMask = kColorWriteAll});
+  std::copy_n(std::begin(state.blend_attachments),
+              std::min(attachments.size(), state.blend_attachments.size()),
+              std::begin(attachments));
+
+  VkPipelineColorBlendStateCreateInfo blend = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+      .logicOpEnable = VK_FALSE,
+      .attachmentCount = uint32_t(attachments.size()),
+      .pAttachments = attachments.data(),
+  };
+
+  VkPipelineDynamicStateCreateInfo dynamic = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+      .dynamicStateCount = uint32_t(kDynamicStates.size()),
+      .pDynamicStates = kDynamicStates.data(),
+  };
+
+  VkGraphicsPipelineCreateInfo create_info = {
+      .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+      .stageCount = uint32_t(stages.size()),
+      .pStages = stages.data(),
+      .pVertexInputState = &vertex_input,
+      .pInputAssemblyState = &input_assembly,
+      .pViewportState = &viewport,
+      .pRasterizationState = &raster,
+      .pMultisampleState = &multisample,
+      .pDepthStencilState =
+          state.depth_format != VK_FORMAT_UNDEFINED ? &depth : nullptr,
+      .pColorBlendState = &blend,
+      .pDynamicState = &dynamic,
+      .layout = state.layout,
+      .renderPass = state.render_pass,
+      .subpass = state.subpass,
+      .basePipelineHandle = VK_NULL_HANDLE,
+      .basePipelineIndex = -1,
+  };
+
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  auto res = vkCreateGraphicsPipelines(device, cache, 1, &create_info, nullptr,
+                                       &pipeline);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to create graphics pipeline: ")
+            .append(to_string(res)));
+  }
+  return pipeline;
+}
+
+}  // namespace
+
+auto read_pipeline_cache(std::string_view path) -> std::vector<char> {
+  if (path.empty()) {
+    return {};
+  }
+
+  std::ifstream file(std::string(path), std::ios::binary);
+  if (!file) {
+    return {};
+  }
+  return {std::istreambuf_iterator<char>(file),
+          std::istreambuf_iterator<char>()};
+}
+
+auto PipelineState::hash() const -> uint64_t {
+  uint64_t h = kFnvOffsetBasis;
+  for (const auto* shader : shaders) {
+    h = hash_combine(h, shader->hash());
+  }
+  h = hash_span(std::span(vertex_bindings), h);
+  h = hash_span(std::span(vertex_attributes), h);
+  h = hash_span(std::span(blend_attachments), h);
+  h = hash_span(std::span(color_formats), h);
+  // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+  h = hash_combine(h, reinterpret_cast<uint64_t>(layout));
+  h = hash_combine(h, reinterpret_cast<uint64_t>(render_pass));
+  // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+  h = hash_value(raster, h);
+  h = hash_value(depth, h);
+  h = hash_combine(h, static_cast<uint64_t>(depth_format));
+  return hash_combine(h, subpass);
+}
+
+auto PipelineState::is_compute() const -> bool {
+  return shaders.size() == 1 &&
+         shaders.front()->type() == shader::Type::kCompute;
+}
+
+PipelineRegistry::PipelineRegistry(const PipelineRegistryConfig& config)
+    : device_(config.device()),
+      jobs_(config.jobs()),
+      cache_path_(config.cache_path()) {
+  const auto& preloaded = config.initial_cache();
+  auto read = preloaded.has_value() ? std::vector<char>{}
+                                    : read_pipeline_cache(cache_path_);
+  const auto& initial = preloaded.has_value() ? preloaded.value() : read;
+
+  VkPipelineCacheCreateInfo create_info = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+      .initialDataSize = initial.size(),
+      .pInitialData = initial.empty() ? nullptr : initial.data(),
+  };
+
+  auto res = vkCreatePipelineCache(device_->device(), &create_info, nullptr,
+                                   &cache_);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(std::string("Failed to create pipeline cache: ")
+                                 .append(to_string(res)));
+  }
+}
+
+PipelineRegistry::~PipelineRegistry() {
+  wait_idle();
+  save_cache();
+
+  auto device = device_->device();
+  std::for_each(std::begin(entries_), std::end(entries_),
+                [device](const auto& entry) {
+                  vkDestroyPipeline(device, entry.second.pipeline, nullptr);
+                });
+  vkDestroyPipelineCache(device, cache_, nullptr);
+}
+
+auto PipelineRegistry::request(const PipelineState& state, VkPipeline fallback)
+    -> PipelineLookup {
+  auto key = state.hash();
+
+  const std::lock_guard<std::mutex> lock(lock_);
+  const auto& entry = schedule_locked(key, state);
+  if (entry.status == PipelineStatus::kReady) {
+    return {.pipeline = entry.pipeline, .status = PipelineStatus::kReady};
+  }
+  return {.pipeline = fallback, .status = entry.status};
+}
+
+auto PipelineRegistry::get_blocking(const PipelineState& state) -> VkPipeline {
+  auto key = state.hash();
+
+  std::unique_lock<std::mutex> lock(lock_);
+  if (entries_.find(key) == entries_.end()) {
+    // Nobody is compiling this yet, so build it right here instead of
+    // waiting for a worker to pick it up.
+    entries_.insert(std::make_pair(key, Entry{}));
+    pending_ += 1;
+    lock.unlock();
+    compile(key, state);
+    lock.lock();
+  }
+
+  // Other threads may insert while we wait, so look the entry up again
+  // rather than holding on to an iterator.
+  Entry entry;
+  compiled_cv_.wait(lock, [this, key, &entry]() {
+    entry = entries_.at(key);
+    return entry.status != PipelineStatus::kPending;
+  });
+  if (entry.status == PipelineStatus::kFailed) {
+    throw std::runtime_error("Pipeline compilation failed");
+  }
+  return entry.pipeline;
+}
+
+auto PipelineRegistry::prewarm(std::span<const PipelineState> states) -> void {
+  const std::lock_guard<std::mutex> lock(lock_);
+  std::for_each(std::begin(states), std::end(states),
+                [this](const PipelineState& state) {
+                  schedule_locked(state.hash(), state);
+                });
+}
+
+auto PipelineRegistry::wait_idle() -> void {
+  std::unique_lock<std::mutex> lock(lock_);
+  compiled_cv_.wait(lock, [this]() { return pending_ == 0; });
+}
+
+auto PipelineRegistry::save_cache() const -> void {
+  if (cache_path_.empty()) {
+    return;
+  }
+
+  size_t size = 0;
+  check(vkGetPipelineCacheData(device_->device(), cache_, &size, nullptr),
+        "get pipeline cache size");
+  std::vector<char> data(size);
+  auto res =
+      vkGetPipelineCacheData(device_->device(), cache_, &size, data.data());
+  // Compiles still running may have grown the cache meanwhile; what fit is
+  // a valid cache all the same.
+  if (res != VK_INCOMPLETE) {
+    check(res, "get pipeline cache data");
+  }
+
+  auto temp_path = cache_path_ + ".tmp";
+  std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+  file.write(data.data(), static_cast<std::streamsize>(size));
+  file.close();
+  if (!file) {
+    std::filesystem::remove(temp_path);
+    throw std::runtime_error(
+        std::string("Failed to write pipeline cache: ").append(temp_path));
+  }
+  std::filesystem::rename(temp_path, cache_path_);
+}
+
+auto PipelineRegistry::schedule_locked(uint64_t key, const PipelineState& state)
+    -> Entry& {
+  auto [it, inserted] = entries_.insert(std::make_pair(key, Entry{}));
+  if (inserted) {
+    pending_ += 1;
+    jobs_->submit([this, key, state]() { compile(key, state); });
+  }
+  return it->second;
+}
+
+auto PipelineRegistry::compile(uint64_t key, const PipelineState& state)
+    -> void {
+  Entry result = {.pipeline = VK_NULL_HANDLE,
+                  .status = PipelineStatus::kFailed};
+  try {
+    result.pipeline = state.is_compute()
+                          ? build_compute(device_->device(), cache_, state)
+                          : build_graphics(device_->device(), cache_, state);
+    result.status = PipelineStatus::kReady;
+  } catch (...) {
+    // Reported through the entry status, there is no caller to throw to.
+    // Nothing may escape, or pending_ would never drop back to zero.
+  }
+
+  {
+    const std::lock_guard<std::mutex> lock(lock_);
+    entries_[key] = result;
+    pending_ -= 1;
+  }
+  compiled_cv_.notify_all();
+}
+
+}  // namespace el::engine
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/engine/device.h"
+#include "src/engine/shader.h"
+#include "src/engine/vk.h"
+#include "src/job_system.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+struct RasterState {
+  VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+  VkPolygonMode polygon_mode = VK_POLYGON_MODE_FILL;
+  VkCullModeFlags cull_mode = VK_CULL_MODE_BACK_BIT;
+  VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+};
+
+struct DepthState {
+  VkBool32 test_enable = VK_TRUE;
+  VkBool32 write_enable = VK_TRUE;
+  VkCompareOp compare_op = VK_COMPARE_OP_LESS_OR_EQUAL;
+};
+
+// Everything which goes into a pipeline. A state with a single compute
+// shader describes a compute pipeline and ignores the graphics fields.
+//
+// The shaders, layout and render pass must outlive any pipeline built from
+// the state.
+struct PipelineState {
+  std::vector<const Shader*> shaders;
+  std::vector<VkVertexInputBindingDescription> vertex_bindings;
+  std::vector<VkVertexInputAttributeDescription> vertex_attributes;
+  // One entry per color format. Missing entries are opaque, non-blended.
+  std::vector<VkPipelineColorBlendAttachmentState> blend_attachments;
+  std::vector<VkFormat> color_formats;
+  VkPipelineLayout layout = VK_NULL_HANDLE;
+  VkRenderPass render_pass = VK_NULL_HANDLE;
+  RasterState raster;
+  DepthState depth;
+  VkFormat depth_format = VK_FORMAT_UNDEFINED;
+  uint32_t subpass = 0;
+  EL_PAD(4);
+
+  [[nodiscard]] auto hash() const -> uint64_t;
+  [[nodiscard]] auto is_compute() const -> bool;
+};
+
+enum class PipelineStatus {
+  kReady,
+  kPending,
+  kFailed,
+};
+
+struct PipelineLookup {
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  PipelineStatus status = PipelineStatus::kPending;
+  EL_PAD(4);
+};
+
+// Contents of the pipeline cache file at |path|, empty when it is missing.
+// Lets startup read the cache while the device is still being created.
+auto read_pipeline_cache(std::string_view path) -> std::vector<char>;
+
+class PipelineRegistryConfig {
+ public:
+  PipelineRegistryConfig(Device* device, JobSystem* jobs)
+      : device_(device), jobs_(jobs) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
+    assert(device);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
+    assert(jobs);
+  }
+
+  // File used to seed the VkPipelineCache on startup and to persist it on
+  // shutdown. Empty disables persistence.
+  auto set_cache_path(std::string_view path) -> PipelineRegistryConfig& {
+    cache_path_ = path;
+    return *this;
+  }
+
+  // Seeds the VkPipelineCache with |data| from read_pipeline_cache() instead
+  // of reading the cache path. The cache is still saved to the path.
+  auto set_initial_cache(std::vector<char> data) -> PipelineRegistryConfig& {
+    initial_cache_ = std::move(data);
+    return *this;
+  }
+
+  [[nodiscard]] auto device() const -> Device* { return device_; }
+  [[nodiscard]] auto jobs() const -> JobSystem* { return jobs_; }
+  [[nodiscard]] auto cache_path() const -> std::string_view {
+    return cache_path_;
+  }
+  [[nodiscard]] auto initial_cache() const
+      -> const std::optional<std::vector<char>>& {
+    return initial_cache_;
+  }
+
+ private:
+  Device* device_ = nullptr;
+  JobSystem* jobs_ = nullptr;
+  std::string cache_path_;
+  std::optional<std::vector<char>> initial_cache_;
+};
+
+// De-duplicates pipelines by a hash of their full PipelineState.
+//
+// Lookups never block the frame: a miss schedules the compile on the job
+// system and returns the caller provided fallback, or VK_NULL_HANDLE, with a
+// kPending status until the pipeline is built. Known states can be compiled
+// at load time through prewarm() so they never hitch on first use.
+class PipelineRegistry {
+ public:
+  explicit PipelineRegistry(const PipelineRegistryConfig& config);
+  PipelineRegistry(const PipelineRegistry&) = delete;
+  PipelineRegistry(PipelineRegistry&&) = delete;
+  ~PipelineRegistry();
+
+  auto operator=(const PipelineRegistry&) -> PipelineRegistry& = delete;
+  auto operator=(PipelineRegistry&&) -> PipelineRegistry& = delete;
+
+  auto request(const PipelineState& state,
+               VkPipeline fallback = VK_NULL_HANDLE) -> PipelineLookup;
+
+  // Returns the pipeline for |state|, compiling it on the calling thread or
+  // waiting for an in-flight compile. Throws if compilation failed.
+  auto get_blocking(const PipelineState& state) -> VkPipeline;
+
+  auto prewarm(std::span<const PipelineState> states) -> void;
+
+  // Blocks until every scheduled compile has finished.
+  auto wait_idle() -> void;
+
+  // Writes the cache next to its path and renames it into place, so an
+  // interrupted save never leaves a truncated cache behind. Throws when the
+  // write fails.
+  auto save_cache() const -> void;
+
+  [[nodiscard]] auto pipeline_cache() const -> VkPipelineCache {
+    return cache_;
+  }
+
+ private:
+  struct Entry {
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    PipelineStatus status = PipelineStatus::kPending;
+    EL_PAD(4);
+  };
+
+  // Inserts a pending entry and schedules its compile if |key| is new.
+  // Requires |lock_| to be held.
+  auto schedule_locked(uint64_t key, const PipelineState& state) -> Entry&;
+  auto compile(uint64_t key, const PipelineState& state) -> void;
+
+  Device* device_ = nullptr;
+  JobSystem* jobs_ = nullptr;
+  std::string cache_path_;
+  VkPipelineCache cache_ = VK_NULL_HANDLE;
+
+  std::unordered_map<uint64_t, Entry> entries_;
+  mutable std::mutex lock_;
+  std::condition_variable compiled_cv_;
+  size_t pending_ = 0;
+};
+
+}  // namespace el::engine
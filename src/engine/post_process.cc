@@ -0,0 +1,366 @@
+#include "src/engine/post_process.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+
+namespace el::engine {
+namespace {
+
+auto group_count(uint32_t size) -> uint32_t {
+  return (size + kPostGroupSize - 1) / kPostGroupSize;
+}
+
+}  // namespace
+
+PostProcess::PostProcess(const PostProcessConfig& config)
+    : device_(config.device()),
+      extent_(config.extent()),
+      params_{.threshold = config.bloom_threshold(),
+              .intensity = config.bloom_intensity(),
+              .exposure = config.exposure()} {
+  if (config.inputs().empty()) {
+    throw std::runtime_error("Post processing needs an input per frame slot");
+  }
+
+  const auto& indices = device_->queue_families();
+  queue_families_ = {indices.graphics_family.value()};
+  if (config.async_compute() &&
+      indices.compute_family != indices.graphics_family) {
+    queue_families_.push_back(indices.compute_family.value());
+  }
+
+  // Each level halves the previous one, down to a few texels.
+  auto size = VkExtent2D{std::max(1U, extent_.width / 2),
+                         std::max(1U, extent_.height / 2)};
+  for (uint32_t i = 0; i < std::max(1U, config.bloom_levels()); ++i) {
+    bloom_extents_.push_back(size);
+    if (size.width == 1 || size.height == 1) {
+      break;
+    }
+    size = {size.width / 2, size.height / 2};
+  }
+
+  bloom_ = create_image(kPostHdrFormat, bloom_extents_.front(),
+                        uint32_t(bloom_extents_.size()), false);
+  tonemapped_ = create_image(kPostLdrFormat, extent_, 1, false);
+  for (size_t i = 0; i < config.inputs().size(); ++i) {
+    outputs_.push_back(create_image(kPostLdrFormat, extent_, 1, true));
+  }
+
+  create_layout(config);
+  create_dispatches(config);
+}
+
+PostProcess::~PostProcess() {
+  // The pipelines belong to the registry and the set layout to the
+  // descriptor allocator.
+  destroy_image(bloom_);
+  destroy_image(tonemapped_);
+  std::for_each(std::begin(outputs_), std::end(outputs_),
+                [this](const Image& image) { destroy_image(image); });
+  device_->destroy_deferred(sampler_);
+  vkDestroyPipelineLayout(device_->device(), layout_, nullptr);
+}
+
+auto PostProcess::record(VkCommandBuffer cmd, uint32_t slot) -> void {
+  if (!initialized_) {
+    initialized_ = true;
+
+    std::vector<VkImageMemoryBarrier> barriers;
+    auto to_general = [&barriers](const Image& image, uint32_t levels) {
+      barriers.push_back({
+          .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+          .srcAccessMask = 0,
+          .dstAccessMask =
+              VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+          .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+          .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+          .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .image = image.image,
+          .subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                               .baseMipLevel = 0,
+                               .levelCount = levels,
+                               .baseArrayLayer = 0,
+                               .layerCount = 1},
+      });
+    };
+    to_general(bloom_, uint32_t(bloom_extents_.size()));
+    to_general(tonemapped_, 1);
+    std::for_each(std::begin(outputs_), std::end(outputs_),
+                  [&to_general](const Image& image) { to_general(image, 1); });
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr,
+                         0, nullptr, uint32_t(barriers.size()),
+                         barriers.data());
+  }
+
+  // Every dispatch reads what the one before wrote. The first one also
+  // waits for the last frame's chain to be done with the shared images.
+  VkMemoryBarrier barrier = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+  };
+  for (const auto& dispatch : dispatches_.at(slot)) {
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier,
+                         0, nullptr, 0, nullptr);
+
+    auto params = params_;
+    params.prefilter = dispatch.prefilter ? 1 : 0;
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, dispatch.pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout_, 0, 1,
+                            &dispatch.set, 0, nullptr);
+    vkCmdPushConstants(cmd, layout_, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       sizeof(params), &params);
+    vkCmdDispatch(cmd, group_count(dispatch.extent.width),
+                  group_count(dispatch.extent.height), 1);
+  }
+}
+
+auto PostProcess::create_image(VkFormat format,
+                               VkExtent2D extent,
+                               uint32_t levels,
+                               bool output) -> Image {
+  // Outputs are also viewed as sRGB, which can't be a storage format.
+  VkImageCreateFlags flags = 0;
+  VkImageUsageFlags usage =
+      VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  if (output) {
+    flags = VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT |
+            VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+    usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  }
+
+  VkImageCreateInfo image_info = {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+      .flags = flags,
+      .imageType = VK_IMAGE_TYPE_2D,
+      .format = format,
+      .extent = {extent.width, extent.height, 1},
+      .mipLevels = levels,
+      .arrayLayers = 1,
+      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .tiling = VK_IMAGE_TILING_OPTIMAL,
+      .usage = usage,
+      .sharingMode = queue_families_.size() > 1 ? VK_SHARING_MODE_CONCURRENT
+                                                : VK_SHARING_MODE_EXCLUSIVE,
+      .queueFamilyIndexCount = uint32_t(queue_families_.size()),
+      .pQueueFamilyIndices = queue_families_.data(),
+      .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+  };
+  Image image;
+  check(vkCreateImage(device_->device(), &image_info, nullptr, &image.image),
+        "create post processing image");
+
+  VkMemoryRequirements reqs = {};
+  vkGetImageMemoryRequirements(device_->device(), image.image, &reqs);
+  auto type = device_->find_memory_type(reqs.memoryTypeBits,
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  if (!type.has_value()) {
+    vkDestroyImage(device_->device(), image.image, nullptr);
+    throw std::runtime_error("Failed to find post processing memory type");
+  }
+  VkMemoryAllocateInfo alloc_info = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+      .allocationSize = reqs.size,
+      .memoryTypeIndex = type.value(),
+  };
+  auto res = device_->allocate_memory(alloc_info, &image.memory);
+  if (res != VK_SUCCESS) {
+    vkDestroyImage(device_->device(), image.image, nullptr);
+    throw std::runtime_error(
+        std::string("Failed to allocate post processing memory: ")
+            .append(to_string(res)));
+  }
+  res = vkBindImageMemory(device_->device(), image.image, image.memory, 0);
+  if (res != VK_SUCCESS) {
+    vkDestroyImage(device_->device(), image.image, nullptr);
+    device_->free_memory(image.memory);
+  }
+  check(res, "bind post processing memory");
+
+  // Views inherit the image's usage unless |usage_info| narrows it.
+  auto add_view = [this, &image](VkFormat view_format, uint32_t level,
+                                 const void* usage_info) {
+    VkImageViewCreateInfo view_info = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .pNext = usage_info,
+        .image = image.image,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = view_format,
+        .subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                             .baseMipLevel = level,
+                             .levelCount = 1,
+                             .baseArrayLayer = 0,
+                             .layerCount = 1},
+    };
+    VkImageView view = VK_NULL_HANDLE;
+    check(vkCreateImageView(device_->device(), &view_info, nullptr, &view),
+          "create post processing view");
+    image.views.push_back(view);
+  };
+  for (uint32_t i = 0; i < levels; ++i) {
+    add_view(format, i, nullptr);
+  }
+  if (output) {
+    // Only the UNORM views are written as storage images.
+    VkImageViewUsageCreateInfo srgb_usage = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO,
+        .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+    };
+    add_view(kPostOutputFormat, 0, &srgb_usage);
+  }
+  return image;
+}
+
+auto PostProcess::destroy_image(const Image& image) -> void {
+  std::for_each(
+      std::begin(image.views), std::end(image.views),
+      [device = device_](VkImageView view) { device->destroy_deferred(view); });
+  device_->destroy_deferred(image.image);
+  device_->destroy_deferred(image.memory);
+}
+
+auto PostProcess::create_layout(const PostProcessConfig& config) -> void {
+  VkSamplerCreateInfo sampler_info = {
+      .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+      .magFilter = VK_FILTER_LINEAR,
+      .minFilter = VK_FILTER_LINEAR,
+      .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+      .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .maxLod = 0,
+  };
+  check(vkCreateSampler(device_->device(), &sampler_info, nullptr, &sampler_),
+        "create post processing sampler");
+
+  // Every pass reads binding 0 and writes binding 1. Only the tonemap reads
+  // binding 2, the others leave their input there.
+  std::array<VkDescriptorSetLayoutBinding, 3> bindings = {
+      VkDescriptorSetLayoutBinding{
+          .binding = 0,
+          .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+          .descriptorCount = 1,
+          .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+      },
+      VkDescriptorSetLayoutBinding{
+          .binding = 1,
+          .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+          .descriptorCount = 1,
+          .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+      },
+      VkDescriptorSetLayoutBinding{
+          .binding = 2,
+          .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+          .descriptorCount = 1,
+          .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+      },
+  };
+  set_layout_ = config.descriptors()->layout(bindings);
+
+  VkPushConstantRange push_range = {
+      .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+      .offset = 0,
+      .size = sizeof(PostParams),
+  };
+  VkPipelineLayoutCreateInfo layout_info = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .setLayoutCount = 1,
+      .pSetLayouts = &set_layout_,
+      .pushConstantRangeCount = 1,
+      .pPushConstantRanges = &push_range,
+  };
+  check(vkCreatePipelineLayout(device_->device(), &layout_info, nullptr,
+                               &layout_),
+        "create post processing pipeline layout");
+}
+
+auto PostProcess::create_dispatches(const PostProcessConfig& config) -> void {
+  auto pipeline = [this, &config](const Shader* shader) {
+    PipelineState state;
+    state.shaders = {shader};
+    state.layout = layout_;
+    return config.pipelines()->get_blocking(state);
+  };
+  const auto& shaders = config.shaders();
+  auto bloom_down = pipeline(shaders.bloom_down);
+  auto bloom_up = pipeline(shaders.bloom_up);
+  auto tonemap = pipeline(shaders.tonemap);
+  auto fxaa = pipeline(shaders.fxaa);
+
+  auto set = [this, &config](VkImageView src, VkImageLayout src_layout,
+                             VkImageView dst, VkImageView extra,
+                             VkImageLayout extra_layout) {
+    std::array<DescriptorWrite, 3> writes = {
+        DescriptorWrite{
+            .image = {sampler_, src, src_layout},
+            .binding = 0,
+            .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        },
+        DescriptorWrite{
+            .image = {VK_NULL_HANDLE, dst, VK_IMAGE_LAYOUT_GENERAL},
+            .binding = 1,
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+        },
+        DescriptorWrite{
+            .image = {sampler_, extra, extra_layout},
+            .binding = 2,
+            .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        },
+    };
+    return config.descriptors()->allocate_immutable(set_layout_, writes);
+  };
+
+  const auto general = VK_IMAGE_LAYOUT_GENERAL;
+  const auto& bloom = bloom_.views;
+  auto levels = bloom_extents_.size();
+  const auto& ldr = tonemapped_.views[0];
+  auto input_layout = config.input_layout();
+  for (size_t slot = 0; slot < outputs_.size(); ++slot) {
+    auto input = config.inputs()[slot];
+    std::vector<Dispatch> dispatches;
+
+    // Down the chain, the first level straight from the scene.
+    dispatches.push_back({
+        .pipeline = bloom_down,
+        .set = set(input, input_layout, bloom[0], input, input_layout),
+        .extent = bloom_extents_[0],
+        .prefilter = true,
+    });
+    for (size_t i = 1; i < levels; ++i) {
+      dispatches.push_back({
+          .pipeline = bloom_down,
+          .set = set(bloom[i - 1], general, bloom[i], input, input_layout),
+          .extent = bloom_extents_[i],
+      });
+    }
+
+    // And back up, accumulating into each finer level.
+    for (auto i = levels - 1; i > 0; --i) {
+      dispatches.push_back({
+          .pipeline = bloom_up,
+          .set = set(bloom[i], general, bloom[i - 1], input, input_layout),
+          .extent = bloom_extents_[i - 1],
+      });
+    }
+
+    dispatches.push_back({
+        .pipeline = tonemap,
+        .set = set(input, input_layout, ldr, bloom[0], general),
+        .extent = extent_,
+    });
+    dispatches.push_back({
+        .pipeline = fxaa,
+        .set = set(ldr, general, outputs_[slot].views[0], ldr, general),
+        .extent = extent_,
+    });
+    dispatches_.push_back(std::move(dispatches));
+  }
+}
+
+}  // namespace el::engine
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "src/engine/descriptor_allocator.h"
+#include "src/engine/device.h"
+#include "src/engine/pipeline_registry.h"
+#include "src/engine/shader.h"
+#include "src/engine/vk.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+// Matches local_size_x and local_size_y of the post processing shaders.
+constexpr uint32_t kPostGroupSize = 8;
+constexpr uint32_t kDefaultBloomLevels = 6;
+constexpr float kDefaultBloomThreshold = 1.0F;
+constexpr float kDefaultBloomIntensity = 0.05F;
+// The bloom chain.
+constexpr VkFormat kPostHdrFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+// Tonemapped images. They hold display encoded values, sample them through
+// an sRGB view.
+constexpr VkFormat kPostLdrFormat = VK_FORMAT_R8G8B8A8_UNORM;
+constexpr VkFormat kPostOutputFormat = VK_FORMAT_R8G8B8A8_SRGB;
+
+// Push constants of the post processing shaders.
+struct PostParams {
+  float threshold = 0;
+  float intensity = 0;
+  float exposure = 0;
+  // Whether the dispatch applies the bloom bright pass.
+  uint32_t prefilter = 0;
+};
+
+// Compute shaders built from src/shaders.
+struct PostProcessShaders {
+  // bloom_down.comp
+  const Shader* bloom_down = nullptr;
+  // bloom_up.comp
+  const Shader* bloom_up = nullptr;
+  // tonemap.comp
+  const Shader* tonemap = nullptr;
+  // fxaa.comp
+  const Shader* fxaa = nullptr;
+};
+
+class PostProcessConfig {
+ public:
+  PostProcessConfig(Device* device,
+                    DescriptorAllocator* descriptors,
+                    PipelineRegistry* pipelines,
+                    const PostProcessShaders& shaders)
+      : device_(device),
+        descriptors_(descriptors),
+        pipelines_(pipelines),
+        shaders_(shaders) {}
+
+  auto set_extent(VkExtent2D extent) -> PostProcessConfig& {
+    extent_ = extent;
+    return *this;
+  }
+
+  // HDR scene color, one view per frame slot so the scene of the next frame
+  // can be rendered while this one is post processed.
+  auto set_inputs(std::vector<VkImageView> inputs) -> PostProcessConfig& {
+    inputs_ = std::move(inputs);
+    return *this;
+  }
+
+  // Layout the inputs are in when record() runs.
+  auto set_input_layout(VkImageLayout layout) -> PostProcessConfig& {
+    input_layout_ = layout;
+    return *this;
+  }
+
+  // Number of bloom levels, the first at half the extent.
+  auto set_bloom_levels(uint32_t levels) -> PostProcessConfig& {
+    bloom_levels_ = levels;
+    return *this;
+  }
+
+  // Scene brightness above which texels bloom.
+  auto set_bloom_threshold(float threshold) -> PostProcessConfig& {
+    bloom_threshold_ = threshold;
+    return *this;
+  }
+
+  auto set_bloom_intensity(float intensity) -> PostProcessConfig& {
+    bloom_intensity_ = intensity;
+    return *this;
+  }
+
+  auto set_exposure(float exposure) -> PostProcessConfig& {
+    exposure_ = exposure;
+    return *this;
+  }
+
+  // Shares the images between the graphics and compute families so the
+  // chain can be recorded on the compute queue. The inputs have to be
+  // shared the same way.
+  auto set_async_compute() -> PostProcessConfig& {
+    async_compute_ = true;
+    return *this;
+  }
+
+  [[nodiscard]] auto device() const -> Device* { return device_; }
+  [[nodiscard]] auto descriptors() const -> DescriptorAllocator* {
+    return descriptors_;
+  }
+  [[nodiscard]] auto pipelines() const -> PipelineRegistry* {
+    return pipelines_;
+  }
+  [[nodiscard]] auto shaders() const -> const PostProcessShaders& {
+    return shaders_;
+  }
+  [[nodiscard]] auto extent() const -> VkExtent2D { return extent_; }
+  [[nodiscard]] auto inputs() const -> const std::vector<VkImageView>& {
+    return inputs_;
+  }
+  [[nodiscard]] auto input_layout() const -> VkImageLayout {
+    return input_layout_;
+  }
+  [[nodiscard]] auto bloom_levels() const -> uint32_t { return bloom_levels_; }
+  [[nodiscard]] auto bloom_threshold() const -> float {
+    return bloom_threshold_;
+  }
+  [[nodiscard]] auto bloom_intensity() const -> float {
+    return bloom_intensity_;
+  }
+  [[nodiscard]] auto exposure() const -> float { return exposure_; }
+  [[nodiscard]] auto async_compute() const -> bool { return async_compute_; }
+
+ private:
+  Device* device_ = nullptr;
+  DescriptorAllocator* descriptors_ = nullptr;
+  PipelineRegistry* pipelines_ = nullptr;
+  PostProcessShaders shaders_;
+  std::vector<VkImageView> inputs_;
+  VkExtent2D extent_ = {};
+  VkImageLayout input_layout_ = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  uint32_t bloom_levels_ = kDefaultBloomLevels;
+  float bloom_threshold_ = kDefaultBloomThreshold;
+  float bloom_intensity_ = kDefaultBloomIntensity;
+  float exposure_ = 1.0F;
+  bool async_compute_ = false;
+  EL_PAD(3);
+};
+
+// Bloom, tonemapping and FXAA as a chain of compute dispatches writing
+// storage images, in place of fullscreen fragment passes.
+//
+// record() may go on the graphics queue after the scene, or on the compute
+// queue when configured with set_async_compute(). Then the caller waits on
+// the scene's semaphore in the compute submission and signals one the
+// frame's composite or present waits on, so the chain overlaps with the
+// next frame's geometry on the graphics queue. Each frame slot has its own
+// input and output; the images in between are only touched by record().
+//
+// The output is left in VK_IMAGE_LAYOUT_GENERAL and holds display encoded
+// values. Sample output_view(), an sRGB view, when compositing into the
+// swapchain.
+class PostProcess {
+ public:
+  explicit PostProcess(const PostProcessConfig& config);
+  PostProcess(const PostProcess&) = delete;
+  PostProcess(PostProcess&&) = delete;
+  ~PostProcess();
+
+  auto operator=(const PostProcess&) -> PostProcess& = delete;
+  auto operator=(PostProcess&&) -> PostProcess& = delete;
+
+  // Records the chain for frame |slot|. The output is ready at
+  // VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT afterwards.
+  auto record(VkCommandBuffer cmd, uint32_t slot) -> void;
+
+  auto set_exposure(float exposure) -> void { params_.exposure = exposure; }
+
+  [[nodiscard]] auto output(uint32_t slot) const -> VkImage {
+    return outputs_.at(slot).image;
+  }
+  [[nodiscard]] auto output_view(uint32_t slot) const -> VkImageView {
+    return outputs_.at(slot).views.back();
+  }
+  [[nodiscard]] auto extent() const -> VkExtent2D { return extent_; }
+
+ private:
+  struct Image {
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    // One per mip level, then for outputs the sRGB view.
+    std::vector<VkImageView> views;
+  };
+
+  struct Dispatch {
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    VkExtent2D extent = {};
+    bool prefilter = false;
+    EL_PAD(7);
+  };
+
+  auto create_image(VkFormat format,
+                    VkExtent2D extent,
+                    uint32_t levels,
+                    bool output) -> Image;
+  auto destroy_image(const Image& image) -> void;
+  auto create_layout(const PostProcessConfig& config) -> void;
+  auto create_dispatches(const PostProcessConfig& config) -> void;
+
+  Device* device_ = nullptr;
+  VkExtent2D extent_ = {};
+  PostParams params_;
+  std::vector<uint32_t> queue_families_;
+
+  VkSampler sampler_ = VK_NULL_HANDLE;
+  VkDescriptorSetLayout set_layout_ = VK_NULL_HANDLE;
+  VkPipelineLayout layout_ = VK_NULL_HANDLE;
+
+  Image bloom_;
+  std::vector<VkExtent2D> bloom_extents_;
+  Image tonemapped_;
+  std::vector<Image> outputs_;
+  // Per frame slot, in recording order.
+  std::vector<std::vector<Dispatch>> dispatches_;
+
+  // The images start out undefined and are moved to
+  // VK_IMAGE_LAYOUT_GENERAL by the first record().
+  bool initialized_ = false;
+  EL_PAD(7);
+};
+
+}  // namespace el::engine
@@ -0,0 +1,193 @@
+#include "src/engine/readback.h"
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace el::engine {
+namespace {
+
+// Reads from uncached memory are very slow, so cached memory is preferred
+// wherever the device has it.
+constexpr VkMemoryPropertyFlags kCachedMemory =
+    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
+    VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+constexpr VkMemoryPropertyFlags kCoherentMemory =
+    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+constexpr VkImageSubresourceRange kColorRange = {
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .baseMipLevel = 0,
+    .levelCount = 1,
+    .baseArrayLayer = 0,
+    .layerCount = 1,
+};
+
+auto image_size(VkFormat format, VkExtent2D extent) -> VkDeviceSize {
+  return VkDeviceSize{extent.width} * extent.height * texel_size(format);
+}
+
+}  // namespace
+
+auto texel_size(VkFormat format) -> uint32_t {
+  switch (format) {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+    case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+    case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+    case VK_FORMAT_R32_SFLOAT:
+      return 4;
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+      return 8;
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+      return 16;
+    default:
+      return 0;
+  }
+}
+
+ReadbackService::ReadbackService(const ReadbackServiceConfig& config)
+    : device_(config.device()),
+      callback_(config.callback()),
+      slots_(config.slots()) {
+  if (slots_.empty()) {
+    throw std::runtime_error("Readbacks need at least one slot");
+  }
+
+  // Buffers accept every host visible memory type on the drivers we know
+  // of, so probing with all type bits picks what the buffers will get.
+  memory_properties_ =
+      device_->find_memory_type(std::numeric_limits<uint32_t>::max(),
+                                kCachedMemory)
+              .has_value()
+          ? kCachedMemory
+          : kCoherentMemory;
+}
+
+// Slot buffers defer their own destruction past any copies in flight.
+ReadbackService::~ReadbackService() = default;
+
+auto ReadbackService::record(VkCommandBuffer cmd,
+                             VkImage image,
+                             VkImageLayout layout,
+                             VkFormat format,
+                             VkExtent2D extent) -> bool {
+  if (texel_size(format) == 0) {
+    throw std::runtime_error(
+        std::string("Unsupported readback format: ")
+            .append(std::to_string(static_cast<int>(format))));
+  }
+  if (pending_ == slots_.size()) {
+    dropped_ += 1;
+    return false;
+  }
+
+  auto& slot = slots_[(head_ + pending_) % slots_.size()];
+  auto size = image_size(format, extent);
+  if (!slot.buffer || slot.buffer->size() < size) {
+    slot.buffer = std::make_unique<Buffer>(
+        BufferConfig(device_)
+            .set_size(size)
+            .set_usage(VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+            .set_memory_properties(memory_properties_));
+  }
+  slot.frame = device_->frame();
+  slot.format = format;
+  slot.extent = extent;
+  pending_ += 1;
+
+  VkImageMemoryBarrier to_transfer = {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+      .oldLayout = layout,
+      .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = image,
+      .subresourceRange = kColorRange,
+  };
+  vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &to_transfer);
+
+  VkBufferImageCopy region = {
+      .bufferOffset = 0,
+      .bufferRowLength = 0,
+      .bufferImageHeight = 0,
+      .imageSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                           .mipLevel = 0,
+                           .baseArrayLayer = 0,
+                           .layerCount = 1},
+      .imageOffset = {0, 0, 0},
+      .imageExtent = {extent.width, extent.height, 1},
+  };
+  vkCmdCopyImageToBuffer(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         slot.buffer->buffer(), 1, &region);
+
+  VkImageMemoryBarrier restore = {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+      .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+      .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      .newLayout = layout,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = image,
+      .subresourceRange = kColorRange,
+  };
+  VkBufferMemoryBarrier to_host = {
+      .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .buffer = slot.buffer->buffer(),
+      .offset = 0,
+      .size = size,
+  };
+  vkCmdPipelineBarrier(
+      cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 0,
+      nullptr, 1, &to_host, 1, &restore);
+  return true;
+}
+
+auto ReadbackService::poll() -> void {
+  if (pending_ > 0) {
+    deliver(device_->completed_frame());
+  }
+}
+
+auto ReadbackService::flush() -> void {
+  if (pending_ == 0) {
+    return;
+  }
+  vkQueueWaitIdle(device_->graphics_queue());
+  deliver(std::numeric_limits<uint64_t>::max());
+}
+
+auto ReadbackService::deliver(uint64_t completed) -> void {
+  while (pending_ > 0) {
+    auto& slot = slots_[head_];
+    if (slot.frame > completed) {
+      return;
+    }
+
+    if (callback_) {
+      callback_({
+          .frame = slot.frame,
+          .format = slot.format,
+          .extent = slot.extent,
+          .data = slot.buffer->mapped().first(
+              image_size(slot.format, slot.extent)),
+      });
+    }
+    head_ = (head_ + 1) % uint32_t(slots_.size());
+    pending_ -= 1;
+  }
+}
+
+}  // namespace el::engine
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "src/engine/buffer.h"
+#include "src/engine/device.h"
+#include "src/engine/vk.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+// Enough slots for every frame in flight plus the one being recorded, so a
+// readback per frame never finds the ring full.
+constexpr uint32_t kDefaultReadbackSlots = kMaxFramesInFlight + 1;
+
+// A finished readback. |data| holds tightly packed texels and is only valid
+// during the callback.
+struct ReadbackImage {
+  // Device frame the copy was recorded in.
+  uint64_t frame = 0;
+  VkFormat format = VK_FORMAT_UNDEFINED;
+  VkExtent2D extent = {};
+  EL_PAD(4);
+  std::span<const std::byte> data;
+};
+
+using ReadbackCallback = std::function<void(const ReadbackImage&)>;
+
+// Size of one texel of |format|, or 0 when readbacks don't support it.
+auto texel_size(VkFormat format) -> uint32_t;
+
+class ReadbackServiceConfig {
+ public:
+  explicit ReadbackServiceConfig(Device* device) : device_(device) {}
+
+  auto set_slots(uint32_t slots) -> ReadbackServiceConfig& {
+    slots_ = slots;
+    return *this;
+  }
+
+  // Called from poll() and flush() for every finished readback, in the
+  // order they were recorded.
+  auto set_callback(ReadbackCallback cb) -> ReadbackServiceConfig& {
+    callback_ = std::move(cb);
+    return *this;
+  }
+
+  [[nodiscard]] auto device() const -> Device* { return device_; }
+  [[nodiscard]] auto slots() const -> uint32_t { return slots_; }
+  [[nodiscard]] auto callback() const -> const ReadbackCallback& {
+    return callback_;
+  }
+
+ private:
+  Device* device_ = nullptr;
+  ReadbackCallback callback_;
+  uint32_t slots_ = kDefaultReadbackSlots;
+  EL_PAD(4);
+};
+
+// Copies images into a ring of persistently mapped host visible buffers and
+// hands them back once the GPU has finished the frame which recorded the
+// copy, a few frames later, so reading back never waits on the GPU.
+//
+// When every slot is still in flight the readback is dropped rather than
+// stalling the frame; add slots if that shows up in dropped(). Not thread
+// safe.
+class ReadbackService {
+ public:
+  explicit ReadbackService(const ReadbackServiceConfig& config);
+  ReadbackService(const ReadbackService&) = delete;
+  ReadbackService(ReadbackService&&) = delete;
+  ~ReadbackService();
+
+  auto operator=(const ReadbackService&) -> ReadbackService& = delete;
+  auto operator=(ReadbackService&&) -> ReadbackService& = delete;
+
+  // Records a copy of the first mip and layer of |image| into |cmd|. The
+  // image is in |layout|, with the writes of earlier commands pending, and is
+  // returned to it afterwards. It needs VK_IMAGE_USAGE_TRANSFER_SRC_BIT.
+  // Returns false when the readback was dropped.
+  auto record(VkCommandBuffer cmd,
+              VkImage image,
+              VkImageLayout layout,
+              VkFormat format,
+              VkExtent2D extent) -> bool;
+
+  // Delivers every readback whose frame the GPU has finished.
+  auto poll() -> void;
+
+  // Waits for the graphics queue to go idle and delivers everything still
+  // pending. For the end of headless runs, not for use every frame.
+  auto flush() -> void;
+
+  [[nodiscard]] auto pending() const -> uint32_t { return pending_; }
+  [[nodiscard]] auto dropped() const -> uint64_t { return dropped_; }
+
+ private:
+  struct Slot {
+    std::unique_ptr<Buffer> buffer;
+    uint64_t frame = 0;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent = {};
+    EL_PAD(4);
+  };
+
+  auto deliver(uint64_t completed) -> void;
+
+  Device* device_ = nullptr;
+  ReadbackCallback callback_;
+  VkMemoryPropertyFlags memory_properties_ = 0;
+  // The oldest pending slot is at |head_|, pending slots follow it.
+  uint32_t head_ = 0;
+  uint32_t pending_ = 0;
+  EL_PAD(4);
+  uint64_t dropped_ = 0;
+  std::vector<Slot> slots_;
+};
+
+}  // namespace el::engine
@@ -0,0 +1,121 @@
+#include "src/engine/residency.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace el::engine {
+
+ResidencyManager::ResidencyManager(const ResidencyManagerConfig& config)
+    : device_(config.device()),
+      high_water_(config.high_water()),
+      low_water_(config.low_water()) {
+  device_->set_memory_pressure_cb(
+      [this](uint32_t /*heap*/, VkDeviceSize bytes) {
+        return make_room(bytes) > 0;
+      });
+}
+
+ResidencyManager::~ResidencyManager() {
+  device_->set_memory_pressure_cb(nullptr);
+}
+
+auto ResidencyManager::add(Evictor evictor) -> ResidencyId {
+  Entry entry = {
+      .evict = std::move(evictor),
+      .last_used = device_->frame(),
+      .live = true,
+  };
+  if (free_ids_.empty()) {
+    entries_.push_back(std::move(entry));
+    return ResidencyId(entries_.size() - 1);
+  }
+
+  auto id = free_ids_.back();
+  free_ids_.pop_back();
+  entries_[id] = std::move(entry);
+  return id;
+}
+
+auto ResidencyManager::remove(ResidencyId id) -> void {
+  entries_[id] = {};
+  free_ids_.push_back(id);
+}
+
+auto ResidencyManager::touch(ResidencyId id) -> void {
+  entries_[id].last_used = device_->frame();
+}
+
+auto ResidencyManager::update() -> void {
+  auto completed = device_->completed_frame();
+  while (!pending_.empty() && pending_.front().frame <= completed) {
+    pending_.pop_front();
+  }
+
+  auto limit = double(budget());
+  auto used = usage();
+  if (double(used) <= limit * high_water_) {
+    return;
+  }
+  make_room(used - VkDeviceSize(limit * low_water_));
+}
+
+auto ResidencyManager::can_grow(VkDeviceSize bytes) const -> bool {
+  return double(usage() + bytes) <= double(budget()) * low_water_;
+}
+
+auto ResidencyManager::make_room(VkDeviceSize bytes) -> VkDeviceSize {
+  std::vector<ResidencyId> order;
+  for (ResidencyId id = 0; id < entries_.size(); ++id) {
+    if (entries_[id].live) {
+      order.push_back(id);
+    }
+  }
+  std::stable_sort(std::begin(order), std::end(order),
+                   [this](ResidencyId a, ResidencyId b) {
+                     return entries_[a].last_used < entries_[b].last_used;
+                   });
+
+  // Least recently used first, each down to whatever it can't give up
+  // before the next one loses anything.
+  VkDeviceSize freed = 0;
+  VkDeviceSize deleted = 0;
+  for (auto id : order) {
+    while (freed < bytes) {
+      auto released = entries_[id].evict();
+      if (released.deleted == 0) {
+        break;
+      }
+      deleted += released.deleted;
+      freed += released.deleted - std::min(released.deleted,
+                                           released.allocated);
+    }
+    if (freed >= bytes) {
+      break;
+    }
+  }
+
+  // Usage counts the replacements already, and the deleted memory until
+  // the GPU is done with it.
+  if (deleted > 0) {
+    pending_.push_back({.frame = device_->frame(), .bytes = deleted});
+  }
+  evicted_bytes_ += freed;
+  return freed;
+}
+
+auto ResidencyManager::usage() const -> VkDeviceSize {
+  auto used = device_->memory_budget().device_local().usage;
+  auto completed = device_->completed_frame();
+  auto pending = std::accumulate(
+      std::begin(pending_), std::end(pending_), VkDeviceSize{0},
+      [completed](VkDeviceSize acc, const Eviction& e) {
+        return e.frame > completed ? acc + e.bytes : acc;
+      });
+  return used - std::min(used, pending);
+}
+
+auto ResidencyManager::budget() const -> VkDeviceSize {
+  return device_->memory_budget().device_local().budget;
+}
+
+}  // namespace el::engine
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "src/engine/device.h"
+#include "src/engine/vk.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+// Device local usage, as a share of the budget, above which update() starts
+// evicting, and the share it evicts down to.
+constexpr double kDefaultHighWater = 0.9;
+constexpr double kDefaultLowWater = 0.8;
+using ResidencyId = uint32_t;
+
+// What an Evictor gave up.
+struct Released {
+  // Bytes handed to the device's deletion queue.
+  VkDeviceSize deleted = 0;
+  // Bytes allocated in their place, such as a smaller image for the
+  // remaining mips. Already in use, so only the difference is freed.
+  VkDeviceSize allocated = 0;
+};
+
+// Releases part of a resource, such as its finest texture mip. Nothing is
+// deleted when there is nothing left to evict. Evictors must not add or
+// remove resources.
+using Evictor = std::function<Released()>;
+
+class ResidencyManagerConfig {
+ public:
+  explicit ResidencyManagerConfig(Device* device) : device_(device) {}
+
+  auto set_high_water(double share) -> ResidencyManagerConfig& {
+    high_water_ = share;
+    return *this;
+  }
+
+  // Streaming only grows resources while usage stays below this share.
+  auto set_low_water(double share) -> ResidencyManagerConfig& {
+    low_water_ = share;
+    return *this;
+  }
+
+  [[nodiscard]] auto device() const -> Device* { return device_; }
+  [[nodiscard]] auto high_water() const -> double { return high_water_; }
+  [[nodiscard]] auto low_water() const -> double { return low_water_; }
+
+ private:
+  Device* device_ = nullptr;
+  double high_water_ = kDefaultHighWater;
+  double low_water_ = kDefaultLowWater;
+};
+
+// Keeps device local memory within the Device's MemoryBudget by evicting
+// the least recently used streamed resources, texture mips and mesh LODs,
+// when usage approaches the budget.
+//
+// Resources are registered with an Evictor and touch()ed whenever they are
+// used. Call update() once a frame after Device::begin_frame(). The manager
+// also installs itself as the device's memory pressure callback, so an
+// allocation running out of memory evicts before failing. Not thread safe.
+class ResidencyManager {
+ public:
+  explicit ResidencyManager(const ResidencyManagerConfig& config);
+  ResidencyManager(const ResidencyManager&) = delete;
+  ResidencyManager(ResidencyManager&&) = delete;
+  ~ResidencyManager();
+
+  auto operator=(const ResidencyManager&) -> ResidencyManager& = delete;
+  auto operator=(ResidencyManager&&) -> ResidencyManager& = delete;
+
+  auto add(Evictor evictor) -> ResidencyId;
+  auto remove(ResidencyId id) -> void;
+  // Marks the resource as used this frame.
+  auto touch(ResidencyId id) -> void;
+
+  auto update() -> void;
+
+  // Whether |bytes| more can be allocated while staying under the low
+  // water mark.
+  [[nodiscard]] auto can_grow(VkDeviceSize bytes) const -> bool;
+
+  // Evicts least recently used resources until |bytes| are freed, net of
+  // what evictors allocated in their place. Returns the bytes actually
+  // freed.
+  auto make_room(VkDeviceSize bytes) -> VkDeviceSize;
+
+  // Device local usage minus what evictions still waiting in the deletion
+  // queue are about to free.
+  [[nodiscard]] auto usage() const -> VkDeviceSize;
+  [[nodiscard]] auto budget() const -> VkDeviceSize;
+  [[nodiscard]] auto evicted_bytes() const -> uint64_t {
+    return evicted_bytes_;
+  }
+
+ private:
+  struct Entry {
+    Evictor evict;
+    uint64_t last_used = 0;
+    bool live = false;
+    EL_PAD(7);
+  };
+
+  struct Eviction {
+    uint64_t frame = 0;
+    VkDeviceSize bytes = 0;
+  };
+
+  Device* device_ = nullptr;
+  double high_water_ = 0;
+  double low_water_ = 0;
+  uint64_t evicted_bytes_ = 0;
+  std::vector<Entry> entries_;
+  std::vector<ResidencyId> free_ids_;
+  // Bytes deleted by evictions, by the frame their memory was queued for
+  // deletion at, until that frame completes.
+  std::deque<Eviction> pending_;
+};
+
+}  // namespace el::engine
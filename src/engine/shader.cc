@@ -1,7 +1,10 @@
 #include "src/engine/shader.h"
 
+#include <algorithm>
 #include <cassert>
+#include <span>
 
+#include "src/engine/hash.h"
 #include "src/engine/vk.h"
 
 namespace el::engine {
@@ -20,7 +23,47 @@ auto type_to_vk(shader::Type type) -> VkShaderStageFlagBits {
 
 }  // namespace
 
-Shader::Shader(const ShaderConfig& config) : type_(config.type()) {
+auto SpecializationConstants::set_bits(uint32_t id, uint32_t bits) -> void {
+  auto it = std::lower_bound(
+      std::begin(entries_), std::end(entries_), id,
+      [](const VkSpecializationMapEntry& e, uint32_t v) {
+        return e.constantID < v;
+      });
+  auto idx = static_cast<size_t>(std::distance(std::begin(entries_), it));
+  if (it != std::end(entries_) && it->constantID == id) {
+    data_[idx] = bits;
+    return;
+  }
+
+  entries_.insert(it, {.constantID = id, .offset = 0, .size = sizeof(bits)});
+  data_.insert(std::begin(data_) + static_cast<std::ptrdiff_t>(idx), bits);
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    entries_[i].offset = uint32_t(i * sizeof(uint32_t));
+  }
+}
+
+auto SpecializationConstants::hash() const -> uint64_t {
+  uint64_t h = kFnvOffsetBasis;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    h = hash_combine(h, entries_[i].constantID);
+    h = hash_combine(h, data_[i]);
+  }
+  return h;
+}
+
+auto SpecializationConstants::info() const -> VkSpecializationInfo {
+  return {
+      .mapEntryCount = uint32_t(entries_.size()),
+      .pMapEntries = entries_.data(),
+      .dataSize = data_.size() * sizeof(uint32_t),
+      .pData = data_.data(),
+  };
+}
+
+Shader::Shader(const ShaderConfig& config)
+    : device_(config.device()),
+      entrypoint_name_(config.entrypoint_name()),
+      type_(config.type()) {
   VkShaderModuleCreateInfo create_info = {
       .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
       .codeSize =
@@ -39,8 +82,63 @@ Shader::Shader(const ShaderConfig& config) : type_(config.type()) {
       .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
       .stage = type_to_vk(config.type()),
       .module = module_,
-      .pName = config.entrypoint_name().data(),
+      .pName = entrypoint_name_.c_str(),
   };
+
+  module_hash_ = hash_span(std::span(config.data()));
+  module_hash_ = hash_combine(module_hash_, static_cast<uint64_t>(type_));
+  module_hash_ = hash_combine(module_hash_, hash_span<char>(entrypoint_name_));
+  set_constants(config.constants());
+}
+
+Shader::Shader(const Shader& base, const SpecializationConstants& constants)
+    : device_(base.device_),
+      module_(base.module_),
+      stage_info_(base.stage_info_),
+      entrypoint_name_(base.entrypoint_name_),
+      module_hash_(base.module_hash_),
+      type_(base.type_),
+      owns_module_(false) {
+  stage_info_.pName = entrypoint_name_.c_str();
+  set_constants(constants);
+}
+
+Shader::~Shader() {
+  if (owns_module_) {
+    vkDestroyShaderModule(device_->device(), module_, nullptr);
+  }
+}
+
+auto Shader::set_constants(const SpecializationConstants& constants) -> void {
+  constants_ = constants;
+  specialization_info_ = constants_.info();
+  stage_info_.pSpecializationInfo =
+      constants_.empty() ? nullptr : &specialization_info_;
+
+  hash_ = module_hash_;
+  if (!constants_.empty()) {
+    hash_ = hash_combine(hash_, constants_.hash());
+  }
+}
+
+auto ShaderVariantCache::get(const Shader& base,
+                             const SpecializationConstants& constants)
+    -> const Shader& {
+  if (constants.empty()) {
+    return base;
+  }
+
+  auto key = hash_combine(base.module_hash(), constants.hash());
+
+  const std::lock_guard<std::mutex> lock(lock_);
+  auto it = variants_.find(key);
+  if (it == variants_.end()) {
+    it = variants_
+             .insert(std::make_pair(
+                 key, std::make_unique<Shader>(base, constants)))
+             .first;
+  }
+  return *it->second;
 }
 
 }  // namespace el::engine
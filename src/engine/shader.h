@@ -1,8 +1,14 @@
 #pragma once
 
+#include <bit>
 #include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "src/engine/device.h"
@@ -17,8 +23,48 @@ enum class Type {
   kCompute,
 };
 
+// Types which map directly onto 32-bit SPIR-V specialization constants.
+template <typename T>
+concept SpecializationType =
+    std::same_as<T, bool> || std::same_as<T, int32_t> ||
+    std::same_as<T, uint32_t> || std::same_as<T, float>;
+
 }  // namespace shader
 
+// Values for the `layout(constant_id = N)` constants of a shader. Constants
+// are baked in at pipeline creation so the driver can fold branches and
+// unroll loops instead of paying for uniform branches at runtime.
+class SpecializationConstants {
+ public:
+  template <shader::SpecializationType T>
+  auto set(uint32_t id, T value) -> SpecializationConstants& {
+    uint32_t bits = 0;
+    if constexpr (std::same_as<T, bool>) {
+      bits = value ? VK_TRUE : VK_FALSE;
+    } else {
+      bits = std::bit_cast<uint32_t>(value);
+    }
+    set_bits(id, bits);
+    return *this;
+  }
+
+  [[nodiscard]] auto empty() const -> bool { return entries_.empty(); }
+
+  // Hash of the constant ids and values, independent of insertion order.
+  [[nodiscard]] auto hash() const -> uint64_t;
+
+  // The returned info points into this object.
+  [[nodiscard]] auto info() const -> VkSpecializationInfo;
+
+ private:
+  auto set_bits(uint32_t id, uint32_t bits) -> void;
+
+  // Kept sorted by constantID. Every constant is 4 bytes wide so entry i
+  // lives at data_[i].
+  std::vector<VkSpecializationMapEntry> entries_;
+  std::vector<uint32_t> data_;
+};
+
 class ShaderConfig {
  public:
   explicit ShaderConfig(Device* device) : device_(device) {
@@ -36,11 +82,17 @@ class ShaderConfig {
     return *this;
   }
 
-  auto set_entrypoint_name(std::string_view name) {
+  auto set_entrypoint_name(std::string_view name) -> ShaderConfig& {
     entrypoint_name_ = name;
     return *this;
   }
 
+  auto set_constants(const SpecializationConstants& constants)
+      -> ShaderConfig& {
+    constants_ = constants;
+    return *this;
+  }
+
   [[nodiscard]] auto device() const -> Device* { return device_; }
 
   [[nodiscard]] auto data() const -> const std::vector<uint32_t>& {
@@ -53,10 +105,15 @@ class ShaderConfig {
     return entrypoint_name_;
   }
 
+  [[nodiscard]] auto constants() const -> const SpecializationConstants& {
+    return constants_;
+  }
+
  private:
   Device* device_ = nullptr;
   std::string entrypoint_name_ = "main";
   std::vector<uint32_t> data_;
+  SpecializationConstants constants_;
   shader::Type type_ = shader::Type::kVertex;
   EL_PAD(4);
 };
@@ -64,6 +121,9 @@ class ShaderConfig {
 class Shader {
  public:
   explicit Shader(const ShaderConfig& config);
+  // Creates a variant of |base| which shares its module but is specialized
+  // with |constants|. |base| must outlive the variant.
+  Shader(const Shader& base, const SpecializationConstants& constants);
   Shader(const Shader&) = delete;
   Shader(const Shader&&) = delete;
   ~Shader();
@@ -71,13 +131,46 @@ class Shader {
   auto operator=(const Shader&) -> Shader& = delete;
   auto operator=(const Shader&&) -> Shader& = delete;
 
-  auto create_info() -> VkPipelineShaderStageCreateInfo { return stage_info_; }
+  [[nodiscard]] auto create_info() const -> VkPipelineShaderStageCreateInfo {
+    return stage_info_;
+  }
+
+  [[nodiscard]] auto type() const -> shader::Type { return type_; }
+
+  // Hash of the SPIR-V code, stage, entrypoint and specialization constants.
+  // Stable across runs.
+  [[nodiscard]] auto hash() const -> uint64_t { return hash_; }
+
+  // Hash of the module alone, shared by every variant of a shader.
+  [[nodiscard]] auto module_hash() const -> uint64_t { return module_hash_; }
 
  private:
+  auto set_constants(const SpecializationConstants& constants) -> void;
+
+  Device* device_ = nullptr;
   VkShaderModule module_{};
   VkPipelineShaderStageCreateInfo stage_info_{};
+  VkSpecializationInfo specialization_info_{};
+  std::string entrypoint_name_;
+  SpecializationConstants constants_;
+  uint64_t module_hash_ = 0;
+  uint64_t hash_ = 0;
   shader::Type type_;
-  EL_PAD(4);
+  bool owns_module_ = true;
+  EL_PAD(3);
+};
+
+// Caches specialized variants of shaders keyed by (module hash, constant
+// values), so every material asking for the same feature set shares one
+// Shader and therefore one PipelineRegistry entry.
+class ShaderVariantCache {
+ public:
+  auto get(const Shader& base, const SpecializationConstants& constants)
+      -> const Shader&;
+
+ private:
+  std::unordered_map<uint64_t, std::unique_ptr<Shader>> variants_;
+  std::mutex lock_;
 };
 
 }  // namespace el::engine
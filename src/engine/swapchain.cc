@@ -1,6 +1,8 @@
 #include "src/engine/swapchain.h"
 
 #include <algorithm>
+#include <limits>
+#include <string>
 
 namespace el::engine {
 namespace {
@@ -72,31 +74,70 @@ auto Swapchain::query_swap_chain_support(VkPhysicalDevice device,
   return {};
 }
 
-Swapchain::Swapchain(Device* device) : device_(device) {
-  create_swapchain();
+Swapchain::Swapchain(const SwapchainConfig& config)
+    : device_(config.device()),
+      surface_(config.surface()),
+      dimensions_cb_(config.dimensions_cb()) {
+  if (surface_ == VK_NULL_HANDLE) {
+    surface_ = device_->surface();
+  }
+  if (!dimensions_cb_) {
+    dimensions_cb_ = [device = device_] { return device->dimensions(); };
+  }
+
+  const auto* old_swapchain = config.old_swapchain();
+  create_swapchain(old_swapchain != nullptr ? old_swapchain->swap_chain_
+                                            : VK_NULL_HANDLE);
   create_image_views();
 }
 
+Swapchain::Swapchain(Device* device, const Swapchain* old_swapchain)
+    : Swapchain(SwapchainConfig(device).set_old_swapchain(old_swapchain)) {}
+
 Swapchain::~Swapchain() {
-  vkDeviceWaitIdle(device_->device());
+  // Frames still in flight may reference the images, so release them once
+  // the GPU is done instead of stalling on vkDeviceWaitIdle.
+  std::for_each(
+      std::begin(image_views_), std::end(image_views_),
+      [device = device_](VkImageView view) { device->destroy_deferred(view); });
 
-  std::for_each(std::begin(image_views_), std::end(image_views_),
-                [device = device_->device()](VkImageView view) {
-                  vkDestroyImageView(device, view, nullptr);
-                });
+  device_->destroy_deferred(swap_chain_);
+}
 
-  vkDestroySwapchainKHR(device_->device(), swap_chain_, nullptr);
+auto Swapchain::acquire(VkSemaphore signal) -> std::optional<uint32_t> {
+  uint32_t index = 0;
+  auto res = vkAcquireNextImageKHR(device_->device(), swap_chain_,
+                                   std::numeric_limits<uint64_t>::max(),
+                                   signal, VK_NULL_HANDLE, &index);
+  if (res == VK_ERROR_OUT_OF_DATE_KHR) {
+    stale_ = true;
+    return {};
+  }
+  if (res == VK_SUBOPTIMAL_KHR) {
+    stale_ = true;
+  } else if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to acquire swap chain image: ")
+            .append(to_string(res)));
+  }
+  return index;
 }
 
-auto Swapchain::create_swapchain() -> void {
+auto Swapchain::create_swapchain(VkSwapchainKHR old_swapchain) -> void {
+  // The present queue was picked for the primary surface, other windows may
+  // be on a display it can't reach.
+  if (!device_->supports_present(surface_)) {
+    throw std::runtime_error("Surface not supported by the present queue");
+  }
+
   auto support = Swapchain::query_swap_chain_support(device_->physical_device(),
-                                                     device_->surface());
+                                                     surface_);
   if (!support.has_value()) {
     throw std::runtime_error(
         "Unable to retrieve swap chain support information");
   }
 
-  auto dimensions = device_->dimensions();
+  auto dimensions = dimensions_cb_();
   auto fmt = choose_swap_surface_format(support->formats);
   auto mode = choose_swap_present_mode(support->present_modes);
   auto extent = choose_swap_extent(support->capabilities, dimensions.width,
@@ -107,22 +148,29 @@ auto Swapchain::create_swapchain() -> void {
     img_count = std::min(img_count, support->capabilities.maxImageCount);
   }
 
+  // Lets the ReadbackService copy presented frames out, and dynamic
+  // resolution upscale into them. Surfaces have to support it for the image
+  // usage to be valid.
+  VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  usage |= support->capabilities.supportedUsageFlags &
+           (VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+
   VkSwapchainCreateInfoKHR create_info = {
       .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
-      .surface = device_->surface(),
+      .surface = surface_,
       .minImageCount = img_count,
       .imageFormat = fmt.format,
       .imageColorSpace = fmt.colorSpace,
       .imageExtent = extent,
       .imageArrayLayers = 1,
-      .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+      .imageUsage = usage,
       .preTransform = support->capabilities.currentTransform,
       .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
       .presentMode = mode,
       .clipped = VK_TRUE,
-      .oldSwapchain = nullptr};
+      .oldSwapchain = old_swapchain};
 
-  auto indices = device_->find_queue_families();
+  const auto& indices = device_->queue_families();
   std::array<uint32_t, 2> family_indices = {indices.graphics_family.value(),
                                             indices.present_family.value()};
   if (indices.graphics_family != indices.present_family) {
@@ -147,6 +195,7 @@ auto Swapchain::create_swapchain() -> void {
 
   image_format_ = fmt.format;
   extent_ = extent;
+  usage_ = usage;
 }
 
 auto Swapchain::create_image_views() -> void {
@@ -182,4 +231,61 @@ auto Swapchain::create_image_views() -> void {
                  std::begin(image_views_), view_creator);
 }
 
+auto PresentBatch::add(Swapchain* swapchain,
+                       uint32_t image_index,
+                       VkSemaphore wait) -> void {
+  swapchains_.push_back(swapchain);
+  handles_.push_back(swapchain->swap_chain_);
+  image_indices_.push_back(image_index);
+  // A binary semaphore is unsignaled by the first wait, a second wait on it
+  // would never finish.
+  if (wait != VK_NULL_HANDLE &&
+      std::find(std::begin(waits_), std::end(waits_), wait) == waits_.end()) {
+    waits_.push_back(wait);
+  }
+}
+
+auto PresentBatch::present() -> void {
+  if (swapchains_.empty()) {
+    return;
+  }
+
+  results_.assign(swapchains_.size(), VK_SUCCESS);
+  VkPresentInfoKHR info = {
+      .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+      .waitSemaphoreCount = uint32_t(waits_.size()),
+      .pWaitSemaphores = waits_.data(),
+      .swapchainCount = uint32_t(handles_.size()),
+      .pSwapchains = handles_.data(),
+      .pImageIndices = image_indices_.data(),
+      .pResults = results_.data(),
+  };
+  auto res = vkQueuePresentKHR(device_->present_queue(), &info);
+
+  // The overall result is the worst of the per swapchain ones.
+  std::optional<VkResult> failure;
+  for (size_t i = 0; i < swapchains_.size(); ++i) {
+    auto result = results_[i];
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+      swapchains_[i]->stale_ = true;
+    } else if (result != VK_SUCCESS && !failure.has_value()) {
+      failure = result;
+    }
+  }
+
+  swapchains_.clear();
+  handles_.clear();
+  image_indices_.clear();
+  waits_.clear();
+
+  if (!failure.has_value() && res != VK_SUCCESS &&
+      res != VK_ERROR_OUT_OF_DATE_KHR && res != VK_SUBOPTIMAL_KHR) {
+    failure = res;
+  }
+  if (failure.has_value()) {
+    throw std::runtime_error(
+        std::string("Failed to present: ").append(to_string(failure.value())));
+  }
+}
+
 }  // namespace el::engine
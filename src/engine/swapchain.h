@@ -3,12 +3,58 @@
 #include <optional>
 #include <vector>
 
+#include "src/dimensions.h"
 #include "src/engine/device.h"
 #include "src/engine/vk.h"
 #include "src/pad.h"
 
 namespace el::engine {
 
+class Swapchain;
+
+class SwapchainConfig {
+ public:
+  explicit SwapchainConfig(Device* device) : device_(device) {}
+
+  // Defaults to the device's primary surface.
+  auto set_surface(VkSurfaceKHR surface) -> SwapchainConfig& {
+    surface_ = surface;
+    return *this;
+  }
+
+  // Size of the surface's window. Defaults to the device's dimensions.
+  auto set_dimensions_cb(DimensionsCallback cb) -> SwapchainConfig& {
+    dimensions_cb_ = std::move(cb);
+    return *this;
+  }
+
+  // The old swapchain's surface resources are handed over to the new one,
+  // which must be for the same surface. The old one can then be destroyed
+  // at any time.
+  auto set_old_swapchain(const Swapchain* old_swapchain) -> SwapchainConfig& {
+    old_swapchain_ = old_swapchain;
+    return *this;
+  }
+
+  [[nodiscard]] auto device() const -> Device* { return device_; }
+  [[nodiscard]] auto surface() const -> VkSurfaceKHR { return surface_; }
+  [[nodiscard]] auto dimensions_cb() const -> DimensionsCallback {
+    return dimensions_cb_;
+  }
+  [[nodiscard]] auto old_swapchain() const -> const Swapchain* {
+    return old_swapchain_;
+  }
+
+ private:
+  Device* device_ = nullptr;
+  VkSurfaceKHR surface_ = VK_NULL_HANDLE;
+  DimensionsCallback dimensions_cb_;
+  const Swapchain* old_swapchain_ = nullptr;
+};
+
+// A swapchain for one of the device's surfaces. Any number of them can
+// share a device, one per window, and be presented together with a
+// PresentBatch.
 class Swapchain {
  public:
   struct SwapChainSupportDetails {
@@ -22,7 +68,9 @@ class Swapchain {
                                        VkSurfaceKHR surface)
       -> std::optional<SwapChainSupportDetails>;
 
-  explicit Swapchain(Device* device);
+  explicit Swapchain(const SwapchainConfig& config);
+  // A swapchain for the device's primary surface.
+  explicit Swapchain(Device* device, const Swapchain* old_swapchain = nullptr);
   Swapchain(const Swapchain&) = delete;
   Swapchain(Swapchain&&) = delete;
   ~Swapchain();
@@ -30,18 +78,77 @@ class Swapchain {
   auto operator=(const Swapchain&) -> Swapchain& = delete;
   auto operator=(Swapchain&&) -> Swapchain& = delete;
 
+  // Index of the next image, which is ready once |signal| is. Empty when the
+  // swapchain is out of date and has to be recreated.
+  auto acquire(VkSemaphore signal) -> std::optional<uint32_t>;
+
+  // Set once an acquire or present found the swapchain out of date or
+  // suboptimal for its surface. Recreate it, passing this one as the old
+  // swapchain.
+  [[nodiscard]] auto stale() const -> bool { return stale_; }
+
+  [[nodiscard]] auto handle() const -> VkSwapchainKHR { return swap_chain_; }
+  [[nodiscard]] auto surface() const -> VkSurfaceKHR { return surface_; }
+  [[nodiscard]] auto images() const -> const std::vector<VkImage>& {
+    return images_;
+  }
+  [[nodiscard]] auto image_format() const -> VkFormat { return image_format_; }
+  [[nodiscard]] auto extent() const -> VkExtent2D { return extent_; }
+
+  // Whether the images can be read back, with the ReadbackService.
+  [[nodiscard]] auto readable() const -> bool {
+    return (usage_ & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+  }
+  // Whether the images can be blitted into, with record_upscale().
+  [[nodiscard]] auto writable() const -> bool {
+    return (usage_ & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0;
+  }
+
  private:
-  auto create_swapchain() -> void;
+  friend class PresentBatch;
+
+  auto create_swapchain(VkSwapchainKHR old_swapchain) -> void;
   auto create_image_views() -> void;
 
   Device* device_ = nullptr;
+  VkSurfaceKHR surface_ = VK_NULL_HANDLE;
+  DimensionsCallback dimensions_cb_;
 
   VkSwapchainKHR swap_chain_{};
   std::vector<VkImage> images_;
   std::vector<VkImageView> image_views_;
   VkFormat image_format_{};
   VkExtent2D extent_{};
-  EL_PAD(4);
+  VkImageUsageFlags usage_ = 0;
+  bool stale_ = false;
+  EL_PAD(7);
+};
+
+// Presents images of several swapchains, such as one per window, with a
+// single vkQueuePresentKHR on the device's present queue.
+class PresentBatch {
+ public:
+  explicit PresentBatch(Device* device) : device_(device) {}
+
+  // Queues |image_index| of |swapchain| once |wait| is signaled. Each
+  // swapchain can be added once per batch. Images rendered by the same
+  // submission can share a semaphore, it is waited on once.
+  auto add(Swapchain* swapchain, uint32_t image_index, VkSemaphore wait)
+      -> void;
+
+  // Presents everything queued and clears the batch. Swapchains which were
+  // out of date or suboptimal are marked stale(); any other failure throws.
+  auto present() -> void;
+
+  [[nodiscard]] auto empty() const -> bool { return swapchains_.empty(); }
+
+ private:
+  Device* device_ = nullptr;
+  std::vector<Swapchain*> swapchains_;
+  std::vector<VkSwapchainKHR> handles_;
+  std::vector<uint32_t> image_indices_;
+  std::vector<VkSemaphore> waits_;
+  std::vector<VkResult> results_;
 };
 
 }  // namespace el::engine
@@ -0,0 +1,763 @@
+#include "src/engine/texture.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace el::engine {
+namespace {
+
+// Copies into block compressed images need offsets aligned to the block.
+constexpr VkDeviceSize kStagingAlignment = 16;
+
+constexpr auto align_up(VkDeviceSize value, VkDeviceSize alignment)
+    -> VkDeviceSize {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+auto level_barrier(VkImage image, uint32_t level, uint32_t count = 1)
+    -> VkImageMemoryBarrier {
+  return {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = image,
+      .subresourceRange =
+          {
+              .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+              .baseMipLevel = level,
+              .levelCount = count,
+              .baseArrayLayer = 0,
+              .layerCount = 1,
+          },
+  };
+}
+
+}  // namespace
+
+Texture::Texture(Device* device, const std::string& path, uint32_t tail_size)
+    : device_(device), file_(path) {
+  VkFormatProperties props = {};
+  vkGetPhysicalDeviceFormatProperties(device_->physical_device(),
+                                      file_.format(), &props);
+  if ((props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) ==
+      0) {
+    throw std::runtime_error(
+        std::string("Texture format not supported: ").append(path));
+  }
+
+  // The tail is the largest level fitting in |tail_size|, or the last level
+  // for textures whose smallest mip is still bigger.
+  tail_level_ = level_count() - 1;
+  for (uint32_t i = 0; i < level_count(); ++i) {
+    auto extent = file_.level_extent(i);
+    if (std::max(extent.width, extent.height) <= tail_size) {
+      tail_level_ = i;
+      break;
+    }
+  }
+
+  wanted_level_ = tail_level_;
+  frame_wanted_level_ = tail_level_;
+
+  // Room for the finer levels is only made once usage asks for them.
+  if (!allocate(tail_level_)) {
+    throw std::runtime_error(
+        std::string("Out of device memory for texture: ").append(path));
+  }
+}
+
+Texture::~Texture() {
+  if (residency_ != nullptr) {
+    residency_->remove(residency_id_);
+  }
+  release_previous();
+  if (view_ != VK_NULL_HANDLE) {
+    device_->destroy_deferred(view_);
+  }
+  device_->destroy_deferred(image_);
+  device_->destroy_deferred(memory_);
+}
+
+auto Texture::create_image(uint32_t base_level) -> std::optional<Allocation> {
+  auto extent = file_.level_extent(base_level);
+  VkImageCreateInfo create_info = {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+      .imageType = VK_IMAGE_TYPE_2D,
+      .format = file_.format(),
+      .extent = {.width = extent.width, .height = extent.height, .depth = 1},
+      .mipLevels = level_count() - base_level,
+      .arrayLayers = 1,
+      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .tiling = VK_IMAGE_TILING_OPTIMAL,
+      // Eviction copies the coarser levels out into a smaller image.
+      .usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+               VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+      .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+      .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+  };
+  VkImage image = VK_NULL_HANDLE;
+  auto res = vkCreateImage(device_->device(), &create_info, nullptr, &image);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to create texture image: ").append(to_string(res)));
+  }
+
+  VkMemoryRequirements reqs = {};
+  vkGetImageMemoryRequirements(device_->device(), image, &reqs);
+
+  auto type = device_->find_memory_type(reqs.memoryTypeBits,
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  if (!type.has_value()) {
+    vkDestroyImage(device_->device(), image, nullptr);
+    throw std::runtime_error("Failed to find texture memory type");
+  }
+
+  VkMemoryAllocateInfo alloc_info = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+      .allocationSize = reqs.size,
+      .memoryTypeIndex = type.value(),
+  };
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  res = device_->allocate_memory(alloc_info, &memory);
+  if (res == VK_ERROR_OUT_OF_DEVICE_MEMORY) {
+    vkDestroyImage(device_->device(), image, nullptr);
+    return std::nullopt;
+  }
+  if (res != VK_SUCCESS) {
+    vkDestroyImage(device_->device(), image, nullptr);
+    throw std::runtime_error(
+        std::string("Failed to allocate texture memory: ")
+            .append(to_string(res)));
+  }
+  res = vkBindImageMemory(device_->device(), image, memory, 0);
+  if (res != VK_SUCCESS) {
+    vkDestroyImage(device_->device(), image, nullptr);
+    device_->free_memory(memory);
+    throw std::runtime_error(
+        std::string("Failed to bind texture memory: ").append(to_string(res)));
+  }
+  return Allocation{.image = image, .memory = memory, .size = reqs.size};
+}
+
+auto Texture::allocate(uint32_t base_level) -> bool {
+  auto allocation = create_image(base_level);
+  if (!allocation.has_value()) {
+    return false;
+  }
+
+  // Whatever is resident stays in view until the new image catches up.
+  if (view_ != VK_NULL_HANDLE) {
+    release_previous();
+    previous_image_ = image_;
+    previous_memory_ = memory_;
+    previous_view_ = view_;
+    previous_level_ = resident_level_;
+  } else if (image_ != VK_NULL_HANDLE) {
+    device_->destroy_deferred(image_);
+    device_->destroy_deferred(memory_);
+  }
+
+  image_ = allocation->image;
+  memory_ = allocation->memory;
+  memory_size_ = allocation->size;
+  view_ = VK_NULL_HANDLE;
+  base_level_ = base_level;
+  resident_level_ = level_count();
+  submitted_level_ = level_count();
+  return true;
+}
+
+auto Texture::shrink(const Allocation& allocation, uint32_t base_level)
+    -> Released {
+  Released released = {.deleted = memory_size_, .allocated = allocation.size};
+  if (view_ != VK_NULL_HANDLE) {
+    device_->destroy_deferred(view_);
+  }
+  device_->destroy_deferred(image_);
+  device_->destroy_deferred(memory_);
+
+  image_ = allocation.image;
+  memory_ = allocation.memory;
+  memory_size_ = allocation.size;
+  view_ = VK_NULL_HANDLE;
+  base_level_ = base_level;
+  submitted_level_ = base_level;
+  set_resident_level(base_level);
+  return released;
+}
+
+auto Texture::release_previous() -> void {
+  if (previous_view_ == VK_NULL_HANDLE) {
+    return;
+  }
+  device_->destroy_deferred(previous_view_);
+  device_->destroy_deferred(previous_image_);
+  device_->destroy_deferred(previous_memory_);
+  previous_view_ = VK_NULL_HANDLE;
+  previous_image_ = VK_NULL_HANDLE;
+  previous_memory_ = VK_NULL_HANDLE;
+}
+
+auto Texture::chain_size(uint32_t level) const -> VkDeviceSize {
+  VkDeviceSize size = 0;
+  for (auto i = level; i < level_count(); ++i) {
+    size += file_.level(i).size();
+  }
+  return size;
+}
+
+auto Texture::note_usage(float pixels) -> void {
+  if (!(pixels > 0.F)) {
+    return;
+  }
+
+  auto size = float(std::max(width(), height()));
+  auto level = std::floor(std::log2(size / pixels));
+  auto clamped = uint32_t(std::clamp(level, 0.F, float(level_count() - 1)));
+  frame_wanted_level_ = std::min(frame_wanted_level_, clamped);
+  if (residency_ != nullptr) {
+    residency_->touch(residency_id_);
+  }
+}
+
+auto Texture::set_resident_level(uint32_t level) -> void {
+  resident_level_ = level;
+
+  VkImageViewCreateInfo create_info = {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+      .image = image_,
+      .viewType = VK_IMAGE_VIEW_TYPE_2D,
+      .format = format(),
+      .subresourceRange =
+          {
+              .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+              .baseMipLevel = resident_level_ - base_level_,
+              .levelCount = level_count() - resident_level_,
+              .baseArrayLayer = 0,
+              .layerCount = 1,
+          },
+  };
+
+  VkImageView view = VK_NULL_HANDLE;
+  auto res = vkCreateImageView(device_->device(), &create_info, nullptr, &view);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to create texture view: ").append(to_string(res)));
+  }
+
+  // Command buffers in flight may still sample through the old view.
+  if (view_ != VK_NULL_HANDLE) {
+    device_->destroy_deferred(view_);
+  }
+  view_ = view;
+
+  // The previous image stays in view until this one has every level it
+  // had, or every level it has room for.
+  if (previous_view_ != VK_NULL_HANDLE) {
+    if (level > std::max(previous_level_, base_level_)) {
+      return;
+    }
+    release_previous();
+  }
+  ++view_version_;
+}
+
+TextureStreamer::TextureStreamer(const TextureStreamerConfig& config)
+    : device_(config.device()),
+      residency_(config.residency()),
+      budget_(align_up(config.budget(), kStagingAlignment)),
+      tail_size_(config.tail_size()),
+      staging_(BufferConfig(config.device())
+                   .set_size(budget_ * kBatchCount)
+                   .set_usage(VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+                   .set_memory_properties(
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+  if (!device_->has_feature(Feature::kTextureCompressionBC)) {
+    throw std::runtime_error(
+        "Texture streaming requires BC texture compression");
+  }
+
+  const auto& indices = device_->queue_families();
+  graphics_family_ = indices.graphics_family.value();
+  transfer_family_ = indices.transfer_family.value();
+
+  std::for_each(std::begin(batches_), std::end(batches_), [this](Batch& b) {
+    VkCommandBufferAllocateInfo alloc_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = device_->transfer_cmd_pool(),
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+    auto res = vkAllocateCommandBuffers(device_->device(), &alloc_info, &b.cmd);
+    if (res != VK_SUCCESS) {
+      throw std::runtime_error(
+          std::string("Failed to allocate streaming command buffer: ")
+              .append(to_string(res)));
+    }
+
+    VkFenceCreateInfo fence_info = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+    };
+    res = vkCreateFence(device_->device(), &fence_info, nullptr, &b.fence);
+    if (res != VK_SUCCESS) {
+      throw std::runtime_error(
+          std::string("Failed to create streaming fence: ")
+              .append(to_string(res)));
+    }
+  });
+
+  VkCommandBufferAllocateInfo alloc_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool = device_->graphics_cmd_pool(),
+      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1,
+  };
+  auto res =
+      vkAllocateCommandBuffers(device_->device(), &alloc_info, &evict_cmd_);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to allocate eviction command buffer: ")
+            .append(to_string(res)));
+  }
+
+  VkFenceCreateInfo fence_info = {
+      .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+  };
+  res = vkCreateFence(device_->device(), &fence_info, nullptr, &evict_fence_);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(std::string("Failed to create eviction fence: ")
+                                 .append(to_string(res)));
+  }
+}
+
+TextureStreamer::~TextureStreamer() {
+  retire_batches(true);
+
+  std::for_each(std::begin(batches_), std::end(batches_), [this](Batch& b) {
+    vkDestroyFence(device_->device(), b.fence, nullptr);
+    vkFreeCommandBuffers(device_->device(), device_->transfer_cmd_pool(), 1,
+                         &b.cmd);
+  });
+  vkDestroyFence(device_->device(), evict_fence_, nullptr);
+  vkFreeCommandBuffers(device_->device(), device_->graphics_cmd_pool(), 1,
+                       &evict_cmd_);
+}
+
+auto TextureStreamer::load(const std::string& path) -> Texture* {
+  textures_.push_back(std::make_unique<Texture>(device_, path, tail_size_));
+  auto* texture = textures_.back().get();
+  if (residency_ != nullptr) {
+    texture->residency_ = residency_;
+    texture->residency_id_ =
+        residency_->add([this, texture] { return evict(texture); });
+  }
+  return texture;
+}
+
+auto TextureStreamer::unload(Texture* texture) -> void {
+  // The copies may still be writing to the image.
+  if (in_flight(texture)) {
+    retire_batches(true);
+  }
+
+  std::erase_if(acquires_,
+                [texture](const Upload& u) { return u.texture == texture; });
+  std::erase_if(textures_, [texture](const std::unique_ptr<Texture>& t) {
+    return t.get() == texture;
+  });
+}
+
+auto TextureStreamer::update() -> void {
+  retire_batches(false);
+
+  std::for_each(std::begin(textures_), std::end(textures_),
+                [this](const std::unique_ptr<Texture>& t) {
+                  t->wanted_level_ = t->frame_wanted_level_;
+                  t->frame_wanted_level_ = t->tail_level_;
+                  grow(t.get());
+                });
+
+  if (submitted_ - retired_ == kBatchCount) {
+    return;
+  }
+
+  auto index = submitted_ % kBatchCount;
+  auto* batch = &batches_.at(index);
+  fill_batch(batch, staging_.mapped().subspan(index * budget_, budget_));
+  if (batch->uploads.empty()) {
+    return;
+  }
+
+  vkEndCommandBuffer(batch->cmd);
+
+  VkSubmitInfo submit_info = {
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &batch->cmd,
+  };
+  auto res = vkQueueSubmit(device_->transfer_queue(), 1, &submit_info,
+                           batch->fence);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to submit texture uploads: ")
+            .append(to_string(res)));
+  }
+  ++submitted_;
+}
+
+auto TextureStreamer::record_acquires(VkCommandBuffer cmd) -> void {
+  if (acquires_.empty()) {
+    return;
+  }
+
+  // With a dedicated transfer family the upload released each level; it
+  // has to be acquired here before it can be sampled.
+  if (graphics_family_ != transfer_family_) {
+    std::vector<VkImageMemoryBarrier> barriers;
+    barriers.reserve(acquires_.size());
+    std::transform(std::begin(acquires_), std::end(acquires_),
+                   std::back_inserter(barriers), [this](const Upload& u) {
+                     auto barrier =
+                         level_barrier(u.texture->image_,
+                                       u.level - u.texture->base_level_);
+                     barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+                     barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                     barrier.newLayout =
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                     barrier.srcQueueFamilyIndex = transfer_family_;
+                     barrier.dstQueueFamilyIndex = graphics_family_;
+                     return barrier;
+                   });
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr,
+                         uint32_t(barriers.size()), barriers.data());
+  }
+
+  // Uploads are in submission order, so the last one seen for a texture is
+  // its finest resident level.
+  std::vector<Texture*> changed;
+  std::for_each(std::begin(acquires_), std::end(acquires_),
+                [&changed](const Upload& u) {
+                  if (u.level < u.texture->resident_level_) {
+                    u.texture->resident_level_ = u.level;
+                    changed.push_back(u.texture);
+                  }
+                });
+  acquires_.clear();
+
+  std::sort(std::begin(changed), std::end(changed));
+  changed.erase(std::unique(std::begin(changed), std::end(changed)),
+                std::end(changed));
+  std::for_each(std::begin(changed), std::end(changed),
+                [](Texture* t) { t->set_resident_level(t->resident_level_); });
+}
+
+auto TextureStreamer::retire_batches(bool wait) -> void {
+  while (retired_ < submitted_) {
+    auto& batch = batches_.at(retired_ % kBatchCount);
+    if (wait) {
+      vkWaitForFences(device_->device(), 1, &batch.fence, VK_TRUE,
+                      std::numeric_limits<uint64_t>::max());
+    } else if (vkGetFenceStatus(device_->device(), batch.fence) !=
+               VK_SUCCESS) {
+      return;
+    }
+
+    vkResetFences(device_->device(), 1, &batch.fence);
+    vkResetCommandBuffer(batch.cmd, 0);
+    acquires_.insert(std::end(acquires_), std::begin(batch.uploads),
+                     std::end(batch.uploads));
+    batch.uploads.clear();
+    batch.overflow.reset();
+    ++retired_;
+  }
+}
+
+auto TextureStreamer::in_flight(const Texture* texture) const -> bool {
+  for (auto i = retired_; i < submitted_; ++i) {
+    const auto& uploads = batches_.at(i % kBatchCount).uploads;
+    if (std::any_of(
+            std::begin(uploads), std::end(uploads),
+            [texture](const Upload& u) { return u.texture == texture; })) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto TextureStreamer::busy(const Texture* texture) const -> bool {
+  return in_flight(texture) ||
+         std::any_of(
+             std::begin(acquires_), std::end(acquires_),
+             [texture](const Upload& u) { return u.texture == texture; });
+}
+
+auto TextureStreamer::grow(Texture* texture) -> void {
+  auto target = std::min(texture->wanted_level_, texture->tail_level_);
+  if (target >= texture->base_level_ ||
+      texture->previous_view_ != VK_NULL_HANDLE || busy(texture)) {
+    return;
+  }
+  if (residency_ != nullptr &&
+      !residency_->can_grow(texture->chain_size(target))) {
+    return;
+  }
+
+  // Out of memory just leaves the texture at its current size.
+  growing_ = texture;
+  try {
+    texture->allocate(target);
+  } catch (...) {
+    growing_ = nullptr;
+    throw;
+  }
+  growing_ = nullptr;
+}
+
+auto TextureStreamer::evict(Texture* texture) -> Released {
+  auto level = texture->resident_level_ + 1;
+  if (texture == growing_ || level > texture->tail_level_ ||
+      texture->previous_view_ != VK_NULL_HANDLE || busy(texture)) {
+    return {};
+  }
+
+  auto allocation = texture->create_image(level);
+  if (!allocation.has_value()) {
+    return {};
+  }
+  try {
+    copy_levels(texture, allocation->image, level);
+  } catch (...) {
+    vkDestroyImage(device_->device(), allocation->image, nullptr);
+    device_->free_memory(allocation->memory);
+    throw;
+  }
+  return texture->shrink(*allocation, level);
+}
+
+auto TextureStreamer::copy_levels(const Texture* texture,
+                                  VkImage image,
+                                  uint32_t level) -> void {
+  VkCommandBufferBeginInfo begin_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+  };
+  vkBeginCommandBuffer(evict_cmd_, &begin_info);
+
+  auto count = texture->level_count() - level;
+  auto src =
+      level_barrier(texture->image_, level - texture->base_level_, count);
+  src.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  src.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  src.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  auto dst = level_barrier(image, 0, count);
+  dst.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  dst.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  dst.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  std::array before = {src, dst};
+  // Frames already submitted may still be sampling the old image.
+  vkCmdPipelineBarrier(evict_cmd_, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, uint32_t(before.size()), before.data());
+
+  std::vector<VkImageCopy> regions;
+  for (auto i = level; i < texture->level_count(); ++i) {
+    auto extent = texture->file_.level_extent(i);
+    regions.push_back({
+        .srcSubresource =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = i - texture->base_level_,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+        .srcOffset = {},
+        .dstSubresource =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = i - level,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+        .dstOffset = {},
+        .extent = {.width = extent.width, .height = extent.height, .depth = 1},
+    });
+  }
+  vkCmdCopyImage(evict_cmd_, texture->image_,
+                 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image,
+                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, uint32_t(regions.size()),
+                 regions.data());
+
+  // The old image goes back to the layout the frame being recorded expects,
+  // since it may already sample it.
+  src.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  src.dstAccessMask = 0;
+  src.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  src.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  dst.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  dst.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  dst.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  dst.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  std::array after = {src, dst};
+  vkCmdPipelineBarrier(evict_cmd_, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0,
+                       nullptr, uint32_t(after.size()), after.data());
+  vkEndCommandBuffer(evict_cmd_);
+
+  VkSubmitInfo submit_info = {
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &evict_cmd_,
+  };
+  auto res = vkQueueSubmit(device_->graphics_queue(), 1, &submit_info,
+                           evict_fence_);
+  if (res != VK_SUCCESS) {
+    vkResetCommandBuffer(evict_cmd_, 0);
+    throw std::runtime_error(
+        std::string("Failed to submit texture eviction: ")
+            .append(to_string(res)));
+  }
+
+  // Evictions are rare, and waiting lets the old image go to the deletion
+  // queue right away.
+  vkWaitForFences(device_->device(), 1, &evict_fence_, VK_TRUE,
+                  std::numeric_limits<uint64_t>::max());
+  vkResetFences(device_->device(), 1, &evict_fence_);
+  vkResetCommandBuffer(evict_cmd_, 0);
+}
+
+auto TextureStreamer::fill_batch(Batch* batch, std::span<std::byte> staging)
+    -> void {
+  // Never finer than the image has room for.
+  auto target = [](const Texture* t) {
+    return std::max(std::min(t->wanted_level_, t->tail_level_),
+                    t->base_level_);
+  };
+
+  // Textures furthest from the level they want go first.
+  std::vector<Texture*> order;
+  std::for_each(std::begin(textures_), std::end(textures_),
+                [&order, &target](const std::unique_ptr<Texture>& t) {
+                  if (t->submitted_level_ > target(t.get())) {
+                    order.push_back(t.get());
+                  }
+                });
+  std::stable_sort(std::begin(order), std::end(order),
+                   [&target](const Texture* a, const Texture* b) {
+                     return a->submitted_level_ - target(a) >
+                            b->submitted_level_ - target(b);
+                   });
+
+  // Hand out one level per texture per pass until the budget is spent.
+  VkDeviceSize used = 0;
+  bool progress = true;
+  while (progress) {
+    progress = false;
+    for (auto* texture : order) {
+      if (texture->submitted_level_ <= target(texture)) {
+        continue;
+      }
+
+      Upload upload = {
+          .texture = texture,
+          .level = texture->submitted_level_ - 1,
+      };
+      auto data = texture->file_.level(upload.level);
+      auto offset = align_up(used, kStagingAlignment);
+      if (offset + data.size() <= staging.size()) {
+        std::memcpy(staging.subspan(offset).data(), data.data(), data.size());
+        auto base = VkDeviceSize(staging.data() - staging_.mapped().data());
+        record_upload(batch, upload, staging_.buffer(), base + offset);
+        used = offset + data.size();
+      } else if (batch->uploads.empty()) {
+        // A single level bigger than the budget gets the batch to itself.
+        batch->overflow = std::make_unique<Buffer>(
+            BufferConfig(device_)
+                .set_size(data.size())
+                .set_usage(VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+                .set_memory_properties(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+        std::memcpy(batch->overflow->mapped().data(), data.data(),
+                    data.size());
+        record_upload(batch, upload, batch->overflow->buffer(), 0);
+        texture->submitted_level_ = upload.level;
+        return;
+      } else {
+        continue;
+      }
+
+      texture->submitted_level_ = upload.level;
+      progress = true;
+    }
+  }
+}
+
+auto TextureStreamer::record_upload(Batch* batch,
+                                    const Upload& upload,
+                                    VkBuffer staging,
+                                    VkDeviceSize offset) const -> void {
+  if (batch->uploads.empty()) {
+    VkCommandBufferBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    vkBeginCommandBuffer(batch->cmd, &begin_info);
+  }
+  batch->uploads.push_back(upload);
+
+  auto image = upload.texture->image_;
+  auto mip = upload.level - upload.texture->base_level_;
+  auto before = level_barrier(image, mip);
+  before.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  before.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  before.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  vkCmdPipelineBarrier(batch->cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &before);
+
+  auto extent = upload.texture->file_.level_extent(upload.level);
+  VkBufferImageCopy region = {
+      .bufferOffset = offset,
+      .imageSubresource =
+          {
+              .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+              .mipLevel = mip,
+              .baseArrayLayer = 0,
+              .layerCount = 1,
+          },
+      .imageExtent = {.width = extent.width,
+                      .height = extent.height,
+                      .depth = 1},
+  };
+  vkCmdCopyBufferToImage(batch->cmd, staging, image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+  // Either releases the level to the graphics family, which acquires it in
+  // record_acquires(), or, on a shared family, makes it readable directly.
+  auto after = level_barrier(image, mip);
+  after.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  after.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  after.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  auto dst_stage = VkPipelineStageFlags{VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT};
+  if (graphics_family_ != transfer_family_) {
+    after.srcQueueFamilyIndex = transfer_family_;
+    after.dstQueueFamilyIndex = graphics_family_;
+  } else {
+    after.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    dst_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+  }
+  vkCmdPipelineBarrier(batch->cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage,
+                       0, 0, nullptr, 0, nullptr, 1, &after);
+}
+
+}  // namespace el::engine
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "src/engine/buffer.h"
+#include "src/engine/device.h"
+#include "src/engine/ktx2.h"
+#include "src/engine/residency.h"
+#include "src/engine/vk.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+// Bytes the streamer uploads per frame.
+constexpr VkDeviceSize kDefaultStreamingBudget = VkDeviceSize{8} * 1024 * 1024;
+// Mips no larger than this are always resident, so a texture shows up as
+// soon as its first, tiny, upload lands.
+constexpr uint32_t kDefaultTailSize = 128;
+
+// A block compressed texture whose mip levels are streamed in by a
+// TextureStreamer, smallest first. The image only has room for the levels
+// usage asks for, and is reallocated when that changes or when levels are
+// evicted. view() only covers the levels which have arrived; while a new
+// image streams in, the old one stays in view.
+class Texture {
+ public:
+  Texture(Device* device, const std::string& path, uint32_t tail_size);
+  Texture(const Texture&) = delete;
+  Texture(Texture&&) = delete;
+  ~Texture();
+
+  auto operator=(const Texture&) -> Texture& = delete;
+  auto operator=(Texture&&) -> Texture& = delete;
+
+  // VK_NULL_HANDLE until the first levels are resident.
+  [[nodiscard]] auto view() const -> VkImageView {
+    return previous_view_ != VK_NULL_HANDLE ? previous_view_ : view_;
+  }
+  // Bumped every time view() changes so descriptors can be refreshed.
+  [[nodiscard]] auto view_version() const -> uint32_t { return view_version_; }
+
+  [[nodiscard]] auto image() const -> VkImage { return image_; }
+  [[nodiscard]] auto format() const -> VkFormat { return file_.format(); }
+  [[nodiscard]] auto width() const -> uint32_t { return file_.width(); }
+  [[nodiscard]] auto height() const -> uint32_t { return file_.height(); }
+  [[nodiscard]] auto level_count() const -> uint32_t {
+    return file_.level_count();
+  }
+
+  // Finest level view() covers, level_count() while nothing is resident.
+  [[nodiscard]] auto resident_level() const -> uint32_t {
+    return previous_view_ != VK_NULL_HANDLE ? previous_level_
+                                            : resident_level_;
+  }
+
+  // Records that the texture covers about |pixels| pixels on screen along
+  // its larger axis this frame. Levels finer than needed by the largest use
+  // are never streamed.
+  auto note_usage(float pixels) -> void;
+
+ private:
+  friend class TextureStreamer;
+
+  struct Allocation {
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+  };
+
+  // Creates an image with room for levels |base_level| and coarser. Empty
+  // when the device is out of memory.
+  auto create_image(uint32_t base_level) -> std::optional<Allocation>;
+  // Replaces the image with an empty one holding levels |base_level| and
+  // coarser. Returns false, keeping the current image, when the device is
+  // out of memory.
+  auto allocate(uint32_t base_level) -> bool;
+  // Switches to |allocation|, which already holds every level from
+  // |base_level| down, and hands the current image to the deletion queue.
+  auto shrink(const Allocation& allocation, uint32_t base_level) -> Released;
+  auto set_resident_level(uint32_t level) -> void;
+  auto release_previous() -> void;
+  // Bytes of the levels from |level| down to the smallest.
+  [[nodiscard]] auto chain_size(uint32_t level) const -> VkDeviceSize;
+
+  Device* device_ = nullptr;
+  Ktx2File file_;
+  ResidencyManager* residency_ = nullptr;
+  VkImage image_ = VK_NULL_HANDLE;
+  VkDeviceMemory memory_ = VK_NULL_HANDLE;
+  VkImageView view_ = VK_NULL_HANDLE;
+  VkDeviceSize memory_size_ = 0;
+  // The image shown while a reallocated one streams its levels in.
+  VkImage previous_image_ = VK_NULL_HANDLE;
+  VkDeviceMemory previous_memory_ = VK_NULL_HANDLE;
+  VkImageView previous_view_ = VK_NULL_HANDLE;
+
+  ResidencyId residency_id_ = 0;
+  uint32_t previous_level_ = 0;
+  // Finest level the image has room for, its first mip.
+  uint32_t base_level_ = 0;
+  uint32_t view_version_ = 0;
+  uint32_t resident_level_ = 0;
+  // Finest level handed to the transfer queue.
+  uint32_t submitted_level_ = 0;
+  // Coarsest level which is always loaded.
+  uint32_t tail_level_ = 0;
+  // Finest level wanted by last frame's usage, and by this frame's so far.
+  uint32_t wanted_level_ = 0;
+  uint32_t frame_wanted_level_ = 0;
+  EL_PAD(4);
+};
+
+class TextureStreamerConfig {
+ public:
+  explicit TextureStreamerConfig(Device* device) : device_(device) {}
+
+  auto set_budget(VkDeviceSize bytes_per_frame) -> TextureStreamerConfig& {
+    budget_ = bytes_per_frame;
+    return *this;
+  }
+
+  auto set_tail_size(uint32_t size) -> TextureStreamerConfig& {
+    tail_size_ = size;
+    return *this;
+  }
+
+  // Registers every texture so its finest levels can be evicted under
+  // memory pressure, and only grows textures while there is room. Must
+  // outlive the streamer.
+  auto set_residency(ResidencyManager* residency) -> TextureStreamerConfig& {
+    residency_ = residency;
+    return *this;
+  }
+
+  [[nodiscard]] auto device() const -> Device* { return device_; }
+  [[nodiscard]] auto budget() const -> VkDeviceSize { return budget_; }
+  [[nodiscard]] auto tail_size() const -> uint32_t { return tail_size_; }
+  [[nodiscard]] auto residency() const -> ResidencyManager* {
+    return residency_;
+  }
+
+ private:
+  Device* device_ = nullptr;
+  ResidencyManager* residency_ = nullptr;
+  VkDeviceSize budget_ = kDefaultStreamingBudget;
+  uint32_t tail_size_ = kDefaultTailSize;
+  EL_PAD(4);
+};
+
+// Streams texture mip levels through the transfer queue.
+//
+// Each frame:
+//   - Texture::note_usage() for every texture drawn,
+//   - update() to retire finished uploads and start new ones,
+//   - record_acquires() on the graphics command buffer before any texture
+//     is sampled; only then are new levels added to the texture views.
+//
+// Textures furthest from the level their usage asks for are served first
+// and every texture gets its next coarser level before any gets two, which
+// keeps first frames cheap and the per-frame upload bounded. Not thread
+// safe.
+class TextureStreamer {
+ public:
+  explicit TextureStreamer(const TextureStreamerConfig& config);
+  TextureStreamer(const TextureStreamer&) = delete;
+  TextureStreamer(TextureStreamer&&) = delete;
+  ~TextureStreamer();
+
+  auto operator=(const TextureStreamer&) -> TextureStreamer& = delete;
+  auto operator=(TextureStreamer&&) -> TextureStreamer& = delete;
+
+  // Loads the KTX2 file at |path|. The returned texture is owned by the
+  // streamer and lives until unload().
+  auto load(const std::string& path) -> Texture*;
+  auto unload(Texture* texture) -> void;
+
+  auto update() -> void;
+  auto record_acquires(VkCommandBuffer cmd) -> void;
+
+ private:
+  // Uploads in flight at once. One more than the frames in flight so a new
+  // batch can start while the GPU drains the previous ones.
+  static constexpr size_t kBatchCount = kMaxFramesInFlight + 1;
+
+  struct Upload {
+    Texture* texture = nullptr;
+    uint32_t level = 0;
+    EL_PAD(4);
+  };
+
+  struct Batch {
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    // Staging for a single level larger than the whole budget.
+    std::unique_ptr<Buffer> overflow;
+    std::vector<Upload> uploads;
+  };
+
+  // Batches are used as a ring and retired in submission order, so levels
+  // always become resident coarsest first.
+  auto retire_batches(bool wait) -> void;
+  // Whether uploads to |texture| are in flight or waiting to be acquired;
+  // its image can't be replaced until they are done.
+  [[nodiscard]] auto in_flight(const Texture* texture) const -> bool;
+  [[nodiscard]] auto busy(const Texture* texture) const -> bool;
+  // Reallocates |texture| with room for the levels its usage wants.
+  auto grow(Texture* texture) -> void;
+  // Drops the finest resident level of |texture| by copying the coarser
+  // ones into a smaller image; the old one goes to the deletion queue. The
+  // tail is never evicted.
+  auto evict(Texture* texture) -> Released;
+  // Copies the levels of |texture| from |level| down into |image| on the
+  // graphics queue, which owns them, and waits for the copy.
+  auto copy_levels(const Texture* texture, VkImage image, uint32_t level)
+      -> void;
+  auto fill_batch(Batch* batch, std::span<std::byte> staging) -> void;
+  auto record_upload(Batch* batch,
+                     const Upload& upload,
+                     VkBuffer staging,
+                     VkDeviceSize offset) const -> void;
+
+  Device* device_ = nullptr;
+  ResidencyManager* residency_ = nullptr;
+  // Being reallocated by grow(), so it isn't evicted meanwhile.
+  const Texture* growing_ = nullptr;
+  VkDeviceSize budget_ = 0;
+  uint32_t tail_size_ = 0;
+  uint32_t graphics_family_ = 0;
+  uint32_t transfer_family_ = 0;
+  EL_PAD(4);
+  uint64_t submitted_ = 0;
+  uint64_t retired_ = 0;
+  Buffer staging_;
+  std::array<Batch, kBatchCount> batches_;
+  // Graphics queue copies made by evict().
+  VkCommandBuffer evict_cmd_ = VK_NULL_HANDLE;
+  VkFence evict_fence_ = VK_NULL_HANDLE;
+  std::vector<std::unique_ptr<Texture>> textures_;
+  // Finished uploads waiting for their graphics queue barrier.
+  std::vector<Upload> acquires_;
+};
+
+}  // namespace el::engine
@@ -0,0 +1,146 @@
+#include "src/engine/uploader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace el::engine {
+namespace {
+
+// Keeps staging offsets friendly to image copies as well as buffer copies.
+constexpr VkDeviceSize kStagingAlignment = 16;
+
+constexpr auto align_up(VkDeviceSize value, VkDeviceSize alignment)
+    -> VkDeviceSize {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace
+
+StagingUploader::StagingUploader(const StagingUploaderConfig& config)
+    : device_(config.device()),
+      staging_(BufferConfig(config.device())
+                   .set_size(config.staging_size())
+                   .set_usage(VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+                   .set_memory_properties(
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+  VkCommandBufferAllocateInfo alloc_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool = device_->graphics_cmd_pool(),
+      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1,
+  };
+  auto res = vkAllocateCommandBuffers(device_->device(), &alloc_info, &cmd_);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to allocate upload command buffer: ")
+            .append(to_string(res)));
+  }
+
+  VkFenceCreateInfo fence_info = {
+      .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+  };
+  res = vkCreateFence(device_->device(), &fence_info, nullptr, &fence_);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to create upload fence: ").append(to_string(res)));
+  }
+}
+
+StagingUploader::~StagingUploader() {
+  flush();
+
+  vkDestroyFence(device_->device(), fence_, nullptr);
+  vkFreeCommandBuffers(device_->device(), device_->graphics_cmd_pool(), 1,
+                       &cmd_);
+}
+
+auto StagingUploader::upload(const Buffer& dst,
+                             VkDeviceSize offset,
+                             std::span<const std::byte> data) -> void {
+  auto staging = staging_.mapped();
+  while (!data.empty()) {
+    if (head_ >= staging.size()) {
+      flush();
+    }
+
+    auto count = std::min(VkDeviceSize{data.size()}, staging.size() - head_);
+    std::memcpy(staging.subspan(head_).data(), data.data(), count);
+    copies_.push_back({
+        .src = staging_.buffer(),
+        .dst = dst.buffer(),
+        .region = {.srcOffset = head_, .dstOffset = offset, .size = count},
+    });
+
+    head_ = align_up(head_ + count, kStagingAlignment);
+    offset += count;
+    data = data.subspan(count);
+  }
+}
+
+auto StagingUploader::copy(const Buffer& src,
+                           VkDeviceSize src_offset,
+                           const Buffer& dst,
+                           VkDeviceSize dst_offset,
+                           VkDeviceSize size) -> void {
+  copies_.push_back({
+      .src = src.buffer(),
+      .dst = dst.buffer(),
+      .region = {.srcOffset = src_offset,
+                 .dstOffset = dst_offset,
+                 .size = size},
+  });
+}
+
+auto StagingUploader::flush() -> void {
+  if (copies_.empty()) {
+    return;
+  }
+
+  VkCommandBufferBeginInfo begin_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+  };
+  vkBeginCommandBuffer(cmd_, &begin_info);
+
+  std::for_each(std::begin(copies_), std::end(copies_),
+                [this](const Copy& copy) {
+                  vkCmdCopyBuffer(cmd_, copy.src, copy.dst, 1, &copy.region);
+                });
+
+  // The fence only orders the host; later submissions still need the copies
+  // made visible to them.
+  VkMemoryBarrier barrier = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+  };
+  vkCmdPipelineBarrier(cmd_, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0,
+                       nullptr, 0, nullptr);
+  vkEndCommandBuffer(cmd_);
+
+  VkSubmitInfo submit_info = {
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &cmd_,
+  };
+  auto res = vkQueueSubmit(device_->graphics_queue(), 1, &submit_info, fence_);
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to submit uploads: ").append(to_string(res)));
+  }
+
+  vkWaitForFences(device_->device(), 1, &fence_, VK_TRUE,
+                  std::numeric_limits<uint64_t>::max());
+  vkResetFences(device_->device(), 1, &fence_);
+  vkResetCommandBuffer(cmd_, 0);
+
+  copies_.clear();
+  head_ = 0;
+}
+
+}  // namespace el::engine
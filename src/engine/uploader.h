@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "src/engine/buffer.h"
+#include "src/engine/device.h"
+#include "src/engine/vk.h"
+#include "src/pad.h"
+
+namespace el::engine {
+
+constexpr VkDeviceSize kDefaultStagingSize = VkDeviceSize{16} * 1024 * 1024;
+
+class StagingUploaderConfig {
+ public:
+  explicit StagingUploaderConfig(Device* device) : device_(device) {}
+
+  auto set_staging_size(VkDeviceSize size) -> StagingUploaderConfig& {
+    staging_size_ = size;
+    return *this;
+  }
+
+  [[nodiscard]] auto device() const -> Device* { return device_; }
+  [[nodiscard]] auto staging_size() const -> VkDeviceSize {
+    return staging_size_;
+  }
+
+ private:
+  Device* device_ = nullptr;
+  VkDeviceSize staging_size_ = kDefaultStagingSize;
+};
+
+// Copies data into device local buffers through a persistently mapped
+// staging buffer.
+//
+// Uploads are batched; they are recorded and submitted together on flush(),
+// or whenever the staging buffer fills up. flush() blocks until the copies
+// are done and makes the results visible to all later commands on the
+// graphics queue. Not thread safe.
+class StagingUploader {
+ public:
+  explicit StagingUploader(const StagingUploaderConfig& config);
+  StagingUploader(const StagingUploader&) = delete;
+  StagingUploader(StagingUploader&&) = delete;
+  ~StagingUploader();
+
+  auto operator=(const StagingUploader&) -> StagingUploader& = delete;
+  auto operator=(StagingUploader&&) -> StagingUploader& = delete;
+
+  // Copies |data| into |dst| starting at |offset|. Data larger than the
+  // staging buffer is split over several submissions.
+  auto upload(const Buffer& dst,
+              VkDeviceSize offset,
+              std::span<const std::byte> data) -> void;
+
+  // Copies |size| bytes from |src|, a host visible buffer the caller has
+  // already filled, into |dst| without going through the staging buffer.
+  // |src| has to stay alive and unmodified until the next flush().
+  auto copy(const Buffer& src,
+            VkDeviceSize src_offset,
+            const Buffer& dst,
+            VkDeviceSize dst_offset,
+            VkDeviceSize size) -> void;
+
+  auto flush() -> void;
+
+  [[nodiscard]] auto device() const -> Device* { return device_; }
+
+ private:
+  struct Copy {
+    VkBuffer src = VK_NULL_HANDLE;
+    VkBuffer dst = VK_NULL_HANDLE;
+    VkBufferCopy region = {};
+  };
+
+  Device* device_ = nullptr;
+  Buffer staging_;
+  VkCommandBuffer cmd_ = VK_NULL_HANDLE;
+  VkFence fence_ = VK_NULL_HANDLE;
+  VkDeviceSize head_ = 0;
+  std::vector<Copy> copies_;
+};
+
+}  // namespace el::engine
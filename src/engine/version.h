@@ -11,15 +11,18 @@ constexpr auto kVkMinorShift = 12;
 
 class VersionInfo {
  public:
-  VersionInfo() = default;
+  constexpr VersionInfo() = default;
   // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
-  VersionInfo(uint32_t variant, uint32_t major, uint32_t minor, uint32_t patch)
+  constexpr VersionInfo(uint32_t variant,
+                        uint32_t major,
+                        uint32_t minor,
+                        uint32_t patch)
       : variant_(variant), major_(major), minor_(minor), patch_(patch) {}
   // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
-  VersionInfo(uint32_t major, uint32_t minor, uint32_t patch)
+  constexpr VersionInfo(uint32_t major, uint32_t minor, uint32_t patch)
       : VersionInfo(0, major, minor, patch) {}
 
-  [[nodiscard]] auto to_vk() const -> uint32_t {
+  [[nodiscard]] constexpr auto to_vk() const -> uint32_t {
     return variant_ << kVkVariantShift | major_ << kVkMajorShift |
            minor_ << kVkMinorShift | patch_;
   }
@@ -1,5 +1,8 @@
 #include "src/engine/vk.h"
 
+#include <stdexcept>
+#include <string>
+
 auto to_string(const VkResult result) -> std::string_view {
   switch (result) {
     case VK_SUCCESS:
@@ -175,3 +178,15 @@ auto to_string(const VkObjectType type) -> std::string_view {
   }
   return "unknown";
 }
+
+namespace el::engine {
+
+auto check(VkResult res, const char* what) -> void {
+  if (res != VK_SUCCESS) {
+    throw std::runtime_error(
+        std::string("Failed to ").append(what).append(": ").append(
+            to_string(res)));
+  }
+}
+
+}  // namespace el::engine
@@ -9,3 +9,10 @@
 
 auto to_string(VkResult result) -> std::string_view;
 auto to_string(VkObjectType type) -> std::string_view;
+
+namespace el::engine {
+
+// Throws "Failed to |what|: <result>" unless |res| is VK_SUCCESS.
+auto check(VkResult res, const char* what) -> void;
+
+}  // namespace el::engine
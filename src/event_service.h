@@ -9,6 +9,8 @@
 
 namespace el {
 
+class Window;
+
 enum class EventType {
   kResized,
   kKey,
@@ -16,7 +18,10 @@ enum class EventType {
 
 struct Event {};
 
-struct ResizeEvent : public Event {};
+struct ResizeEvent : public Event {
+  // The window which was resized, for swapchains of other windows to ignore.
+  const Window* window = nullptr;
+};
 
 using EventCallback = std::function<void(const Event*)>;
 
@@ -0,0 +1,119 @@
+#include "src/job_system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace el {
+
+JobSystem::JobSystem(uint32_t thread_count) {
+  if (thread_count == 0) {
+    auto hw = std::thread::hardware_concurrency();
+    thread_count = hw > 1 ? hw - 1 : 1;
+  }
+
+  workers_.reserve(thread_count);
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    workers_.emplace_back([this]() { worker_loop(); });
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    const std::lock_guard<std::mutex> lock(lock_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+
+  std::for_each(std::begin(workers_), std::end(workers_),
+                [](std::thread& t) { t.join(); });
+}
+
+auto JobSystem::submit(Job job) -> void {
+  {
+    const std::lock_guard<std::mutex> lock(lock_);
+    queue_.push_back(std::move(job));
+  }
+  work_cv_.notify_one();
+}
+
+auto JobSystem::parallel_for(size_t count, size_t grain, const RangeJob& fn)
+    -> void {
+  if (count == 0) {
+    return;
+  }
+  grain = std::max<size_t>(grain, 1);
+
+  struct State {
+    std::atomic<size_t> next = 0;
+    std::atomic<size_t> remaining = 0;
+    std::mutex lock;
+    std::condition_variable done;
+  };
+
+  auto chunks = (count + grain - 1) / grain;
+  auto state = std::make_shared<State>();
+  state->remaining = chunks;
+
+  // Workers share the chunk counter, so late starters simply find nothing
+  // left to do. |fn| outlives every chunk since we block below.
+  auto run = [state, count, grain, chunks, &fn]() {
+    for (;;) {
+      auto chunk = state->next.fetch_add(1);
+      if (chunk >= chunks) {
+        return;
+      }
+
+      auto begin = chunk * grain;
+      fn(begin, std::min(begin + grain, count));
+
+      if (state->remaining.fetch_sub(1) == 1) {
+        const std::lock_guard<std::mutex> lock(state->lock);
+        state->done.notify_all();
+      }
+    }
+  };
+
+  auto helpers = std::min(chunks - 1, workers_.size());
+  for (size_t i = 0; i < helpers; ++i) {
+    submit(run);
+  }
+  run();
+
+  std::unique_lock<std::mutex> lock(state->lock);
+  state->done.wait(lock, [&state]() { return state->remaining == 0; });
+}
+
+auto JobSystem::wait_idle() -> void {
+  std::unique_lock<std::mutex> lock(lock_);
+  idle_cv_.wait(lock, [this]() { return queue_.empty() && running_ == 0; });
+}
+
+auto JobSystem::worker_loop() -> void {
+  for (;;) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      work_cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (stop_ && queue_.empty()) {
+        return;
+      }
+
+      job = std::move(queue_.front());
+      queue_.pop_front();
+      running_ += 1;
+    }
+
+    job();
+
+    {
+      const std::lock_guard<std::mutex> lock(lock_);
+      running_ -= 1;
+      if (queue_.empty() && running_ == 0) {
+        idle_cv_.notify_all();
+      }
+    }
+  }
+}
+
+}  // namespace el
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "src/pad.h"
+
+namespace el {
+
+using Job = std::function<void()>;
+using RangeJob = std::function<void(size_t begin, size_t end)>;
+
+// Fixed size pool of worker threads executing jobs in FIFO order.
+class JobSystem {
+ public:
+  // A |thread_count| of 0 uses one thread per hardware thread, minus the
+  // caller's thread.
+  explicit JobSystem(uint32_t thread_count = 0);
+  JobSystem(const JobSystem&) = delete;
+  JobSystem(JobSystem&&) = delete;
+  ~JobSystem();
+
+  auto operator=(const JobSystem&) -> JobSystem& = delete;
+  auto operator=(JobSystem&&) -> JobSystem& = delete;
+
+  auto submit(Job job) -> void;
+
+  // Splits [0, count) into chunks of |grain| items and runs |fn| over them on
+  // the workers. The calling thread participates and the call returns once
+  // every chunk has finished.
+  auto parallel_for(size_t count, size_t grain, const RangeJob& fn) -> void;
+
+  // Blocks until the queue is empty and no job is running.
+  auto wait_idle() -> void;
+
+  [[nodiscard]] auto thread_count() const -> uint32_t {
+    return static_cast<uint32_t>(workers_.size());
+  }
+
+ private:
+  auto worker_loop() -> void;
+
+  std::vector<std::thread> workers_;
+  std::deque<Job> queue_;
+  std::mutex lock_;
+  std::condition_variable work_cv_;
+  std::condition_variable idle_cv_;
+  size_t running_ = 0;
+  bool stop_ = false;
+  EL_PAD(7);
+};
+
+}  // namespace el
@@ -1,23 +1,42 @@
 #include <exception>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <optional>
 
 #include "src/dimensions.h"
 #include "src/engine.h"
 #include "src/event_service.h"
+#include "src/job_system.h"
+#include "src/startup_timer.h"
 #include "src/window.h"
 
 constexpr uint32_t kDefaultWidth = 1024;
 constexpr uint32_t kDefaultHeight = 768;
+constexpr const char* kPipelineCachePath = "pipeline_cache.bin";
 
 auto main() -> int {
   try {
+    el::StartupTimer startup;
     el::EventService event_service;
 
-    el::Window window(
-        el::WindowConfig()
-            .set_title("Elysian")
-            .set_dimensions({.width = kDefaultWidth, .height = kDefaultHeight})
-            .set_event_service(&event_service));
+    // The pipeline cache is plain file IO, read while the window and device
+    // are created.
+    auto pipeline_cache = std::async(std::launch::async, [&startup] {
+      return startup.time("pipeline_cache/read", [] {
+        return el::engine::read_pipeline_cache(kPipelineCachePath);
+      });
+    });
+
+    // The device needs the window system's instance extensions up front, but
+    // the window only once it creates the surface. Windows must be created on
+    // the main thread, so the device is built in the background and waits for
+    // the window just before creating its surface.
+    startup.time("window/init", [] { el::Window::Init(); });
+
+    std::optional<el::Window> window;
+    std::promise<void> window_created;
+    std::shared_future<void> window_ready = window_created.get_future();
 
     el::engine::ErrorData err_data{
         .cb =
@@ -27,29 +46,83 @@ auto main() -> int {
         .user_data = nullptr,
     };
 
-    el::engine::Device device(
-        el::engine::DeviceConfig()
-            .set_app_name("Elysian")
-            .set_app_version(0, 1, 0)
-            .set_enable_validation()
-            .set_error_data(&err_data)
-            .set_device_extensions(el::Window::required_engine_extensions())
-            .set_event_service(&event_service)
-            .set_dimensions_cb(
-                [&window]() -> el::Dimensions { return window.dimensions(); })
-            .set_surface_cb([&window](el::engine::Device& d) {
-              window.create_surface(d);
-            }));
-
-    auto swapchain = std::make_unique<el::engine::Swapchain>(&device);
+    auto device_created = std::async(std::launch::async, [&] {
+      return std::make_unique<el::engine::Device>(
+          el::engine::DeviceConfig()
+              .set_app_name("Elysian")
+              .set_app_version(0, 1, 0)
+              .set_enable_validation()
+              .set_error_data(&err_data)
+              .set_device_extensions(el::Window::required_engine_extensions())
+              .set_event_service(&event_service)
+              .set_startup_timer(&startup)
+              .set_optional_features({
+                  el::engine::Feature::kMultiDrawIndirect,
+                  el::engine::Feature::kDrawIndirectFirstInstance,
+                  el::engine::Feature::kDrawIndirectCount,
+                  el::engine::Feature::kTimelineSemaphore,
+                  el::engine::Feature::kDescriptorIndexing,
+                  el::engine::Feature::kRuntimeDescriptorArray,
+                  el::engine::Feature::kDescriptorBindingPartiallyBound,
+                  el::engine::Feature::kStorageBuffer8BitAccess,
+                  el::engine::Feature::kStorageBuffer16BitAccess,
+                  el::engine::Feature::kShaderInt64,
+                  el::engine::Feature::kTextureCompressionBC,
+                  el::engine::Feature::kHostQueryReset,
+              })
+              .set_dimensions_cb([&window]() -> el::Dimensions {
+                return window->dimensions();
+              })
+              .set_surface_cb([&window, window_ready](el::engine::Device& d) {
+                window_ready.get();
+                window->create_surface(d);
+              }));
+    });
+
+    try {
+      startup.time("window/create", [&] {
+        window.emplace(el::WindowConfig()
+                           .set_title("Elysian")
+                           .set_dimensions({.width = kDefaultWidth,
+                                            .height = kDefaultHeight})
+                           .set_event_service(&event_service));
+      });
+      window_created.set_value();
+    } catch (...) {
+      // Fails the device's surface creation instead of leaving it waiting.
+      window_created.set_exception(std::current_exception());
+      throw;
+    }
+
+    auto device = device_created.get();
+
+    el::JobSystem jobs;
+    auto pipelines = startup.time("pipeline_registry/create", [&] {
+      return std::make_unique<el::engine::PipelineRegistry>(
+          el::engine::PipelineRegistryConfig(device.get(), &jobs)
+              .set_cache_path(kPipelineCachePath)
+              .set_initial_cache(pipeline_cache.get()));
+    });
+
+    auto swapchain = startup.time("swapchain/create", [&device] {
+      return std::make_unique<el::engine::Swapchain>(device.get());
+    });
     event_service.add(el::EventType::kResized,
                       [&swapchain, &device](const el::Event* /*evt*/) -> void {
-                        swapchain =
-                            std::make_unique<el::engine::Swapchain>(&device);
+                        swapchain = std::make_unique<el::engine::Swapchain>(
+                            device.get(), swapchain.get());
                       });
 
-    while (!window.shouldClose()) {
+    bool started = false;
+    while (!window->shouldClose()) {
       el::Window::Poll();
+      device->begin_frame();
+
+      if (!started) {
+        started = true;
+        startup.finish();
+        std::cerr << "Startup:\n" << startup.report();
+      }
     }
   } catch (const std::exception& e) {
     std::cerr << "Exception: " << e.what() << std::endl;
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "src/math/batch.h"
+#include "src/math/geometry.h"
+#include "src/math/mat.h"
+#include "src/math/quat.h"
+#include "src/math/vec.h"
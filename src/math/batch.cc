@@ -0,0 +1,182 @@
+#include "src/math/batch.h"
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+
+#include "src/math/simd.h"
+
+namespace el::math {
+namespace {
+
+using TransformFn = void (*)(const Mat4& m,
+                             std::span<const Vec4> in,
+                             std::span<Vec4> out);
+using PointsFn = void (*)(const Mat4& m,
+                          std::span<const Vec3> in,
+                          std::span<Vec3> out);
+
+auto check_sizes(size_t in, size_t out) -> void {
+  if (in != out) {
+    throw std::runtime_error("Batch output size does not match its input");
+  }
+}
+
+// A run of matrices as a run of their columns.
+auto columns(std::span<const Mat4> m) -> std::span<const Vec4> {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return {reinterpret_cast<const Vec4*>(m.data()), m.size() * 4};
+}
+auto columns(std::span<Mat4> m) -> std::span<Vec4> {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return {reinterpret_cast<Vec4*>(m.data()), m.size() * 4};
+}
+
+auto transform_x4(const Mat4& m,
+                  std::span<const Vec4> in,
+                  std::span<Vec4> out) -> void {
+  auto c0 = simd::load(m[0].array());
+  auto c1 = simd::load(m[1].array());
+  auto c2 = simd::load(m[2].array());
+  auto c3 = simd::load(m[3].array());
+  for (size_t i = 0; i < in.size(); ++i) {
+    auto v = simd::load(in[i].array());
+    auto r = simd::mul(c0, simd::lane<0>(v));
+    r = simd::madd(c1, simd::lane<1>(v), r);
+    r = simd::madd(c2, simd::lane<2>(v), r);
+    r = simd::madd(c3, simd::lane<3>(v), r);
+    out[i] = Vec4::from(simd::store(r));
+  }
+}
+
+auto transform_points_x4(const Mat4& m,
+                         std::span<const Vec3> in,
+                         std::span<Vec3> out) -> void {
+  auto c0 = simd::load(m[0].array());
+  auto c1 = simd::load(m[1].array());
+  auto c2 = simd::load(m[2].array());
+  auto c3 = simd::load(m[3].array());
+  for (size_t i = 0; i < in.size(); ++i) {
+    const auto& p = in[i];
+    auto r = simd::madd(c0, simd::splat(p.x),
+                        simd::madd(c1, simd::splat(p.y),
+                                   simd::madd(c2, simd::splat(p.z), c3)));
+    out[i] = Vec4::from(simd::store(r)).xyz();
+  }
+}
+
+#if defined(__x86_64__)
+
+// Each 256 bit register holds two vectors, with the matrix columns repeated
+// in both halves and each half broadcasting its own vector's components.
+__attribute__((target("avx2,fma"))) auto broadcast(const Vec4& column)
+    -> __m256 {
+  auto c = _mm_loadu_ps(&column.x);
+  return _mm256_set_m128(c, c);
+}
+
+__attribute__((target("avx2,fma"))) auto transform_x8(
+    const Mat4& m,
+    std::span<const Vec4> in,
+    std::span<Vec4> out) -> void {
+  auto c0 = broadcast(m[0]);
+  auto c1 = broadcast(m[1]);
+  auto c2 = broadcast(m[2]);
+  auto c3 = broadcast(m[3]);
+
+  size_t i = 0;
+  for (; i + 2 <= in.size(); i += 2) {
+    auto v = _mm256_loadu_ps(&in[i].x);
+    auto r = _mm256_mul_ps(c0, _mm256_permute_ps(v, 0x00));
+    r = _mm256_fmadd_ps(c1, _mm256_permute_ps(v, 0x55), r);
+    r = _mm256_fmadd_ps(c2, _mm256_permute_ps(v, 0xaa), r);
+    r = _mm256_fmadd_ps(c3, _mm256_permute_ps(v, 0xff), r);
+    _mm256_storeu_ps(&out[i].x, r);
+  }
+  transform_x4(m, in.subspan(i), out.subspan(i));
+}
+
+__attribute__((target("avx2,fma"))) auto transform_points_x8(
+    const Mat4& m,
+    std::span<const Vec3> in,
+    std::span<Vec3> out) -> void {
+  auto c0 = broadcast(m[0]);
+  auto c1 = broadcast(m[1]);
+  auto c2 = broadcast(m[2]);
+  auto c3 = broadcast(m[3]);
+
+  size_t i = 0;
+  for (; i + 2 <= in.size(); i += 2) {
+    const auto& a = in[i];
+    const auto& b = in[i + 1];
+    auto r = _mm256_fmadd_ps(
+        c0, _mm256_setr_ps(a.x, a.x, a.x, a.x, b.x, b.x, b.x, b.x),
+        _mm256_fmadd_ps(
+            c1, _mm256_setr_ps(a.y, a.y, a.y, a.y, b.y, b.y, b.y, b.y),
+            _mm256_fmadd_ps(
+                c2, _mm256_setr_ps(a.z, a.z, a.z, a.z, b.z, b.z, b.z, b.z),
+                c3)));
+    std::array<float, 8> result = {};
+    _mm256_storeu_ps(result.data(), r);
+    out[i] = {result[0], result[1], result[2]};
+    out[i + 1] = {result[4], result[5], result[6]};
+  }
+  transform_points_x4(m, in.subspan(i), out.subspan(i));
+}
+
+#endif
+
+auto transform_kernel() -> TransformFn {
+#if defined(__x86_64__)
+  static const TransformFn kernel =
+      simd::has_avx2() ? transform_x8 : transform_x4;
+  return kernel;
+#else
+  return transform_x4;
+#endif
+}
+
+auto points_kernel() -> PointsFn {
+#if defined(__x86_64__)
+  static const PointsFn kernel =
+      simd::has_avx2() ? transform_points_x8 : transform_points_x4;
+  return kernel;
+#else
+  return transform_points_x4;
+#endif
+}
+
+}  // namespace
+
+auto transform(const Mat4& m, std::span<const Vec4> in, std::span<Vec4> out)
+    -> void {
+  check_sizes(in.size(), out.size());
+  transform_kernel()(m, in, out);
+}
+
+auto transform_points(const Mat4& m,
+                      std::span<const Vec3> in,
+                      std::span<Vec3> out) -> void {
+  check_sizes(in.size(), out.size());
+  points_kernel()(m, in, out);
+}
+
+auto multiply(const Mat4& a, std::span<const Mat4> b, std::span<Mat4> out)
+    -> void {
+  check_sizes(b.size(), out.size());
+  // Every column of every b[i] is transformed by |a|.
+  transform_kernel()(a, columns(b), columns(out));
+}
+
+auto multiply(std::span<const Mat4> a,
+              std::span<const Mat4> b,
+              std::span<Mat4> out) -> void {
+  check_sizes(a.size(), out.size());
+  check_sizes(b.size(), out.size());
+  auto kernel = transform_kernel();
+  for (size_t i = 0; i < a.size(); ++i) {
+    kernel(a[i], columns(b.subspan(i, 1)), columns(out.subspan(i, 1)));
+  }
+}
+
+}  // namespace el::math
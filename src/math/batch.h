@@ -0,0 +1,31 @@
+#pragma once
+
+#include <span>
+
+#include "src/math/mat.h"
+#include "src/math/vec.h"
+
+// Kernels over arrays of vectors and matrices. They use AVX2 and FMA, two
+// vectors or matrix columns per instruction, when the CPU has them and
+// SSE2 or NEON otherwise. Each throws if |out| isn't the size of the input.
+namespace el::math {
+
+// out[i] = m * in[i].
+auto transform(const Mat4& m, std::span<const Vec4> in, std::span<Vec4> out)
+    -> void;
+
+// out[i] = transform_point(m, in[i]).
+auto transform_points(const Mat4& m,
+                      std::span<const Vec3> in,
+                      std::span<Vec3> out) -> void;
+
+// out[i] = a * b[i], such as a parent transform applied to its children.
+auto multiply(const Mat4& a, std::span<const Mat4> b, std::span<Mat4> out)
+    -> void;
+
+// out[i] = a[i] * b[i].
+auto multiply(std::span<const Mat4> a,
+              std::span<const Mat4> b,
+              std::span<Mat4> out) -> void;
+
+}  // namespace el::math
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "src/math/mat.h"
+#include "src/math/vec.h"
+
+namespace el::math {
+
+struct Sphere {
+  Vec3 center;
+  float radius = 0.0F;
+
+  [[nodiscard]] constexpr auto array() const -> std::array<float, 4> {
+    return {center.x, center.y, center.z, radius};
+  }
+};
+
+struct Aabb {
+  Vec3 min;
+  Vec3 max;
+
+  [[nodiscard]] constexpr auto center() const -> Vec3 {
+    return (min + max) * 0.5F;
+  }
+  // Half the size along each axis.
+  [[nodiscard]] constexpr auto extent() const -> Vec3 {
+    return (max - min) * 0.5F;
+  }
+};
+
+constexpr auto merge(const Aabb& a, const Aabb& b) -> Aabb {
+  return {min(a.min, b.min), max(a.max, b.max)};
+}
+
+// Bounds of |box| after an affine transform, projecting the extent onto each
+// axis rather than transforming all eight corners.
+constexpr auto transform(const Mat4& m, const Aabb& box) -> Aabb {
+  auto center = transform_point(m, box.center());
+  auto e = box.extent();
+  auto l = linear(m);
+  auto extent = abs(l[0]) * e.x + abs(l[1]) * e.y + abs(l[2]) * e.z;
+  return {center - extent, center + extent};
+}
+
+// Points p with dot(normal, p) + distance >= 0 are in front of the plane.
+// Laid out as a GLSL vec4, xyz normal and w distance.
+struct Plane {
+  Vec3 normal;
+  float distance = 0.0F;
+
+  [[nodiscard]] constexpr auto signed_distance(const Vec3& p) const -> float {
+    return dot(normal, p) + distance;
+  }
+};
+
+static_assert(sizeof(Plane) == 16);
+
+// Scales |p| to a unit normal, so signed distances are in world units.
+inline auto normalize(const Plane& p) -> Plane {
+  auto l = length(p.normal);
+  return l > 0.0F ? Plane{p.normal / l, p.distance / l} : p;
+}
+
+// Six planes bounding the view volume, in the order left, right, bottom,
+// top, near, far, with normals pointing inwards.
+struct Frustum {
+  std::array<Plane, 6> planes = {};
+
+  // Extracts the planes from a view projection matrix using Vulkan's [0, 1]
+  // depth range, Gribb and Hartmann's method. The planes are normalized.
+  [[nodiscard]] static auto from_matrix(const Mat4& m) -> Frustum {
+    auto plane = [](const Vec4& v) {
+      return normalize(Plane{v.xyz(), v.w});
+    };
+
+    // The rows of |m|.
+    auto t = transpose(m);
+    const auto& x = t[0];
+    const auto& y = t[1];
+    const auto& z = t[2];
+    const auto& w = t[3];
+    return {{plane(w + x), plane(w - x), plane(w + y), plane(w - y), plane(z),
+             plane(w - z)}};
+  }
+
+  // Whether |sphere| is at least partly inside.
+  [[nodiscard]] constexpr auto intersects(const Sphere& sphere) const -> bool {
+    return std::all_of(std::begin(planes), std::end(planes),
+                       [&sphere](const Plane& p) {
+                         return p.signed_distance(sphere.center) >=
+                                -sphere.radius;
+                       });
+  }
+
+  // Whether |box| is at least partly inside. Conservative, a box just outside
+  // a corner of the frustum but not entirely behind any one plane passes.
+  [[nodiscard]] constexpr auto intersects(const Aabb& box) const -> bool {
+    auto center = box.center();
+    auto e = box.extent();
+    return std::all_of(
+        std::begin(planes), std::end(planes), [&center, &e](const Plane& p) {
+          return p.signed_distance(center) >= -dot(abs(p.normal), e);
+        });
+  }
+};
+
+}  // namespace el::math
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#include "src/math/simd.h"
+#include "src/math/vec.h"
+
+namespace el::math {
+
+// Column major, as GLSL expects, so columns[c] is the c-th column and
+// vectors multiply on the right.
+struct Mat3 {
+  std::array<Vec3, 3> columns = {};
+
+  [[nodiscard]] static constexpr auto identity() -> Mat3 {
+    return {{Vec3{1, 0, 0}, Vec3{0, 1, 0}, Vec3{0, 0, 1}}};
+  }
+
+  constexpr auto operator[](size_t c) -> Vec3& { return columns.at(c); }
+  constexpr auto operator[](size_t c) const -> const Vec3& {
+    return columns.at(c);
+  }
+
+  constexpr auto operator==(const Mat3&) const -> bool = default;
+};
+
+struct Mat4 {
+  std::array<Vec4, 4> columns = {};
+
+  [[nodiscard]] static constexpr auto identity() -> Mat4 {
+    return {{Vec4{1, 0, 0, 0}, Vec4{0, 1, 0, 0}, Vec4{0, 0, 1, 0},
+             Vec4{0, 0, 0, 1}}};
+  }
+
+  constexpr auto operator[](size_t c) -> Vec4& { return columns.at(c); }
+  constexpr auto operator[](size_t c) const -> const Vec4& {
+    return columns.at(c);
+  }
+
+  constexpr auto operator==(const Mat4&) const -> bool = default;
+};
+
+static_assert(sizeof(Mat4) == 64);
+
+constexpr auto operator*(const Mat3& m, const Vec3& v) -> Vec3 {
+  return m[0] * v.x + m[1] * v.y + m[2] * v.z;
+}
+
+constexpr auto operator*(const Mat3& a, const Mat3& b) -> Mat3 {
+  return {{a * b[0], a * b[1], a * b[2]}};
+}
+
+constexpr auto operator*(const Mat4& m, const Vec4& v) -> Vec4 {
+  if (std::is_constant_evaluated()) {
+    return m[0] * v.x + m[1] * v.y + m[2] * v.z + m[3] * v.w;
+  }
+  auto x = simd::load(v.array());
+  auto r = simd::mul(simd::load(m[0].array()), simd::lane<0>(x));
+  r = simd::madd(simd::load(m[1].array()), simd::lane<1>(x), r);
+  r = simd::madd(simd::load(m[2].array()), simd::lane<2>(x), r);
+  r = simd::madd(simd::load(m[3].array()), simd::lane<3>(x), r);
+  return Vec4::from(simd::store(r));
+}
+
+constexpr auto operator*(const Mat4& a, const Mat4& b) -> Mat4 {
+  return {{a * b[0], a * b[1], a * b[2], a * b[3]}};
+}
+
+// |p| with w = 1, without the perspective divide.
+constexpr auto transform_point(const Mat4& m, const Vec3& p) -> Vec3 {
+  return (m * extend(p, 1.0F)).xyz();
+}
+
+// |v| with w = 0, ignoring translation.
+constexpr auto transform_vector(const Mat4& m, const Vec3& v) -> Vec3 {
+  return (m * extend(v, 0.0F)).xyz();
+}
+
+constexpr auto transpose(const Mat3& m) -> Mat3 {
+  return {{Vec3{m[0].x, m[1].x, m[2].x}, Vec3{m[0].y, m[1].y, m[2].y},
+           Vec3{m[0].z, m[1].z, m[2].z}}};
+}
+
+constexpr auto transpose(const Mat4& m) -> Mat4 {
+  return {{Vec4{m[0].x, m[1].x, m[2].x, m[3].x},
+           Vec4{m[0].y, m[1].y, m[2].y, m[3].y},
+           Vec4{m[0].z, m[1].z, m[2].z, m[3].z},
+           Vec4{m[0].w, m[1].w, m[2].w, m[3].w}}};
+}
+
+// The upper left 3x3, the rotation and scale of an affine transform.
+constexpr auto linear(const Mat4& m) -> Mat3 {
+  return {{m[0].xyz(), m[1].xyz(), m[2].xyz()}};
+}
+
+constexpr auto determinant(const Mat3& m) -> float {
+  return dot(m[0], cross(m[1], m[2]));
+}
+
+// Inverse by cofactors. Singular matrices give infinities or NaNs.
+constexpr auto inverse(const Mat3& m) -> Mat3 {
+  auto inv_det = 1.0F / determinant(m);
+  return transpose(Mat3{{cross(m[1], m[2]) * inv_det,
+                         cross(m[2], m[0]) * inv_det,
+                         cross(m[0], m[1]) * inv_det}});
+}
+
+// General 4x4 inverse from the 2x2 sub-determinants of the upper and lower
+// halves. Singular matrices give infinities or NaNs.
+constexpr auto inverse(const Mat4& m) -> Mat4 {
+  auto a = m[0].xyz();
+  auto b = m[1].xyz();
+  auto c = m[2].xyz();
+  auto d = m[3].xyz();
+  auto x = m[0].w;
+  auto y = m[1].w;
+  auto z = m[2].w;
+  auto w = m[3].w;
+
+  auto s = cross(a, b);
+  auto t = cross(c, d);
+  auto u = a * y - b * x;
+  auto v = c * w - d * z;
+
+  auto inv_det = 1.0F / (dot(s, v) + dot(t, u));
+  s = s * inv_det;
+  t = t * inv_det;
+  u = u * inv_det;
+  v = v * inv_det;
+
+  auto r0 = cross(b, v) + t * y;
+  auto r1 = cross(v, a) - t * x;
+  auto r2 = cross(d, u) + s * w;
+  auto r3 = cross(u, c) - s * z;
+  return {{Vec4{r0.x, r1.x, r2.x, r3.x}, Vec4{r0.y, r1.y, r2.y, r3.y},
+           Vec4{r0.z, r1.z, r2.z, r3.z},
+           Vec4{-dot(b, t), dot(a, t), -dot(d, s), dot(c, s)}}};
+}
+
+constexpr auto translation(const Vec3& t) -> Mat4 {
+  auto m = Mat4::identity();
+  m[3] = extend(t, 1.0F);
+  return m;
+}
+
+constexpr auto scaling(const Vec3& s) -> Mat4 {
+  return {{Vec4{s.x, 0, 0, 0}, Vec4{0, s.y, 0, 0}, Vec4{0, 0, s.z, 0},
+           Vec4{0, 0, 0, 1}}};
+}
+
+// Right handed perspective projection into Vulkan's clip space, where y
+// points down and depth goes from 0 at |near_z| to 1 at |far_z|.
+inline auto perspective(float fov_y, float aspect, float near_z, float far_z)
+    -> Mat4 {
+  auto f = 1.0F / std::tan(fov_y / 2.0F);
+  Mat4 m;
+  m[0].x = f / aspect;
+  m[1].y = -f;
+  m[2].z = far_z / (near_z - far_z);
+  m[2].w = -1.0F;
+  m[3].z = near_z * far_z / (near_z - far_z);
+  return m;
+}
+
+// Right handed view matrix at |eye| looking towards |target|.
+inline auto look_at(const Vec3& eye, const Vec3& target, const Vec3& up)
+    -> Mat4 {
+  auto f = normalize(target - eye);
+  auto s = normalize(cross(f, up));
+  auto u = cross(s, f);
+  return {{Vec4{s.x, u.x, -f.x, 0}, Vec4{s.y, u.y, -f.y, 0},
+           Vec4{s.z, u.z, -f.z, 0},
+           Vec4{-dot(s, eye), -dot(u, eye), dot(f, eye), 1}}};
+}
+
+}  // namespace el::math
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cmath>
+
+#include "src/math/mat.h"
+#include "src/math/vec.h"
+
+namespace el::math {
+
+// Unit quaternion rotation, xyz vector part and w scalar part.
+struct Quat {
+  float x = 0.0F;
+  float y = 0.0F;
+  float z = 0.0F;
+  float w = 1.0F;
+
+  [[nodiscard]] static constexpr auto identity() -> Quat { return {}; }
+
+  // Rotation of |radians| around the unit vector |axis|.
+  [[nodiscard]] static auto from_axis_angle(const Vec3& axis, float radians)
+      -> Quat {
+    auto s = std::sin(radians / 2.0F);
+    return {axis.x * s, axis.y * s, axis.z * s, std::cos(radians / 2.0F)};
+  }
+
+  constexpr auto operator==(const Quat&) const -> bool = default;
+};
+
+// Rotation by |b| then by |a|.
+constexpr auto operator*(const Quat& a, const Quat& b) -> Quat {
+  return {a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+          a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+          a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+          a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z};
+}
+
+constexpr auto dot(const Quat& a, const Quat& b) -> float {
+  return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+// The inverse of a unit quaternion.
+constexpr auto conjugate(const Quat& q) -> Quat {
+  return {-q.x, -q.y, -q.z, q.w};
+}
+
+constexpr auto rotate(const Quat& q, const Vec3& v) -> Vec3 {
+  // v + 2w(u x v) + 2u x (u x v), with u the vector part.
+  auto u = Vec3{q.x, q.y, q.z};
+  auto t = cross(u, v) * 2.0F;
+  return v + t * q.w + cross(u, t);
+}
+
+inline auto normalize(const Quat& q) -> Quat {
+  auto l = std::sqrt(dot(q, q));
+  return l > 0.0F ? Quat{q.x / l, q.y / l, q.z / l, q.w / l} : q;
+}
+
+// Spherical interpolation along the shorter arc, falling back to normalized
+// linear interpolation when the two are nearly parallel.
+inline auto slerp(const Quat& a, Quat b, float t) -> Quat {
+  constexpr float kLinearThreshold = 0.9995F;
+
+  auto cos_theta = dot(a, b);
+  if (cos_theta < 0.0F) {
+    b = {-b.x, -b.y, -b.z, -b.w};
+    cos_theta = -cos_theta;
+  }
+
+  auto wa = 1.0F - t;
+  auto wb = t;
+  if (cos_theta < kLinearThreshold) {
+    auto theta = std::acos(cos_theta);
+    auto sin_theta = std::sin(theta);
+    wa = std::sin(wa * theta) / sin_theta;
+    wb = std::sin(wb * theta) / sin_theta;
+  }
+  return normalize(Quat{wa * a.x + wb * b.x, wa * a.y + wb * b.y,
+                        wa * a.z + wb * b.z, wa * a.w + wb * b.w});
+}
+
+constexpr auto to_mat3(const Quat& q) -> Mat3 {
+  auto xx = q.x * q.x;
+  auto yy = q.y * q.y;
+  auto zz = q.z * q.z;
+  auto xy = q.x * q.y;
+  auto xz = q.x * q.z;
+  auto yz = q.y * q.z;
+  auto wx = q.w * q.x;
+  auto wy = q.w * q.y;
+  auto wz = q.w * q.z;
+  return {{Vec3{1 - 2 * (yy + zz), 2 * (xy + wz), 2 * (xz - wy)},
+           Vec3{2 * (xy - wz), 1 - 2 * (xx + zz), 2 * (yz + wx)},
+           Vec3{2 * (xz + wy), 2 * (yz - wx), 1 - 2 * (xx + yy)}}};
+}
+
+// Translation * rotation * scale, the usual local to parent transform.
+constexpr auto compose(const Vec3& translation,
+                       const Quat& rotation,
+                       const Vec3& scale) -> Mat4 {
+  auto r = to_mat3(rotation);
+  return {{extend(r[0] * scale.x, 0.0F), extend(r[1] * scale.y, 0.0F),
+           extend(r[2] * scale.z, 0.0F), extend(translation, 1.0F)}};
+}
+
+}  // namespace el::math
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// Thin four lane float wrapper over SSE2 on x86-64 and NEON on AArch64, with
+// a scalar fallback elsewhere. Only used at runtime, constexpr code paths in
+// the math types stay scalar.
+namespace el::math::simd {
+
+#if defined(__x86_64__)
+using F32x4 = __m128;
+
+inline auto load(const std::array<float, 4>& v) -> F32x4 {
+  return _mm_loadu_ps(v.data());
+}
+inline auto store(F32x4 v) -> std::array<float, 4> {
+  std::array<float, 4> out;
+  _mm_storeu_ps(out.data(), v);
+  return out;
+}
+inline auto splat(float v) -> F32x4 {
+  return _mm_set1_ps(v);
+}
+inline auto add(F32x4 a, F32x4 b) -> F32x4 {
+  return _mm_add_ps(a, b);
+}
+inline auto mul(F32x4 a, F32x4 b) -> F32x4 {
+  return _mm_mul_ps(a, b);
+}
+// a * b + c. SSE2 has no FMA, so this rounds twice.
+inline auto madd(F32x4 a, F32x4 b, F32x4 c) -> F32x4 {
+  return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+template <int kLane>
+inline auto lane(F32x4 v) -> F32x4 {
+  return _mm_shuffle_ps(v, v, _MM_SHUFFLE(kLane, kLane, kLane, kLane));
+}
+
+// Whether the AVX2 and FMA batch kernels can run on this CPU.
+inline auto has_avx2() -> bool {
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+#elif defined(__aarch64__)
+using F32x4 = float32x4_t;
+
+inline auto load(const std::array<float, 4>& v) -> F32x4 {
+  return vld1q_f32(v.data());
+}
+inline auto store(F32x4 v) -> std::array<float, 4> {
+  std::array<float, 4> out;
+  vst1q_f32(out.data(), v);
+  return out;
+}
+inline auto splat(float v) -> F32x4 {
+  return vdupq_n_f32(v);
+}
+inline auto add(F32x4 a, F32x4 b) -> F32x4 {
+  return vaddq_f32(a, b);
+}
+inline auto mul(F32x4 a, F32x4 b) -> F32x4 {
+  return vmulq_f32(a, b);
+}
+inline auto madd(F32x4 a, F32x4 b, F32x4 c) -> F32x4 {
+  return vfmaq_f32(c, a, b);
+}
+template <int kLane>
+inline auto lane(F32x4 v) -> F32x4 {
+  return vdupq_laneq_f32(v, kLane);
+}
+
+#else
+using F32x4 = std::array<float, 4>;
+
+inline auto load(const std::array<float, 4>& v) -> F32x4 {
+  return v;
+}
+inline auto store(F32x4 v) -> std::array<float, 4> {
+  return v;
+}
+inline auto splat(float v) -> F32x4 {
+  return {v, v, v, v};
+}
+inline auto add(F32x4 a, F32x4 b) -> F32x4 {
+  return {a[0] + b[0], a[1] + b[1], a[2] + b[2], a[3] + b[3]};
+}
+inline auto mul(F32x4 a, F32x4 b) -> F32x4 {
+  return {a[0] * b[0], a[1] * b[1], a[2] * b[2], a[3] * b[3]};
+}
+inline auto madd(F32x4 a, F32x4 b, F32x4 c) -> F32x4 {
+  return add(mul(a, b), c);
+}
+template <int kLane>
+inline auto lane(F32x4 v) -> F32x4 {
+  return splat(v[kLane]);
+}
+#endif
+
+}  // namespace el::math::simd
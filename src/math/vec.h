@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <concepts>
+
+namespace el::math {
+
+// Vectors are plain aggregates with constexpr operators, usable for compile
+// time constants. Vec4 is 16 byte aligned to match GLSL's vec4 and to load
+// into one SIMD register.
+
+struct Vec2 {
+  float x = 0.0F;
+  float y = 0.0F;
+
+  constexpr auto operator==(const Vec2&) const -> bool = default;
+};
+
+struct Vec3 {
+  float x = 0.0F;
+  float y = 0.0F;
+  float z = 0.0F;
+
+  constexpr auto operator==(const Vec3&) const -> bool = default;
+};
+
+struct alignas(16) Vec4 {
+  float x = 0.0F;
+  float y = 0.0F;
+  float z = 0.0F;
+  float w = 0.0F;
+
+  [[nodiscard]] constexpr auto xyz() const -> Vec3 { return {x, y, z}; }
+
+  [[nodiscard]] constexpr auto array() const -> std::array<float, 4> {
+    return {x, y, z, w};
+  }
+  [[nodiscard]] static constexpr auto from(const std::array<float, 4>& a)
+      -> Vec4 {
+    return {a[0], a[1], a[2], a[3]};
+  }
+
+  constexpr auto operator==(const Vec4&) const -> bool = default;
+};
+
+constexpr auto extend(const Vec3& v, float w) -> Vec4 {
+  return {v.x, v.y, v.z, w};
+}
+
+static_assert(sizeof(Vec3) == 12);
+static_assert(sizeof(Vec4) == 16);
+
+template <typename T>
+concept Vector =
+    std::same_as<T, Vec2> || std::same_as<T, Vec3> || std::same_as<T, Vec4>;
+
+constexpr auto apply(const Vec2& a, const Vec2& b, auto fn) -> Vec2 {
+  return {fn(a.x, b.x), fn(a.y, b.y)};
+}
+constexpr auto apply(const Vec3& a, const Vec3& b, auto fn) -> Vec3 {
+  return {fn(a.x, b.x), fn(a.y, b.y), fn(a.z, b.z)};
+}
+constexpr auto apply(const Vec4& a, const Vec4& b, auto fn) -> Vec4 {
+  return {fn(a.x, b.x), fn(a.y, b.y), fn(a.z, b.z), fn(a.w, b.w)};
+}
+
+template <Vector T>
+constexpr auto operator+(const T& a, const T& b) -> T {
+  return apply(a, b, [](float l, float r) { return l + r; });
+}
+template <Vector T>
+constexpr auto operator-(const T& a, const T& b) -> T {
+  return apply(a, b, [](float l, float r) { return l - r; });
+}
+template <Vector T>
+constexpr auto operator*(const T& a, const T& b) -> T {
+  return apply(a, b, [](float l, float r) { return l * r; });
+}
+template <Vector T>
+constexpr auto operator*(const T& a, float s) -> T {
+  return apply(a, a, [s](float l, float /*r*/) { return l * s; });
+}
+template <Vector T>
+constexpr auto operator*(float s, const T& a) -> T {
+  return a * s;
+}
+template <Vector T>
+constexpr auto operator/(const T& a, float s) -> T {
+  return a * (1.0F / s);
+}
+template <Vector T>
+constexpr auto operator-(const T& a) -> T {
+  return a * -1.0F;
+}
+
+constexpr auto dot(const Vec2& a, const Vec2& b) -> float {
+  return a.x * b.x + a.y * b.y;
+}
+constexpr auto dot(const Vec3& a, const Vec3& b) -> float {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+constexpr auto dot(const Vec4& a, const Vec4& b) -> float {
+  return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+constexpr auto cross(const Vec3& a, const Vec3& b) -> Vec3 {
+  return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+constexpr auto min(const Vec3& a, const Vec3& b) -> Vec3 {
+  return apply(a, b, [](float l, float r) { return l < r ? l : r; });
+}
+constexpr auto max(const Vec3& a, const Vec3& b) -> Vec3 {
+  return apply(a, b, [](float l, float r) { return l < r ? r : l; });
+}
+constexpr auto abs(const Vec3& a) -> Vec3 {
+  return apply(a, a, [](float l, float /*r*/) { return l < 0 ? -l : l; });
+}
+
+template <Vector T>
+constexpr auto lerp(const T& a, const T& b, float t) -> T {
+  return a + (b - a) * t;
+}
+
+template <Vector T>
+auto length(const T& v) -> float {
+  return std::sqrt(dot(v, v));
+}
+
+// Zero length vectors are returned as is.
+template <Vector T>
+auto normalize(const T& v) -> T {
+  auto l = length(v);
+  return l > 0.0F ? v / l : v;
+}
+
+}  // namespace el::math
@@ -0,0 +1,62 @@
+// Clustered point lighting for fragment shaders, reading what
+// light_cull.comp binned. Include it after defining CLUSTER_SET as the index
+// of the set ClusteredLights::set() is bound to; glslc needs
+// GL_GOOGLE_include_directive enabled.
+
+struct ClusterLight {
+  vec3 position;
+  float radius;
+  vec3 color;
+  float intensity;
+};
+
+layout(std430, set = CLUSTER_SET, binding = 0) readonly buffer ClusterLights {
+  ClusterLight cluster_lights[];
+};
+
+layout(std430, set = CLUSTER_SET, binding = 1) readonly buffer Clusters {
+  uvec2 clusters[];
+};
+
+layout(std430, set = CLUSTER_SET, binding = 2) readonly buffer
+    ClusterIndices {
+  uint cluster_light_indices[];
+};
+
+layout(std430, set = CLUSTER_SET, binding = 3) readonly buffer ClusterInfo {
+  uint cluster_index_count;
+  float cluster_slice_scale;
+  vec2 cluster_tile_scale;
+  float cluster_slice_bias;
+};
+
+const uvec3 kClusterGrid = uvec3(16, 9, 24);
+
+// Offset into cluster_light_indices and light count of the cluster holding
+// the fragment at |frag_coord|, |view_depth| in front of the camera.
+uvec2 cluster_lights_at(vec2 frag_coord, float view_depth) {
+  uvec2 tile = min(uvec2(frag_coord * cluster_tile_scale), kClusterGrid.xy - 1);
+  float slice = log(max(view_depth, 1e-4)) * cluster_slice_scale +
+                cluster_slice_bias;
+  uint z = uint(clamp(slice, 0.0, float(kClusterGrid.z - 1)));
+  return clusters[(z * kClusterGrid.y + tile.y) * kClusterGrid.x + tile.x];
+}
+
+// Diffuse light reaching |position|, with |normal|, from the lights of its
+// cluster. Each light fades out smoothly towards its radius.
+vec3 clustered_diffuse(vec3 position, vec3 normal, vec2 frag_coord,
+                       float view_depth) {
+  uvec2 range = cluster_lights_at(frag_coord, view_depth);
+  vec3 total = vec3(0.0);
+  for (uint i = 0; i < range.y; ++i) {
+    ClusterLight light = cluster_lights[cluster_light_indices[range.x + i]];
+    vec3 to_light = light.position - position;
+    float dist_sq = dot(to_light, to_light);
+    float ratio = dist_sq / (light.radius * light.radius);
+    float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+    float falloff = window * window / max(dist_sq, 1e-4);
+    float lambert = max(dot(normal, to_light * inversesqrt(dist_sq)), 0.0);
+    total += light.color * light.intensity * lambert * falloff;
+  }
+  return total;
+}
@@ -0,0 +1,15 @@
+#version 460
+
+// A soft disc, premultiplied for additive blending.
+
+layout(location = 0) in vec4 color;
+layout(location = 1) in vec2 corner;
+layout(location = 0) out vec4 frag_color;
+
+void main() {
+  float falloff = 1.0 - dot(corner, corner);
+  if (falloff <= 0.0) {
+    discard;
+  }
+  frag_color = vec4(color.rgb * color.a * falloff, 0);
+}
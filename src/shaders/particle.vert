@@ -0,0 +1,31 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+// Camera facing quads for the live particles, drawn from six vertices per
+// instance without vertex buffers by ParticleSystem::record_draw(). The push
+// constants match ParticleSystem's draw parameters.
+
+#define PARTICLE_SET 0
+#define PARTICLE_ACCESS readonly
+#include "particles.glsl"
+
+layout(push_constant) uniform View {
+  mat4 view_projection;
+  vec4 camera_right;
+  vec4 camera_up;
+};
+
+layout(location = 0) out vec4 color;
+layout(location = 1) out vec2 corner;
+
+const vec2 kCorners[6] = vec2[](vec2(-1, -1), vec2(1, -1), vec2(1, 1),
+                                vec2(-1, -1), vec2(1, 1), vec2(-1, 1));
+
+void main() {
+  Particle p = particles[alive[gl_InstanceIndex]];
+  corner = kCorners[gl_VertexIndex];
+  vec3 offset = camera_right.xyz * corner.x + camera_up.xyz * corner.y;
+  gl_Position = view_projection * vec4(p.position + offset * p.size, 1);
+  color = unpackUnorm4x8(p.color);
+  color.a *= 1.0 - p.age / p.lifetime;
+}
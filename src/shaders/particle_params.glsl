@@ -0,0 +1,19 @@
+// Push constants of the particle compute stages, matching ParticleSystem's.
+
+layout(push_constant) uniform Params {
+  // xyz position and w radius of the emitter sphere.
+  vec4 emitter;
+  // xyz initial velocity and w random jitter added to it.
+  vec4 emit_velocity;
+  vec4 emit_color;
+  // xyz acceleration and w drag.
+  vec4 gravity;
+  float dt;
+  float lifetime;
+  float size;
+  uint emit_count;
+  uint seed;
+  // Alive list simulated this frame, 0 or 1.
+  uint list;
+  uint capacity;
+};
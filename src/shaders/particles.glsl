@@ -0,0 +1,51 @@
+// Particle storage shared by the particle compute stages and particle.vert.
+// Include it after defining PARTICLE_SET as the index of the set
+// ParticleSystem::set() is bound to, and PARTICLE_ACCESS as readonly from
+// graphics stages; glslc needs GL_GOOGLE_include_directive enabled.
+// Layouts match el::engine::ParticleSystem.
+
+#ifndef PARTICLE_ACCESS
+#define PARTICLE_ACCESS
+#endif
+
+struct Particle {
+  vec3 position;
+  float age;
+  vec3 velocity;
+  float lifetime;
+  // packUnorm4x8 of the color at birth.
+  uint color;
+  float size;
+  uvec2 unused;
+};
+
+layout(std430, set = PARTICLE_SET, binding = 0) PARTICLE_ACCESS buffer
+    Particles {
+  Particle particles[];
+};
+
+// Indices of free particles, a stack of dead_count entries.
+layout(std430, set = PARTICLE_SET, binding = 1) PARTICLE_ACCESS buffer Dead {
+  uint dead[];
+};
+
+// Two lists of live particle indices, capacity entries each. Simulation
+// reads one and compacts the survivors into the other.
+layout(std430, set = PARTICLE_SET, binding = 2) PARTICLE_ACCESS buffer Alive {
+  uint alive[];
+};
+
+layout(std430, set = PARTICLE_SET, binding = 3) PARTICLE_ACCESS buffer State {
+  uint dead_count;
+  // Top of the dead list while simulation pushes onto it.
+  uint dead_top;
+  uint alive_count;
+  // Survivors compacted so far.
+  uint alive_next;
+  // VkDispatchIndirectCommand for the simulate stage.
+  uvec3 simulate_groups;
+  uint state_unused;
+  // VkDrawIndirectCommand: vertex count, instance count, first vertex and
+  // first instance.
+  uvec4 draw;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace el {
+
+struct StartupPhase {
+  std::string name;
+  // Milliseconds since the timer was created.
+  double start_ms = 0;
+  double end_ms = 0;
+};
+
+// Records how long each step of startup takes, and when, relative to the
+// timer's creation. Phases may run concurrently on several threads, so
+// overlapped work shows up as overlapping ranges.
+class StartupTimer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  StartupTimer() = default;
+  StartupTimer(const StartupTimer&) = delete;
+  StartupTimer(StartupTimer&&) = delete;
+  ~StartupTimer() = default;
+
+  auto operator=(const StartupTimer&) -> StartupTimer& = delete;
+  auto operator=(StartupTimer&&) -> StartupTimer& = delete;
+
+  // Runs |fn| and records it as |name|. Safe to call from any thread.
+  template <typename Fn>
+  auto time(std::string_view name, Fn&& fn) -> decltype(fn()) {
+    auto start = Clock::now();
+    if constexpr (std::is_void_v<decltype(fn())>) {
+      std::forward<Fn>(fn)();
+      record(name, start, Clock::now());
+    } else {
+      auto result = std::forward<Fn>(fn)();
+      record(name, start, Clock::now());
+      return result;
+    }
+  }
+
+  auto record(std::string_view name,
+              Clock::time_point start,
+              Clock::time_point end) -> void {
+    const std::lock_guard<std::mutex> lock(lock_);
+    phases_.push_back({
+        .name = std::string(name),
+        .start_ms = ms(start),
+        .end_ms = ms(end),
+    });
+  }
+
+  // Marks the end of startup, such as the first presented frame.
+  auto finish() -> void {
+    const std::lock_guard<std::mutex> lock(lock_);
+    total_ms_ = ms(Clock::now());
+  }
+
+  [[nodiscard]] auto total_ms() const -> double {
+    const std::lock_guard<std::mutex> lock(lock_);
+    return total_ms_;
+  }
+
+  // Ordered by start.
+  [[nodiscard]] auto phases() const -> std::vector<StartupPhase> {
+    const std::lock_guard<std::mutex> lock(lock_);
+    auto phases = phases_;
+    std::stable_sort(std::begin(phases), std::end(phases),
+                     [](const StartupPhase& a, const StartupPhase& b) {
+                       return a.start_ms < b.start_ms;
+                     });
+    return phases;
+  }
+
+  // One line per phase with its start, end and duration.
+  [[nodiscard]] auto report() const -> std::string {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    for (const auto& phase : phases()) {
+      out << std::left << std::setw(32) << phase.name << std::right
+          << std::setw(9) << phase.start_ms << " - " << std::setw(9)
+          << phase.end_ms << " ms" << std::setw(10)
+          << phase.end_ms - phase.start_ms << " ms\n";
+    }
+    out << std::left << std::setw(32) << "total" << std::right << std::setw(9)
+        << total_ms() << " ms\n";
+    return out.str();
+  }
+
+ private:
+  [[nodiscard]] auto ms(Clock::time_point t) const -> double {
+    return std::chrono::duration<double, std::milli>(t - origin_).count();
+  }
+
+  Clock::time_point origin_ = Clock::now();
+  std::vector<StartupPhase> phases_;
+  double total_ms_ = 0;
+  mutable std::mutex lock_;
+};
+
+}  // namespace el
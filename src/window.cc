@@ -13,22 +13,20 @@
 #include "src/glfw3.h"
 
 namespace el {
+namespace {
+
+// Windows are only created and destroyed on the main thread.
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+uint32_t live_windows = 0;
+
+}  // namespace
 
 Window::Window(const WindowConfig& config)
     : event_service_(config.event_service()) {
   // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
   assert(event_service_ != nullptr);
 
-  glfwSetErrorCallback([](int error, const char* desc) {
-    std::cerr << "Err: " << error << ": " << desc << std::endl;
-  });
-
-  if (glfwInit() == 0) {
-    throw std::runtime_error("GLFW initialization failed.");
-  }
-  if (glfwVulkanSupported() == 0) {
-    throw std::runtime_error("GLFW vulkan support missing.");
-  }
+  Init();
   glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
   window_ = glfwCreateWindow(static_cast<int>(config.width()),
@@ -37,19 +35,39 @@ Window::Window(const WindowConfig& config)
   if (window_ == nullptr) {
     throw std::runtime_error("GLFW window creation failed.");
   }
+  ++live_windows;
 
   glfwSetWindowUserPointer(window_, this);
   glfwSetFramebufferSizeCallback(
       window_, [](GLFWwindow* win, int /*width*/, int /*height*/) {
         auto* t = static_cast<Window*>(glfwGetWindowUserPointer(win));
         ResizeEvent evt;
+        evt.window = t;
         t->event_service_->emit(EventType::kResized, &evt);
       });
 }
 
 Window::~Window() {
   glfwDestroyWindow(window_);
-  glfwTerminate();
+  // Other windows keep the window system alive.
+  if (--live_windows == 0) {
+    glfwTerminate();
+  }
+}
+
+// static
+auto Window::Init() -> void {
+  glfwSetErrorCallback([](int error, const char* desc) {
+    std::cerr << "Err: " << error << ": " << desc << std::endl;
+  });
+
+  // Initializing again is a no-op.
+  if (glfwInit() == 0) {
+    throw std::runtime_error("GLFW initialization failed.");
+  }
+  if (glfwVulkanSupported() == 0) {
+    throw std::runtime_error("GLFW vulkan support missing.");
+  }
 }
 
 // static
@@ -80,8 +98,8 @@ auto Window::dimensions() const -> Dimensions {
   };
 }
 
-auto Window::create_surface(engine::Device& device) -> void {
-  device.create_surface([&](VkInstance instance) -> VkSurfaceKHR {
+auto Window::create_surface(engine::Device& device) -> VkSurfaceKHR {
+  return device.create_surface([&](VkInstance instance) -> VkSurfaceKHR {
     VkSurfaceKHR surface = {};
 
     auto res =
@@ -53,6 +53,11 @@ class Window {
   auto operator=(const Window&) -> Window& = delete;
   auto operator=(Window&&) -> Window& = delete;
 
+  // Initializes the window system. Windows do this themselves, call it
+  // directly to query required_engine_extensions() before any window
+  // exists.
+  static auto Init() -> void;
+
   // Returned strings are owned by the window system and will be free'd.
   static auto required_engine_extensions() -> std::vector<const char*>;
 
@@ -64,7 +69,10 @@ class Window {
 
   auto static Poll() -> void { glfwPollEvents(); }
 
-  auto create_surface(engine::Device& device) -> void;
+  // The device's primary surface when called from its surface callback,
+  // otherwise an additional one sharing the device. Pass it to a
+  // SwapchainConfig.
+  auto create_surface(engine::Device& device) -> VkSurfaceKHR;
 
  private:
   GLFWwindow* window_ = nullptr;
@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "src/engine/mesh_format.h"
+#include "tools/mesh_convert/obj.h"
+#include "tools/mesh_convert/optimize.h"
+#include "tools/mesh_convert/simplify.h"
+
+namespace {
+
+using el::engine::mesh::Header;
+using el::engine::mesh::Lod;
+using el::engine::mesh::PackedVertex;
+using el::engine::mesh::Submesh;
+using el::tools::SimplifyResult;
+using el::tools::SourceSubmesh;
+using el::tools::Vertex;
+
+constexpr float kUnorm16Max = 65535.0F;
+constexpr float kSnorm16Max = 32767.0F;
+constexpr size_t kReportCacheSize = 16;
+
+struct Range {
+  std::array<float, 3> min = {std::numeric_limits<float>::max(),
+                              std::numeric_limits<float>::max(),
+                              std::numeric_limits<float>::max()};
+  std::array<float, 3> max = {std::numeric_limits<float>::lowest(),
+                              std::numeric_limits<float>::lowest(),
+                              std::numeric_limits<float>::lowest()};
+
+  auto add(std::span<const float> v) -> void {
+    for (size_t i = 0; i < v.size(); ++i) {
+      min[i] = std::min(min[i], v[i]);
+      max[i] = std::max(max[i], v[i]);
+    }
+  }
+
+  [[nodiscard]] auto scale(size_t i) const -> float {
+    return (max[i] - min[i]) / kUnorm16Max;
+  }
+};
+
+auto align_up(uint64_t value, uint64_t alignment) -> uint64_t {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+auto quantize_unorm(float v, float min, float scale) -> uint16_t {
+  if (scale <= 0.0F) {
+    return 0;
+  }
+  return uint16_t(std::clamp(std::round((v - min) / scale), 0.0F, kUnorm16Max));
+}
+
+auto quantize_snorm(float v) -> int16_t {
+  return int16_t(std::round(std::clamp(v, -1.0F, 1.0F) * kSnorm16Max));
+}
+
+// Octahedral mapping: project onto the octahedron |x|+|y|+|z| = 1 and fold
+// the lower hemisphere over the upper one.
+auto encode_octahedral(const std::array<float, 3>& n)
+    -> std::array<int16_t, 2> {
+  float l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+  if (l1 <= 0.0F) {
+    return {0, 0};
+  }
+  float x = n[0] / l1;
+  float y = n[1] / l1;
+  if (n[2] < 0.0F) {
+    float fx = (1.0F - std::abs(y)) * (x >= 0.0F ? 1.0F : -1.0F);
+    float fy = (1.0F - std::abs(x)) * (y >= 0.0F ? 1.0F : -1.0F);
+    x = fx;
+    y = fy;
+  }
+  return {quantize_snorm(x), quantize_snorm(y)};
+}
+
+// A submesh ready to be written: optimised vertices and its LOD chain.
+struct Processed {
+  std::string material;
+  std::vector<Vertex> vertices;
+  std::vector<SimplifyResult> levels;
+};
+
+// LOD generation, then cache, overdraw and fetch optimisation, in that order
+// since each pass keeps the improvements of the previous one.
+auto process(const SourceSubmesh& sm) -> Processed {
+  auto before = el::tools::average_cache_miss_ratio(
+      sm.indices, sm.vertices.size(), kReportCacheSize);
+
+  std::vector<std::array<float, 3>> positions(sm.vertices.size());
+  std::transform(std::begin(sm.vertices), std::end(sm.vertices),
+                 std::begin(positions),
+                 [](const Vertex& v) { return v.position; });
+
+  Processed out = {.material = sm.material,
+                   .vertices = {},
+                   .levels = el::tools::build_lod_chain(
+                       sm.indices, positions, el::engine::mesh::kMaxLods)};
+  for (auto& level : out.levels) {
+    el::tools::optimize_vertex_cache(level.indices, sm.vertices.size());
+    el::tools::optimize_overdraw(level.indices, positions);
+  }
+
+  // Coarser levels only use a subset of the full detail vertices, so the
+  // first level decides the vertex order for all of them.
+  auto remap = el::tools::optimize_vertex_fetch(out.levels[0].indices,
+                                                sm.vertices.size());
+  std::for_each(std::begin(out.levels) + 1, std::end(out.levels),
+                [&remap](SimplifyResult& level) {
+                  for (auto& idx : level.indices) {
+                    idx = remap[idx];
+                  }
+                });
+
+  out.vertices.resize(sm.vertices.size());
+  size_t used = 0;
+  for (size_t i = 0; i < remap.size(); ++i) {
+    if (remap[i] != el::tools::kUnusedVertex) {
+      out.vertices[remap[i]] = sm.vertices[i];
+      ++used;
+    }
+  }
+  out.vertices.resize(used);
+
+  std::cout << "  " << (sm.material.empty() ? "<default>" : sm.material)
+            << ": " << out.vertices.size() << " vertices, ACMR " << before
+            << " -> "
+            << el::tools::average_cache_miss_ratio(
+                   out.levels[0].indices, used, kReportCacheSize)
+            << std::endl;
+  for (size_t i = 0; i < out.levels.size(); ++i) {
+    std::cout << "    lod " << i << ": " << out.levels[i].indices.size() / 3
+              << " triangles, max distance "
+              << out.levels[i].max_distance << std::endl;
+  }
+  return out;
+}
+
+auto bounding_sphere(const Processed& sm) -> std::array<float, 4> {
+  Range range;
+  std::for_each(std::begin(sm.vertices), std::end(sm.vertices),
+                [&range](const Vertex& v) { range.add(v.position); });
+
+  std::array<float, 3> center = {};
+  for (size_t i = 0; i < 3; ++i) {
+    center[i] = (range.min[i] + range.max[i]) * 0.5F;
+  }
+  float radius = 0.0F;
+  for (const auto& v : sm.vertices) {
+    float d = 0.0F;
+    for (size_t i = 0; i < 3; ++i) {
+      d += (v.position[i] - center[i]) * (v.position[i] - center[i]);
+    }
+    radius = std::max(radius, d);
+  }
+  return {center[0], center[1], center[2], std::sqrt(radius)};
+}
+
+template <typename T>
+auto write_at(std::vector<char>* out, uint64_t offset, std::span<const T> data)
+    -> void {
+  std::memcpy(out->data() + offset, data.data(), data.size_bytes());
+}
+
+auto write_mesh(std::span<const Processed> src, const std::string& path)
+    -> void {
+  Range positions;
+  Range uvs;
+  size_t max_submesh_vertices = 0;
+  for (const auto& sm : src) {
+    for (const auto& v : sm.vertices) {
+      positions.add(v.position);
+      uvs.add(v.uv);
+    }
+    max_submesh_vertices = std::max(max_submesh_vertices, sm.vertices.size());
+  }
+
+  Header header;
+  header.index_type =
+      max_submesh_vertices <= size_t{std::numeric_limits<uint16_t>::max()} + 1
+          ? el::engine::mesh::IndexType::kUint16
+          : el::engine::mesh::IndexType::kUint32;
+  header.position_min = {positions.min[0], positions.min[1], positions.min[2],
+                         0.0F};
+  header.position_scale = {positions.scale(0), positions.scale(1),
+                           positions.scale(2), 0.0F};
+  header.uv_min = {uvs.min[0], uvs.min[1]};
+  header.uv_scale = {uvs.scale(0), uvs.scale(1)};
+
+  std::vector<PackedVertex> vertices;
+  std::vector<uint32_t> indices;
+  std::vector<Submesh> submeshes;
+  std::vector<Lod> lods;
+  for (const auto& sm : src) {
+    submeshes.push_back({
+        .vertex_offset = uint32_t(vertices.size()),
+        .vertex_count = uint32_t(sm.vertices.size()),
+        .first_lod = uint32_t(lods.size()),
+        .lod_count = uint32_t(sm.levels.size()),
+        .bounds = bounding_sphere(sm),
+    });
+    for (const auto& level : sm.levels) {
+      lods.push_back({
+          .first_index = uint32_t(indices.size()),
+          .index_count = uint32_t(level.indices.size()),
+          .error = level.max_distance,
+      });
+      indices.insert(std::end(indices), std::begin(level.indices),
+                     std::end(level.indices));
+    }
+
+    std::transform(
+        std::begin(sm.vertices), std::end(sm.vertices),
+        std::back_inserter(vertices), [&header](const Vertex& v) {
+          PackedVertex p;
+          for (size_t i = 0; i < 3; ++i) {
+            p.position[i] = quantize_unorm(v.position[i],
+                                           header.position_min[i],
+                                           header.position_scale[i]);
+          }
+          p.normal = encode_octahedral(v.normal);
+          for (size_t i = 0; i < 2; ++i) {
+            p.uv[i] =
+                quantize_unorm(v.uv[i], header.uv_min[i], header.uv_scale[i]);
+          }
+          return p;
+        });
+  }
+
+  header.vertex_count = uint32_t(vertices.size());
+  header.index_count = uint32_t(indices.size());
+  header.submesh_count = uint32_t(submeshes.size());
+  header.lod_count = uint32_t(lods.size());
+  header.submesh_offset = sizeof(Header);
+  header.lod_offset =
+      header.submesh_offset + submeshes.size() * sizeof(Submesh);
+  header.data_offset = align_up(header.lod_offset + lods.size() * sizeof(Lod),
+                                el::engine::mesh::kDataAlignment);
+  header.vertex_offset = 0;
+  header.index_offset = align_up(vertices.size() * sizeof(PackedVertex),
+                                 el::engine::mesh::kDataAlignment);
+  header.data_size =
+      header.index_offset +
+      indices.size() * el::engine::mesh::index_size(header.index_type);
+
+  std::vector<char> out(header.data_offset + header.data_size, 0);
+  write_at(&out, 0, std::span<const Header>(&header, 1));
+  write_at(&out, header.submesh_offset, std::span<const Submesh>(submeshes));
+  write_at(&out, header.lod_offset, std::span<const Lod>(lods));
+  write_at(&out, header.data_offset + header.vertex_offset,
+           std::span<const PackedVertex>(vertices));
+  if (header.index_type == el::engine::mesh::IndexType::kUint16) {
+    std::vector<uint16_t> narrow(std::begin(indices), std::end(indices));
+    write_at(&out, header.data_offset + header.index_offset,
+             std::span<const uint16_t>(narrow));
+  } else {
+    write_at(&out, header.data_offset + header.index_offset,
+             std::span<const uint32_t>(indices));
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    throw std::runtime_error("Failed to open " + path);
+  }
+  file.write(out.data(), std::streamsize(out.size()));
+  file.close();
+  if (!file) {
+    throw std::runtime_error("Failed to write " + path);
+  }
+  std::cout << "Wrote " << path << " (" << out.size() << " bytes)"
+            << std::endl;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+  std::span args(argv, size_t(argc));
+  if (args.size() != 3) {
+    std::cerr << "Usage: " << args[0] << " <input.obj> <output.elm>"
+              << std::endl;
+    return 1;
+  }
+
+  try {
+    auto mesh = el::tools::load_obj(args[1]);
+    std::vector<Processed> processed(mesh.submeshes.size());
+    std::transform(std::begin(mesh.submeshes), std::end(mesh.submeshes),
+                   std::begin(processed), process);
+    write_mesh(processed, args[2]);
+  } catch (const std::exception& e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,265 @@
+#include "tools/mesh_convert/obj.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace el::tools {
+namespace {
+
+constexpr int32_t kMissing = -1;
+
+struct Corner {
+  int32_t position = kMissing;
+  int32_t uv = kMissing;
+  int32_t normal = kMissing;
+
+  auto operator==(const Corner&) const -> bool = default;
+};
+
+struct CornerHash {
+  auto operator()(const Corner& c) const -> size_t {
+    auto h = std::hash<int32_t>{}(c.position);
+    h = h * 31 + std::hash<int32_t>{}(c.uv);
+    return h * 31 + std::hash<int32_t>{}(c.normal);
+  }
+};
+
+auto next_token(std::string_view* line) -> std::string_view {
+  auto start = line->find_first_not_of(" \t\r");
+  if (start == std::string_view::npos) {
+    *line = {};
+    return {};
+  }
+  line->remove_prefix(start);
+  auto end = line->find_first_of(" \t\r");
+  auto token = line->substr(0, end);
+  line->remove_prefix(end == std::string_view::npos ? line->size() : end);
+  return token;
+}
+
+auto parse_float(std::string_view token) -> float {
+  // strtof rather than from_chars, which not every standard library has for
+  // floating point yet.
+  std::string str(token);
+  char* end = nullptr;
+  float v = std::strtof(str.c_str(), &end);
+  if (end == str.c_str()) {
+    throw std::runtime_error("Invalid number in OBJ: " + str);
+  }
+  return v;
+}
+
+template <size_t N>
+auto parse_floats(std::string_view line) -> std::array<float, N> {
+  std::array<float, N> ret = {};
+  for (auto& v : ret) {
+    v = parse_float(next_token(&line));
+  }
+  return ret;
+}
+
+// Resolves a 1 based, possibly negative (relative), OBJ index.
+auto resolve(std::string_view token, size_t count) -> int32_t {
+  if (token.empty()) {
+    return kMissing;
+  }
+  int32_t idx = 0;
+  auto res = std::from_chars(token.data(), token.data() + token.size(), idx);
+  if (res.ec != std::errc() || idx == 0) {
+    throw std::runtime_error("Invalid index in OBJ: " + std::string(token));
+  }
+  auto resolved = idx > 0 ? int64_t{idx} - 1 : int64_t(count) + idx;
+  if (resolved < 0 || resolved >= int64_t(count)) {
+    throw std::runtime_error("OBJ index out of range: " + std::string(token));
+  }
+  return int32_t(resolved);
+}
+
+class Builder {
+ public:
+  auto add_position(std::string_view line) -> void {
+    positions_.push_back(parse_floats<3>(line));
+  }
+
+  auto add_uv(std::string_view line) -> void {
+    auto uv = parse_floats<2>(line);
+    uvs_.push_back({uv[0], 1.0F - uv[1]});
+  }
+
+  auto add_normal(std::string_view line) -> void {
+    normals_.push_back(parse_floats<3>(line));
+  }
+
+  auto add_face(std::string_view line) -> void {
+    std::vector<uint32_t> polygon;
+    for (auto token = next_token(&line); !token.empty();
+         token = next_token(&line)) {
+      polygon.push_back(vertex(parse_corner(token)));
+    }
+    if (polygon.size() < 3) {
+      throw std::runtime_error("OBJ face with fewer than 3 vertices");
+    }
+
+    auto& indices = current_.indices;
+    for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+      indices.push_back(polygon[0]);
+      indices.push_back(polygon[i]);
+      indices.push_back(polygon[i + 1]);
+    }
+  }
+
+  auto use_material(std::string_view line) -> void {
+    finish_submesh();
+    current_.material = std::string(next_token(&line));
+  }
+
+  auto finish() -> SourceMesh {
+    finish_submesh();
+    return std::move(mesh_);
+  }
+
+ private:
+  auto parse_corner(std::string_view token) const -> Corner {
+    Corner c;
+    auto slash = token.find('/');
+    c.position = resolve(token.substr(0, slash), positions_.size());
+    if (slash == std::string_view::npos) {
+      return c;
+    }
+
+    token.remove_prefix(slash + 1);
+    slash = token.find('/');
+    c.uv = resolve(token.substr(0, slash), uvs_.size());
+    if (slash != std::string_view::npos) {
+      c.normal = resolve(token.substr(slash + 1), normals_.size());
+    }
+    return c;
+  }
+
+  auto vertex(const Corner& c) -> uint32_t {
+    auto [it, inserted] =
+        corners_.try_emplace(c, uint32_t(current_.vertices.size()));
+    if (!inserted) {
+      return it->second;
+    }
+
+    Vertex v;
+    v.position = positions_[size_t(c.position)];
+    if (c.uv != kMissing) {
+      v.uv = uvs_[size_t(c.uv)];
+    }
+    if (c.normal != kMissing) {
+      v.normal = normals_[size_t(c.normal)];
+    }
+    current_.vertices.push_back(v);
+    vertex_positions_.push_back(c.normal == kMissing ? c.position : kMissing);
+    return it->second;
+  }
+
+  // Vertices without an OBJ normal share one accumulated normal per position
+  // so the surface comes out smooth.
+  auto generate_normals() -> void {
+    std::unordered_map<int32_t, std::array<float, 3>> accum;
+    const auto& verts = current_.vertices;
+    const auto& idx = current_.indices;
+    for (size_t t = 0; t + 2 < idx.size(); t += 3) {
+      const auto& a = verts[idx[t]].position;
+      const auto& b = verts[idx[t + 1]].position;
+      const auto& c = verts[idx[t + 2]].position;
+      std::array<float, 3> e1 = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+      std::array<float, 3> e2 = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+      // Unnormalized, so larger triangles weigh more.
+      std::array<float, 3> n = {e1[1] * e2[2] - e1[2] * e2[1],
+                                e1[2] * e2[0] - e1[0] * e2[2],
+                                e1[0] * e2[1] - e1[1] * e2[0]};
+      for (size_t k = 0; k < 3; ++k) {
+        auto pos = vertex_positions_[idx[t + k]];
+        if (pos == kMissing) {
+          continue;
+        }
+        auto& sum = accum[pos];
+        sum = {sum[0] + n[0], sum[1] + n[1], sum[2] + n[2]};
+      }
+    }
+
+    for (size_t i = 0; i < current_.vertices.size(); ++i) {
+      auto pos = vertex_positions_[i];
+      if (pos == kMissing) {
+        continue;
+      }
+      auto n = accum[pos];
+      float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      current_.vertices[i].normal =
+          len > 0.0F ? std::array<float, 3>{n[0] / len, n[1] / len, n[2] / len}
+                     : std::array<float, 3>{0.0F, 0.0F, 1.0F};
+    }
+  }
+
+  auto finish_submesh() -> void {
+    if (!current_.indices.empty()) {
+      generate_normals();
+      mesh_.submeshes.push_back(std::move(current_));
+    }
+    current_ = {};
+    corners_.clear();
+    vertex_positions_.clear();
+  }
+
+  std::vector<std::array<float, 3>> positions_;
+  std::vector<std::array<float, 2>> uvs_;
+  std::vector<std::array<float, 3>> normals_;
+
+  SourceMesh mesh_;
+  SourceSubmesh current_;
+  std::unordered_map<Corner, uint32_t, CornerHash> corners_;
+  // OBJ position of each vertex in current_ still needing a normal.
+  std::vector<int32_t> vertex_positions_;
+};
+
+}  // namespace
+
+auto load_obj(const std::string& path) -> SourceMesh {
+  std::ifstream file(path);
+  if (!file) {
+    throw std::runtime_error("Failed to open " + path);
+  }
+  std::stringstream buf;
+  buf << file.rdbuf();
+  const std::string contents = buf.str();
+
+  Builder builder;
+  std::string_view rest(contents);
+  while (!rest.empty()) {
+    auto eol = rest.find('\n');
+    auto line = rest.substr(0, eol);
+    rest.remove_prefix(eol == std::string_view::npos ? rest.size() : eol + 1);
+
+    auto keyword = next_token(&line);
+    if (keyword == "v") {
+      builder.add_position(line);
+    } else if (keyword == "vt") {
+      builder.add_uv(line);
+    } else if (keyword == "vn") {
+      builder.add_normal(line);
+    } else if (keyword == "f") {
+      builder.add_face(line);
+    } else if (keyword == "usemtl") {
+      builder.use_material(line);
+    }
+  }
+
+  auto mesh = builder.finish();
+  if (mesh.submeshes.empty()) {
+    throw std::runtime_error("No faces in " + path);
+  }
+  return mesh;
+}
+
+}  // namespace el::tools
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace el::tools {
+
+struct Vertex {
+  std::array<float, 3> position = {};
+  std::array<float, 3> normal = {};
+  std::array<float, 2> uv = {};
+};
+
+// One material's worth of triangles, with its own vertices.
+struct SourceSubmesh {
+  std::string material;
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+};
+
+struct SourceMesh {
+  std::vector<SourceSubmesh> submeshes;
+};
+
+// Loads a Wavefront OBJ file. Polygons are triangulated as fans and a new
+// submesh is started at every `usemtl`. Vertices without normals get
+// smooth, area weighted normals. UVs are flipped to a top left origin.
+auto load_obj(const std::string& path) -> SourceMesh;
+
+}  // namespace el::tools
@@ -0,0 +1,314 @@
+#include "tools/mesh_convert/optimize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace el::tools {
+namespace {
+
+// Scoring constants from Tom Forsyth's "Linear-Speed Vertex Cache
+// Optimisation".
+constexpr size_t kCacheSize = 32;
+constexpr float kCacheDecayPower = 1.5F;
+constexpr float kLastTriangleScore = 0.75F;
+constexpr float kValenceBoostScale = 2.0F;
+constexpr float kValenceBoostPower = 0.5F;
+
+// Cache size assumed when looking for places to split the triangle order.
+constexpr size_t kFifoCacheSize = 16;
+// Smaller runs are merged into the previous one; reordering very small
+// runs costs more vertex reuse than it saves in overdraw.
+constexpr size_t kMinClusterTriangles = 32;
+
+auto vertex_score(int32_t cache_position, uint32_t live_triangles) -> float {
+  if (live_triangles == 0) {
+    return -1.0F;
+  }
+
+  float score = 0.0F;
+  if (cache_position >= 0) {
+    if (cache_position < 3) {
+      // Vertices of the triangle just drawn; deliberately below the top of
+      // the decay curve so strips don't always go the same way.
+      score = kLastTriangleScore;
+    } else {
+      float scale = 1.0F / float(kCacheSize - 3);
+      score = std::pow(1.0F - float(cache_position - 3) * scale,
+                       kCacheDecayPower);
+    }
+  }
+  return score + kValenceBoostScale *
+                     std::pow(float(live_triangles), -kValenceBoostPower);
+}
+
+// Vertex to triangle adjacency in CSR form. Triangles are swapped out of a
+// vertex's live range as they are emitted.
+struct Adjacency {
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> live;
+  std::vector<uint32_t> triangles;
+
+  Adjacency(std::span<const uint32_t> indices, size_t vertex_count)
+      : offsets(vertex_count + 1),
+        live(vertex_count),
+        triangles(indices.size()) {
+    std::for_each(std::begin(indices), std::end(indices),
+                  [this](uint32_t v) { ++live[v]; });
+    std::partial_sum(std::begin(live), std::end(live),
+                     std::begin(offsets) + 1);
+
+    std::vector<uint32_t> fill(std::begin(offsets), std::end(offsets) - 1);
+    for (size_t i = 0; i < indices.size(); ++i) {
+      triangles[fill[indices[i]]++] = uint32_t(i / 3);
+    }
+  }
+
+  [[nodiscard]] auto of(uint32_t v) const -> std::span<const uint32_t> {
+    return std::span(triangles).subspan(offsets[v], live[v]);
+  }
+
+  auto remove(uint32_t v, uint32_t triangle) -> void {
+    auto range = std::span(triangles).subspan(offsets[v], live[v]);
+    auto it = std::find(std::begin(range), std::end(range), triangle);
+    std::iter_swap(it, std::end(range) - 1);
+    --live[v];
+  }
+};
+
+auto fifo_misses(std::span<const uint32_t> triangle,
+                 std::vector<size_t>* timestamps,
+                 size_t* time,
+                 size_t cache_size) -> uint32_t {
+  uint32_t misses = 0;
+  for (auto v : triangle) {
+    if (*time - (*timestamps)[v] >= cache_size) {
+      (*timestamps)[v] = *time;
+      ++*time;
+      ++misses;
+    }
+  }
+  return misses;
+}
+
+using Vec3 = std::array<float, 3>;
+
+auto sub(const Vec3& a, const Vec3& b) -> Vec3 {
+  return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+auto cross(const Vec3& a, const Vec3& b) -> Vec3 {
+  return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+          a[0] * b[1] - a[1] * b[0]};
+}
+
+auto dot(const Vec3& a, const Vec3& b) -> float {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+}  // namespace
+
+auto optimize_vertex_cache(std::span<uint32_t> indices, size_t vertex_count)
+    -> void {
+  const size_t triangle_count = indices.size() / 3;
+  if (triangle_count == 0) {
+    return;
+  }
+
+  Adjacency adjacency(indices, vertex_count);
+  std::vector<int32_t> cache_position(vertex_count, -1);
+  std::vector<float> score(vertex_count);
+  for (size_t v = 0; v < vertex_count; ++v) {
+    score[v] = vertex_score(-1, adjacency.live[v]);
+  }
+
+  auto triangle = [&indices](size_t t) { return indices.subspan(t * 3, 3); };
+  std::vector<float> triangle_score(triangle_count);
+  for (size_t t = 0; t < triangle_count; ++t) {
+    auto tri = triangle(t);
+    triangle_score[t] = score[tri[0]] + score[tri[1]] + score[tri[2]];
+  }
+
+  std::vector<bool> emitted(triangle_count, false);
+  std::vector<uint32_t> output;
+  output.reserve(indices.size());
+  std::vector<uint32_t> cache;
+  std::vector<uint32_t> next_cache;
+  size_t cursor = 0;
+
+  auto best = static_cast<size_t>(
+      std::distance(std::begin(triangle_score),
+                    std::max_element(std::begin(triangle_score),
+                                     std::end(triangle_score))));
+  while (output.size() < indices.size()) {
+    if (best == triangle_count) {
+      // Nothing in the cache has live triangles left; continue in input
+      // order.
+      while (emitted[cursor]) {
+        ++cursor;
+      }
+      best = cursor;
+    }
+
+    emitted[best] = true;
+    auto tri = triangle(best);
+    next_cache.assign(std::begin(tri), std::end(tri));
+    for (auto v : tri) {
+      output.push_back(v);
+      adjacency.remove(v, uint32_t(best));
+    }
+    std::copy_if(std::begin(cache), std::end(cache),
+                 std::back_inserter(next_cache), [&tri](uint32_t v) {
+                   return std::find(std::begin(tri), std::end(tri), v) ==
+                          std::end(tri);
+                 });
+
+    // Entries past kCacheSize have just been evicted; they still get their
+    // score updated below.
+    for (size_t i = 0; i < next_cache.size(); ++i) {
+      auto v = next_cache[i];
+      cache_position[v] = i < kCacheSize ? int32_t(i) : -1;
+      score[v] = vertex_score(cache_position[v], adjacency.live[v]);
+    }
+
+    best = triangle_count;
+    float best_score = -1.0F;
+    for (auto v : next_cache) {
+      for (auto t : adjacency.of(v)) {
+        auto other = triangle(t);
+        triangle_score[t] = score[other[0]] + score[other[1]] + score[other[2]];
+        if (triangle_score[t] > best_score) {
+          best_score = triangle_score[t];
+          best = t;
+        }
+      }
+    }
+
+    if (next_cache.size() > kCacheSize) {
+      next_cache.resize(kCacheSize);
+    }
+    std::swap(cache, next_cache);
+  }
+
+  std::copy(std::begin(output), std::end(output), std::begin(indices));
+}
+
+auto optimize_overdraw(std::span<uint32_t> indices,
+                       std::span<const std::array<float, 3>> positions)
+    -> void {
+  const size_t triangle_count = indices.size() / 3;
+  if (triangle_count == 0) {
+    return;
+  }
+
+  // Split where the cache order restarts, i.e. a triangle misses on every
+  // vertex.
+  std::vector<size_t> cluster_starts = {0};
+  std::vector<size_t> timestamps(positions.size(), 0);
+  size_t time = kFifoCacheSize + 1;
+  for (size_t t = 0; t < triangle_count; ++t) {
+    auto misses = fifo_misses(indices.subspan(t * 3, 3), &timestamps, &time,
+                              kFifoCacheSize);
+    if (misses == 3 && t - cluster_starts.back() >= kMinClusterTriangles) {
+      cluster_starts.push_back(t);
+    }
+  }
+  cluster_starts.push_back(triangle_count);
+
+  struct Cluster {
+    Vec3 centroid = {};
+    Vec3 normal = {};
+    float area = 0.0F;
+  };
+  std::vector<Cluster> clusters(cluster_starts.size() - 1);
+  Vec3 mesh_centroid = {};
+  float mesh_area = 0.0F;
+  for (size_t c = 0; c < clusters.size(); ++c) {
+    auto& cluster = clusters[c];
+    for (size_t t = cluster_starts[c]; t < cluster_starts[c + 1]; ++t) {
+      const auto& a = positions[indices[t * 3]];
+      const auto& b = positions[indices[t * 3 + 1]];
+      const auto& d = positions[indices[t * 3 + 2]];
+      auto n = cross(sub(b, a), sub(d, a));
+      float area = std::sqrt(dot(n, n));
+      for (size_t k = 0; k < 3; ++k) {
+        cluster.centroid[k] += (a[k] + b[k] + d[k]) / 3.0F * area;
+        cluster.normal[k] += n[k];
+        mesh_centroid[k] += (a[k] + b[k] + d[k]) / 3.0F * area;
+      }
+      cluster.area += area;
+      mesh_area += area;
+    }
+  }
+  if (mesh_area <= 0.0F) {
+    return;
+  }
+  for (auto& v : mesh_centroid) {
+    v /= mesh_area;
+  }
+
+  std::vector<float> keys(clusters.size());
+  std::transform(std::begin(clusters), std::end(clusters), std::begin(keys),
+                 [&mesh_centroid](Cluster& cluster) {
+                   if (cluster.area <= 0.0F) {
+                     return 0.0F;
+                   }
+                   for (auto& v : cluster.centroid) {
+                     v /= cluster.area;
+                   }
+                   float len = std::sqrt(dot(cluster.normal, cluster.normal));
+                   if (len <= 0.0F) {
+                     return 0.0F;
+                   }
+                   return dot(sub(cluster.centroid, mesh_centroid),
+                              cluster.normal) /
+                          len;
+                 });
+
+  std::vector<size_t> order(clusters.size());
+  std::iota(std::begin(order), std::end(order), 0);
+  std::stable_sort(std::begin(order), std::end(order),
+                   [&keys](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+  std::vector<uint32_t> output;
+  output.reserve(indices.size());
+  for (auto c : order) {
+    auto first = indices.begin() + std::ptrdiff_t(cluster_starts[c] * 3);
+    auto last = indices.begin() + std::ptrdiff_t(cluster_starts[c + 1] * 3);
+    output.insert(std::end(output), first, last);
+  }
+  std::copy(std::begin(output), std::end(output), std::begin(indices));
+}
+
+auto optimize_vertex_fetch(std::span<uint32_t> indices, size_t vertex_count)
+    -> std::vector<uint32_t> {
+  std::vector<uint32_t> remap(vertex_count, kUnusedVertex);
+  uint32_t next = 0;
+  for (auto& idx : indices) {
+    if (remap[idx] == kUnusedVertex) {
+      remap[idx] = next++;
+    }
+    idx = remap[idx];
+  }
+  return remap;
+}
+
+auto average_cache_miss_ratio(std::span<const uint32_t> indices,
+                              size_t vertex_count,
+                              size_t cache_size) -> float {
+  const size_t triangle_count = indices.size() / 3;
+  if (triangle_count == 0) {
+    return 0.0F;
+  }
+
+  std::vector<size_t> timestamps(vertex_count, 0);
+  size_t time = cache_size + 1;
+  size_t misses = 0;
+  for (size_t t = 0; t < triangle_count; ++t) {
+    misses += fifo_misses(indices.subspan(t * 3, 3), &timestamps, &time,
+                          cache_size);
+  }
+  return float(misses) / float(triangle_count);
+}
+
+}  // namespace el::tools
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace el::tools {
+
+// Reorders triangles for the post-transform vertex cache, using Forsyth's
+// linear speed vertex cache optimisation.
+auto optimize_vertex_cache(std::span<uint32_t> indices, size_t vertex_count)
+    -> void;
+
+// Reorders runs of triangles so outward facing regions are drawn first,
+// which cuts overdraw when the mesh is seen from outside. Runs split where
+// the cache optimised order already starts over, so cache efficiency is kept.
+// Expects cache optimised indices.
+auto optimize_overdraw(std::span<uint32_t> indices,
+                       std::span<const std::array<float, 3>> positions)
+    -> void;
+
+// Returns, for each vertex, its new position when vertices are laid out in
+// the order they are first referenced. Unreferenced vertices map to
+// kUnusedVertex. Rewrites |indices| to match.
+constexpr uint32_t kUnusedVertex = ~0U;
+auto optimize_vertex_fetch(std::span<uint32_t> indices, size_t vertex_count)
+    -> std::vector<uint32_t>;
+
+// Average number of vertex shader invocations per triangle for a FIFO cache
+// of |cache_size| entries. Lower is better, 0.5 is the ideal for a grid.
+auto average_cache_miss_ratio(std::span<const uint32_t> indices,
+                              size_t vertex_count,
+                              size_t cache_size) -> float;
+
+}  // namespace el::tools
@@ -0,0 +1,350 @@
+#include "tools/mesh_convert/simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+
+namespace el::tools {
+namespace {
+
+using Vec3 = std::array<float, 3>;
+
+constexpr uint32_t kRemoved = ~0U;
+// A collapse may turn the normal of a triangle it moves by at most about 75
+// degrees, the cosine of which this is.
+constexpr float kMinNormalCosine = 0.25F;
+// Triangles whose doubled area is below this share of their summed squared
+// edge lengths count as degenerate. Equilateral ones reach about 0.29.
+constexpr float kMinTriangleShape = 0.01F;
+
+auto sub(const Vec3& a, const Vec3& b) -> Vec3 {
+  return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+auto cross(const Vec3& a, const Vec3& b) -> Vec3 {
+  return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+          a[0] * b[1] - a[1] * b[0]};
+}
+
+auto dot(const Vec3& a, const Vec3& b) -> float {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// Symmetric 4x4 matrix summing the area weighted squared distances to a set
+// of planes, stored as its 10 unique coefficients. Dividing by the total
+// area makes the error a mean squared distance, which doesn't grow just
+// because a vertex has absorbed many planes.
+class Quadric {
+ public:
+  Quadric() = default;
+
+  // Plane through |p| with unit normal |n|.
+  static auto plane(const Vec3& n, const Vec3& p, double area) -> Quadric {
+    double a = n[0];
+    double b = n[1];
+    double c = n[2];
+    double d = -(a * p[0] + b * p[1] + c * p[2]);
+
+    Quadric q;
+    q.m_ = {a * a, a * b, a * c, a * d, b * b,
+            b * c, b * d, c * c, c * d, d * d};
+    std::for_each(std::begin(q.m_), std::end(q.m_),
+                  [area](double& v) { v *= area; });
+    q.weight_ = area;
+    return q;
+  }
+
+  auto operator+=(const Quadric& other) -> Quadric& {
+    std::transform(std::begin(m_), std::end(m_), std::begin(other.m_),
+                   std::begin(m_), std::plus<>());
+    weight_ += other.weight_;
+    return *this;
+  }
+
+  [[nodiscard]] auto error(const Vec3& p) const -> double {
+    if (weight_ <= 0.0) {
+      return 0.0;
+    }
+    double x = p[0];
+    double y = p[1];
+    double z = p[2];
+    double e = m_[0] * x * x + 2 * m_[1] * x * y + 2 * m_[2] * x * z +
+               2 * m_[3] * x + m_[4] * y * y + 2 * m_[5] * y * z +
+               2 * m_[6] * y + m_[7] * z * z + 2 * m_[8] * z + m_[9];
+    return std::max(e, 0.0) / weight_;
+  }
+
+ private:
+  std::array<double, 10> m_ = {};
+  double weight_ = 0.0;
+};
+
+struct Collapse {
+  double cost = 0.0;
+  uint32_t from = 0;
+  uint32_t to = 0;
+};
+
+auto edge_key(uint32_t a, uint32_t b) -> uint64_t {
+  return (uint64_t{std::min(a, b)} << 32U) | std::max(a, b);
+}
+
+// Border, non-manifold and seam vertices must keep their place.
+auto find_locked(std::span<const uint32_t> indices,
+                 std::span<const Vec3> positions) -> std::vector<bool> {
+  std::vector<bool> locked(positions.size(), false);
+
+  std::unordered_map<uint64_t, uint32_t> edges;
+  for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+    for (size_t k = 0; k < 3; ++k) {
+      ++edges[edge_key(indices[t + k], indices[t + (k + 1) % 3])];
+    }
+  }
+  for (const auto& [key, count] : edges) {
+    if (count != 2) {
+      locked[key >> 32U] = true;
+      locked[key & 0xffffffffU] = true;
+    }
+  }
+
+  std::unordered_map<std::string, std::vector<uint32_t>> by_position;
+  for (uint32_t v = 0; v < positions.size(); ++v) {
+    std::string key(sizeof(Vec3), '\0');
+    std::memcpy(key.data(), positions[v].data(), sizeof(Vec3));
+    by_position[key].push_back(v);
+  }
+  for (const auto& [key, verts] : by_position) {
+    if (verts.size() > 1) {
+      std::for_each(std::begin(verts), std::end(verts),
+                    [&locked](uint32_t v) { locked[v] = true; });
+    }
+  }
+  return locked;
+}
+
+// Triangles around each vertex, in CSR form.
+struct Adjacency {
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> triangles;
+
+  Adjacency(std::span<const uint32_t> indices, size_t vertex_count)
+      : offsets(vertex_count + 1, 0), triangles(indices.size()) {
+    std::for_each(std::begin(indices), std::end(indices),
+                  [this](uint32_t v) { ++offsets[v + 1]; });
+    std::partial_sum(std::begin(offsets), std::end(offsets),
+                     std::begin(offsets));
+
+    std::vector<uint32_t> fill(std::begin(offsets), std::end(offsets) - 1);
+    for (size_t i = 0; i < indices.size(); ++i) {
+      triangles[fill[indices[i]]++] = uint32_t(i / 3);
+    }
+  }
+
+  [[nodiscard]] auto of(uint32_t v) const -> std::span<const uint32_t> {
+    return std::span(triangles).subspan(offsets[v],
+                                        offsets[v + 1] - offsets[v]);
+  }
+};
+
+class Simplifier {
+ public:
+  Simplifier(std::span<const uint32_t> indices, std::span<const Vec3> positions)
+      : positions_(positions),
+        indices_(std::begin(indices), std::end(indices)),
+        locked_(find_locked(indices, positions)),
+        quadrics_(positions.size()) {
+    for (size_t t = 0; t + 2 < indices_.size(); t += 3) {
+      const auto& a = positions_[indices_[t]];
+      auto n = cross(sub(positions_[indices_[t + 1]], a),
+                     sub(positions_[indices_[t + 2]], a));
+      float len = std::sqrt(dot(n, n));
+      if (len <= 0.0F) {
+        continue;
+      }
+      auto q = Quadric::plane({n[0] / len, n[1] / len, n[2] / len}, a,
+                              0.5 * double(len));
+      for (size_t k = 0; k < 3; ++k) {
+        quadrics_[indices_[t + k]] += q;
+      }
+    }
+  }
+
+  // Runs collapse passes until |target| indices remain or nothing more can
+  // be removed.
+  auto run(size_t target) -> SimplifyResult {
+    while (indices_.size() > target) {
+      if (!collapse_pass(target)) {
+        break;
+      }
+    }
+    return {.indices = indices_, .max_distance = float(std::sqrt(max_cost_))};
+  }
+
+ private:
+  auto collapse_pass(size_t target) -> bool {
+    Adjacency adjacency(indices_, positions_.size());
+
+    // Every directed edge a->b of a triangle is a candidate to move a onto
+    // b. Interior edges are seen once per direction.
+    std::vector<Collapse> candidates;
+    for (size_t t = 0; t + 2 < indices_.size(); t += 3) {
+      for (size_t k = 0; k < 3; ++k) {
+        auto from = indices_[t + k];
+        auto to = indices_[t + (k + 1) % 3];
+        if (!locked_[from]) {
+          candidates.push_back({
+              .cost = quadrics_[from].error(positions_[to]),
+              .from = from,
+              .to = to,
+          });
+        }
+      }
+    }
+    std::sort(std::begin(candidates), std::end(candidates),
+              [](const Collapse& a, const Collapse& b) {
+                return a.cost < b.cost;
+              });
+
+    // Vertices around a collapse are frozen for the rest of the pass, which
+    // keeps the adjacency built above valid for every collapse attempted.
+    std::vector<bool> touched(positions_.size(), false);
+    size_t remaining = indices_.size();
+    bool progress = false;
+    for (const auto& c : candidates) {
+      if (remaining <= target) {
+        break;
+      }
+      if (touched[c.from] || touched[c.to] || !can_collapse(adjacency, c)) {
+        continue;
+      }
+
+      for (auto t : adjacency.of(c.from)) {
+        auto tri = std::span(indices_).subspan(size_t{t} * 3, 3);
+        for (auto v : tri) {
+          touched[v] = true;
+        }
+        if (std::find(std::begin(tri), std::end(tri), c.to) != std::end(tri)) {
+          std::fill(std::begin(tri), std::end(tri), kRemoved);
+          remaining -= 3;
+        } else {
+          std::replace(std::begin(tri), std::end(tri), c.from, c.to);
+        }
+      }
+      quadrics_[c.to] += quadrics_[c.from];
+      max_cost_ = std::max(max_cost_, c.cost);
+      progress = true;
+    }
+
+    indices_.erase(
+        std::remove(std::begin(indices_), std::end(indices_), kRemoved),
+        std::end(indices_));
+    return progress;
+  }
+
+  // Rejects collapses which would turn a triangle too far, collapse it to a
+  // sliver or make the surface non-manifold.
+  [[nodiscard]] auto can_collapse(const Adjacency& adjacency,
+                                  const Collapse& c) const -> bool {
+    std::vector<uint32_t> from_ring;
+    std::vector<uint32_t> to_ring;
+    for (auto t : adjacency.of(c.from)) {
+      auto tri = std::span(indices_).subspan(size_t{t} * 3, 3);
+      from_ring.insert(std::end(from_ring), std::begin(tri), std::end(tri));
+
+      if (std::find(std::begin(tri), std::end(tri), c.to) != std::end(tri)) {
+        continue;
+      }
+
+      std::array<Vec3, 3> before = {positions_[tri[0]], positions_[tri[1]],
+                                    positions_[tri[2]]};
+      auto after = before;
+      for (size_t k = 0; k < 3; ++k) {
+        if (tri[k] == c.from) {
+          after[k] = positions_[c.to];
+        }
+      }
+      auto e0 = sub(after[1], after[0]);
+      auto e1 = sub(after[2], after[0]);
+      auto e2 = sub(after[2], after[1]);
+      auto n0 = cross(sub(before[1], before[0]), sub(before[2], before[0]));
+      auto n1 = cross(e0, e1);
+      auto len0 = std::sqrt(dot(n0, n0));
+      auto len1 = std::sqrt(dot(n1, n1));
+      auto edges = dot(e0, e0) + dot(e1, e1) + dot(e2, e2);
+      if (len1 <= kMinTriangleShape * edges ||
+          dot(n0, n1) < kMinNormalCosine * len0 * len1) {
+        return false;
+      }
+    }
+    for (auto t : adjacency.of(c.to)) {
+      auto tri = std::span(indices_).subspan(size_t{t} * 3, 3);
+      to_ring.insert(std::end(to_ring), std::begin(tri), std::end(tri));
+    }
+
+    // Link condition: the two rings may only share the two vertices opposite
+    // the collapsed edge.
+    auto unique = [](std::vector<uint32_t>* ring, uint32_t a, uint32_t b) {
+      std::sort(std::begin(*ring), std::end(*ring));
+      ring->erase(std::unique(std::begin(*ring), std::end(*ring)),
+                  std::end(*ring));
+      ring->erase(
+          std::remove_if(std::begin(*ring), std::end(*ring),
+                         [a, b](uint32_t v) { return v == a || v == b; }),
+          std::end(*ring));
+    };
+    unique(&from_ring, c.from, c.to);
+    unique(&to_ring, c.from, c.to);
+
+    std::vector<uint32_t> shared;
+    std::set_intersection(std::begin(from_ring), std::end(from_ring),
+                          std::begin(to_ring), std::end(to_ring),
+                          std::back_inserter(shared));
+    return shared.size() == 2;
+  }
+
+  std::span<const Vec3> positions_;
+  std::vector<uint32_t> indices_;
+  std::vector<bool> locked_;
+  std::vector<Quadric> quadrics_;
+  // Largest quadric error, a squared distance, of any collapse made.
+  double max_cost_ = 0.0;
+};
+
+}  // namespace
+
+auto simplify(std::span<const uint32_t> indices,
+              std::span<const std::array<float, 3>> positions,
+              size_t target_index_count) -> SimplifyResult {
+  return Simplifier(indices, positions).run(target_index_count);
+}
+
+auto build_lod_chain(std::span<const uint32_t> indices,
+                     std::span<const std::array<float, 3>> positions,
+                     size_t max_levels) -> std::vector<SimplifyResult> {
+  std::vector<SimplifyResult> levels;
+  levels.push_back({.indices = {std::begin(indices), std::end(indices)},
+                    .max_distance = 0.0F});
+
+  while (levels.size() < max_levels) {
+    const auto& prev = levels.back();
+    if (prev.indices.size() / 3 < kMinLodTriangles) {
+      break;
+    }
+
+    auto target = size_t(float(prev.indices.size() / 3) * kLodReduction) * 3;
+    auto result = simplify(indices, positions, target);
+    if (float(result.indices.size()) >
+        float(prev.indices.size()) * kMinLodProgress) {
+      break;
+    }
+    result.max_distance = std::max(result.max_distance, prev.max_distance);
+    levels.push_back(std::move(result));
+  }
+  return levels;
+}
+
+}  // namespace el::tools
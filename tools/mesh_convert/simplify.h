@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "src/pad.h"
+
+namespace el::tools {
+
+// Each level aims for this fraction of the previous level's triangles.
+constexpr float kLodReduction = 0.5F;
+// A level which keeps more than this fraction of the previous one isn't
+// worth its memory; the chain stops there.
+constexpr float kMinLodProgress = 0.85F;
+constexpr size_t kMinLodTriangles = 64;
+
+struct SimplifyResult {
+  std::vector<uint32_t> indices;
+  // Maximum quadric distance: over every collapse, the largest RMS distance
+  // from the kept vertex to the area weighted planes of the triangles the
+  // removed one had gathered. An object space bound for selecting levels,
+  // not a measured distance between the two surfaces.
+  float max_distance = 0.0F;
+  EL_PAD(4);
+};
+
+// Reduces |indices| towards |target_index_count| with quadric error driven
+// half edge collapses. Vertices are only ever removed, never moved, so the
+// result indexes the same vertex buffer as the input.
+//
+// Vertices on open borders and on attribute seams (several vertices sharing a
+// position) are never collapsed, which keeps UVs and outlines intact at the
+// cost of stopping early on heavily seamed meshes.
+auto simplify(std::span<const uint32_t> indices,
+              std::span<const std::array<float, 3>> positions,
+              size_t target_index_count) -> SimplifyResult;
+
+// Simplifies |indices| to half the triangles of the previous level until
+// |max_levels| levels exist or simplification stops paying off. The first
+// level is |indices| itself, and max_distance never decreases along the
+// chain.
+auto build_lod_chain(std::span<const uint32_t> indices,
+                     std::span<const std::array<float, 3>> positions,
+                     size_t max_levels) -> std::vector<SimplifyResult>;
+
+}  // namespace el::tools
@@ -0,0 +1,140 @@
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <numbers>
+#include <vector>
+
+#include "src/engine/mesh_format.h"
+#include "tools/mesh_convert/simplify.h"
+
+namespace {
+
+using Vec3 = std::array<float, 3>;
+
+constexpr uint32_t kSlices = 32;
+constexpr uint32_t kStacks = 24;
+// Every level of a closed, convex mesh has to keep at least this share of
+// the full detail surface area.
+constexpr float kMinAreaRatio = 0.8F;
+
+struct Mesh {
+  std::vector<Vec3> positions;
+  std::vector<uint32_t> indices;
+};
+
+// A unit UV sphere with single pole vertices and no seam, so it is closed
+// and nothing is locked. Triangles wind counter clockwise seen from outside.
+auto uv_sphere() -> Mesh {
+  Mesh mesh;
+  mesh.positions.push_back({0.0F, 1.0F, 0.0F});
+  for (uint32_t stack = 1; stack < kStacks; ++stack) {
+    auto phi = std::numbers::pi_v<float> * float(stack) / float(kStacks);
+    for (uint32_t slice = 0; slice < kSlices; ++slice) {
+      auto theta =
+          2.0F * std::numbers::pi_v<float> * float(slice) / float(kSlices);
+      mesh.positions.push_back({std::sin(phi) * std::cos(theta), std::cos(phi),
+                                -std::sin(phi) * std::sin(theta)});
+    }
+  }
+  auto south = uint32_t(mesh.positions.size());
+  mesh.positions.push_back({0.0F, -1.0F, 0.0F});
+
+  auto ring = [](uint32_t stack, uint32_t slice) {
+    return 1 + (stack - 1) * kSlices + slice % kSlices;
+  };
+  for (uint32_t slice = 0; slice < kSlices; ++slice) {
+    mesh.indices.insert(std::end(mesh.indices),
+                        {0, ring(1, slice), ring(1, slice + 1)});
+    mesh.indices.insert(
+        std::end(mesh.indices),
+        {south, ring(kStacks - 1, slice + 1), ring(kStacks - 1, slice)});
+  }
+  for (uint32_t stack = 1; stack + 1 < kStacks; ++stack) {
+    for (uint32_t slice = 0; slice < kSlices; ++slice) {
+      auto a = ring(stack, slice);
+      auto b = ring(stack + 1, slice);
+      auto c = ring(stack + 1, slice + 1);
+      auto d = ring(stack, slice + 1);
+      mesh.indices.insert(std::end(mesh.indices), {a, b, c, a, c, d});
+    }
+  }
+  return mesh;
+}
+
+auto sub(const Vec3& a, const Vec3& b) -> Vec3 {
+  return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+auto cross(const Vec3& a, const Vec3& b) -> Vec3 {
+  return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+          a[0] * b[1] - a[1] * b[0]};
+}
+
+auto dot(const Vec3& a, const Vec3& b) -> float {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+struct Surface {
+  float area = 0.0F;
+  // Triangles facing the sphere's center, or without area.
+  uint32_t inverted = 0;
+};
+
+auto measure(const Mesh& mesh, const std::vector<uint32_t>& indices)
+    -> Surface {
+  Surface surface;
+  for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+    const auto& a = mesh.positions[indices[t]];
+    const auto& b = mesh.positions[indices[t + 1]];
+    const auto& c = mesh.positions[indices[t + 2]];
+    auto n = cross(sub(b, a), sub(c, a));
+    Vec3 center = {a[0] + b[0] + c[0], a[1] + b[1] + c[1], a[2] + b[2] + c[2]};
+    if (!(dot(n, center) > 0.0F)) {
+      ++surface.inverted;
+    }
+    surface.area += 0.5F * std::sqrt(dot(n, n));
+  }
+  return surface;
+}
+
+}  // namespace
+
+// Simplifies a closed sphere through the whole LOD chain and checks that no
+// level turns triangles inside out or loses a large part of the surface.
+auto main() -> int {
+  auto mesh = uv_sphere();
+  auto levels = el::tools::build_lod_chain(mesh.indices, mesh.positions,
+                                           el::engine::mesh::kMaxLods);
+  auto source = measure(mesh, mesh.indices);
+
+  int failures = 0;
+  if (levels.size() < 3) {
+    std::cerr << "Expected at least 3 levels, got " << levels.size()
+              << std::endl;
+    ++failures;
+  }
+  float previous_distance = 0.0F;
+  for (size_t i = 0; i < levels.size(); ++i) {
+    auto surface = measure(mesh, levels[i].indices);
+    std::cout << "lod " << i << ": " << levels[i].indices.size() / 3
+              << " triangles, area " << surface.area << ", max distance "
+              << levels[i].max_distance << std::endl;
+    if (surface.inverted > 0) {
+      std::cerr << "lod " << i << ": " << surface.inverted
+                << " inverted or degenerate triangles" << std::endl;
+      ++failures;
+    }
+    if (surface.area < source.area * kMinAreaRatio) {
+      std::cerr << "lod " << i << ": area " << surface.area << " against "
+                << source.area << " for the source" << std::endl;
+      ++failures;
+    }
+    if (levels[i].max_distance < previous_distance) {
+      std::cerr << "lod " << i << ": max distance decreased" << std::endl;
+      ++failures;
+    }
+    previous_distance = levels[i].max_distance;
+  }
+  return failures == 0 ? 0 : 1;
+}
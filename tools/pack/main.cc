@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/engine/lz4.h"
+#include "src/engine/pack_format.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+namespace pack = el::engine::pack;
+
+// Entries are only stored compressed when that saves at least this fraction
+// of their size; anything else is left mappable in place.
+constexpr double kMinCompressionSaving = 0.125;
+
+struct Input {
+  fs::path path;
+  std::string name;
+};
+
+constexpr auto align_up(uint64_t value, uint64_t alignment) -> uint64_t {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+auto read_file(const fs::path& path) -> std::vector<std::byte> {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Failed to open " + path.string());
+  }
+  std::vector<char> data{std::istreambuf_iterator<char>(file),
+                         std::istreambuf_iterator<char>()};
+  auto bytes = std::as_bytes(std::span<const char>(data));
+  return {std::begin(bytes), std::end(bytes)};
+}
+
+auto collect(const fs::path& root) -> std::vector<Input> {
+  std::vector<Input> inputs;
+  for (const auto& entry : fs::recursive_directory_iterator(root)) {
+    if (!entry.is_regular_file()) {
+      continue;
+    }
+    inputs.push_back({
+        .path = entry.path(),
+        .name = fs::relative(entry.path(), root).generic_string(),
+    });
+  }
+
+  // The engine binary searches the index by (hash, name).
+  std::sort(std::begin(inputs), std::end(inputs),
+            [](const Input& a, const Input& b) {
+              auto ha = pack::name_hash(a.name);
+              auto hb = pack::name_hash(b.name);
+              return ha != hb ? ha < hb : a.name < b.name;
+            });
+  return inputs;
+}
+
+// Writes to a pack file, throwing as soon as a write fails so a full disk
+// never leaves a truncated pack behind a successful exit.
+class PackWriter {
+ public:
+  explicit PackWriter(const std::string& path)
+      : path_(path), file_(path, std::ios::binary | std::ios::trunc) {
+    if (!file_) {
+      throw std::runtime_error("Failed to open " + path);
+    }
+  }
+
+  auto write(std::span<const std::byte> bytes) -> void {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    file_.write(reinterpret_cast<const char*>(bytes.data()),
+                std::streamsize(bytes.size()));
+    check();
+    offset_ += bytes.size();
+  }
+
+  // Zero fills up to |offset|.
+  auto pad_to(uint64_t offset) -> void {
+    static constexpr std::array<std::byte, 4096> kZeros = {};
+    while (offset_ < offset) {
+      write(std::span(kZeros).first(
+          size_t(std::min<uint64_t>(offset - offset_, kZeros.size()))));
+    }
+  }
+
+  auto seek(uint64_t offset) -> void {
+    file_.seekp(std::streamoff(offset));
+    check();
+    offset_ = offset;
+  }
+
+  auto close() -> void {
+    file_.close();
+    check();
+  }
+
+  [[nodiscard]] auto offset() const -> uint64_t { return offset_; }
+
+ private:
+  auto check() -> void {
+    if (!file_) {
+      throw std::runtime_error("Failed to write " + path_);
+    }
+  }
+
+  std::string path_;
+  std::ofstream file_;
+  uint64_t offset_ = 0;
+};
+
+// Streams one entry at a time to disk, so only a single input is ever held
+// in memory. The index goes in front of the data and is written last, once
+// the stored sizes are known.
+auto write_pack(const std::vector<Input>& inputs,
+                const std::string& path,
+                bool compress) -> void {
+  std::string names;
+  std::vector<pack::Entry> entries(inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    entries[i].name_hash = pack::name_hash(inputs[i].name);
+    entries[i].name_offset = uint32_t(names.size());
+    entries[i].name_size = uint32_t(inputs[i].name.size());
+    names += inputs[i].name;
+  }
+
+  pack::Header header;
+  header.entry_count = uint32_t(inputs.size());
+  header.entry_offset = sizeof(pack::Header);
+  header.names_offset =
+      header.entry_offset + inputs.size() * sizeof(pack::Entry);
+  header.names_size = names.size();
+
+  PackWriter out(path);
+  out.pad_to(header.names_offset);
+  out.write(std::as_bytes(std::span<const char>(names)));
+
+  uint64_t raw = 0;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    auto stored = read_file(inputs[i].path);
+    auto& entry = entries[i];
+    entry.size = stored.size();
+    if (compress && !stored.empty()) {
+      auto packed = el::engine::lz4::compress(stored);
+      if (double(packed.size()) <=
+          double(entry.size) * (1.0 - kMinCompressionSaving)) {
+        stored = std::move(packed);
+        entry.compression = pack::Compression::kLz4;
+      }
+    }
+    entry.offset = align_up(out.offset(), pack::kEntryAlignment);
+    entry.stored_size = stored.size();
+    out.pad_to(entry.offset);
+    out.write(stored);
+    raw += entry.size;
+  }
+  out.pad_to(align_up(out.offset(), pack::kEntryAlignment));
+  auto total = out.offset();
+
+  out.seek(0);
+  out.write(std::as_bytes(std::span<const pack::Header>(&header, 1)));
+  out.write(std::as_bytes(std::span<const pack::Entry>(entries)));
+  out.close();
+  std::cout << "Wrote " << path << ": " << entries.size() << " entries, "
+            << raw << " bytes in, " << total << " bytes out" << std::endl;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+  std::span args(argv, size_t(argc));
+  auto store = args.size() == 4 && std::string_view(args[1]) == "-s";
+  if (args.size() != 3 && !store) {
+    std::cerr << "Usage: " << args[0] << " [-s] <input dir> <output.elp>"
+              << std::endl
+              << "  -s  store every entry uncompressed" << std::endl;
+    return 1;
+  }
+
+  try {
+    auto inputs = collect(args[args.size() - 2]);
+    write_pack(inputs, args[args.size() - 1], !store);
+  } catch (const std::exception& e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}